@@ -1,8 +1,9 @@
 // Copyright (C) Pavel Grebnev 2026
 // Distributed under the MIT License (license terms are at http://opensource.org/licenses/MIT).
 
-#include <thread>
+#include <chrono>
 
+#include "common_shared/cryptography/utils/ephemeral_keypair_pool.h"
 #include "common_shared/debug/log.h"
 #include "common_shared/network/utils.h"
 #include "common_shared/nsd/nsd_client.h"
@@ -14,44 +15,68 @@ int main()
 {
 	Network::initSocketLib();
 
+	// the keys get generated while we're waiting for the discovery
+	Cryptography::EphemeralKeypairPool::start(4);
+
 	TestFullFileBackup test{ "." };
 	test.startDiscovery();
-	std::vector<TestServerInfo> discoveryResults;
-	int tries = 0;
-	do {
-		std::this_thread::sleep_for(std::chrono::milliseconds(10));
-		discoveryResults = test.getDiscoveryResults();
-		++tries;
-	} while (discoveryResults.empty() && tries < 1000);
-	test.stopDiscovery();
-
-	if (!discoveryResults.empty())
+
+	constexpr std::chrono::seconds DiscoveryTimeout(10);
+
+	const std::vector<std::array<std::byte, 16>> pairedServerIds = test.getPairedServerIds();
+	if (!pairedServerIds.empty())
 	{
-		std::variant<std::string, PendingServerBinding> pairintExchangeResult = test.exchangePairInformationWithServer(discoveryResults.front());
+		// for an already paired server the last known address is tried while NSD is still looking for it
+		const std::optional<TestServerInfo> serverInfo = test.findPairedServer(pairedServerIds.front(), DiscoveryTimeout);
+		test.stopDiscovery();
 
-		std::visit(
-			VisitLambda{
-				[](std::string&& error) {
-					Debug::Log::printDebug("Error when exchanging pairing information: {}", std::move(error));
-				},
-				[&serverAddress = discoveryResults.front(), &test](PendingServerBinding&& pendingBinding) {
-					if (auto error = test.approveServer(serverAddress, std::move(pendingBinding)); error.has_value())
-					{
-						Debug::Log::printDebug("Error when pairing: {}", std::move(*error));
-						return;
-					}
-
-					if (auto error = test.sendFiles(serverAddress, "./client_files_to_send", "./client_files_to_send"); error.has_value())
-					{
-						Debug::Log::printDebug("Error when exchanging files: {}", std::move(*error));
-						return;
-					}
+		if (serverInfo.has_value())
+		{
+			if (auto error = test.sendFiles(*serverInfo, "./client_files_to_send", "./client_files_to_send"); error.has_value())
+			{
+				Debug::Log::printDebug("Error when exchanging files: {}", std::move(*error));
+			}
+		}
+		else
+		{
+			Debug::Log::printDebug("Could not find the paired server");
+		}
+	}
+	else
+	{
+		const std::optional<TestServerInfo> serverInfo = test.waitForAnyServer(DiscoveryTimeout);
+		test.stopDiscovery();
+
+		if (serverInfo.has_value())
+		{
+			std::variant<std::string, PendingServerBinding> pairintExchangeResult = test.exchangePairInformationWithServer(*serverInfo);
+
+			std::visit(
+				VisitLambda{
+					[](std::string&& error) {
+						Debug::Log::printDebug("Error when exchanging pairing information: {}", std::move(error));
+					},
+					[&serverAddress = *serverInfo, &test](PendingServerBinding&& pendingBinding) {
+						if (auto error = test.approveServer(serverAddress, std::move(pendingBinding)); error.has_value())
+						{
+							Debug::Log::printDebug("Error when pairing: {}", std::move(*error));
+							return;
+						}
+
+						if (auto error = test.sendFiles(serverAddress, "./client_files_to_send", "./client_files_to_send"); error.has_value())
+						{
+							Debug::Log::printDebug("Error when exchanging files: {}", std::move(*error));
+							return;
+						}
+					},
 				},
-			},
-			std::move(pairintExchangeResult)
-		);
+				std::move(pairintExchangeResult)
+			);
+		}
 	}
 
+	Cryptography::EphemeralKeypairPool::stop();
+
 	Network::shutdownSocketLib();
 
 	return 0;
@@ -6,8 +6,10 @@
 #include <filesystem>
 #include <vector>
 
+#include "common_shared/cryptography/noise/session_resumption.h"
 #include "common_shared/cryptography/types/dh_types.h"
 #include "common_shared/cryptography/types/hash_types.h"
+#include "common_shared/network/utils.h"
 #include "common_shared/storage/lmdb_environment.h"
 
 struct ClientStorageData
@@ -24,6 +26,16 @@ struct ClientStorageData
 		Cryptography::HashResult connectionId;
 		Cryptography::PublicKey remoteStaticKey;
 		Cryptography::Keypair staticKeys;
+		// DH(staticKeys, remoteStaticKey), computed once at pairing time, see NoiseKK::computeStaticStaticDh
+		Cryptography::DhResult staticStaticDh;
+	};
+
+	struct ResumptionTicket
+	{
+		Noise::Resumption::Ticket ticket;
+		Cryptography::HashResult resumptionSecret;
+		// seconds since epoch, by the local clock
+		uint64_t expirationTime;
 	};
 
 	using ServerId = std::array<std::byte, 16>;
@@ -45,6 +57,16 @@ public:
 	[[nodiscard]] std::optional<ClientStorageData::ServerBinding> getConfirmedServerBinding(const ClientStorageData::ServerId& serverId) noexcept;
 	[[nodiscard]] bool hasConfirmedServerBinding(const ClientStorageData::ServerId& serverId) noexcept;
 
+	// only one ticket per server is stored, a new ticket replaces the previous one
+	void storeResumptionTicket(const ClientStorageData::ServerId& serverId, const ClientStorageData::ResumptionTicket& ticket) noexcept;
+	// the ticket is removed from the storage, since it can't be used twice
+	[[nodiscard]] std::optional<ClientStorageData::ResumptionTicket> takeResumptionTicket(const ClientStorageData::ServerId& serverId) noexcept;
+
+	// the last address where we successfully reached the server, to try it before waiting for NSD
+	void storeServerEndpoint(const ClientStorageData::ServerId& serverId, const Network::NetworkAddress& address) noexcept;
+	[[nodiscard]] std::optional<Network::NetworkAddress> getServerEndpoint(const ClientStorageData::ServerId& serverId) noexcept;
+	[[nodiscard]] std::vector<ClientStorageData::ServerId> getConfirmedServerIds() noexcept;
+
 private:
 	explicit ClientStorage(Lmdb::Environment&& mEnvironment) noexcept;
 
@@ -0,0 +1,54 @@
+// Copyright (C) Pavel Grebnev 2026
+// Distributed under the MIT License (license terms are at http://opensource.org/licenses/MIT).
+
+#pragma once
+
+#include <mutex>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "common_shared/network/utils.h"
+
+#include "client_shared/request_answers.h"
+#include "client_shared/requests.h"
+
+/// A persistent connection to a server that carries short requests, see Protocol::ControlChannel.
+///
+/// The connection is opened on the first request and stays open until close() is called
+/// or the object is destroyed. If the server closed an idle connection in the meantime,
+/// the requests are sent once more through a new connection.
+/// Interactive requests (Pair, SendFiles) still need a connection of their own.
+///
+/// The object can be used from multiple threads, the requests are sent one batch after another.
+class ControlConnection
+{
+public:
+	explicit ControlConnection(Network::NetworkAddress serverAddress) noexcept;
+	~ControlConnection() noexcept;
+
+	ControlConnection(const ControlConnection&) = delete;
+	ControlConnection& operator=(const ControlConnection&) = delete;
+	ControlConnection(ControlConnection&&) = delete;
+	ControlConnection& operator=(ControlConnection&&) = delete;
+
+	[[nodiscard]] RequestAnswers::RequestAnswer sendAndProcessRequest(Requests::Request&& request) noexcept;
+	// sends the requests without waiting for the answers in between, the answers are returned in the order of the requests
+	[[nodiscard]] std::vector<RequestAnswers::RequestAnswer> sendAndProcessRequests(std::vector<Requests::Request>&& requests) noexcept;
+
+	void close() noexcept;
+	[[nodiscard]] bool isOpen() const noexcept;
+
+private:
+	struct PreparedRequest;
+
+	[[nodiscard]] std::optional<RequestAnswers::RequestAnswer> open() noexcept;
+	void closeUnsafe() noexcept;
+	[[nodiscard]] std::optional<std::string> exchangeFrames(std::span<const PreparedRequest> requests, std::span<std::optional<RequestAnswers::RequestAnswer>> outAnswers, size_t& outReceivedCount) noexcept;
+
+	mutable std::mutex mMutex;
+	Network::NetworkAddress mServerAddress;
+	std::optional<Network::RawSocket> mSocket;
+	uint16_t mNextRequestTag = 0;
+};
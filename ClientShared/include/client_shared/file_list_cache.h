@@ -3,10 +3,13 @@
 
 #pragma once
 
+#include <cstddef>
 #include <filesystem>
-#include <fstream>
+#include <optional>
 #include <vector>
 
+#include "common_shared/files/append_only_file.h"
+
 /// A list of file paths that is stored in memory and on disk.
 ///
 /// The only reason for this class to exist is recovery from crashes.
@@ -16,8 +19,10 @@
 /// Using ClientStorage would be very inefficient if we were to mutate and save it
 /// after every file.
 ///
-/// During the file transfer, use this class to store and append each path in a simple
-/// text file.
+/// During the file transfer, use this class to record each confirmed path, and commit
+/// the recorded paths to a binary log file once per server answer.
+/// Each record in the log is a CRC32, the size of the path and the path, so the partially
+/// written records at the end of the file after a crash are detected and dropped.
 /// As soon as we finish the transfer, we go through the files we saved and save them to
 /// the client storage.
 /// After a crash, we first recover the list of files and save it to the client storage,
@@ -27,14 +32,22 @@ class FileListCache
 public:
 	FileListCache(const std::filesystem::path& storagePath) noexcept;
 
+	// only keeps the record in memory, it is written to the disk with the next commitRecordedFiles()
 	void recordFile(const std::filesystem::path& newPath) noexcept;
+	// writes all the new records with one write and flushes them to the disk
+	void commitRecordedFiles() noexcept;
 	[[nodiscard]] std::vector<std::filesystem::path> consumeAllFiles() noexcept;
 
 	[[nodiscard]] static std::vector<std::filesystem::path> recoverPreviouslyRecorded(const std::filesystem::path& storagePath) noexcept;
 	static void removePreviouslyRecorded(const std::filesystem::path& storagePath) noexcept;
 
+private:
+	[[nodiscard]] bool openLogFile() noexcept;
+
 private:
 	std::vector<std::filesystem::path> mFilePathList;
-	std::fstream mStorageFile;
+	// encoded records that are not written to the file yet
+	std::vector<std::byte> mPendingRecords;
+	std::optional<Files::AppendOnlyFile> mLogFile;
 	std::filesystem::path mStoragePath;
 };
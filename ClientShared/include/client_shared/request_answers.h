@@ -40,5 +40,8 @@ namespace RequestAnswers
 		GetProtocolVersion,
 		GetServerName,
 		Pair,
-		SendFiles>;
+		SendFiles,
+		OpenControlChannel,
+		UnsupportedRequest,
+		Hello>;
 } // namespace RequestAnswers
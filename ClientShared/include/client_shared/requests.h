@@ -6,6 +6,8 @@
 #include <cstdint>
 #include <functional>
 #include <optional>
+#include <span>
+#include <string>
 #include <variant>
 
 #include "common_shared/network/protocol.h"
@@ -20,7 +22,15 @@ namespace Requests
 	using Request = std::variant<
 		GetProtocolVersion,
 		GetServerName,
-		Pair>;
+		Pair,
+		Hello>;
+
+	// writes the request data that follows the request ID and returns the request ID
+	[[nodiscard]] Protocol::RequestId prepareRequest(Request&& request, std::span<std::byte> outData, size_t& outBytesWritten, bool& outExpectsAnswer);
+	[[nodiscard]] RequestAnswers::RequestAnswer readRequestAnswer(Protocol::RequestId request, std::byte answerId, std::span<const std::byte> answerData);
+
+	// creates a TCP socket connected to the server with the timeouts for short requests, the caller owns the socket
+	[[nodiscard]] std::variant<Network::RawSocket, std::string> createConnectedSocket(const char* serverAddress, const Network::AddressType serverAddressType, uint16_t port);
 
 	[[nodiscard]] RequestAnswers::RequestAnswer prepareConnectionAndProcess(const char* serverAddress, const Network::AddressType serverAddressType, uint16_t port, const std::function<RequestAnswers::RequestAnswer(Network::RawSocket socket)>& processFn);
 
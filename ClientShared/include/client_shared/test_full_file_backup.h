@@ -4,7 +4,12 @@
 #pragma once
 
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <filesystem>
+#include <functional>
+#include <map>
+#include <memory>
 #include <mutex>
 #include <optional>
 #include <thread>
@@ -12,8 +17,10 @@
 #include <vector>
 
 #include "common_shared/network/utils.h"
+#include "common_shared/nsd/nsd_client.h"
 
 #include "client_shared/client_storage.h"
+#include "client_shared/control_connection.h"
 
 // This is a test implementation for quick testing of file transfer
 // it should be removed as soon as a complete interactive implementation is ready
@@ -25,6 +32,20 @@ struct TestServerInfo
 	std::array<std::byte, 16> serverId;
 };
 
+enum class DiscoverySource
+{
+	Nsd,
+	// the address where we reached a paired server last time
+	CachedEndpoint,
+};
+
+struct DiscoveryEvent
+{
+	TestServerInfo serverInfo;
+	NsdClient::DiscoveryState state;
+	DiscoverySource source;
+};
+
 struct PendingServerBinding
 {
 	Cryptography::Keypair staticKeys;
@@ -37,13 +58,21 @@ struct PendingServerBinding
 class TestFullFileBackup
 {
 public:
+	using DiscoveryCallback = std::function<void(const DiscoveryEvent&)>;
+
 	TestFullFileBackup(const std::filesystem::path& localDataPath) noexcept;
+	~TestFullFileBackup() noexcept;
 
-	void startDiscovery() noexcept;
+	// the callback is called from the discovery threads
+	void startDiscovery(DiscoveryCallback callback = nullptr) noexcept;
 	[[nodiscard]] std::vector<TestServerInfo> getDiscoveryResults() noexcept;
+	// blocks until any server is discovered or the timeout passes
+	[[nodiscard]] std::optional<TestServerInfo> waitForAnyServer(std::chrono::milliseconds timeout) noexcept;
+	// tries the last known address of a paired server in parallel with NSD (if it was started) and returns the first one that answers
+	[[nodiscard]] std::optional<TestServerInfo> findPairedServer(const std::array<std::byte, 16>& serverId, std::chrono::milliseconds timeout) noexcept;
 	void stopDiscovery() noexcept;
 
-	[[nodiscard]] static std::optional<std::string> requestServerName(const Network::NetworkAddress& address) noexcept;
+	[[nodiscard]] std::optional<std::string> requestServerName(const Network::NetworkAddress& address) noexcept;
 
 	[[nodiscard]] std::variant<std::string, PendingServerBinding> exchangePairInformationWithServer(const TestServerInfo& serverInfo) noexcept;
 	[[nodiscard]] std::optional<std::string> approveServer(const TestServerInfo& serverInfo, const PendingServerBinding& serverBindingInfo) noexcept;
@@ -53,11 +82,22 @@ public:
 	[[nodiscard]] std::optional<std::string> removeServer(const std::array<std::byte, 16>& serverId) noexcept;
 
 	[[nodiscard]] bool isServerPaired(const std::array<std::byte, 16>& serverName) noexcept;
+	[[nodiscard]] std::vector<std::array<std::byte, 16>> getPairedServerIds() noexcept;
+
+private:
+	void onServerAdded(TestServerInfo&& serverInfo, DiscoverySource source) noexcept;
+	void onServerRemoved(const Network::NetworkAddress& address) noexcept;
+	void probeCachedEndpoint(const Network::NetworkAddress& address, const std::array<std::byte, 16>& serverId) noexcept;
 
 private:
 	std::mutex mDataMutex;
+	std::condition_variable mDiscoveryCondition;
 	std::thread mDiscoveryThread;
+	std::thread mEndpointProbeThread;
+	DiscoveryCallback mDiscoveryCallback;
 	std::vector<TestServerInfo> mDiscoveredServers;
+	// keyed by the server address, kept open to not reconnect for every status query
+	std::map<std::string, std::unique_ptr<ControlConnection>> mControlConnections;
 	std::atomic_bool mNsdStopFlag{};
 	ClientStorage mClientStorage;
 	std::filesystem::path mLocalDataPath;
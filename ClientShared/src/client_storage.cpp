@@ -4,12 +4,16 @@
 #include "client_shared/client_storage.h"
 
 #include <algorithm>
+#include <optional>
 #include <string_view>
 
+#include "common_shared/cryptography/noise/noise_kk_handshake.h"
+#include "common_shared/cryptography/utils/crypto_wipe.h"
 #include "common_shared/debug/assert.h"
-#include "common_shared/serialization/number_serialization.h"
-#include "common_shared/serialization/serialization_helpers.h"
+#include "common_shared/serialization/record_schema.h"
+#include "common_shared/storage/lmdb_cursor.h"
 #include "common_shared/storage/lmdb_helpers.h"
+#include "common_shared/storage/lmdb_typed_database.h"
 
 namespace ClientStorageInternal
 {
@@ -17,11 +21,135 @@ namespace ClientStorageInternal
 	static constexpr std::zstring_view ConfirmedDatabaseName = "confirmed";
 	static constexpr std::zstring_view SentFilesDatabaseName = "sent_files";
 	static constexpr std::zstring_view PartiallySentDatabaseName = "part_sent";
+	static constexpr std::zstring_view ResumptionTicketsDatabaseName = "tickets";
+	static constexpr std::zstring_view ServerEndpointsDatabaseName = "endpoints";
+	static constexpr std::array<std::zstring_view, 5> DatabaseNames = {
+		ConfirmedDatabaseName,
+		SentFilesDatabaseName,
+		PartiallySentDatabaseName,
+		ResumptionTicketsDatabaseName,
+		ServerEndpointsDatabaseName,
+	};
+
+	using ServerIdCodec = Lmdb::Codecs::FixedBytes<std::tuple_size_v<ClientStorageData::ServerId>>;
+	// server ID to a serialized record
+	template<typename DatabaseT = Lmdb::ReadOnlyDatabase>
+	using ServerRecordsDatabase = Lmdb::TypedDatabase<ServerIdCodec, Lmdb::Codecs::Bytes, DatabaseT>;
+	// relative path of the file to the number of bytes already sent
+	template<typename DatabaseT = Lmdb::ReadOnlyDatabase>
+	using PartiallySentDatabase = Lmdb::TypedDatabase<Lmdb::Codecs::PathString, Lmdb::Codecs::BigEndian<uint64_t>, DatabaseT>;
+
+	using ServerBindingSchema = Serialization::RecordSchema<
+		ClientStorageData::ServerBinding,
+		Serialization::Field<"serverName", &ClientStorageData::ServerBinding::serverName>,
+		Serialization::Field<"connectionId", &ClientStorageData::ServerBinding::connectionId>,
+		Serialization::Field<"remoteStaticKey", &ClientStorageData::ServerBinding::remoteStaticKey>,
+		Serialization::Field<"publicKey", &ClientStorageData::ServerBinding::staticKeys, &Cryptography::Keypair::publicKey>,
+		Serialization::Field<"secretKey", &ClientStorageData::ServerBinding::staticKeys, &Cryptography::Keypair::secretKey>,
+		Serialization::Field<"staticStaticDh", &ClientStorageData::ServerBinding::staticStaticDh>>;
+
+	// bindings saved before the ss result was stored
+	using LegacyServerBindingSchema = Serialization::RecordSchema<
+		ClientStorageData::ServerBinding,
+		Serialization::Field<"serverName", &ClientStorageData::ServerBinding::serverName>,
+		Serialization::Field<"connectionId", &ClientStorageData::ServerBinding::connectionId>,
+		Serialization::Field<"remoteStaticKey", &ClientStorageData::ServerBinding::remoteStaticKey>,
+		Serialization::Field<"publicKey", &ClientStorageData::ServerBinding::staticKeys, &Cryptography::Keypair::publicKey>,
+		Serialization::Field<"secretKey", &ClientStorageData::ServerBinding::staticKeys, &Cryptography::Keypair::secretKey>>;
+
+	using ResumptionTicketSchema = Serialization::RecordSchema<
+		ClientStorageData::ResumptionTicket,
+		Serialization::Field<"ticket", &ClientStorageData::ResumptionTicket::ticket>,
+		Serialization::Field<"resumptionSecret", &ClientStorageData::ResumptionTicket::resumptionSecret>,
+		Serialization::Field<"expirationTime", &ClientStorageData::ResumptionTicket::expirationTime>>;
+
+	using ServerEndpointSchema = Serialization::RecordSchema<
+		Network::NetworkAddress,
+		Serialization::Field<"ip", &Network::NetworkAddress::ip>,
+		Serialization::Field<"addressType", &Network::NetworkAddress::addressType>,
+		Serialization::Field<"port", &Network::NetworkAddress::port>>;
+
+	[[nodiscard]] static std::optional<std::string_view> getCursorKey(Lmdb::ReadOnlyCursor& cursor, Lmdb::ReturnCode moveResult) noexcept
+	{
+		if (moveResult != Lmdb::ReturnCode::Success)
+		{
+			return std::nullopt;
+		}
+
+		Lmdb::Result<Lmdb::CursorDataView> data = cursor.get();
+		if (data.isError())
+		{
+			return std::nullopt;
+		}
+		return std::string_view(reinterpret_cast<const char*>(data->key.data()), data->key.size());
+	}
+
+	[[nodiscard]] static Lmdb::ReturnCode addSentFilesTransaction(Lmdb::Environment& environment, const std::vector<std::filesystem::path>& newSentFiles, const std::string& partiallySentPath, uint64_t partiallySentData, const std::vector<std::filesystem::path>& rejectedPartialFiles) noexcept
+	{
+		Lmdb::Result<Lmdb::ReadWriteTransaction> transaction = Lmdb::ReadWriteTransaction::create(environment);
+		if (transaction.isError())
+		{
+			return transaction.getError();
+		}
+
+		Lmdb::Result<Lmdb::ReadWriteDatabase> sentFilesDb = Lmdb::ReadWriteDatabase::open(*transaction, SentFilesDatabaseName);
+		if (sentFilesDb.isError())
+		{
+			return sentFilesDb.getError();
+		}
+
+		{
+			static constexpr std::array<std::byte, 1> sentFileValue{ std::byte(0x00) };
+
+			std::vector<std::string> pathStrings;
+			pathStrings.reserve(newSentFiles.size());
+			std::vector<Lmdb::RecordView> records;
+			records.reserve(newSentFiles.size());
+			for (const std::filesystem::path& path : newSentFiles)
+			{
+				const std::string& pathString = pathStrings.emplace_back(path.string());
+				records.push_back({ .key = std::as_bytes(std::span(pathString)), .value = sentFileValue });
+			}
+
+			const Lmdb::ReturnCode returnCode = sentFilesDb->putBatch(records);
+			if (returnCode != Lmdb::ReturnCode::Success)
+			{
+				return returnCode;
+			}
+		}
+
+		Lmdb::Result<Lmdb::ReadWriteDatabase> partiallySentDbRes = Lmdb::ReadWriteDatabase::open(*transaction, PartiallySentDatabaseName);
+		if (partiallySentDbRes.isError())
+		{
+			return partiallySentDbRes.getError();
+		}
+		PartiallySentDatabase<Lmdb::ReadWriteDatabase> partiallySentDb{ *partiallySentDbRes };
+
+		if (partiallySentData > 0 && !partiallySentPath.empty())
+		{
+			Lmdb::ReturnCode returnCode = partiallySentDb.put(partiallySentPath, partiallySentData);
+			if (returnCode != Lmdb::ReturnCode::Success && returnCode != Lmdb::ReturnCode::NotFound)
+			{
+				return returnCode;
+			}
+		}
+
+		for (const std::filesystem::path& rejectedFilePath : rejectedPartialFiles)
+		{
+			Lmdb::ReturnCode returnCode = partiallySentDb.deleteKey(rejectedFilePath);
+			if (returnCode != Lmdb::ReturnCode::Success)
+			{
+				return returnCode;
+			}
+		}
+
+		return transaction->commit();
+	}
 }
 
 std::optional<ClientStorage> ClientStorage::openStorage(const std::filesystem::path& storageRootPath)
 {
-	static constexpr size_t maxNamedDatabases = 5;
+	static constexpr size_t maxNamedDatabases = 6;
 
 	std::filesystem::path dbPath = storageRootPath / ClientStorageInternal::ClientStorageEnviromentName;
 	Lmdb::Result<Lmdb::Environment> envResult = Lmdb::Environment::open(dbPath, maxNamedDatabases);
@@ -50,118 +178,144 @@ std::optional<ClientStorage> ClientStorage::openStorage(const std::filesystem::p
 		return std::nullopt;
 	}
 
+	// hot read paths (e.g. checking the pairing on each discovery event) then skip the lookup of the databases by name
+	if (envResult->openDatabaseHandles(ClientStorageInternal::DatabaseNames) != Lmdb::ReturnCode::Success)
+	{
+		return std::nullopt;
+	}
+
 	return ClientStorage(envResult.consumeResult());
 }
 
 void ClientStorage::addSentFiles(const std::vector<std::filesystem::path>& newSentFiles, std::string partiallySentPath, uint64_t partiallySentData, const std::vector<std::filesystem::path>& rejectedPartialFiles) noexcept
 {
-	Lmdb::Result<Lmdb::ReadWriteTransaction> transaction = Lmdb::ReadWriteTransaction::create(mEnvironment);
+	// the list of sent files only grows, so this is the transaction that eventually fills the map
+	const Lmdb::ReturnCode returnCode = Lmdb::retryOnMapFull(mEnvironment, [&]() {
+		return ClientStorageInternal::addSentFilesTransaction(mEnvironment, newSentFiles, partiallySentPath, partiallySentData, rejectedPartialFiles);
+	});
+	if (returnCode != Lmdb::ReturnCode::Success)
+	{
+		return;
+	}
+}
+
+void ClientStorage::filterOutSentFiles(const std::filesystem::path& rootPath, std::vector<std::filesystem::path>& inOutPaths, std::vector<uint64_t>& outPreviouslySentBytes) noexcept
+{
+	Lmdb::Result<Lmdb::ReadOnlyTransaction> transaction = Lmdb::ReadOnlyTransaction::create(mEnvironment);
 	if (transaction.isError())
 	{
 		return;
 	}
 
-	Lmdb::Result<Lmdb::ReadWriteDatabase> sentFilesDb = Lmdb::ReadWriteDatabase::open(*transaction, ClientStorageInternal::SentFilesDatabaseName);
+	Lmdb::Result<Lmdb::ReadOnlyDatabase> sentFilesDb = Lmdb::ReadOnlyDatabase::open(*transaction, ClientStorageInternal::SentFilesDatabaseName);
 	if (sentFilesDb.isError())
 	{
 		return;
 	}
 
-	for (const std::filesystem::path& path : newSentFiles)
+	// sort the candidates once and walk them together with the ordered keys of the database
+	std::vector<std::pair<std::string, size_t>> sortedRelativePaths;
+	sortedRelativePaths.reserve(inOutPaths.size());
+	for (size_t i = 0; i < inOutPaths.size(); ++i)
 	{
-		const Lmdb::ReturnCode returnCode = sentFilesDb->put(std::as_bytes(std::span<const char>(path.string())), std::array<std::byte, 1>{ std::byte(0x00) });
-		if (returnCode != Lmdb::ReturnCode::Success)
-		{
-			return;
-		}
+		sortedRelativePaths.emplace_back(inOutPaths[i].lexically_relative(rootPath).string(), i);
 	}
+	std::ranges::sort(sortedRelativePaths);
 
-	Lmdb::Result<Lmdb::ReadWriteDatabase> partiallySentDb = Lmdb::ReadWriteDatabase::open(*transaction, ClientStorageInternal::PartiallySentDatabaseName);
-	if (partiallySentDb.isError())
+	Lmdb::Result<Lmdb::ReadOnlyCursor> cursor = Lmdb::ReadOnlyCursor::open(*transaction, *sentFilesDb);
+	if (cursor.isError())
 	{
 		return;
 	}
 
-	if (partiallySentData > 0 && !partiallySentPath.empty())
+	std::vector<bool> isSent(inOutPaths.size(), false);
+	std::optional<std::string_view> cursorKey;
+	for (const auto& [relativePath, index] : sortedRelativePaths)
 	{
-		std::array<std::byte, 8> sentDataBytes;
-		Serialization::writeUint64(sentDataBytes, partiallySentData);
-		Lmdb::ReturnCode returnCode = partiallySentDb->put(std::as_bytes(std::span(partiallySentPath)), sentDataBytes);
-		if (returnCode != Lmdb::ReturnCode::Success && returnCode != Lmdb::ReturnCode::NotFound)
+		if (!cursorKey.has_value() || *cursorKey < relativePath)
 		{
-			return;
+			// when most of the files were already sent the next key is usually the one we need
+			if (cursorKey.has_value())
+			{
+				cursorKey = ClientStorageInternal::getCursorKey(*cursor, cursor->next());
+			}
+
+			if (!cursorKey.has_value() || *cursorKey < relativePath)
+			{
+				cursorKey = ClientStorageInternal::getCursorKey(*cursor, cursor->seek(std::as_bytes(std::span(relativePath))));
+			}
+
+			if (!cursorKey.has_value())
+			{
+				// no keys left that are not less than the remaining paths
+				break;
+			}
 		}
-	}
 
-	for (const std::filesystem::path& rejectedFilePath : rejectedPartialFiles)
-	{
-		std::string pathString = rejectedFilePath.string();
-		Lmdb::ReturnCode returnCode = partiallySentDb->deleteKey(std::as_bytes(std::span(pathString)));
-		if (returnCode != Lmdb::ReturnCode::Success)
+		if (*cursorKey == relativePath)
 		{
-			return;
+			isSent[index] = true;
 		}
 	}
 
-	const Lmdb::ReturnCode returnCode = transaction->commit();
-	if (returnCode != Lmdb::ReturnCode::Success)
+	size_t keptCount = 0;
+	for (size_t i = 0; i < inOutPaths.size(); ++i)
 	{
-		return;
+		if (!isSent[i])
+		{
+			if (keptCount != i)
+			{
+				inOutPaths[keptCount] = std::move(inOutPaths[i]);
+			}
+			++keptCount;
+		}
 	}
-}
+	inOutPaths.resize(keptCount);
 
-void ClientStorage::filterOutSentFiles(const std::filesystem::path& rootPath, std::vector<std::filesystem::path>& inOutPaths, std::vector<uint64_t>& outPreviouslySentBytes) noexcept
-{
-	Lmdb::Result<Lmdb::ReadOnlyTransaction> transaction = Lmdb::ReadOnlyTransaction::create(mEnvironment);
-	if (transaction.isError())
+	Lmdb::Result<Lmdb::ReadOnlyDatabase> partiallySentDbRes = Lmdb::ReadOnlyDatabase::open(*transaction, ClientStorageInternal::PartiallySentDatabaseName);
+	if (partiallySentDbRes.isError())
 	{
 		return;
 	}
+	ClientStorageInternal::PartiallySentDatabase<> partiallySentDb{ *partiallySentDbRes };
 
-	Lmdb::Result<Lmdb::ReadOnlyDatabase> sentFilesDb = Lmdb::ReadOnlyDatabase::open(*transaction, ClientStorageInternal::SentFilesDatabaseName);
-	if (sentFilesDb.isError())
+	std::vector<ClientStorageData::PartiallySentFile> partiallySent;
+	Lmdb::ReturnCode returnCode = partiallySentDb.readAllRecords(*transaction, [&partiallySent](std::string_view path, uint64_t sentBytes) {
+		partiallySent.emplace_back(std::string(path), sentBytes);
+	});
+	debugAssert(returnCode == Lmdb::ReturnCode::Success, "Unexpected result from cursor iteration");
+
+	if (partiallySent.empty())
 	{
 		return;
 	}
 
-	// it may be theoretically more efficient to load the list and cache it into a better search structure
-	inOutPaths.erase(
-		std::remove_if(inOutPaths.begin(), inOutPaths.end(), [&sentFilesDb, &rootPath](const std::filesystem::path& path) -> bool {
-			bool hasMatched = false;
-			auto result = sentFilesDb->readValue(std::as_bytes(std::span<const char>(path.lexically_relative(rootPath).string())), [&hasMatched](std::span<const std::byte>) {
-				hasMatched = true;
-			});
-			return hasMatched && result == Lmdb::ReturnCode::Success;
-		}),
-		inOutPaths.end()
-	);
-
-	Lmdb::Result<Lmdb::ReadOnlyDatabase> partiallySentDb = Lmdb::ReadOnlyDatabase::open(*transaction, ClientStorageInternal::PartiallySentDatabaseName);
-	if (partiallySentDb.isError())
+	// partially sent files go first (in reverse order of the storage), the rest of the files keep their order
+	std::vector<std::filesystem::path> sortedPartialPaths;
+	sortedPartialPaths.reserve(partiallySent.size());
+	std::vector<std::filesystem::path> result;
+	result.reserve(inOutPaths.size() + partiallySent.size());
+	std::vector<uint64_t> previouslySentBytes;
+	previouslySentBytes.reserve(outPreviouslySentBytes.size() + partiallySent.size());
+	for (auto it = partiallySent.rbegin(); it != partiallySent.rend(); ++it)
 	{
-		return;
+		result.emplace_back(it->path);
+		sortedPartialPaths.emplace_back(it->path);
+		previouslySentBytes.push_back(it->sentData);
 	}
+	std::ranges::sort(sortedPartialPaths);
 
-	std::vector<ClientStorageData::PartiallySentFile> partiallySent;
-	Lmdb::ReturnCode returnCode = Lmdb::readAllDbRecords(*transaction, *partiallySentDb, [&partiallySent](std::span<const std::byte> key, std::span<const std::byte> value) {
-		uint64_t readBytes = Serialization::readUint64(value);
-		partiallySent.emplace_back(std::string(reinterpret_cast<const char*>(key.data()), key.size()), readBytes);
-	});
-	debugAssert(returnCode == Lmdb::ReturnCode::Success, "Unexpected result from cursor iteration");
-
-	for (auto& file : partiallySent)
+	for (std::filesystem::path& path : inOutPaths)
 	{
-		auto it = std::find(inOutPaths.begin(), inOutPaths.end(), file.path);
-		if (it == inOutPaths.end())
-		{
-			inOutPaths.emplace(inOutPaths.begin(), file.path);
-		}
-		else if (it != inOutPaths.begin())
+		if (!std::ranges::binary_search(sortedPartialPaths, path))
 		{
-			std::rotate(inOutPaths.begin(), it, it + 1);
+			result.push_back(std::move(path));
 		}
-		outPreviouslySentBytes.emplace(outPreviouslySentBytes.begin(), file.sentData);
 	}
+	inOutPaths = std::move(result);
+
+	previouslySentBytes.insert(previouslySentBytes.end(), outPreviouslySentBytes.begin(), outPreviouslySentBytes.end());
+	outPreviouslySentBytes = std::move(previouslySentBytes);
 }
 
 void ClientStorage::addConfirmedServerBinding(const ClientStorageData::ServerId& serverId, const ClientStorageData::ServerBinding& binding) noexcept
@@ -178,24 +332,15 @@ void ClientStorage::addConfirmedServerBinding(const ClientStorageData::ServerId&
 		return;
 	}
 
-	std::vector<std::byte> value;
-	value.resize(1 + binding.serverName.size() + binding.connectionId.size() + binding.remoteStaticKey.size() + binding.staticKeys.publicKey.size() + binding.staticKeys.secretKey.size());
-	Serialization::GenericSerializationWrapper serializer{ value };
-
-	if (!serializer.writeShortString(binding.serverName, "serverName")) { return; }
-	if (!serializer.writeFixedData(binding.connectionId, "connectionId")) { return; }
-	if (!serializer.writeFixedData(binding.remoteStaticKey, "remoteStaticKey")) { return; }
-	if (!serializer.writeFixedData(binding.staticKeys.publicKey, "publicKey")) { return; }
-	if (!serializer.writeFixedData(binding.staticKeys.secretKey, "secretKey")) { return; }
-	assertFatalRelease(serializer.getBytesWritten() == value.size(), "Logical error, serialization of confirmed binding leaves not filled bytes, buffer size: {} written: {}", value.size(), serializer.getBytesWritten());
-
-	Lmdb::ReturnCode returnCode = wrapper->database.put(serverId, value);
-	if (returnCode != Lmdb::ReturnCode::Success)
+	// serialize right into the database memory, so the keys are not copied into temporary buffers
+	Lmdb::Result<std::span<std::byte>> value = wrapper->database.reserve(serverId, ClientStorageInternal::ServerBindingSchema::getSerializedSize(binding));
+	if (value.isError())
 	{
 		return;
 	}
+	if (!ClientStorageInternal::ServerBindingSchema::write(binding, *value)) { return; }
 
-	returnCode = wrapper->transaction.commit();
+	Lmdb::ReturnCode returnCode = wrapper->transaction.commit();
 	if (returnCode != Lmdb::ReturnCode::Success)
 	{
 		return;
@@ -210,12 +355,25 @@ bool ClientStorage::removeConfirmedServerBinding(const ClientStorageData::Server
 		return false;
 	}
 
-	Lmdb::ReturnCode returnCode = wrapper->database.deleteKey(serverId);
+	Lmdb::ReturnCode returnCode = ClientStorageInternal::ServerRecordsDatabase<Lmdb::ReadWriteDatabase>{ wrapper->database }.deleteKey(serverId);
 	if (returnCode != Lmdb::ReturnCode::Success)
 	{
 		return false;
 	}
 
+	// the endpoint is only useful for the paired servers
+	Lmdb::Result<Lmdb::ReadWriteDatabase> endpointsDb = Lmdb::ReadWriteDatabase::open(wrapper->transaction, ClientStorageInternal::ServerEndpointsDatabaseName);
+	if (endpointsDb.isError())
+	{
+		return false;
+	}
+
+	returnCode = ClientStorageInternal::ServerRecordsDatabase<Lmdb::ReadWriteDatabase>{ *endpointsDb }.deleteKey(serverId);
+	if (returnCode != Lmdb::ReturnCode::Success && returnCode != Lmdb::ReturnCode::NotFound)
+	{
+		return false;
+	}
+
 	returnCode = wrapper->transaction.commit();
 	if (returnCode != Lmdb::ReturnCode::Success)
 	{
@@ -233,52 +391,191 @@ std::optional<ClientStorageData::ServerBinding> ClientStorage::getConfirmedServe
 		return std::nullopt;
 	}
 
-	std::vector<std::byte> value;
-	Lmdb::ReturnCode returnCode = wrapper->database.getDynamic(serverId, value);
+	ClientStorageInternal::ServerRecordsDatabase<> confirmedDb{ wrapper->database };
+	ClientStorageData::ServerBinding result{};
+	bool isRead = false;
+	const Lmdb::ReturnCode returnCode = confirmedDb.read(serverId, [&result, &isRead](std::span<const std::byte> value) {
+		const std::optional<size_t> legacyBytesRead = ClientStorageInternal::LegacyServerBindingSchema::readPrefix(value, result);
+		if (!legacyBytesRead.has_value())
+		{
+			return;
+		}
+
+		if (*legacyBytesRead == value.size())
+		{
+			result.staticStaticDh = Noise::NoiseKK::computeStaticStaticDh(result.staticKeys, result.remoteStaticKey);
+			isRead = true;
+		}
+		else
+		{
+			isRead = ClientStorageInternal::ServerBindingSchema::read(value, result);
+		}
+	});
+	if (returnCode != Lmdb::ReturnCode::Success || !isRead)
+	{
+		return std::nullopt;
+	}
+
+	return result;
+}
+
+bool ClientStorage::hasConfirmedServerBinding(const ClientStorageData::ServerId& serverId) noexcept
+{
+	Lmdb::Result<Lmdb::ReadOnlySingleDbWrapper> wrapper = Lmdb::openReadOnlySingleDbTransaction(mEnvironment, ClientStorageInternal::ConfirmedDatabaseName);
+	if (wrapper.isError())
+	{
+		return false;
+	}
+
+	ClientStorageInternal::ServerRecordsDatabase<> confirmedDb{ wrapper->database };
+	return confirmedDb.contains(serverId);
+}
+
+ClientStorage::ClientStorage(Lmdb::Environment&& environment) noexcept
+	: mEnvironment(std::move(environment))
+{
+}
+
+void ClientStorage::storeResumptionTicket(const ClientStorageData::ServerId& serverId, const ClientStorageData::ResumptionTicket& ticket) noexcept
+{
+	Lmdb::Result<Lmdb::ReadWriteSingleDbWrapper> wrapper = Lmdb::openReadWriteSingleDbTransaction(mEnvironment, ClientStorageInternal::ResumptionTicketsDatabaseName);
+	if (wrapper.isError())
+	{
+		return;
+	}
+
+	std::array<std::byte, *ClientStorageInternal::ResumptionTicketSchema::FixedSize> value;
+	if (!ClientStorageInternal::ResumptionTicketSchema::write(ticket, value)) { return; }
+
+	Lmdb::ReturnCode returnCode = ClientStorageInternal::ServerRecordsDatabase<Lmdb::ReadWriteDatabase>{ wrapper->database }.put(serverId, value);
+	Cryptography::cryptoWipeRawData(value);
 	if (returnCode != Lmdb::ReturnCode::Success)
+	{
+		return;
+	}
+
+	returnCode = wrapper->transaction.commit();
+	if (returnCode != Lmdb::ReturnCode::Success)
+	{
+		return;
+	}
+}
+
+std::optional<ClientStorageData::ResumptionTicket> ClientStorage::takeResumptionTicket(const ClientStorageData::ServerId& serverId) noexcept
+{
+	Lmdb::Result<Lmdb::ReadWriteSingleDbWrapper> wrapper = Lmdb::openReadWriteSingleDbTransaction(mEnvironment, ClientStorageInternal::ResumptionTicketsDatabaseName);
+	if (wrapper.isError())
 	{
 		return std::nullopt;
 	}
 
-	ClientStorageData::ServerBinding result{};
-	Serialization::GenericDeserializationWrapper deserializer{ value };
+	ClientStorageInternal::ServerRecordsDatabase<Lmdb::ReadWriteDatabase> ticketsDb{ wrapper->database };
+	// the value is read right from the database memory, so there is no copy of the secret to wipe
+	ClientStorageData::ResumptionTicket result{};
+	bool isRead = false;
+	size_t valueSize = 0;
+	Lmdb::ReturnCode returnCode = ticketsDb.read(serverId, [&result, &isRead, &valueSize](std::span<const std::byte> value) {
+		isRead = ClientStorageInternal::ResumptionTicketSchema::read(value, result);
+		valueSize = value.size();
+	});
+	if (returnCode != Lmdb::ReturnCode::Success)
+	{
+		return std::nullopt;
+	}
 
-	if (!deserializer.readShortString(result.serverName, "serverName")) { return std::nullopt; }
-	if (!deserializer.readFixedData(result.connectionId, "connectionId")) { return std::nullopt; }
-	if (!deserializer.readFixedData(result.remoteStaticKey, "remoteStaticKey")) { return std::nullopt; }
-	if (!deserializer.readFixedData(result.staticKeys.publicKey, "publicKey")) { return std::nullopt; }
-	if (!deserializer.readFixedData(result.staticKeys.secretKey, "secretKey")) { return std::nullopt; }
+	// remove the ticket even if it was malformed
+	returnCode = ticketsDb.deleteKey(serverId);
+	if (returnCode != Lmdb::ReturnCode::Success)
+	{
+		return std::nullopt;
+	}
 
-	if (deserializer.getBytesRead() != value.size())
+	returnCode = wrapper->transaction.commit();
+	if (returnCode != Lmdb::ReturnCode::Success)
 	{
-		reportReleaseError("Deserialization of server binding read incorrect number of bytes: got {}, read {}", value.size(), deserializer.getBytesRead());
+		return std::nullopt;
+	}
+
+	if (!isRead)
+	{
+		reportReleaseError("Could not deserialize resumption ticket of size {}", valueSize);
 		return std::nullopt;
 	}
 
 	return result;
 }
 
-bool ClientStorage::hasConfirmedServerBinding(const ClientStorageData::ServerId& serverId) noexcept
+void ClientStorage::storeServerEndpoint(const ClientStorageData::ServerId& serverId, const Network::NetworkAddress& address) noexcept
 {
-	Lmdb::Result<Lmdb::ReadOnlySingleDbWrapper> wrapper = Lmdb::openReadOnlySingleDbTransaction(mEnvironment, ClientStorageInternal::ConfirmedDatabaseName);
+	Lmdb::Result<Lmdb::ReadWriteSingleDbWrapper> wrapper = Lmdb::openReadWriteSingleDbTransaction(mEnvironment, ClientStorageInternal::ServerEndpointsDatabaseName);
 	if (wrapper.isError())
 	{
-		return false;
+		return;
 	}
 
 	std::vector<std::byte> value;
-	bool isFound = false;
-	Lmdb::ReturnCode returnCode = wrapper->database.readValue(serverId, [&isFound](std::span<const std::byte>) {
-		isFound = true;
-	});
+	value.resize(ClientStorageInternal::ServerEndpointSchema::getSerializedSize(address));
+	if (!ClientStorageInternal::ServerEndpointSchema::write(address, value)) { return; }
+
+	Lmdb::ReturnCode returnCode = ClientStorageInternal::ServerRecordsDatabase<Lmdb::ReadWriteDatabase>{ wrapper->database }.put(serverId, value);
 	if (returnCode != Lmdb::ReturnCode::Success)
 	{
-		return false;
+		return;
+	}
+
+	returnCode = wrapper->transaction.commit();
+	if (returnCode != Lmdb::ReturnCode::Success)
+	{
+		return;
 	}
-	return isFound;
 }
 
-ClientStorage::ClientStorage(Lmdb::Environment&& environment) noexcept
-	: mEnvironment(std::move(environment))
+std::optional<Network::NetworkAddress> ClientStorage::getServerEndpoint(const ClientStorageData::ServerId& serverId) noexcept
+{
+	Lmdb::Result<Lmdb::ReadOnlySingleDbWrapper> wrapper = Lmdb::openReadOnlySingleDbTransaction(mEnvironment, ClientStorageInternal::ServerEndpointsDatabaseName);
+	if (wrapper.isError())
+	{
+		return std::nullopt;
+	}
+
+	ClientStorageInternal::ServerRecordsDatabase<> endpointsDb{ wrapper->database };
+	Network::NetworkAddress result;
+	bool isRead = false;
+	const Lmdb::ReturnCode returnCode = endpointsDb.read(serverId, [&result, &isRead](std::span<const std::byte> value) {
+		isRead = ClientStorageInternal::ServerEndpointSchema::read(value, result);
+	});
+	if (returnCode != Lmdb::ReturnCode::Success || !isRead)
+	{
+		return std::nullopt;
+	}
+
+	if (result.addressType != Network::AddressType::IpV4 && result.addressType != Network::AddressType::IpV6)
+	{
+		reportReleaseError("Unexpected address type of server endpoint: {}", static_cast<uint8_t>(result.addressType));
+		return std::nullopt;
+	}
+
+	return result;
+}
+
+std::vector<ClientStorageData::ServerId> ClientStorage::getConfirmedServerIds() noexcept
 {
+	std::vector<ClientStorageData::ServerId> result;
+
+	Lmdb::Result<Lmdb::ReadOnlySingleDbWrapper> wrapper = Lmdb::openReadOnlySingleDbTransaction(mEnvironment, ClientStorageInternal::ConfirmedDatabaseName);
+	if (wrapper.isError())
+	{
+		return result;
+	}
+
+	ClientStorageInternal::ServerRecordsDatabase<> confirmedDb{ wrapper->database };
+	const Lmdb::ReturnCode returnCode = confirmedDb.readAllRecords(wrapper->transaction, [&result](std::span<const std::byte, std::tuple_size_v<ClientStorageData::ServerId>> serverId, std::span<const std::byte>) {
+		std::ranges::copy(serverId, result.emplace_back().begin());
+	});
+	if (returnCode != Lmdb::ReturnCode::Success)
+	{
+		return {};
+	}
+
+	return result;
 }
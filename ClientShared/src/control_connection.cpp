@@ -0,0 +1,220 @@
+// Copyright (C) Pavel Grebnev 2026
+// Distributed under the MIT License (license terms are at http://opensource.org/licenses/MIT).
+
+#include "client_shared/control_connection.h"
+
+#include <algorithm>
+#include <array>
+#include <format>
+
+#include "common_shared/debug/assert.h"
+#include "common_shared/network/protocol.h"
+#include "common_shared/serialization/number_serialization.h"
+
+struct ControlConnection::PreparedRequest
+{
+	Protocol::RequestId requestId;
+	uint16_t requestTag;
+	std::vector<std::byte> payload;
+};
+
+namespace ControlConnectionInternal
+{
+	// keep the number of requests in flight small, so neither side can get blocked on a full socket buffer
+	constexpr size_t MaxPipelinedRequests = 32;
+} // namespace ControlConnectionInternal
+
+ControlConnection::ControlConnection(Network::NetworkAddress serverAddress) noexcept
+	: mServerAddress(std::move(serverAddress))
+{
+}
+
+ControlConnection::~ControlConnection() noexcept
+{
+	close();
+}
+
+RequestAnswers::RequestAnswer ControlConnection::sendAndProcessRequest(Requests::Request&& request) noexcept
+{
+	std::vector<Requests::Request> requests;
+	requests.push_back(std::move(request));
+	return std::move(sendAndProcessRequests(std::move(requests)).front());
+}
+
+std::vector<RequestAnswers::RequestAnswer> ControlConnection::sendAndProcessRequests(std::vector<Requests::Request>&& requests) noexcept
+{
+	std::vector<RequestAnswers::RequestAnswer> result;
+	result.reserve(requests.size());
+
+	std::lock_guard lock(mMutex);
+
+	for (size_t batchStart = 0; batchStart < requests.size(); batchStart += ControlConnectionInternal::MaxPipelinedRequests)
+	{
+		const size_t batchSize = std::min(requests.size() - batchStart, ControlConnectionInternal::MaxPipelinedRequests);
+
+		std::vector<PreparedRequest> preparedRequests;
+		preparedRequests.reserve(batchSize);
+		for (size_t i = batchStart; i < batchStart + batchSize; ++i)
+		{
+			std::array<std::byte, Protocol::ControlChannel::MaxFramePayloadSize> buffer;
+			size_t dataSize = 0;
+			bool expectsAnswer = false;
+			const Protocol::RequestId requestId = Requests::prepareRequest(std::move(requests[i]), std::span(buffer.data() + 1, buffer.size() - 1), dataSize, expectsAnswer);
+			buffer[0] = static_cast<std::byte>(requestId);
+
+			preparedRequests.push_back(PreparedRequest{
+				.requestId = requestId,
+				.requestTag = mNextRequestTag++,
+				.payload = std::vector<std::byte>(buffer.begin(), buffer.begin() + 1 + dataSize),
+			});
+		}
+
+		std::vector<std::optional<RequestAnswers::RequestAnswer>> answers(batchSize);
+		std::optional<std::string> error;
+
+		// a connection that we used before could have been closed by the server because of the idle timeout
+		// in this case we should fail before receiving any answer, and can safely retry all the requests
+		const bool isReusedConnection = mSocket.has_value();
+		for (int attempt = 0; attempt < (isReusedConnection ? 2 : 1); ++attempt)
+		{
+			if (!mSocket.has_value())
+			{
+				if (std::optional<RequestAnswers::RequestAnswer> openError = open(); openError.has_value())
+				{
+					// the answers can't be copied, so only the first request gets the details
+					result.push_back(std::move(*openError));
+					while (result.size() < requests.size())
+					{
+						result.push_back(RequestAnswers::Error{ "Could not open the control channel" });
+					}
+					return result;
+				}
+			}
+
+			size_t receivedCount = 0;
+			error = exchangeFrames(preparedRequests, answers, receivedCount);
+			if (!error.has_value())
+			{
+				break;
+			}
+
+			closeUnsafe();
+
+			if (receivedCount != 0)
+			{
+				break;
+			}
+		}
+
+		for (std::optional<RequestAnswers::RequestAnswer>& answer : answers)
+		{
+			if (answer.has_value())
+			{
+				result.push_back(std::move(*answer));
+			}
+			else
+			{
+				result.push_back(RequestAnswers::Error{ error.value_or("No answer received") });
+			}
+		}
+	}
+
+	return result;
+}
+
+void ControlConnection::close() noexcept
+{
+	std::lock_guard lock(mMutex);
+	closeUnsafe();
+}
+
+bool ControlConnection::isOpen() const noexcept
+{
+	std::lock_guard lock(mMutex);
+	return mSocket.has_value();
+}
+
+std::optional<RequestAnswers::RequestAnswer> ControlConnection::open() noexcept
+{
+	std::variant<Network::RawSocket, std::string> createSocketResult = Requests::createConnectedSocket(mServerAddress.ip.data(), mServerAddress.addressType, mServerAddress.port);
+	if (std::holds_alternative<std::string>(createSocketResult))
+	{
+		return RequestAnswers::Error{ std::get<std::string>(std::move(createSocketResult)) };
+	}
+
+	mSocket = std::get<Network::RawSocket>(createSocketResult);
+
+	std::array<std::byte, Protocol::MaxRequestAnswerSize> buffer;
+	Serialization::writeUint16(buffer[0], buffer[1], Protocol::NetworkProtocolVersion);
+	buffer[2] = static_cast<std::byte>(Protocol::RequestId::OpenControlChannel);
+
+	if (auto result = Network::send(*mSocket, std::span(buffer.data(), 3)); result.has_value())
+	{
+		closeUnsafe();
+		return RequestAnswers::Error{ std::move(*result) };
+	}
+
+	size_t answerSize = 0;
+	if (auto result = Network::recv(*mSocket, buffer, -1, answerSize); result.has_value())
+	{
+		closeUnsafe();
+		return RequestAnswers::Error{ std::move(*result) };
+	}
+
+	RequestAnswers::RequestAnswer answer = Requests::readRequestAnswer(Protocol::RequestId::OpenControlChannel, buffer[0], std::span(buffer.data() + 1, answerSize - 1));
+	if (!std::holds_alternative<RequestAnswers::OpenControlChannel>(answer))
+	{
+		// e.g. UnsupportedProtocolVersion, which should be returned to the caller
+		closeUnsafe();
+		return answer;
+	}
+
+	return std::nullopt;
+}
+
+void ControlConnection::closeUnsafe() noexcept
+{
+	if (mSocket.has_value())
+	{
+		Network::closeSocket(*mSocket);
+		mSocket.reset();
+	}
+}
+
+std::optional<std::string> ControlConnection::exchangeFrames(std::span<const PreparedRequest> requests, std::span<std::optional<RequestAnswers::RequestAnswer>> outAnswers, size_t& outReceivedCount) noexcept
+{
+	outReceivedCount = 0;
+
+	for (const PreparedRequest& request : requests)
+	{
+		if (auto result = Network::sendFrame(*mSocket, request.requestTag, request.payload); result.has_value())
+		{
+			return result;
+		}
+	}
+
+	const uint16_t firstRequestTag = requests.front().requestTag;
+	std::array<std::byte, Protocol::ControlChannel::MaxFramePayloadSize> buffer;
+	while (outReceivedCount < requests.size())
+	{
+		uint16_t requestTag = 0;
+		size_t payloadSize = 0;
+		if (auto result = Network::recvFrame(*mSocket, buffer, requestTag, payloadSize); result.has_value())
+		{
+			return result;
+		}
+
+		// the tags in the batch are consecutive, wrapping around at the end of the uint16_t range
+		const size_t index = static_cast<uint16_t>(requestTag - firstRequestTag);
+		if (index >= requests.size() || outAnswers[index].has_value()) [[unlikely]]
+		{
+			reportDebugError("Received an answer with unexpected tag {}", requestTag);
+			return std::format("Received an answer with unexpected tag {}", requestTag);
+		}
+
+		outAnswers[index] = Requests::readRequestAnswer(requests[index].requestId, buffer[0], std::span(buffer.data() + 1, payloadSize - 1));
+		++outReceivedCount;
+	}
+
+	return std::nullopt;
+}
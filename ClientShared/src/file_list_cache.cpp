@@ -3,7 +3,67 @@
 
 #include "client_shared/file_list_cache.h"
 
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <span>
+#include <string_view>
+#include <type_traits>
+
+#include "common_shared/debug/assert.h"
 #include "common_shared/debug/log.h"
+#include "common_shared/files/mapped_file.h"
+#include "common_shared/hash_utils.h"
+#include "common_shared/serialization/number_serialization.h"
+
+namespace FileListCacheInternal
+{
+	// CRC32 of the rest of the record, then the size of the path and the path bytes
+	static constexpr size_t RecordHeaderSize = 4 + 2;
+	static constexpr size_t MaxPathSize = std::numeric_limits<uint16_t>::max();
+
+	static void appendRecord(std::vector<std::byte>& inOutRecords, std::span<const std::byte> pathBytes) noexcept
+	{
+		const size_t recordStart = inOutRecords.size();
+		inOutRecords.resize(recordStart + RecordHeaderSize + pathBytes.size());
+		const std::span<std::byte> record = std::span(inOutRecords).subspan(recordStart);
+
+		Serialization::writeUint16(record[4], record[5], static_cast<uint16_t>(pathBytes.size()));
+		std::ranges::copy(pathBytes, record.begin() + RecordHeaderSize);
+		Serialization::writeUint32(record.first(4), Hash::crc32(record.subspan(4)));
+	}
+
+	// calls recordFn for each complete record, returns the size of the data that contains only valid records
+	static size_t readValidRecords(std::span<const std::byte> data, auto recordFn) noexcept
+	{
+		size_t position = 0;
+		while (data.size() - position >= RecordHeaderSize)
+		{
+			const std::span<const std::byte> header = data.subspan(position, RecordHeaderSize);
+			const size_t pathSize = Serialization::readUint16(header[4], header[5]);
+			if (data.size() - position - RecordHeaderSize < pathSize)
+			{
+				break;
+			}
+
+			const std::span<const std::byte> checkedData = data.subspan(position + 4, 2 + pathSize);
+			if (Serialization::readUint32(header.first(4)) != Hash::crc32(checkedData))
+			{
+				break;
+			}
+
+			recordFn(std::string_view(reinterpret_cast<const char*>(checkedData.data() + 2), pathSize));
+			position += RecordHeaderSize + pathSize;
+		}
+
+		if (position != data.size())
+		{
+			// expected after a crash in the middle of a write
+			Debug::Log::printDebug("File list cache has {} bytes of incomplete or damaged records at the end", data.size() - position);
+		}
+		return position;
+	}
+} // namespace FileListCacheInternal
 
 FileListCache::FileListCache(const std::filesystem::path& storagePath) noexcept
 	: mStoragePath(storagePath)
@@ -13,39 +73,66 @@ FileListCache::FileListCache(const std::filesystem::path& storagePath) noexcept
 void FileListCache::recordFile(const std::filesystem::path& newPath) noexcept
 {
 	mFilePathList.push_back(newPath);
-	try
+
+	if constexpr (std::is_same_v<std::filesystem::path::value_type, char>)
 	{
-		if (!mStorageFile.is_open())
+		const std::span<const std::byte> pathBytes = std::as_bytes(std::span(newPath.native()));
+		if (pathBytes.size() > FileListCacheInternal::MaxPathSize)
 		{
-			mStorageFile.open(mStoragePath, std::ios_base::out | std::ios_base::app);
+			reportDebugError("Path is too long to be recorded in the file list cache: {}", pathBytes.size());
+			return;
 		}
-
-#if defined(_WIN32) || defined(_WIN64)
-		const std::string pathStr = newPath.string();
-		mStorageFile.write(pathStr.c_str(), pathStr.size());
-#else
-		mStorageFile.write(newPath.native().c_str(), newPath.native().size());
-#endif
+		FileListCacheInternal::appendRecord(mPendingRecords, pathBytes);
 	}
-	catch (...)
+	else
 	{
-		Debug::Log::printDebug("Could not write to file list cache file {}", mStoragePath.generic_string());
+		const std::string pathString = newPath.string();
+		if (pathString.size() > FileListCacheInternal::MaxPathSize)
+		{
+			reportDebugError("Path is too long to be recorded in the file list cache: {}", pathString.size());
+			return;
+		}
+		FileListCacheInternal::appendRecord(mPendingRecords, std::as_bytes(std::span(pathString)));
 	}
 }
 
-std::vector<std::filesystem::path> FileListCache::consumeAllFiles() noexcept
+void FileListCache::commitRecordedFiles() noexcept
 {
-	try
+	if (mPendingRecords.empty())
+	{
+		return;
+	}
+
+	if (!mLogFile.has_value() && !openLogFile())
 	{
-		if (mStorageFile.is_open())
+		return;
+	}
+
+	const uint64_t committedSize = mLogFile->getSize();
+	if (!mLogFile->append(mPendingRecords) || !mLogFile->sync())
+	{
+		Debug::Log::printDebug("Could not write to file list cache file {}", mStoragePath.generic_string());
+		// don't leave a partial record in front of the ones written next time, the records stay pending
+		if (!mLogFile->truncate(committedSize))
 		{
-			mStorageFile.close();
+			mLogFile.reset();
 		}
-		std::filesystem::remove(mStoragePath);
+		return;
 	}
-	catch (...)
+
+	mPendingRecords.clear();
+}
+
+std::vector<std::filesystem::path> FileListCache::consumeAllFiles() noexcept
+{
+	mLogFile.reset();
+	mPendingRecords.clear();
+
+	std::error_code errorCode;
+	std::filesystem::remove(mStoragePath, errorCode);
+	if (errorCode)
 	{
-		Debug::Log::printDebug("Could not close or remove file list cache file {}", mStoragePath.generic_string());
+		Debug::Log::printDebug("Could not remove file list cache file {}", mStoragePath.generic_string());
 	}
 
 	return std::move(mFilePathList);
@@ -54,20 +141,23 @@ std::vector<std::filesystem::path> FileListCache::consumeAllFiles() noexcept
 std::vector<std::filesystem::path> FileListCache::recoverPreviouslyRecorded(const std::filesystem::path& storagePath) noexcept
 {
 	std::vector<std::filesystem::path> result;
-	if (std::filesystem::exists(storagePath) && !std::filesystem::is_directory(storagePath))
+
+	// missing and empty files are not mapped
+	const std::optional<Files::MappedFile> file = Files::MappedFile::open(storagePath);
+	if (!file.has_value())
 	{
-		try
-		{
-			std::ifstream file{ storagePath };
-			for (std::string line; getline(file, line);)
-			{
-				result.emplace_back(line);
-			}
-		}
-		catch (...)
-		{
-			Debug::Log::printDebug("Could not read file list cache file {}", storagePath.generic_string());
-		}
+		return result;
+	}
+
+	try
+	{
+		FileListCacheInternal::readValidRecords(file->getData(), [&result](std::string_view path) {
+			result.emplace_back(path);
+		});
+	}
+	catch (...)
+	{
+		Debug::Log::printDebug("Could not read file list cache file {}", storagePath.generic_string());
 	}
 
 	return result;
@@ -77,3 +167,39 @@ void FileListCache::removePreviouslyRecorded(const std::filesystem::path& storag
 {
 	std::filesystem::remove(storagePath);
 }
+
+bool FileListCache::openLogFile() noexcept
+{
+	mLogFile = Files::AppendOnlyFile::open(mStoragePath);
+	if (!mLogFile.has_value())
+	{
+		Debug::Log::printDebug("Could not open file list cache file {}", mStoragePath.generic_string());
+		return false;
+	}
+
+	if (mLogFile->getSize() == 0)
+	{
+		return true;
+	}
+
+	// records left after a crash are kept for the recovery, but a torn record at the end would hide the new ones
+	size_t validSize = 0;
+	{
+		const std::optional<Files::MappedFile> file = Files::MappedFile::open(mStoragePath);
+		if (!file.has_value())
+		{
+			// without reading the records we can't tell where they end, so the file is left as it is until the next attempt
+			Debug::Log::printDebug("Could not read file list cache file {}", mStoragePath.generic_string());
+			mLogFile.reset();
+			return false;
+		}
+		validSize = FileListCacheInternal::readValidRecords(file->getData(), [](std::string_view) {});
+	}
+
+	if (validSize < mLogFile->getSize() && !mLogFile->truncate(validSize))
+	{
+		mLogFile.reset();
+		return false;
+	}
+	return true;
+}
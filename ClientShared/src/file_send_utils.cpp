@@ -18,11 +18,12 @@ namespace FileSendUtils
 {
 	/// Files are sent in chunks of 1024 bytes + auth data,
 	/// each message is encrypted separately,
-	/// rekey is called after each message,
+	/// rekey is called according to the negotiated policy (see Protocol::FileExchange::DefaultRekeyPolicy),
 	/// no out-of-order messages allowed.
 	/// If the file size does not align to 1024, the next file will be written right after
 	/// in the same message if possible. All messages below 1024 bytes are padded with zeroes at the end.
 	/// An answer is sent each 32 chunks, or at the end of the transmission.
+	/// Filled chunks are queued and encrypted in one batch right before we need to wait for an answer.
 	struct FileSendingState
 	{
 		constexpr static size_t ChunkSize = Protocol::FileExchange::ChunkSize;
@@ -113,7 +114,10 @@ namespace FileSendUtils
 #ifdef WITH_TESTS
 		Mocks mocks;
 #endif
-		Cryptography::ByteSequence<Cryptography::ByteSequenceTag::TempInternalBuffer, ChunkSize + Cryptography::CipherAuthDataSize> buffer;
+		using TransportChunk = Cryptography::ByteSequence<Cryptography::ByteSequenceTag::TempInternalBuffer, ChunkSize + Cryptography::CipherAuthDataSize>;
+		// we never need to queue more chunks than we send between answers
+		std::array<TransportChunk, ChunksBetweenAnswers> queuedChunks;
+		size_t queuedChunksCount = 0;
 		std::string filePath;
 		size_t bytesFilledInChunk = 0;
 		size_t chunksSent = 0;
@@ -130,9 +134,13 @@ namespace FileSendUtils
 		uint64_t firstAwaitingFileBytesConfirmed = 0;
 		FileListCache confirmedFilesCache;
 		std::vector<std::filesystem::path> rejectedPartialFiles;
+		Noise::RekeySchedule sendingRekeySchedule;
+		Noise::RekeySchedule receivingRekeySchedule;
 
-		FileSendingState(const std::filesystem::path& localDataRoot)
-			: confirmedFilesCache(localDataRoot / "sent_cache.txt")
+		FileSendingState(const std::filesystem::path& localDataRoot, const Noise::RekeyPolicy& rekeyPolicy)
+			: confirmedFilesCache(localDataRoot / "sent_cache.wal")
+			, sendingRekeySchedule{ .policy = rekeyPolicy }
+			, receivingRekeySchedule{ .policy = rekeyPolicy }
 		{
 		}
 
@@ -162,6 +170,11 @@ namespace FileSendUtils
 			return !filesAwaitingConfirmation.empty();
 		}
 
+		[[nodiscard]] std::span<std::byte, ChunkSize + Cryptography::CipherAuthDataSize> getCurrentChunk() noexcept
+		{
+			return queuedChunks[queuedChunksCount].raw;
+		}
+
 		void openFile(std::ifstream& stream, const std::filesystem::path& path)
 		{
 #ifdef WITH_TESTS
@@ -246,7 +259,7 @@ namespace FileSendUtils
 			std::copy(
 				data.begin() + alreadyWrittenBytes,
 				data.begin() + (alreadyWrittenBytes + bytesToCopy),
-				buffer.raw.begin() + bytesFilledInChunk
+				getCurrentChunk().begin() + bytesFilledInChunk
 			);
 			bytesFilledInChunk += bytesToCopy;
 			return bytesToCopy;
@@ -327,7 +340,7 @@ namespace FileSendUtils
 			assertFatalRelease(hasMetadataBeenFullyWritten(), "Logical error, we should not get here before we finish writing metadata");
 			debugPrintState(DebugState::FileContent);
 			const size_t bytesToRead = std::min(fileSizeBytes - bytesReadFromFile, static_cast<uint64_t>(ChunkSize - bytesFilledInChunk));
-			readFileStreamIntoSpan(file, std::span(buffer.raw.data() + bytesFilledInChunk, bytesToRead));
+			readFileStreamIntoSpan(file, getCurrentChunk().subspan(bytesFilledInChunk, bytesToRead));
 			bytesReadFromFile += bytesToRead;
 			bytesFilledInChunk += bytesToRead;
 			assertFatalRelease(bytesReadFromFile <= fileSizeBytes, "File read size bigger than file size, this should never happen");
@@ -341,18 +354,44 @@ namespace FileSendUtils
 				return false;
 			}
 
-			auto sendResult = Network::sendEncrypted(socket, buffer, bytesFilledInChunk, sendingCipherstate);
+			++queuedChunksCount;
+			++chunksSent;
+			bytesFilledInChunk = 0;
+
+			// the other side will not answer until it receives all the chunks, so we can't hold them any longer
+			if (queuedChunksCount == queuedChunks.size() || shouldReadAnswer())
+			{
+				return flushQueuedChunks(socket, sendingCipherstate);
+			}
+
+			return true;
+		}
+
+		[[nodiscard]] bool flushQueuedChunks(Network::RawSocket socket, Noise::CipherStateSending& sendingCipherstate) noexcept
+		{
+			if (queuedChunksCount == 0)
+			{
+				return true;
+			}
+
+			std::array<std::span<std::byte>, ChunksBetweenAnswers> frames;
+			for (size_t i = 0; i < queuedChunksCount; ++i)
+			{
+				frames[i] = queuedChunks[i].raw;
+			}
+
+			auto sendResult = Network::sendEncryptedBatch(socket, std::span(frames.data(), queuedChunksCount), sendingCipherstate, sendingRekeySchedule);
 			if (sendResult.has_value()) [[unlikely]]
 			{
 				reportDebugError("Could not send file part: {}", *sendResult);
 				return false;
 			}
 
-			Noise::Utils::rekey(sendingCipherstate);
-
-			++chunksSent;
-			bytesFilledInChunk = 0;
-			std::fill(buffer.raw.begin(), buffer.raw.end(), std::byte(0x00));
+			for (size_t i = 0; i < queuedChunksCount; ++i)
+			{
+				std::fill(queuedChunks[i].raw.begin(), queuedChunks[i].raw.end(), std::byte(0x00));
+			}
+			queuedChunksCount = 0;
 
 			return true;
 		}
@@ -364,7 +403,7 @@ namespace FileSendUtils
 
 		void fillRemainderWithZeroes() noexcept
 		{
-			std::fill(buffer.raw.begin() + bytesFilledInChunk, buffer.raw.end(), std::byte(0x00));
+			std::fill(getCurrentChunk().begin() + bytesFilledInChunk, getCurrentChunk().end(), std::byte(0x00));
 			bytesFilledInChunk = ChunkSize;
 		}
 
@@ -392,6 +431,8 @@ namespace FileSendUtils
 
 				confirmedFilesCache.recordFile(filesAwaitingConfirmation[i]);
 			}
+			// one flush to the disk for all the files confirmed by this answer
+			confirmedFilesCache.commitRecordedFiles();
 
 			if (shouldRecordLast)
 			{
@@ -406,7 +447,25 @@ namespace FileSendUtils
 			}
 		}
 
-		[[nodiscard]] bool readAnswer(Network::RawSocket socket, Noise::CipherStateReceiving& receivingCipherstate, [[maybe_unused]] bool isMidSendingEndState = false) noexcept
+		[[nodiscard]] bool applyRequestedRekey(const bool isRekeyRequested, Noise::CipherStateSending& sendingCipherstate, Noise::CipherStateReceiving& receivingCipherstate) noexcept
+		{
+			if (!isRekeyRequested)
+			{
+				return true;
+			}
+
+			if (Noise::Utils::rekey(sendingCipherstate) != Cryptography::EncryptResult::Success || Noise::Utils::rekey(receivingCipherstate) != Cryptography::EncryptResult::Success) [[unlikely]]
+			{
+				reportDebugError("Could not rekey the cipher states on request of the receiving side");
+				return false;
+			}
+
+			Noise::Utils::resetRekeySchedule(sendingRekeySchedule);
+			Noise::Utils::resetRekeySchedule(receivingRekeySchedule);
+			return true;
+		}
+
+		[[nodiscard]] bool readAnswer(Network::RawSocket socket, Noise::CipherStateSending& sendingCipherstate, Noise::CipherStateReceiving& receivingCipherstate, [[maybe_unused]] bool isMidSendingEndState = false) noexcept
 		{
 			// read the big comment in Protocol::FileExchange for the explanation
 
@@ -425,21 +484,14 @@ namespace FileSendUtils
 			Cryptography::ByteSequence<Cryptography::ByteSequenceTag::TempInternalBuffer, AnswerChunkSize + Cryptography::CipherAuthDataSize> receivingBuffer;
 
 			size_t posInChunk = 0;
-			auto readChunk = [socket, &receivingBuffer, &receivingCipherstate, &posInChunk] {
-				size_t bytesReceived = 0;
-				if (auto result = Network::recvEncrypted(socket, receivingBuffer, bytesReceived, receivingCipherstate); result.has_value()) [[unlikely]]
+			auto readChunk = [socket, &receivingBuffer, &receivingCipherstate, &rekeySchedule = receivingRekeySchedule, &posInChunk] {
+				const std::array<std::span<std::byte>, 1> frames = { receivingBuffer.raw };
+				if (auto result = Network::recvEncryptedBatch(socket, frames, receivingCipherstate, rekeySchedule); result.has_value()) [[unlikely]]
 				{
 					reportDebugError("Could not recv answer chunk: {}", *result);
 					return false;
 				}
 
-				if (bytesReceived != AnswerChunkSize) [[unlikely]]
-				{
-					reportDebugError("Unexpected answer chunk size {}", bytesReceived);
-					return false;
-				}
-
-				Noise::Utils::rekey(receivingCipherstate);
 				posInChunk = 0;
 
 				return true;
@@ -450,7 +502,9 @@ namespace FileSendUtils
 				return false;
 			}
 
-			const uint16_t statusesToRead = Serialization::readUint16(receivingBuffer.raw[0], receivingBuffer.raw[1]);
+			const uint16_t answerHeader = Serialization::readUint16(receivingBuffer.raw[0], receivingBuffer.raw[1]);
+			const bool isRekeyRequested = (answerHeader & Protocol::FileExchange::AnswerRekeyFlag) != 0;
+			const uint16_t statusesToRead = answerHeader & static_cast<uint16_t>(~Protocol::FileExchange::AnswerRekeyFlag);
 			posInChunk += 2;
 
 			// make sure it won't compile if we configure the file transfer logic in a way that is not supported
@@ -475,7 +529,7 @@ namespace FileSendUtils
 				if (popcount == 0) [[likely]]
 				{
 					recordAndClearConfirmations({}, {});
-					return true;
+					return applyRequestedRekey(isRekeyRequested, sendingCipherstate, receivingCipherstate);
 				}
 			}
 
@@ -570,14 +624,15 @@ namespace FileSendUtils
 			}
 
 			recordAndClearConfirmations(errorFileIndexes, skipFileIndexes);
-			return true;
+			return applyRequestedRekey(isRekeyRequested, sendingCipherstate, receivingCipherstate);
 		}
 	};
 
 	static void concludeSendingFiles(FileSendingState& sendingState, ClientStorage& storage)
 	{
 		const uint64_t firstAwaitingFileBytesConfirmed = sendingState.firstAwaitingFileBytesConfirmed;
-		const std::string partiallySentFilePath = firstAwaitingFileBytesConfirmed > 0 ? std::move(sendingState.filePath) : std::string{};
+		// with queued chunks we may have already read past the partially confirmed file, so take its path from the awaiting list
+		const std::string partiallySentFilePath = firstAwaitingFileBytesConfirmed > 0 ? sendingState.filesAwaitingConfirmation.front().generic_string() : std::string{};
 		std::vector<std::filesystem::path> confirmedFiles = sendingState.confirmedFilesCache.consumeAllFiles();
 		std::vector<std::filesystem::path> rejectedPartialFiles = std::move(sendingState.rejectedPartialFiles);
 
@@ -610,9 +665,9 @@ namespace FileSendUtils
 		return result;
 	}
 
-	void sendFiles(const std::vector<std::filesystem::path>& files, const std::vector<uint64_t>& previouslySentBytes, const std::filesystem::path& commonRoot, Network::RawSocket socket, ClientStorage& storage, const std::filesystem::path& localDataPath, Noise::CipherStateSending& sendingCipherstate, Noise::CipherStateReceiving& receivingCipherState, [[maybe_unused]] Mocks mocks) noexcept
+	void sendFiles(const std::vector<std::filesystem::path>& files, const std::vector<uint64_t>& previouslySentBytes, const std::filesystem::path& commonRoot, Network::RawSocket socket, ClientStorage& storage, const std::filesystem::path& localDataPath, Noise::CipherStateSending& sendingCipherstate, Noise::CipherStateReceiving& receivingCipherState, const Noise::RekeyPolicy& rekeyPolicy, [[maybe_unused]] Mocks mocks) noexcept
 	{
-		FileSendingState sendingState{ localDataPath };
+		FileSendingState sendingState{ localDataPath, rekeyPolicy };
 
 #ifdef WITH_TESTS
 		sendingState.mocks = std::move(mocks);
@@ -672,7 +727,7 @@ namespace FileSendUtils
 
 						if (sendingState.shouldReadAnswer())
 						{
-							if (!sendingState.readAnswer(socket, receivingCipherState))
+							if (!sendingState.readAnswer(socket, sendingCipherstate, receivingCipherState))
 							{
 								return concludeSendingFiles(sendingState, storage);
 							}
@@ -708,7 +763,7 @@ namespace FileSendUtils
 
 						if (sendingState.shouldReadAnswer())
 						{
-							if (!sendingState.readAnswer(socket, receivingCipherState, endingBytesWritten < endingBytes.size()))
+							if (!sendingState.readAnswer(socket, sendingCipherstate, receivingCipherState, endingBytesWritten < endingBytes.size()))
 							{
 								return concludeSendingFiles(sendingState, storage);
 							}
@@ -733,9 +788,14 @@ namespace FileSendUtils
 				sendingState.debugPrintState(FileSendingState::DebugState::EndChunk);
 			}
 
+			if (!sendingState.flushQueuedChunks(socket, sendingCipherstate))
+			{
+				return concludeSendingFiles(sendingState, storage);
+			}
+
 			if (sendingState.haveUnconfirmedFiles())
 			{
-				if (!sendingState.readAnswer(socket, receivingCipherState))
+				if (!sendingState.readAnswer(socket, sendingCipherstate, receivingCipherState))
 				{
 					return concludeSendingFiles(sendingState, storage);
 				}
@@ -3,6 +3,7 @@
 
 #include "client_shared/requests.h"
 
+#include <algorithm>
 #include <array>
 #include <cstring>
 #include <format>
@@ -19,7 +20,7 @@ namespace Requests
 	constexpr const int MessageTimeoutSeconds = 2;
 	constexpr const int MessagesTimeoutMicroseconds = 0;
 
-	static Protocol::RequestId prepareRequest(Request&& request, std::span<std::byte> /*outData*/, size_t& outBytesWritten, bool& outExpectsAnswer)
+	Protocol::RequestId prepareRequest(Request&& request, std::span<std::byte> /*outData*/, size_t& outBytesWritten, bool& outExpectsAnswer)
 	{
 		return std::visit(
 			VisitLambda{
@@ -40,12 +41,17 @@ namespace Requests
 					outBytesWritten = 0;
 					return Protocol::RequestId::Pair;
 				},
+				[&outExpectsAnswer, &outBytesWritten](Requests::Hello&&) {
+					outExpectsAnswer = true;
+					outBytesWritten = 0;
+					return Protocol::RequestId::Hello;
+				},
 			},
 			std::move(request)
 		);
 	}
 
-	static RequestAnswers::RequestAnswer readRequestAnswer(Protocol::RequestId request, std::byte answerId, const std::span<const std::byte> answerData)
+	RequestAnswers::RequestAnswer readRequestAnswer(Protocol::RequestId request, std::byte answerId, const std::span<const std::byte> answerData)
 	{
 		using namespace RequestAnswers;
 
@@ -64,6 +70,11 @@ namespace Requests
 			};
 		}
 
+		if (answerId == static_cast<std::byte>(Protocol::RequestAnswerId::UnsupportedRequest))
+		{
+			return RequestAnswers::UnsupportedRequest{};
+		}
+
 		switch (request)
 		{
 		case Protocol::RequestId::GetProtocolVersion: {
@@ -95,8 +106,38 @@ namespace Requests
 			}
 			break;
 		}
+		case Protocol::RequestId::Hello: {
+			if (answerId == static_cast<std::byte>(Protocol::RequestAnswerId::Hello))
+			{
+				RequestAnswers::Hello answer;
+				constexpr size_t FixedSize = sizeof(RequestAnswers::Hello::protocolVersion) + sizeof(RequestAnswers::Hello::serverId) + sizeof(RequestAnswers::Hello::capabilities);
+				if (answerData.size() < FixedSize)
+				{
+					reportDebugError("Hello answer is shorter than expected {}", answerData.size());
+					return RequestAnswers::Error{ std::format("Hello answer is shorter than expected {}", answerData.size()) };
+				}
+
+				answer.protocolVersion = Serialization::readUint16(answerData[0], answerData[1]);
+				std::copy(answerData.begin() + 2, answerData.begin() + 2 + answer.serverId.size(), answer.serverId.begin());
+				answer.capabilities = Serialization::readUint32(answerData.subspan(2 + answer.serverId.size(), sizeof(answer.capabilities)));
+				if (auto result = Serialization::readShortString(answerData.subspan(FixedSize), answer.serverName, Protocol::MaxServerNameSize); result.has_value())
+				{
+					return RequestAnswers::Error{ std::move(*result) };
+				}
+				return answer;
+			}
+			break;
+		}
+		case Protocol::RequestId::OpenControlChannel: {
+			if (answerId == static_cast<std::byte>(Protocol::RequestAnswerId::OpenControlChannel))
+			{
+				return RequestAnswers::OpenControlChannel{};
+			}
+			break;
+		}
 		case Protocol::RequestId::Pair:
 		case Protocol::RequestId::SendFiles:
+		case Protocol::RequestId::ResumeSendFiles:
 			// no answer expected, fall through to the error
 			break;
 		}
@@ -105,39 +146,57 @@ namespace Requests
 		return RequestAnswers::Error{ std::format("Unknown answer {} to request {}", static_cast<int>(answerId), static_cast<int>(request)) };
 	}
 
-	RequestAnswers::RequestAnswer prepareConnectionAndProcess(const char* serverAddress, const Network::AddressType serverAddressType, uint16_t port, const std::function<RequestAnswers::RequestAnswer(Network::RawSocket socket)>& processFn)
+	static std::optional<std::string> setUpAndConnectSocket(const Network::RawSocket socket, const char* serverAddress, const Network::AddressType serverAddressType, uint16_t port)
 	{
-		std::variant<Network::RawSocket, std::string> createSocketResult = Network::createSocket(Network::SocketType::Tcp, serverAddressType);
-		if (std::holds_alternative<std::string>(createSocketResult))
-		{
-			reportDebugError("Could not create a TCP socket to send a request from client");
-			return RequestAnswers::Error{ std::get<std::string>(createSocketResult) };
-		}
-
-		const Network::AutoclosingSocket socket = Network::AutoclosingSocket(std::get<Network::RawSocket>(std::move(createSocketResult)));
-
-		if (const auto result = Network::setSocketTimeout(socket, SO_RCVTIMEO, MessageTimeoutSeconds, MessagesTimeoutMicroseconds); result.has_value())
+		if (auto result = Network::setSocketTimeout(socket, SO_RCVTIMEO, MessageTimeoutSeconds, MessagesTimeoutMicroseconds); result.has_value())
 		{
 			reportDebugError("Could not set SO_RCVTIMEO to a client TCP socket");
-			return RequestAnswers::Error{ *result };
+			return result;
 		}
-		if (const auto result = Network::setSocketTimeout(socket, SO_SNDTIMEO, MessageTimeoutSeconds, MessagesTimeoutMicroseconds); result.has_value())
+		if (auto result = Network::setSocketTimeout(socket, SO_SNDTIMEO, MessageTimeoutSeconds, MessagesTimeoutMicroseconds); result.has_value())
 		{
 			reportDebugError("Could not set SO_SNDTIMEO to a client TCP socket");
-			return RequestAnswers::Error{ *result };
+			return result;
 		}
 
-		if (const auto result = Network::bindSocket(socket, nullptr, serverAddressType, 0); result.has_value())
+		if (auto result = Network::bindSocket(socket, nullptr, serverAddressType, 0); result.has_value())
 		{
 			reportDebugError("Could not bind client TCP socket");
-			return RequestAnswers::Error{ *result };
+			return result;
 		}
 
-		if (const auto result = Network::connectToServer(socket, serverAddress, serverAddressType, port); result.has_value())
+		return Network::connectToServer(socket, serverAddress, serverAddressType, port);
+	}
+
+	std::variant<Network::RawSocket, std::string> createConnectedSocket(const char* serverAddress, const Network::AddressType serverAddressType, uint16_t port)
+	{
+		std::variant<Network::RawSocket, std::string> createSocketResult = Network::createSocket(Network::SocketType::Tcp, serverAddressType);
+		if (std::holds_alternative<std::string>(createSocketResult))
 		{
-			return RequestAnswers::Error{ *result };
+			reportDebugError("Could not create a TCP socket to send a request from client");
+			return createSocketResult;
 		}
 
+		const Network::RawSocket socket = std::get<Network::RawSocket>(createSocketResult);
+		if (auto result = setUpAndConnectSocket(socket, serverAddress, serverAddressType, port); result.has_value())
+		{
+			Network::closeSocket(socket);
+			return std::move(*result);
+		}
+
+		return socket;
+	}
+
+	RequestAnswers::RequestAnswer prepareConnectionAndProcess(const char* serverAddress, const Network::AddressType serverAddressType, uint16_t port, const std::function<RequestAnswers::RequestAnswer(Network::RawSocket socket)>& processFn)
+	{
+		std::variant<Network::RawSocket, std::string> createSocketResult = createConnectedSocket(serverAddress, serverAddressType, port);
+		if (std::holds_alternative<std::string>(createSocketResult))
+		{
+			return RequestAnswers::Error{ std::get<std::string>(std::move(createSocketResult)) };
+		}
+
+		const Network::AutoclosingSocket socket = Network::AutoclosingSocket(std::get<Network::RawSocket>(createSocketResult));
+
 		return processFn(socket);
 	}
 
@@ -3,10 +3,16 @@
 
 #include "client_shared/send_files_interactive_request.h"
 
+#include <chrono>
+
+#include "common_shared/cryptography/noise/cipher_utils.h"
 #include "common_shared/cryptography/noise/noise_kk_handshake.h"
+#include "common_shared/cryptography/noise/session_resumption.h"
+#include "common_shared/cryptography/utils/random.h"
 #include "common_shared/debug/assert.h"
 #include "common_shared/network/protocol.h"
 #include "common_shared/network/raw_sockets.h"
+#include "common_shared/network/session_parameters.h"
 #include "common_shared/network/utils.h"
 #include "common_shared/serialization/number_serialization.h"
 
@@ -15,7 +21,7 @@
 
 namespace Requests
 {
-	bool processKkHandshake(Network::RawSocket socket, ClientStorage& clientStorage, const std::array<std::byte, 16>& serverId, Noise::CipherStateSending& outSendingCipherState, Noise::CipherStateReceiving& outReceivingCipherState) noexcept
+	bool processKkHandshake(Network::RawSocket socket, ClientStorage& clientStorage, const std::array<std::byte, 16>& serverId, Noise::CipherStateSending& outSendingCipherState, Noise::CipherStateReceiving& outReceivingCipherState, Cryptography::HashResult& outResumptionSecret) noexcept
 	{
 		using namespace Noise;
 
@@ -29,14 +35,8 @@ namespace Requests
 			return false;
 		}
 
-		InitiatorHandshakeState handshakeState{
-			.ephemeralKeys = {},
-			.staticKeys = serverBinding->staticKeys.clone(),
-			.remoteEphemeralKey = {},
-			.remoteStaticKey = serverBinding->remoteStaticKey.clone(),
-			.symmetricState = {},
-		};
-		Cryptography::HashResult connectionId;
+		InitiatorHandshakeState handshakeState = NoiseKK::initializeInitiator(serverBinding->staticKeys, serverBinding->remoteStaticKey, serverBinding->staticStaticDh);
+		const Cryptography::HashResult& connectionId = serverBinding->connectionId;
 
 		constexpr size_t BufferSize = SecondMessagePreludeSize + DHLEN + DHLEN + DHLEN + CipherAuthDataSize;
 		Cryptography::ByteSequence<Cryptography::ByteSequenceTag::TempInternalBuffer, BufferSize> buffer;
@@ -48,7 +48,7 @@ namespace Requests
 
 			Serialization::writeUint16(buffer.raw[0], buffer.raw[1], Protocol::NetworkProtocolVersion);
 			buffer.raw[2] = static_cast<std::byte>(Protocol::RequestId::SendFiles);
-			static_assert(buffer.raw.size() >= connectionId.size() + 3);
+			static_assert(buffer.raw.size() >= Cryptography::HASHLEN + 3);
 			std::copy(connectionId.raw.begin(), connectionId.raw.end(), buffer.raw.begin() + 3);
 			cursor += FirstMessagePreludeSize;
 
@@ -121,6 +121,7 @@ namespace Requests
 				{
 					outSendingCipherState = std::move(std::get<NoiseKK::HandshakeResult>(result).sendingCipherState);
 					outReceivingCipherState = std::move(std::get<NoiseKK::HandshakeResult>(result).receivingCipherState);
+					outResumptionSecret = std::move(std::get<NoiseKK::HandshakeResult>(result).resumptionSecret);
 					return true;
 				}
 			}
@@ -128,35 +129,251 @@ namespace Requests
 		return false;
 	}
 
-	RequestAnswers::RequestAnswer sendAndProcessSendFilesInteractiveRequest(Network::RawSocket socket, ClientStorage& storage, const std::filesystem::path& localDataPath, const std::array<std::byte, 16>& serverId, const std::vector<std::filesystem::path>& files, const std::vector<uint64_t>& previouslySentBytes, const std::filesystem::path& commonRoot) noexcept
+	static uint64_t getCurrentTime() noexcept
+	{
+		return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count());
+	}
+
+	static std::optional<Protocol::SessionParameters::Parameters> receiveChosenSessionParameters(Network::RawSocket socket, const Protocol::SessionParameters::Parameters& offeredParameters, Noise::CipherStateReceiving& receivingCipherState) noexcept
+	{
+		constexpr size_t MessageSize = Protocol::SessionParameters::MessageSize;
+		Cryptography::ByteSequence<Cryptography::ByteSequenceTag::TempInternalBuffer, Protocol::SessionParameters::MaxMessageSize + Cryptography::CipherAuthDataSize> buffer;
+
+		size_t receivedBytes = 0;
+		if (auto result = Network::recvEncrypted(socket, buffer, receivedBytes, receivingCipherState); result.has_value())
+		{
+			reportDebugError("Could not receive the chosen session parameters: {}", *result);
+			return std::nullopt;
+		}
+
+		if (receivedBytes < MessageSize)
+		{
+			reportDebugError("Unexpected size of the chosen session parameters message {}", receivedBytes);
+			return std::nullopt;
+		}
+
+		const Protocol::SessionParameters::Parameters chosenParameters = Protocol::SessionParameters::read(std::span<const std::byte, MessageSize>(buffer.raw.data(), MessageSize));
+
+		if (!Protocol::SessionParameters::isValidChoice(offeredParameters, chosenParameters))
+		{
+			reportDebugError("The server answered with session parameters that we didn't offer");
+			return std::nullopt;
+		}
+
+		return chosenParameters;
+	}
+
+	// see Protocol::SessionParameters for the description of the negotiation
+	static std::optional<Protocol::SessionParameters::Parameters> negotiateSessionParameters(Network::RawSocket socket, const Protocol::SessionParameters::Parameters& offeredParameters, Noise::CipherStateSending& sendingCipherState, Noise::CipherStateReceiving& receivingCipherState) noexcept
+	{
+		constexpr size_t MessageSize = Protocol::SessionParameters::MessageSize;
+		Cryptography::ByteSequence<Cryptography::ByteSequenceTag::TempInternalBuffer, MessageSize + Cryptography::CipherAuthDataSize> buffer;
+
+		Protocol::SessionParameters::write(std::span<std::byte, MessageSize>(buffer.raw.data(), MessageSize), offeredParameters);
+
+		if (auto result = Network::sendEncrypted(socket, buffer, MessageSize, sendingCipherState); result.has_value())
+		{
+			reportDebugError("Could not send our session parameters: {}", *result);
+			return std::nullopt;
+		}
+
+		return receiveChosenSessionParameters(socket, offeredParameters, receivingCipherState);
+	}
+
+	static bool setFileTransferTimeouts(Network::RawSocket socket) noexcept
 	{
 		constexpr const int FileTransferMessagesTimeoutSeconds = 20;
 		constexpr const int FileTransferMessagesTimeoutMicroseconds = 0;
 
+		if (const auto result = Network::setSocketTimeout(socket, SO_RCVTIMEO, FileTransferMessagesTimeoutSeconds, FileTransferMessagesTimeoutMicroseconds); result.has_value())
+		{
+			reportDebugError("Could not set SO_RCVTIMEO to a connection socket: {}", *result);
+			return false;
+		}
+
+		if (const auto result = Network::setSocketTimeout(socket, SO_SNDTIMEO, FileTransferMessagesTimeoutSeconds, FileTransferMessagesTimeoutMicroseconds); result.has_value())
+		{
+			reportDebugError("Could not set SO_SNDTIMEO to a connection socket: {}", *result);
+			return false;
+		}
+
+		return true;
+	}
+
+	struct EstablishedSession
+	{
 		Noise::CipherStateSending sendingCipherState;
 		Noise::CipherStateReceiving receivingCipherState;
-		if (!processKkHandshake(socket, storage, serverId, sendingCipherState, receivingCipherState))
+		Protocol::SessionParameters::Parameters parameters;
+		Cryptography::HashResult resumptionSecret;
+	};
+
+	enum class ResumeAttemptResult
+	{
+		Resumed,
+		// we didn't have a valid ticket, or the server rejected it, the connection can be used for the full handshake
+		NotResumed,
+		Failed,
+	};
+
+	// see Protocol::Resumption for the description
+	static ResumeAttemptResult tryResumeSession(Network::RawSocket socket, ClientStorage& storage, const std::array<std::byte, 16>& serverId, const Protocol::SessionParameters::Parameters& offeredParameters, EstablishedSession& outSession) noexcept
+	{
+		using namespace Noise::Resumption;
+
+		std::optional<ClientStorageData::ResumptionTicket> ticket = storage.takeResumptionTicket(serverId);
+		if (!ticket.has_value() || ticket->expirationTime <= getCurrentTime())
+		{
+			return ResumeAttemptResult::NotResumed;
+		}
+
+		constexpr size_t MessagePreludeSize = sizeof(Protocol::NetworkProtocolVersion) + sizeof(Protocol::RequestId);
+		std::array<std::byte, MessagePreludeSize + Protocol::Resumption::FirstMessageSize> message;
+		Serialization::writeUint16(message[0], message[1], Protocol::NetworkProtocolVersion);
+		message[2] = static_cast<std::byte>(Protocol::RequestId::ResumeSendFiles);
+		std::copy(ticket->ticket.begin(), ticket->ticket.end(), message.begin() + MessagePreludeSize);
+		const std::span<std::byte> clientNonce(message.data() + MessagePreludeSize + TicketSize, RandomNonceSize);
+		Cryptography::fillWithRandomBytes(clientNonce);
+		Protocol::SessionParameters::write(std::span<std::byte, Protocol::SessionParameters::MessageSize>(message.data() + MessagePreludeSize + TicketSize + RandomNonceSize, Protocol::SessionParameters::MessageSize), offeredParameters);
+
+		if (auto result = Network::send(socket, message); result.has_value())
+		{
+			reportDebugError("Could not send ResumeSendFiles request: {}", *result);
+			return ResumeAttemptResult::Failed;
+		}
+
+		std::array<std::byte, sizeof(Protocol::RequestAnswerId) + sizeof(Protocol::Resumption::ResumeStatus)> answerPrelude;
+		size_t readBytes = 0;
+		if (auto result = Network::recv(socket, answerPrelude, answerPrelude.size(), readBytes); result.has_value())
+		{
+			reportDebugError("Could not recv the answer to ResumeSendFiles request: {}", *result);
+			return ResumeAttemptResult::Failed;
+		}
+
+		if (answerPrelude[0] != static_cast<std::byte>(Protocol::RequestAnswerId::ResumeSendFiles))
+		{
+			reportDebugError("Unexpected answer to ResumeSendFiles request {}", static_cast<uint8_t>(answerPrelude[0]));
+			return ResumeAttemptResult::Failed;
+		}
+
+		if (answerPrelude[1] != static_cast<std::byte>(Protocol::Resumption::ResumeStatus::Accepted))
+		{
+			Debug::Log::printDebug("The server rejected the resumption ticket, falling back to the full handshake");
+			return ResumeAttemptResult::NotResumed;
+		}
+
+		RandomNonce serverNonce;
+		if (auto result = Network::recv(socket, serverNonce, serverNonce.size(), readBytes); result.has_value())
+		{
+			reportDebugError("Could not recv the server nonce: {}", *result);
+			return ResumeAttemptResult::Failed;
+		}
+
+		ResumedSession session = deriveResumedSession(ticket->resumptionSecret, std::span(message.data() + MessagePreludeSize, Protocol::Resumption::FirstMessageSize), serverNonce, SessionRole::Client);
+
+		if (!setFileTransferTimeouts(socket))
+		{
+			return ResumeAttemptResult::Failed;
+		}
+
+		// failing to decrypt this message means that the server doesn't know the resumption secret or the request was modified
+		std::optional<Protocol::SessionParameters::Parameters> sessionParameters = receiveChosenSessionParameters(socket, offeredParameters, session.receivingCipherState);
+		if (!sessionParameters.has_value())
+		{
+			return ResumeAttemptResult::Failed;
+		}
+
+		outSession.sendingCipherState = std::move(session.sendingCipherState);
+		outSession.receivingCipherState = std::move(session.receivingCipherState);
+		outSession.parameters = *sessionParameters;
+		outSession.resumptionSecret = std::move(session.nextResumptionSecret);
+		return ResumeAttemptResult::Resumed;
+	}
+
+	static bool establishFullSession(Network::RawSocket socket, ClientStorage& storage, const std::array<std::byte, 16>& serverId, const Protocol::SessionParameters::Parameters& offeredParameters, EstablishedSession& outSession) noexcept
+	{
+		if (!processKkHandshake(socket, storage, serverId, outSession.sendingCipherState, outSession.receivingCipherState, outSession.resumptionSecret))
 		{
 			reportDebugError("Failed to process KK handshake");
-			return RequestAnswers::ErrorNoHandling{};
+			return false;
 		}
 
 		// increase the timeouts for the rest of the handshake
-		if (const auto result = Network::setSocketTimeout(socket, SO_RCVTIMEO, FileTransferMessagesTimeoutSeconds, FileTransferMessagesTimeoutMicroseconds); result.has_value())
+		if (!setFileTransferTimeouts(socket))
 		{
-			reportDebugError("Could not set SO_RCVTIMEO to a connection socket: {}", *result);
-			return RequestAnswers::ErrorNoHandling{};
+			return false;
 		}
 
-		if (const auto result = Network::setSocketTimeout(socket, SO_SNDTIMEO, FileTransferMessagesTimeoutSeconds, FileTransferMessagesTimeoutMicroseconds); result.has_value())
+		std::optional<Protocol::SessionParameters::Parameters> sessionParameters = negotiateSessionParameters(socket, offeredParameters, outSession.sendingCipherState, outSession.receivingCipherState);
+		if (!sessionParameters.has_value())
+		{
+			return false;
+		}
+
+		outSession.parameters = *sessionParameters;
+		return true;
+	}
+
+	// see Protocol::Resumption for the description
+	static bool receiveResumptionTicket(Network::RawSocket socket, ClientStorage& storage, const std::array<std::byte, 16>& serverId, EstablishedSession& session) noexcept
+	{
+		constexpr size_t MessageSize = Protocol::Resumption::TicketMessageSize;
+		Cryptography::ByteSequence<Cryptography::ByteSequenceTag::TempInternalBuffer, MessageSize + Cryptography::CipherAuthDataSize> buffer;
+
+		size_t receivedBytes = 0;
+		if (auto result = Network::recvEncrypted(socket, buffer, receivedBytes, session.receivingCipherState); result.has_value())
+		{
+			reportDebugError("Could not receive the resumption ticket: {}", *result);
+			return false;
+		}
+
+		if (receivedBytes != MessageSize)
+		{
+			reportDebugError("Unexpected size of the resumption ticket message {}", receivedBytes);
+			return false;
+		}
+
+		ClientStorageData::ResumptionTicket ticket{
+			.ticket = {},
+			.resumptionSecret = std::move(session.resumptionSecret),
+			.expirationTime = getCurrentTime() + Serialization::readUint64(std::span(buffer.raw.data() + Noise::Resumption::TicketSize, sizeof(uint64_t))),
+		};
+		std::copy(buffer.raw.begin(), buffer.raw.begin() + Noise::Resumption::TicketSize, ticket.ticket.begin());
+
+		storage.storeResumptionTicket(serverId, ticket);
+		return true;
+	}
+
+	RequestAnswers::RequestAnswer sendAndProcessSendFilesInteractiveRequest(Network::RawSocket socket, ClientStorage& storage, const std::filesystem::path& localDataPath, const std::array<std::byte, 16>& serverId, const std::vector<std::filesystem::path>& files, const std::vector<uint64_t>& previouslySentBytes, const std::filesystem::path& commonRoot) noexcept
+	{
+		const Protocol::SessionParameters::Parameters offeredParameters = Protocol::SessionParameters::getSupported();
+
+		EstablishedSession session;
+		const ResumeAttemptResult resumeResult = tryResumeSession(socket, storage, serverId, offeredParameters, session);
+		if (resumeResult == ResumeAttemptResult::Failed)
 		{
-			reportDebugError("Could not set SO_SNDTIMEO to a connection socket: {}", *result);
 			return RequestAnswers::ErrorNoHandling{};
 		}
 
+		if (resumeResult == ResumeAttemptResult::NotResumed)
+		{
+			if (!establishFullSession(socket, storage, serverId, offeredParameters, session))
+			{
+				return RequestAnswers::ErrorNoHandling{};
+			}
+		}
+
+		if ((session.parameters.features & Protocol::SessionParameters::Features::ResumptionTickets) != 0)
+		{
+			if (!receiveResumptionTicket(socket, storage, serverId, session))
+			{
+				return RequestAnswers::ErrorNoHandling{};
+			}
+		}
+
 		Debug::Log::printDebug("Start sending files");
 
-		FileSendUtils::sendFiles(files, previouslySentBytes, commonRoot, socket, storage, localDataPath, sendingCipherState, receivingCipherState);
+		FileSendUtils::sendFiles(files, previouslySentBytes, commonRoot, socket, storage, localDataPath, session.sendingCipherState, session.receivingCipherState, session.parameters.rekeyPolicy);
 
 		return Protocol::RequestAnswers::SendFiles{};
 	}
@@ -3,12 +3,15 @@
 
 #include "client_shared/test_full_file_backup.h"
 
+#include <algorithm>
 #include <format>
 
+#include "common_shared/cryptography/noise/noise_kk_handshake.h"
 #include "common_shared/cryptography/utils/connection_id_utils.h"
 #include "common_shared/cryptography/utils/short_authentification_string_utils.h"
 #include "common_shared/debug/assert.h"
 #include "common_shared/debug/log.h"
+#include "common_shared/network/protocol.h"
 #include "common_shared/nsd/nsd_client.h"
 #include "common_shared/template_utils.h"
 
@@ -29,15 +32,29 @@ TestFullFileBackup::TestFullFileBackup(const std::filesystem::path& localDataPat
 {
 }
 
-void TestFullFileBackup::startDiscovery() noexcept
+TestFullFileBackup::~TestFullFileBackup() noexcept
 {
-	mDiscoveryThread = std::thread([&servers = mDiscoveredServers, &mutex = mDataMutex, &nsdStopFlag = mNsdStopFlag] {
+	if (mEndpointProbeThread.joinable())
+	{
+		mEndpointProbeThread.join();
+	}
+}
+
+void TestFullFileBackup::startDiscovery(DiscoveryCallback callback) noexcept
+{
+	{
+		std::unique_lock lock(mDataMutex);
+		mDiscoveryCallback = std::move(callback);
+	}
+
+	mDiscoveryThread = std::thread([this] {
 		std::optional<std::string> result = NsdClient::processServiceDiscoveryThread(
 			"_easy-photo-backup._tcp",
-			5354,
+			Protocol::Discovery::QueryPort,
+			Protocol::Discovery::AnnouncementPort,
 			Network::AddressType::IpV4,
 			1,
-			[&servers, &mutex](auto&& event) {
+			[this](auto&& event) {
 				if (event.state == NsdClient::DiscoveryState::Added)
 				{
 					int version = -1;
@@ -54,41 +71,23 @@ void TestFullFileBackup::startDiscovery() noexcept
 					}
 
 					Debug::Log::printDebug("NSD: Server added v={}, id='{}', ip='{}', port='{}'", version, idString, event.address.ip, event.address.port);
+
+					// the extra data comes from the network unauthenticated, anything but the expected size is ignored
+					std::array<std::byte, 16> serverId{};
+					if (event.extraData.size() == 2 + serverId.size())
 					{
-						std::unique_lock lock(mutex);
-						std::array<std::byte, 16> serverId{};
-						if (event.extraData.size() >= 16 + 2)
-						{
-							std::copy(event.extraData.begin() + 2, event.extraData.end(), serverId.begin());
-						}
-
-						servers.emplace_back(
-							event.address,
-							serverId
-						);
+						std::copy_n(event.extraData.begin() + 2, serverId.size(), serverId.begin());
 					}
+
+					onServerAdded(TestServerInfo{ event.address, serverId }, DiscoverySource::Nsd);
 				}
 				else
 				{
 					Debug::Log::printDebug("NSD: Server removed");
-					{
-						std::unique_lock lock(mutex);
-						auto it = std::find_if(
-							servers.begin(),
-							servers.end(),
-							[&event](const TestServerInfo& item) {
-								return item.address.ip == event.address.ip;
-							}
-						);
-
-						if (it != servers.end())
-						{
-							servers.erase(it);
-						}
-					}
+					onServerRemoved(event.address);
 				}
 			},
-			nsdStopFlag
+			mNsdStopFlag
 		);
 
 		if (result.has_value())
@@ -108,24 +107,176 @@ std::vector<TestServerInfo> TestFullFileBackup::getDiscoveryResults() noexcept
 	return mDiscoveredServers;
 }
 
+std::optional<TestServerInfo> TestFullFileBackup::waitForAnyServer(const std::chrono::milliseconds timeout) noexcept
+{
+	std::unique_lock lock(mDataMutex);
+	if (!mDiscoveryCondition.wait_for(lock, timeout, [this] { return !mDiscoveredServers.empty(); }))
+	{
+		return std::nullopt;
+	}
+
+	return mDiscoveredServers.front();
+}
+
+std::optional<TestServerInfo> TestFullFileBackup::findPairedServer(const std::array<std::byte, 16>& serverId, const std::chrono::milliseconds timeout) noexcept
+{
+	const std::optional<Network::NetworkAddress> cachedEndpoint = mClientStorage.getServerEndpoint(serverId);
+	if (cachedEndpoint.has_value())
+	{
+		if (mEndpointProbeThread.joinable())
+		{
+			mEndpointProbeThread.join();
+		}
+
+		mEndpointProbeThread = std::thread([this, address = *cachedEndpoint, serverId] {
+			probeCachedEndpoint(address, serverId);
+		});
+	}
+
+	std::optional<TestServerInfo> result;
+	{
+		std::unique_lock lock(mDataMutex);
+		mDiscoveryCondition.wait_for(lock, timeout, [this, &serverId, &result] {
+			auto it = std::find_if(mDiscoveredServers.begin(), mDiscoveredServers.end(), [&serverId](const TestServerInfo& item) {
+				return item.serverId == serverId;
+			});
+
+			if (it == mDiscoveredServers.end())
+			{
+				return false;
+			}
+
+			result = *it;
+			return true;
+		});
+	}
+
+	// remember where the server is now, so the next time we can skip waiting for NSD
+	if (result.has_value() && (!cachedEndpoint.has_value() || cachedEndpoint->toString() != result->address.toString()))
+	{
+		mClientStorage.storeServerEndpoint(serverId, result->address);
+	}
+
+	return result;
+}
+
 void TestFullFileBackup::stopDiscovery() noexcept
 {
 	mNsdStopFlag.store(true, std::memory_order::release);
-	mDiscoveredServers.clear();
 	mDiscoveryThread.join();
 	mNsdStopFlag.store(false, std::memory_order::relaxed);
+
+	if (mEndpointProbeThread.joinable())
+	{
+		mEndpointProbeThread.join();
+	}
+
+	std::unique_lock lock(mDataMutex);
+	mDiscoveredServers.clear();
+	mDiscoveryCallback = nullptr;
+}
+
+void TestFullFileBackup::onServerAdded(TestServerInfo&& serverInfo, const DiscoverySource source) noexcept
+{
+	DiscoveryCallback callback;
+	{
+		std::unique_lock lock(mDataMutex);
+		const bool isKnown = std::any_of(mDiscoveredServers.begin(), mDiscoveredServers.end(), [&serverInfo](const TestServerInfo& item) {
+			return item.serverId == serverInfo.serverId && item.address.toString() == serverInfo.address.toString();
+		});
+
+		// the cached endpoint and NSD can find the same server
+		if (isKnown)
+		{
+			return;
+		}
+
+		mDiscoveredServers.push_back(serverInfo);
+		callback = mDiscoveryCallback;
+	}
+	mDiscoveryCondition.notify_all();
+
+	if (callback)
+	{
+		callback(DiscoveryEvent{ std::move(serverInfo), NsdClient::DiscoveryState::Added, source });
+	}
+}
+
+void TestFullFileBackup::onServerRemoved(const Network::NetworkAddress& address) noexcept
+{
+	DiscoveryCallback callback;
+	std::optional<TestServerInfo> removedServer;
+	{
+		std::unique_lock lock(mDataMutex);
+		auto it = std::find_if(
+			mDiscoveredServers.begin(),
+			mDiscoveredServers.end(),
+			// several servers can run on the same host
+			[&address](const TestServerInfo& item) {
+				return item.address.ip == address.ip && item.address.port == address.port;
+			}
+		);
+
+		if (it == mDiscoveredServers.end())
+		{
+			return;
+		}
+
+		removedServer = std::move(*it);
+		mDiscoveredServers.erase(it);
+		callback = mDiscoveryCallback;
+	}
+
+	if (callback)
+	{
+		callback(DiscoveryEvent{ std::move(*removedServer), NsdClient::DiscoveryState::Removed, DiscoverySource::Nsd });
+	}
+}
+
+void TestFullFileBackup::probeCachedEndpoint(const Network::NetworkAddress& address, const std::array<std::byte, 16>& serverId) noexcept
+{
+	RequestAnswers::RequestAnswer helloAnswer = Requests::sendAndProcessRequest(address.ip.c_str(), address.addressType, address.port, Requests::Hello{});
+
+	RequestAnswers::Hello* hello = std::get_if<RequestAnswers::Hello>(&helloAnswer);
+	if (hello == nullptr)
+	{
+		Debug::Log::printDebug("The cached endpoint {} is not reachable", address.toString());
+		return;
+	}
+
+	// the address could have been given to another device, or another server could be running there
+	if (hello->serverId != serverId)
+	{
+		Debug::Log::printDebug("The cached endpoint {} belongs to a different server now", address.toString());
+		return;
+	}
+
+	Debug::Log::printDebug("Reached the server at the cached endpoint {}", address.toString());
+	onServerAdded(TestServerInfo{ address, serverId }, DiscoverySource::CachedEndpoint);
 }
 
 std::optional<std::string> TestFullFileBackup::requestServerName(const Network::NetworkAddress& address) noexcept
 {
-	RequestAnswers::RequestAnswer nameAnswer = Requests::sendAndProcessRequest(address.ip.data(), address.addressType, address.port, Requests::GetServerName{});
+	ControlConnection* controlConnection = nullptr;
+	{
+		std::unique_lock lock(mDataMutex);
+		std::unique_ptr<ControlConnection>& connection = mControlConnections[address.toString()];
+		if (connection == nullptr)
+		{
+			connection = std::make_unique<ControlConnection>(address);
+		}
+		controlConnection = connection.get();
+	}
+
+	// Hello gives us the name together with the rest of the server information in one round trip
+	RequestAnswers::RequestAnswer helloAnswer = controlConnection->sendAndProcessRequest(Requests::Hello{});
 
 	std::optional<std::string> serverName;
 	std::visit(
 		VisitLambda{
-			[&serverName](RequestAnswers::GetServerName&& getServerName) {
-				serverName = getServerName.serverName;
-				Debug::Log::printDebug(getServerName.serverName);
+			[&serverName](RequestAnswers::Hello&& hello) {
+				serverName = hello.serverName;
+				Debug::Log::printDebug("{} (protocol version {}, capabilities {:#x})", hello.serverName, hello.protocolVersion, hello.capabilities);
 			},
 			[](RequestAnswers::UnsupportedProtocolVersion&& unsupportedProtocolVersion) {
 				Debug::Log::printDebug("The server rejected our protocol version, expected version {}", unsupportedProtocolVersion.firstSupportedProtocolVersion);
@@ -140,7 +291,7 @@ std::optional<std::string> TestFullFileBackup::requestServerName(const Network::
 				Debug::Log::printDebug("logical error, unexpected answer");
 			},
 		},
-		std::move(nameAnswer)
+		std::move(helloAnswer)
 	);
 
 	return serverName;
@@ -199,9 +350,12 @@ std::optional<std::string> TestFullFileBackup::approveServer(const TestServerInf
 			.connectionId = Cryptography::generateConnectionId(serverBindingInfo.staticKeys.publicKey, serverBindingInfo.remoteStaticKey),
 			.remoteStaticKey = serverBindingInfo.remoteStaticKey.clone(),
 			.staticKeys = serverBindingInfo.staticKeys.clone(),
+			.staticStaticDh = Noise::NoiseKK::computeStaticStaticDh(serverBindingInfo.staticKeys, serverBindingInfo.remoteStaticKey),
 		}
 	);
 
+	mClientStorage.storeServerEndpoint(serverInfo.serverId, serverInfo.address);
+
 	Debug::Log::printDebug("The server got automatically approved for testing purposes");
 
 	return std::nullopt;
@@ -260,3 +414,8 @@ bool TestFullFileBackup::isServerPaired(const std::array<std::byte, 16>& serverI
 {
 	return mClientStorage.hasConfirmedServerBinding(serverId);
 }
+
+std::vector<std::array<std::byte, 16>> TestFullFileBackup::getPairedServerIds() noexcept
+{
+	return mClientStorage.getConfirmedServerIds();
+}
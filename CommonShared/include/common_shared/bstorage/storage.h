@@ -7,9 +7,31 @@
 #include <optional>
 
 #include "common_shared/bstorage/value.h"
+#include "common_shared/bstorage/value_view.h"
+#include "common_shared/files/mapped_file.h"
 
 namespace BStorage
 {
+	// keeps the file mapped for as long as the views into it are used
+	class StorageView
+	{
+	public:
+		[[nodiscard]] const ValueView& getRoot() const noexcept { return mRoot; }
+		[[nodiscard]] uint16_t getVersion() const noexcept { return mVersion; }
+
+	private:
+		friend std::optional<StorageView> loadStorageView(const std::filesystem::path& filePath) noexcept;
+		StorageView(Files::MappedFile&& file, ValueView root, uint16_t version) noexcept;
+
+	private:
+		Files::MappedFile mFile;
+		ValueView mRoot;
+		uint16_t mVersion;
+	};
+
 	[[nodiscard]] std::optional<std::tuple<Value, uint16_t>> loadStorage(const std::filesystem::path& filePath) noexcept;
+	// maps the file and validates it without building a Value tree
+	[[nodiscard]] std::optional<StorageView> loadStorageView(const std::filesystem::path& filePath) noexcept;
+	// the file is replaced atomically, a failed or interrupted save keeps the previous content
 	[[nodiscard]] bool saveStorage(const std::filesystem::path& filePath, const Value& storage, uint16_t version) noexcept;
 }
@@ -0,0 +1,37 @@
+// Copyright (C) Pavel Grebnev 2026
+// Distributed under the MIT License (license terms are at http://opensource.org/licenses/MIT).
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace BStorage::Internal
+{
+	enum class TagBits : uint8_t
+	{
+		DynamicUnknown = 0x00,
+
+		// fixed size
+		U8 = 0x10,
+		U16 = 0x20,
+		U32 = 0x30,
+		U64 = 0x40,
+
+		// variable size
+		String = 0x01,
+		ByteArray = 0x11,
+
+		// compound, recursive
+		OptionNull = 0x02,
+		OptionSet = 0x12,
+
+		ArrayEmpty = 0x03,
+		ArrayVariableTypes = 0x13,
+		ArraySameType = 0x23, // does not repeat the type for each element
+
+		Object = 0x04,
+	};
+
+	constexpr size_t MaxContainerSize = 0x3FFFFFFF;
+} // namespace BStorage::Internal
@@ -5,11 +5,13 @@
 #include <cstdint>
 #include <istream>
 #include <memory>
+#include <memory_resource>
 #include <optional>
 #include <ostream>
 #include <span>
 #include <string>
-#include <unordered_map>
+#include <string_view>
+#include <utility>
 #include <vector>
 
 namespace BStorage
@@ -27,39 +29,93 @@ namespace BStorage
 		Object,
 	};
 
-	struct string_hash
+	/**
+	 * Owns the memory of whole Value trees, values created with its resource are freed all together
+	 * when the arena is destroyed, so it should outlive all these values.
+	 * Not thread-safe.
+	 */
+	class Arena
 	{
-		using is_transparent = void;
-		[[nodiscard]] size_t operator()(const char* txt) const
-		{
-			return std::hash<std::string_view>{}(txt);
-		}
-		[[nodiscard]] size_t operator()(std::string_view txt) const
-		{
-			return std::hash<std::string_view>{}(txt);
-		}
-		[[nodiscard]] size_t operator()(const std::string& txt) const
-		{
-			return std::hash<std::string>{}(txt);
-		}
+	public:
+		explicit Arena(size_t initialBufferSize = 4096) noexcept;
+
+		Arena(const Arena&) = delete;
+		Arena& operator=(const Arena&) = delete;
+		Arena(Arena&&) = delete;
+		Arena& operator=(Arena&&) = delete;
+		~Arena() noexcept = default;
+
+		[[nodiscard]] std::pmr::memory_resource* getResource() noexcept { return &mResource; }
+
+	private:
+		std::pmr::monotonic_buffer_resource mResource;
 	};
 
 	class Value
 	{
 	public:
-		using ObjectMap = std::unordered_map<std::string, Value, string_hash, std::equal_to<>>;
+		using StringType = std::pmr::string;
+		using ByteArrayType = std::pmr::vector<std::byte>;
+		using ArrayType = std::pmr::vector<Value>;
+
+		struct OptionDeleter
+		{
+			std::pmr::memory_resource* resource;
+			void operator()(Value* value) const noexcept;
+		};
+		using OptionType = std::unique_ptr<Value, OptionDeleter>;
+
+		// flat map sorted by key, objects are small records that are usually filled in sorted order
+		class ObjectMap
+		{
+		public:
+			using value_type = std::pair<StringType, Value>;
+			using EntriesType = std::pmr::vector<value_type>;
+			using iterator = EntriesType::iterator;
+			using const_iterator = EntriesType::const_iterator;
+
+		public:
+			ObjectMap() noexcept = default;
+			explicit ObjectMap(std::pmr::memory_resource* resource) noexcept;
+
+			// keeps the old value if the key already exists, same as std::map
+			std::pair<iterator, bool> emplace(std::string_view key, Value&& value) noexcept;
+
+			[[nodiscard]] iterator find(std::string_view key) noexcept;
+			[[nodiscard]] const_iterator find(std::string_view key) const noexcept;
+			[[nodiscard]] bool contains(std::string_view key) const noexcept;
+			// the key must exist
+			[[nodiscard]] Value& at(std::string_view key) noexcept;
+			[[nodiscard]] const Value& at(std::string_view key) const noexcept;
+
+			[[nodiscard]] size_t size() const noexcept { return mEntries.size(); }
+			[[nodiscard]] bool empty() const noexcept { return mEntries.empty(); }
+			void reserve(size_t size) noexcept { mEntries.reserve(size); }
+
+			[[nodiscard]] iterator begin() noexcept { return mEntries.begin(); }
+			[[nodiscard]] iterator end() noexcept { return mEntries.end(); }
+			[[nodiscard]] const_iterator begin() const noexcept { return mEntries.begin(); }
+			[[nodiscard]] const_iterator end() const noexcept { return mEntries.end(); }
+
+			[[nodiscard]] std::pmr::memory_resource* getResource() const noexcept { return mEntries.get_allocator().resource(); }
+
+		private:
+			EntriesType mEntries;
+		};
 
 	public:
+		// values that own memory take it from the provided resource (e.g. Arena::getResource())
 		[[nodiscard]] static Value makeU8(uint8_t v) noexcept;
 		[[nodiscard]] static Value makeU16(uint16_t v) noexcept;
 		[[nodiscard]] static Value makeU32(uint32_t v) noexcept;
 		[[nodiscard]] static Value makeU64(uint64_t v) noexcept;
-		[[nodiscard]] static Value makeString(std::string_view v) noexcept;
-		[[nodiscard]] static Value makeString(std::string&& v) noexcept;
-		[[nodiscard]] static Value makeByteArray(std::span<const std::byte> v) noexcept;
-		[[nodiscard]] static Value makeByteArray(std::vector<std::byte>&& v) noexcept;
-		[[nodiscard]] static Value makeOption(std::unique_ptr<Value>&& v) noexcept;
-		[[nodiscard]] static Value makeArray(std::vector<Value>&& v) noexcept;
+		[[nodiscard]] static Value makeString(std::string_view v, std::pmr::memory_resource* resource = std::pmr::get_default_resource()) noexcept;
+		[[nodiscard]] static Value makeString(StringType&& v) noexcept;
+		[[nodiscard]] static Value makeByteArray(std::span<const std::byte> v, std::pmr::memory_resource* resource = std::pmr::get_default_resource()) noexcept;
+		[[nodiscard]] static Value makeByteArray(ByteArrayType&& v) noexcept;
+		[[nodiscard]] static Value makeOption(Value&& v, std::pmr::memory_resource* resource = std::pmr::get_default_resource()) noexcept;
+		[[nodiscard]] static Value makeEmptyOption() noexcept;
+		[[nodiscard]] static Value makeArray(ArrayType&& v) noexcept;
 		[[nodiscard]] static Value makeObject(ObjectMap&& v) noexcept;
 
 		bool isA(Tag tag) const { return mTag == tag; }
@@ -72,29 +128,33 @@ namespace BStorage
 		const uint32_t* asU32() const noexcept;
 		uint64_t* asU64() noexcept;
 		const uint64_t* asU64() const noexcept;
-		std::string* asString() noexcept;
-		const std::string* asString() const noexcept;
-		std::vector<std::byte>* asByteArray() noexcept;
-		const std::vector<std::byte>* asByteArray() const noexcept;
-		std::unique_ptr<Value>* asOption() noexcept;
-		const std::unique_ptr<Value>* asOption() const noexcept;
-		std::vector<Value>* asArray() noexcept;
-		const std::vector<Value>* asArray() const noexcept;
+		StringType* asString() noexcept;
+		const StringType* asString() const noexcept;
+		ByteArrayType* asByteArray() noexcept;
+		const ByteArrayType* asByteArray() const noexcept;
+		OptionType* asOption() noexcept;
+		const OptionType* asOption() const noexcept;
+		ArrayType* asArray() noexcept;
+		const ArrayType* asArray() const noexcept;
 		ObjectMap* asObject() noexcept;
 		const ObjectMap* asObject() const noexcept;
 
-		// sure, these are not the most optimal, but it should do for now
 		[[nodiscard]] bool writeToStream(std::ostream& outputStream, bool skipTag = false) const noexcept;
-		[[nodiscard]] static std::optional<Value> readFromStream(std::istream& inputStream, std::optional<uint8_t> forcedTag = {}) noexcept;
+		// exact size of the data written by writeToBuffer, nullopt if the value can't be serialized
+		[[nodiscard]] std::optional<size_t> getSerializedSize() const noexcept;
+		// the buffer should have exactly getSerializedSize() bytes
+		[[nodiscard]] bool writeToBuffer(std::span<std::byte> buffer) const noexcept;
+		// sure, this is not the most optimal, but it should do for now
+		[[nodiscard]] static std::optional<Value> readFromStream(std::istream& inputStream, std::optional<uint8_t> forcedTag = {}, std::pmr::memory_resource* resource = std::pmr::get_default_resource()) noexcept;
 
 		[[nodiscard]] bool isSameDeepCompare(const Value& other) const noexcept;
 
-		[[nodiscard]] Value deepCopy() const noexcept;
+		[[nodiscard]] Value deepCopy(std::pmr::memory_resource* resource = std::pmr::get_default_resource()) const noexcept;
 
 		Value(const Value&) noexcept = delete;
 		Value& operator=(const Value&) noexcept = delete;
 		Value(Value&&) noexcept;
-		Value& operator=(Value&&) noexcept = delete;
+		Value& operator=(Value&& v) noexcept;
 		~Value() noexcept;
 
 	private:
@@ -104,10 +164,10 @@ namespace BStorage
 			uint16_t U16;
 			uint32_t U32;
 			uint64_t U64;
-			std::string String;
-			std::vector<std::byte> ByteArray;
-			std::unique_ptr<Value> Option;
-			std::vector<Value> Array;
+			StringType String;
+			ByteArrayType ByteArray;
+			OptionType Option;
+			ArrayType Array;
 			ObjectMap Object;
 
 			Storage() noexcept;
@@ -121,6 +181,9 @@ namespace BStorage
 	private:
 		Value(Tag tag);
 
+		template<typename Writer>
+		[[nodiscard]] bool writeTo(Writer& writer, bool skipTag) const noexcept;
+
 	private:
 		Tag mTag;
 		Storage mStorage;
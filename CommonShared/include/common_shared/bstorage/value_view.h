@@ -0,0 +1,154 @@
+// Copyright (C) Pavel Grebnev 2026
+// Distributed under the MIT License (license terms are at http://opensource.org/licenses/MIT).
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory_resource>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <utility>
+
+#include "common_shared/bstorage/value.h"
+
+namespace BStorage
+{
+	/**
+	 * Read-only view of a serialized Value, doesn't own or copy the data.
+	 * The whole buffer is validated once in parse(), after that the navigation doesn't do bounds checks.
+	 * Strings and byte arrays point into the buffer, so the buffer should outlive all the views.
+	 */
+	class ValueView
+	{
+	public:
+		class ArrayIterator
+		{
+		public:
+			using iterator_category = std::input_iterator_tag;
+			using value_type = ValueView;
+			using difference_type = std::ptrdiff_t;
+			using pointer = void;
+			using reference = ValueView;
+
+		public:
+			ValueView operator*() const noexcept;
+			ArrayIterator& operator++() noexcept;
+			ArrayIterator operator++(int) noexcept
+			{
+				ArrayIterator previous = *this;
+				++*this;
+				return previous;
+			}
+			bool operator==(const ArrayIterator& other) const noexcept { return mRemainingCount == other.mRemainingCount; }
+
+		private:
+			friend class ValueView;
+			ArrayIterator(const std::byte* position, size_t remainingCount, uint8_t sameTypeTagBits) noexcept;
+
+		private:
+			const std::byte* mPosition;
+			size_t mRemainingCount;
+			// zero if each element has its own tag
+			uint8_t mSameTypeTagBits;
+		};
+
+		class ObjectIterator
+		{
+		public:
+			using iterator_category = std::input_iterator_tag;
+			using value_type = std::pair<std::string_view, ValueView>;
+			using difference_type = std::ptrdiff_t;
+			using pointer = void;
+			using reference = std::pair<std::string_view, ValueView>;
+
+		public:
+			std::pair<std::string_view, ValueView> operator*() const noexcept;
+			ObjectIterator& operator++() noexcept;
+			ObjectIterator operator++(int) noexcept
+			{
+				ObjectIterator previous = *this;
+				++*this;
+				return previous;
+			}
+			bool operator==(const ObjectIterator& other) const noexcept { return mRemainingCount == other.mRemainingCount; }
+
+		private:
+			friend class ValueView;
+			ObjectIterator(const std::byte* position, size_t remainingCount) noexcept;
+
+		private:
+			const std::byte* mPosition;
+			size_t mRemainingCount;
+		};
+
+		class ArrayRange
+		{
+		public:
+			[[nodiscard]] ArrayIterator begin() const noexcept { return mBegin; }
+			[[nodiscard]] ArrayIterator end() const noexcept { return ArrayIterator(nullptr, 0, 0); }
+			[[nodiscard]] size_t size() const noexcept { return mSize; }
+			[[nodiscard]] bool empty() const noexcept { return mSize == 0; }
+
+		private:
+			friend class ValueView;
+			ArrayRange(ArrayIterator begin, size_t size) noexcept
+				: mBegin(begin), mSize(size) {}
+
+		private:
+			ArrayIterator mBegin;
+			size_t mSize;
+		};
+
+		class ObjectRange
+		{
+		public:
+			[[nodiscard]] ObjectIterator begin() const noexcept { return mBegin; }
+			[[nodiscard]] ObjectIterator end() const noexcept { return ObjectIterator(nullptr, 0); }
+			[[nodiscard]] size_t size() const noexcept { return mSize; }
+			[[nodiscard]] bool empty() const noexcept { return mSize == 0; }
+
+			// linear search, objects are usually small records
+			[[nodiscard]] std::optional<ValueView> find(std::string_view key) const noexcept;
+
+		private:
+			friend class ValueView;
+			ObjectRange(ObjectIterator begin, size_t size) noexcept
+				: mBegin(begin), mSize(size) {}
+
+		private:
+			ObjectIterator mBegin;
+			size_t mSize;
+		};
+
+	public:
+		// the data should contain exactly one serialized value
+		[[nodiscard]] static std::optional<ValueView> parse(std::span<const std::byte> data) noexcept;
+
+		[[nodiscard]] Tag getTag() const noexcept;
+		[[nodiscard]] bool isA(Tag tag) const noexcept { return getTag() == tag; }
+
+		[[nodiscard]] std::optional<uint8_t> asU8() const noexcept;
+		[[nodiscard]] std::optional<uint16_t> asU16() const noexcept;
+		[[nodiscard]] std::optional<uint32_t> asU32() const noexcept;
+		[[nodiscard]] std::optional<uint64_t> asU64() const noexcept;
+		[[nodiscard]] std::optional<std::string_view> asString() const noexcept;
+		[[nodiscard]] std::optional<std::span<const std::byte>> asByteArray() const noexcept;
+		// nullopt if the value is not an option or the option is not set
+		[[nodiscard]] std::optional<ValueView> asOptionValue() const noexcept;
+		[[nodiscard]] std::optional<ArrayRange> asArray() const noexcept;
+		[[nodiscard]] std::optional<ObjectRange> asObject() const noexcept;
+
+		// makes an owning copy of the whole subtree
+		[[nodiscard]] Value toValue(std::pmr::memory_resource* resource = std::pmr::get_default_resource()) const noexcept;
+
+	private:
+		ValueView(const std::byte* payload, uint8_t tagBits) noexcept;
+
+	private:
+		// points right after the tag
+		const std::byte* mPayload;
+		uint8_t mTagBits;
+	};
+} // namespace BStorage
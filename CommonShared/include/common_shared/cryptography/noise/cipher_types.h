@@ -30,4 +30,25 @@ namespace Noise
 	using CipherStateHandshake = CipherState<CipherStateInstanceTag::Handshake>;
 	using CipherStateSending = CipherState<CipherStateInstanceTag::Sending>;
 	using CipherStateReceiving = CipherState<CipherStateInstanceTag::Receiving>;
+
+	// describes how often the transport keys are replaced, zero disables the corresponding trigger
+	// both parties should agree on the same policy before exchanging the transport messages
+	struct RekeyPolicy
+	{
+		uint64_t messagesInterval = 1;
+		// counted in ciphertext bytes, including MAC
+		uint64_t bytesInterval = 0;
+		// can't be checked by both parties independently, so it is up to the protocol to synchronize it
+		uint64_t timeIntervalMs = 0;
+
+		bool operator==(const RekeyPolicy&) const = default;
+	};
+
+	// tracks the messages sent or received with one cipher state since its last rekey
+	struct RekeySchedule
+	{
+		RekeyPolicy policy;
+		uint64_t messagesSinceRekey = 0;
+		uint64_t bytesSinceRekey = 0;
+	};
 } // namespace Noise
@@ -16,9 +16,24 @@ namespace Noise::Utils
 	[[nodiscard]] Cryptography::EncryptResult encryptTransportMessageInplace(CipherStateSending& cipherState, const std::span<std::byte> inOutData);
 	[[nodiscard]] Cryptography::DecryptResult decryptTransportMessageInplace(CipherStateReceiving& cipherState, const std::span<std::byte> inOutData);
 
+	// batch versions of the functions above, the messages are processed back to back with sequential nonces
+	// and the cipher state is validated once for the whole batch
+	// each message should have Cryptography::CipherAuthDataSize bytes reserved at the end for MAC
+	// rekey is called after each message that makes the schedule due, the result is the same as doing it one by one
+	[[nodiscard]] Cryptography::EncryptResult encryptTransportMessagesInplace(CipherStateSending& cipherState, const std::span<const std::span<std::byte>> inOutMessages, RekeySchedule& rekeySchedule);
+	// if one of the messages fails to decrypt, the cipher state is still advanced for all the messages before it
+	[[nodiscard]] Cryptography::DecryptResult decryptTransportMessagesInplace(CipherStateReceiving& cipherState, const std::span<const std::span<std::byte>> inOutMessages, RekeySchedule& rekeySchedule);
+
 	[[nodiscard]] Cryptography::EncryptResult encryptWithAd(CipherStateHandshake& cipherState, const std::span<const std::byte> associatedData, const std::span<const std::byte> plaintext, const std::span<std::byte> outCiphertext);
 	[[nodiscard]] Cryptography::DecryptResult decryptWithAd(CipherStateHandshake& cipherState, const std::span<const std::byte> associatedData, const std::span<const std::byte> ciphertext, const std::span<std::byte> outPlaintext);
 
 	EncryptResult rekey(CipherStateSending& cipherState);
 	EncryptResult rekey(CipherStateReceiving& cipherState);
+
+	// accounts for one more transport message, returns true if the cipher state should be rekeyed after it
+	// (in which case the schedule is already reset)
+	[[nodiscard]] bool registerTransportMessage(RekeySchedule& rekeySchedule, size_t ciphertextSize) noexcept;
+	void resetRekeySchedule(RekeySchedule& rekeySchedule) noexcept;
+	// each trigger is set to the most frequent of the two, so neither party gets less rekeys than it asked for
+	[[nodiscard]] RekeyPolicy negotiateRekeyPolicy(const RekeyPolicy& ourPolicy, const RekeyPolicy& theirPolicy) noexcept;
 }
@@ -38,6 +38,7 @@ namespace Noise
 		std::optional<Keypair> staticKeys; // s
 		std::optional<PublicKey> remoteEphemeralKey; // re
 		std::optional<PublicKey> remoteStaticKey; // rs
+		std::optional<DhResult> staticStaticDh; // DH(s, rs) precomputed when s and rs are known in advance, used by the ss token
 
 		SymmetricState symmetricState;
 	};
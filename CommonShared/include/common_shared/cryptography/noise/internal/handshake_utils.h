@@ -24,6 +24,8 @@ namespace Noise::Utils
 	[[nodiscard]] Cryptography::EncryptResult encryptAndHash(SymmetricState& symmetricState, const std::span<const std::byte> plaintext, const std::span<std::byte> outCiphertext);
 	[[nodiscard]] Cryptography::DecryptResult decryptAndHash(SymmetricState& symmetricState, const std::span<const std::byte> ciphertext, const std::span<std::byte> outPlaintext);
 	void split(const SymmetricState& symmetricState, CipherStateSending& c1, CipherStateReceiving& c2, HandshakeRole role);
+	// the third output of the same HKDF that Split() uses, the first two outputs (the transport keys) are not affected by it
+	[[nodiscard]] HashResult deriveResumptionSecret(const SymmetricState& symmetricState) noexcept;
 	// returns zero on success, non-zero on failure (not enough space in the buffer)
 	[[nodiscard]] int writeDataToBuffer(const std::span<const std::byte> data, const std::span<std::byte> inOutBuffer, size_t& inOutWritePos) noexcept;
 	// returns zero on success, non-zero on failure (not enough space in the buffer)
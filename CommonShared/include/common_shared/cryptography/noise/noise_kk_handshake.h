@@ -18,6 +18,8 @@ namespace Noise::NoiseKK
 	{
 		CipherStateSending sendingCipherState;
 		CipherStateReceiving receivingCipherState;
+		// secret shared by both parties that can be used to resume the session later without a new handshake
+		HashResult resumptionSecret;
 		// this can include more data which is omitted because this application doesn't use it
 	};
 
@@ -25,6 +27,12 @@ namespace Noise::NoiseKK
 	[[nodiscard]] InitiatorHandshakeState initializeInitiator(const Keypair& staticKeys, const PublicKey& remoteStaticKey) noexcept;
 	[[nodiscard]] ResponderHandshakeState initializeResponder(const Keypair& staticKeys, const PublicKey& remoteStaticKey) noexcept;
 
+	// the static keys of both parties don't change after pairing, so the ss DH can be computed
+	// once and stored with the binding, which saves one X25519 operation per handshake
+	[[nodiscard]] DhResult computeStaticStaticDh(const Keypair& staticKeys, const PublicKey& remoteStaticKey) noexcept;
+	[[nodiscard]] InitiatorHandshakeState initializeInitiator(const Keypair& staticKeys, const PublicKey& remoteStaticKey, const DhResult& staticStaticDh) noexcept;
+	[[nodiscard]] ResponderHandshakeState initializeResponder(const Keypair& staticKeys, const PublicKey& remoteStaticKey, const DhResult& staticStaticDh) noexcept;
+
 	// message 1
 	const size_t Message1ExpectedSize = DHLEN;
 	using AppendHandshakeMessage1Result = std::optional<MessageWriteError>;
@@ -0,0 +1,59 @@
+// Copyright (C) Pavel Grebnev 2026
+// Distributed under the MIT License (license terms are at http://opensource.org/licenses/MIT).
+
+#pragma once
+
+#include <array>
+#include <optional>
+#include <span>
+
+#include "common_shared/cryptography/noise/cipher_types.h"
+#include "common_shared/cryptography/types/hash_types.h"
+
+// This is not a part of the Noise specification.
+// A session established with a full handshake produces a resumption secret known to both parties.
+// The server seals it together with the connection ID into a ticket that only the server can open,
+// and the client later presents the ticket to derive new transport keys without any DH operations.
+// Fresh random nonces of both parties make sure that the keys of each resumed session are unique,
+// and every session gives a new resumption secret, so a ticket is not supposed to be used twice.
+namespace Noise::Resumption
+{
+	constexpr size_t RandomNonceSize = 32;
+	constexpr size_t TicketPlaintextSize = HASHLEN + HASHLEN + sizeof(uint64_t);
+	constexpr size_t TicketSize = sizeof(Cryptography::Nonce) + TicketPlaintextSize + CipherAuthDataSize;
+
+	using Ticket = std::array<std::byte, TicketSize>;
+	using RandomNonce = std::array<std::byte, RandomNonceSize>;
+
+	struct TicketContent
+	{
+		HashResult connectionId;
+		HashResult resumptionSecret;
+		// seconds since epoch
+		uint64_t expirationTime = 0;
+	};
+
+	struct ResumedSession
+	{
+		CipherStateSending sendingCipherState;
+		CipherStateReceiving receivingCipherState;
+		// to be put into the next ticket
+		HashResult nextResumptionSecret;
+	};
+
+	enum class SessionRole
+	{
+		Client,
+		Server,
+	};
+
+	// each ticket sealed with the same key should use a unique ticketNonce
+	[[nodiscard]] EncryptResult sealTicket(const CipherKey& ticketKey, Cryptography::Nonce ticketNonce, const TicketContent& content, Ticket& outTicket) noexcept;
+	// returns nullopt if the ticket was not sealed with this key, was tampered with, or is expired
+	[[nodiscard]] std::optional<TicketContent> openTicket(const CipherKey& ticketKey, std::span<const std::byte> ticket, uint64_t currentTime) noexcept;
+	[[nodiscard]] Cryptography::Nonce getTicketNonce(std::span<const std::byte> ticket) noexcept;
+
+	// both parties should provide exactly the same client message (the whole resumption request after the prelude)
+	// so any modification of it results in the keys that don't match
+	[[nodiscard]] ResumedSession deriveResumedSession(const HashResult& resumptionSecret, std::span<const std::byte> clientMessage, const RandomNonce& serverNonce, SessionRole role) noexcept;
+} // namespace Noise::Resumption
@@ -23,4 +23,25 @@ namespace Cryptography
 		const std::span<const std::byte> ciphertext,
 		const std::span<std::byte> outPlaintext
 	) noexcept;
+
+	// batch versions of the functions above for messages without associated data
+	// each message is encrypted/decrypted in place, the last CipherAuthDataSize bytes of each message are reserved for MAC
+	// the n-th message uses firstNonce + n as its nonce, the key and the sizes are validated once for the whole batch
+	[[nodiscard]] EncryptResult encryptInplaceBatch_chacha20poly1305(
+		const CipherKey& key,
+		const Nonce firstNonce,
+		const std::span<const std::span<std::byte>> inOutMessages
+	) noexcept;
+
+	// stops at the first message that fails authentication, outDecryptedMessagesCount is set to the number of successfully decrypted messages
+	[[nodiscard]] DecryptResult decryptInplaceBatch_chacha20poly1305(
+		const CipherKey& key,
+		const Nonce firstNonce,
+		const std::span<const std::span<std::byte>> inOutMessages,
+		size_t& outDecryptedMessagesCount
+	) noexcept;
+
+	// REKEY(k) from the Noise specification: the first 32 bytes of ENCRYPT(k, maxnonce, zerolen, zeros)
+	// produces the same key as going through encrypt_chacha20poly1305, but skips the MAC calculation
+	[[nodiscard]] EncryptResult rekey_chacha20(CipherKey& inOutKey) noexcept;
 }
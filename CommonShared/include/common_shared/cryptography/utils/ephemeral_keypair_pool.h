@@ -0,0 +1,26 @@
+// Copyright (C) Pavel Grebnev 2026
+// Distributed under the MIT License (license terms are at http://opensource.org/licenses/MIT).
+
+#pragma once
+
+#include <cstddef>
+
+#include "common_shared/cryptography/types/dh_types.h"
+
+namespace Cryptography::EphemeralKeypairPool
+{
+	constexpr size_t DefaultCapacity = 32;
+
+	// starts a low-priority background thread that keeps up to `capacity` pre-generated keypairs ready
+	// calling it when the pool is already running does nothing
+	void start(size_t capacity = DefaultCapacity) noexcept;
+	// stops the background thread and wipes all the keypairs that weren't taken
+	void stop() noexcept;
+
+	// returns a single-use keypair, the pool doesn't keep its copy
+	// if the pool is not running or is drained, the keypair is generated on the calling thread
+	[[nodiscard]] Keypair takeKeypair() noexcept;
+
+	// number of the keypairs ready to be taken
+	[[nodiscard]] size_t getAvailableCount() noexcept;
+} // namespace Cryptography::EphemeralKeypairPool
@@ -0,0 +1,50 @@
+// Copyright (C) Pavel Grebnev 2026
+// Distributed under the MIT License (license terms are at http://opensource.org/licenses/MIT).
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <span>
+
+namespace Files
+{
+	// file for logs that are only written at the end, the writes are not buffered and are durable only after sync()
+	class AppendOnlyFile
+	{
+	public:
+		// creates the file if it doesn't exist
+		[[nodiscard]] static std::optional<AppendOnlyFile> open(const std::filesystem::path& path) noexcept;
+
+		AppendOnlyFile(const AppendOnlyFile&) = delete;
+		AppendOnlyFile& operator=(const AppendOnlyFile&) = delete;
+		AppendOnlyFile(AppendOnlyFile&& other) noexcept;
+		AppendOnlyFile& operator=(AppendOnlyFile&& other) noexcept;
+		~AppendOnlyFile() noexcept;
+
+		[[nodiscard]] bool append(std::span<const std::byte> data) noexcept;
+		// flushes the written data to the disk
+		[[nodiscard]] bool sync() noexcept;
+		// cuts the file to the size, e.g. to drop a partially written tail
+		[[nodiscard]] bool truncate(uint64_t size) noexcept;
+
+		[[nodiscard]] uint64_t getSize() const noexcept { return mSize; }
+
+	private:
+#if defined(_WIN32) || defined(_WIN64)
+		using NativeHandle = void*;
+#else
+		using NativeHandle = int;
+#endif
+
+	private:
+		AppendOnlyFile(NativeHandle handle, uint64_t size) noexcept;
+		void close() noexcept;
+
+	private:
+		NativeHandle mHandle;
+		uint64_t mSize = 0;
+	};
+} // namespace Files
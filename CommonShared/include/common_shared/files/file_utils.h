@@ -3,9 +3,15 @@
 
 #pragma once
 
+#include <cstddef>
 #include <filesystem>
+#include <span>
 
 namespace Files
 {
 	bool isFilePathAcceptable(const std::filesystem::path& path) noexcept;
+
+	// writes the data into a temporary file next to the target, flushes it to the disk and renames it over the target,
+	// so after a crash the target has either the old or the new content
+	[[nodiscard]] bool writeFileAtomically(const std::filesystem::path& path, std::span<const std::byte> data) noexcept;
 } // namespace Files
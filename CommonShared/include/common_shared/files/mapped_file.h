@@ -0,0 +1,35 @@
+// Copyright (C) Pavel Grebnev 2026
+// Distributed under the MIT License (license terms are at http://opensource.org/licenses/MIT).
+
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <optional>
+#include <span>
+
+namespace Files
+{
+	// read-only memory mapping of a whole file, the data address doesn't change when the object is moved
+	class MappedFile
+	{
+	public:
+		[[nodiscard]] static std::optional<MappedFile> open(const std::filesystem::path& path) noexcept;
+
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+		MappedFile(MappedFile&& other) noexcept;
+		MappedFile& operator=(MappedFile&& other) noexcept;
+		~MappedFile() noexcept;
+
+		[[nodiscard]] std::span<const std::byte> getData() const noexcept { return { mData, mSize }; }
+
+	private:
+		MappedFile(const std::byte* data, size_t size) noexcept;
+		void unmap() noexcept;
+
+	private:
+		const std::byte* mData = nullptr;
+		size_t mSize = 0;
+	};
+} // namespace Files
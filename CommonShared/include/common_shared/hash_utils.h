@@ -3,6 +3,8 @@
 
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
 #include <span>
 #include <type_traits>
 
@@ -25,4 +27,7 @@ namespace Hash
 	}
 
 	size_t hashSpan(std::span<const std::byte> span) noexcept;
+
+	// standard CRC-32 (the one of zlib and PNG), to detect damaged records in files, not a protection against tampering
+	[[nodiscard]] uint32_t crc32(std::span<const std::byte> data) noexcept;
 } // namespace Hash
@@ -8,13 +8,16 @@
 #include <string>
 #include <vector>
 
+#include "common_shared/cryptography/noise/cipher_types.h"
+#include "common_shared/cryptography/noise/session_resumption.h"
 #include "common_shared/cryptography/types/dh_types.h"
 #include "common_shared/cryptography/types/hash_types.h"
+#include "common_shared/network/session_parameters.h"
 
 namespace Protocol
 {
 	// increase the version every time the protocol changes
-	constexpr uint16_t NetworkProtocolVersion = 0;
+	constexpr uint16_t NetworkProtocolVersion = 5;
 
 	enum class RequestId : uint8_t
 	{
@@ -24,6 +27,9 @@ namespace Protocol
 		GetServerName = 1,
 		Pair = 2,
 		SendFiles = 3,
+		ResumeSendFiles = 4,
+		OpenControlChannel = 5,
+		Hello = 6,
 	};
 
 	enum class RequestAnswerId : uint8_t
@@ -37,6 +43,11 @@ namespace Protocol
 		GetServerName = 2,
 		Pair = 3,
 		SendFiles = 4,
+		ResumeSendFiles = 5,
+		OpenControlChannel = 6,
+		// the request can't be processed through the control channel
+		UnsupportedRequest = 7,
+		Hello = 8,
 	};
 
 	constexpr size_t MaxRequestSize = 1024;
@@ -44,6 +55,27 @@ namespace Protocol
 
 	constexpr uint16_t MaxServerNameSize = 32;
 
+	// UDP ports of the service discovery, see NsdServer and NsdClient
+	namespace Discovery
+	{
+		// the clients broadcast queries to this port and the servers answer them
+		constexpr uint16_t QueryPort = 5354;
+		// the servers broadcast announcements to this port, it is unassigned in the IANA registry
+		// so the broadcasts don't reach other services (e.g. 5355 is LLMNR, and is taken by the system resolvers)
+		constexpr uint16_t AnnouncementPort = 45818;
+	} // namespace Discovery
+
+	// Bits of the capability mask in the Hello answer.
+	// They describe optional features of the server within the current protocol version,
+	// a client should ignore the bits it doesn't know about.
+	namespace Capabilities
+	{
+		constexpr uint32_t ControlChannel = 1 << 0;
+		constexpr uint32_t SessionResumption = 1 << 1;
+
+		constexpr uint32_t AllSupported = ControlChannel | SessionResumption;
+	} // namespace Capabilities
+
 	namespace Requests
 	{
 		// make sure GetProtocolVersion does not change the ID or data
@@ -67,6 +99,24 @@ namespace Protocol
 			Cryptography::HashResult connectionId;
 			std::vector<std::byte> firstMessage;
 		};
+
+		struct ResumeSendFiles
+		{
+			// see Protocol::Resumption for the format
+			std::vector<std::byte> firstMessage;
+		};
+
+		// see Protocol::ControlChannel
+		struct OpenControlChannel
+		{
+		};
+
+		// everything a client needs to know about a server to show it to the user, in a single round trip
+		// it follows the same version rules as the other requests, so a server with a different version
+		// answers it with UnsupportedProtocolVersion
+		struct Hello
+		{
+		};
 	} // namespace Requests
 
 	namespace RequestAnswers
@@ -101,6 +151,24 @@ namespace Protocol
 		struct SendFiles
 		{
 		};
+
+		struct OpenControlChannel
+		{
+		};
+
+		struct UnsupportedRequest
+		{
+		};
+
+		// protocol version (uint16), server ID (16 bytes), capabilities (uint32), server name (short string)
+		struct Hello
+		{
+			uint16_t protocolVersion = 0;
+			std::array<std::byte, 16> serverId{};
+			// see Protocol::Capabilities
+			uint32_t capabilities = 0;
+			std::string serverName;
+		};
 	} // namespace RequestAnswers
 
 	namespace FileExchange
@@ -123,6 +191,19 @@ namespace Protocol
 		// The answer is split into chunks of 64 bytes, it is expected that the server waits for all the chunks before proceedin sending next file chunks.
 
 		constexpr static size_t AnswerChunkSize = 64;
+
+		// Right after the KK handshake the parties negotiate the session parameters (see Protocol::SessionParameters), which include the rekey policy
+		// negotiated with Noise::Utils::negotiateRekeyPolicy, and both parties use it for the rest of the session.
+		// The message and byte counters are kept separately for each direction, and can be checked independently by each party.
+		// The time-based rekey is decided by the receiving side when it writes an answer, it sets AnswerRekeyFlag in the number of statuses,
+		// and as soon as the answer is fully sent/received both parties rekey both of their cipher states.
+		constexpr static uint16_t AnswerRekeyFlag = 0x8000;
+		constexpr static Noise::RekeyPolicy DefaultRekeyPolicy{
+			.messagesInterval = ChunksBetweenAnswers,
+			.bytesInterval = 0,
+			.timeIntervalMs = 60 * 1000,
+		};
+
 		enum class FileReceiveStatus : uint8_t
 		{
 			Success = 0,
@@ -144,4 +225,49 @@ namespace Protocol
 			PartCorrupted = 8,
 		};
 	}
+
+	namespace Resumption
+	{
+		// A client that has a ticket from a previous session sends ResumeSendFiles request instead of SendFiles:
+		// - the ticket (Noise::Resumption::TicketSize bytes),
+		// - client random nonce (Noise::Resumption::RandomNonceSize bytes),
+		// - client session parameters (see Protocol::SessionParameters).
+		// The server answers with RequestAnswerId::ResumeSendFiles and ResumeStatus.
+		// If the ticket is accepted, the server random nonce follows, and then the chosen session parameters as the first transport message.
+		// This saves a round trip and all the DH operations of the KK handshake.
+		// If the ticket is rejected (e.g. expired, or the server got restarted), the client sends a regular SendFiles request over the same connection.
+		// After the session parameters are negotiated (in both full and resumed sessions), if SessionParameters::Features::ResumptionTickets was chosen,
+		// the server sends a new ticket as a transport message:
+		// - the ticket (Noise::Resumption::TicketSize bytes),
+		// - ticket lifetime in seconds (uint64).
+		constexpr static uint64_t TicketLifetimeSeconds = 60 * 60;
+		constexpr static size_t FirstMessageSize = Noise::Resumption::TicketSize + Noise::Resumption::RandomNonceSize + SessionParameters::MessageSize;
+		constexpr static size_t TicketMessageSize = Noise::Resumption::TicketSize + sizeof(uint64_t);
+
+		enum class ResumeStatus : uint8_t
+		{
+			Rejected = 0,
+			Accepted = 1,
+		};
+	} // namespace Resumption
+
+	namespace ControlChannel
+	{
+		// The control channel is a persistent connection that carries multiple short requests (e.g. GetServerName),
+		// so the client doesn't pay for the TCP setup and teardown every time it needs to query the server.
+		// The client opens it with a regular OpenControlChannel request, and the server confirms it with RequestAnswerId::OpenControlChannel.
+		// After that each request and answer is sent as a frame:
+		// - payload size (uint16),
+		// - request tag (uint16), chosen by the client, the answer has the same tag as its request,
+		// - payload, the request ID followed by the request data, or the answer ID followed by the answer data.
+		// The protocol version is not repeated in the frames, it was checked when the channel was opened.
+		// The client can send several requests without waiting for the answers, and should match the answers by their tags.
+		// Only the requests that get a single answer can be sent through the channel (GetProtocolVersion, GetServerName and Hello),
+		// the server answers any other request with RequestAnswerId::UnsupportedRequest.
+		// The server closes the channel if there were no requests for IdleTimeoutSeconds, the client is expected to reopen it when needed.
+		// The server also limits the number of open channels, and answers OpenControlChannel with UnsupportedRequest when there are too many.
+		constexpr static size_t FrameHeaderSize = sizeof(uint16_t) + sizeof(uint16_t);
+		constexpr static size_t MaxFramePayloadSize = MaxRequestSize < MaxRequestAnswerSize ? MaxRequestSize : MaxRequestAnswerSize;
+		constexpr static int IdleTimeoutSeconds = 5;
+	} // namespace ControlChannel
 } // namespace Protocol
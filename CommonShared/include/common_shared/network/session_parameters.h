@@ -0,0 +1,78 @@
+// Copyright (C) Pavel Grebnev 2026
+// Distributed under the MIT License (license terms are at http://opensource.org/licenses/MIT).
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+
+#include "common_shared/cryptography/noise/cipher_types.h"
+
+// Right after the session keys are established (KK handshake or resumption) the client sends the parameters it supports,
+// and the server answers with the parameters chosen for the session. This allows adding new file transfer features
+// without bumping NetworkProtocolVersion, as a party that doesn't know about a feature or a mode just doesn't offer it.
+//
+// The message layout:
+// - features (uint32), bitset of SessionParameters::Features,
+// - frame modes (uint8), bitset of SessionParameters::FrameModes,
+// - hash modes (uint8), bitset of SessionParameters::HashModes,
+// - compression modes (uint8), bitset of SessionParameters::CompressionModes,
+// - reserved (uint8), zero,
+// - rekey policy (three uint64 values).
+// The client offers all the modes it supports, the server answers with exactly one bit for each mode.
+// A message can be longer than MessageSize, the bytes after MessageSize are reserved for the future extensions and are ignored.
+namespace Protocol::SessionParameters
+{
+	namespace Features
+	{
+		// the server sends a resumption ticket before the file transfer starts
+		constexpr uint32_t ResumptionTickets = 1 << 0;
+	} // namespace Features
+
+	namespace FrameModes
+	{
+		// chunks of FileExchange::ChunkSize bytes, an answer after every FileExchange::ChunksBetweenAnswers chunks
+		constexpr uint8_t Chunk1024Window32 = 1 << 0;
+	} // namespace FrameModes
+
+	namespace HashModes
+	{
+		// the file hashes are calculated with Cryptography::hashFileBytes
+		constexpr uint8_t Blake2b = 1 << 0;
+	} // namespace HashModes
+
+	namespace CompressionModes
+	{
+		constexpr uint8_t None = 1 << 0;
+	} // namespace CompressionModes
+
+	struct Parameters
+	{
+		uint32_t features = 0;
+		uint8_t frameModes = 0;
+		uint8_t hashModes = 0;
+		uint8_t compressionModes = 0;
+		Noise::RekeyPolicy rekeyPolicy;
+
+		bool operator==(const Parameters&) const = default;
+	};
+
+	constexpr size_t MessageSize = sizeof(uint32_t) + 4 * sizeof(uint8_t) + 3 * sizeof(uint64_t);
+	// the size of the buffer to receive the message, to be able to read messages from the newer versions
+	constexpr size_t MaxMessageSize = 64;
+
+	void write(std::span<std::byte, MessageSize> outData, const Parameters& parameters) noexcept;
+	[[nodiscard]] Parameters read(std::span<const std::byte, MessageSize> data) noexcept;
+
+	// the parameters that this build supports, used by both the client and the server
+	[[nodiscard]] Parameters getSupported() noexcept;
+
+	// picks the best common mode for each kind of modes and the common features
+	// returns std::nullopt if there is no common mode for at least one kind of modes
+	[[nodiscard]] std::optional<Parameters> negotiate(const Parameters& ours, const Parameters& theirs) noexcept;
+
+	// checks that the parameters chosen by the server are one of the combinations that we offered
+	[[nodiscard]] bool isValidChoice(const Parameters& offered, const Parameters& chosen) noexcept;
+} // namespace Protocol::SessionParameters
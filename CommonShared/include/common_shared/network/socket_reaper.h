@@ -0,0 +1,28 @@
+// Copyright (C) Pavel Grebnev 2026
+// Distributed under the MIT License (license terms are at http://opensource.org/licenses/MIT).
+
+#pragma once
+
+#include <cstddef>
+
+#include "common_shared/network/utils.h"
+
+// Closing a TCP socket that still has unread incoming data makes the OS reset the connection,
+// which can destroy the data that the peer hasn't read yet. To avoid it we half-close the socket
+// and wait for the peer to close its side, but we don't want to block the thread that owns the socket.
+// The reaper thread does the waiting for all the sockets closed with CloseMode::Graceful.
+namespace Network::SocketReaper
+{
+	// how long we wait for the peer to close its side before closing the socket anyway
+	constexpr int DrainTimeoutMilliseconds = 100;
+	// if the peers keep the connections open, we don't want to accumulate unlimited number of sockets
+	constexpr size_t MaxPendingSockets = 256;
+
+	// takes ownership of a socket which sending side is already shut down
+	// the incoming data is read and discarded until the peer closes the connection or the drain timeout passes
+	// returns false if the socket was not taken and the caller should close it
+	[[nodiscard]] bool tryAdd(RawSocket socket) noexcept;
+
+	// number of the sockets that are waiting to be closed
+	[[nodiscard]] size_t getPendingCount() noexcept;
+} // namespace Network::SocketReaper
@@ -74,23 +74,47 @@ namespace Network
 	std::optional<std::string> sendEncrypted(RawSocket socket, std::span<std::byte> buffer, size_t bytesToSend, Noise::CipherStateSending& cipherState);
 	// the buffer should have enough space to contain the expected plaintext + Cryptography::CipherAuthDataSize, receivedBytes is the size of plaintext
 	std::optional<std::string> recvEncrypted(RawSocket socket, std::span<std::byte> buffer, size_t& receivedBytes, Noise::CipherStateReceiving& cipherState);
-	void closeSocket(RawSocket socket, int timeoutMicroseconds = 100000);
+	// encrypts all the frames in one batch (rekeying according to the schedule) and then sends them in order, each frame should have Cryptography::CipherAuthDataSize bytes reserved at the end
+	std::optional<std::string> sendEncryptedBatch(RawSocket socket, std::span<const std::span<std::byte>> frames, Noise::CipherStateSending& cipherState, Noise::RekeySchedule& rekeySchedule);
+	// receives data to fill each of the frames completely and then decrypts them in one batch, the plaintext of each frame is frame.size() - Cryptography::CipherAuthDataSize
+	std::optional<std::string> recvEncryptedBatch(RawSocket socket, std::span<const std::span<std::byte>> frames, Noise::CipherStateReceiving& cipherState, Noise::RekeySchedule& rekeySchedule);
+	// sends one frame of the control channel (see Protocol::ControlChannel), the payload should not be bigger than Protocol::ControlChannel::MaxFramePayloadSize
+	std::optional<std::string> sendFrame(RawSocket socket, uint16_t requestTag, std::span<const std::byte> payload);
+	// receives one frame of the control channel, the payload is written to the beginning of outPayload
+	std::optional<std::string> recvFrame(RawSocket socket, std::span<std::byte> outPayload, uint16_t& outRequestTag, size_t& outPayloadSize);
+
+	enum class CloseMode : uint8_t
+	{
+		// half-closes the connection and lets SocketReaper wait for the peer to close its side, doesn't block the caller
+		Graceful,
+		// shuts down both directions and closes the socket right away, use for UDP and listening sockets
+		// this also wakes up the threads blocked on this socket
+		Immediate,
+		// closes the socket with zero SO_LINGER timeout, so the connection is reset without waiting, use for misbehaving peers
+		Abortive,
+	};
+
+	void closeSocket(RawSocket socket, CloseMode closeMode = CloseMode::Graceful);
 
 	class AutoclosingSocket
 	{
 	public:
-		explicit AutoclosingSocket(const RawSocket socket) noexcept
-			: mSocket(socket) {}
+		explicit AutoclosingSocket(const RawSocket socket, const CloseMode closeMode = CloseMode::Graceful) noexcept
+			: mSocket(socket)
+			, mCloseMode(closeMode) {}
 		AutoclosingSocket(AutoclosingSocket&) = delete;
 		AutoclosingSocket& operator=(AutoclosingSocket&) = delete;
 		AutoclosingSocket(AutoclosingSocket&&) = delete;
 		AutoclosingSocket& operator=(AutoclosingSocket&&) = delete;
-		~AutoclosingSocket() { closeSocket(mSocket); }
+		~AutoclosingSocket() { closeSocket(mSocket, mCloseMode); }
+
+		void setCloseMode(const CloseMode closeMode) noexcept { mCloseMode = closeMode; }
 
 		// ReSharper disable once CppNonExplicitConversionOperator
 		operator RawSocket() const noexcept { return mSocket; }
 
 	private:
 		RawSocket mSocket;
+		CloseMode mCloseMode;
 	};
 } // namespace Network
@@ -7,6 +7,7 @@
 #include <functional>
 #include <optional>
 #include <string>
+#include <vector>
 
 #include "common_shared/network/utils.h"
 
@@ -27,9 +28,18 @@ namespace NsdClient
 		DiscoveryState state;
 	};
 
+	// the period of queries grows up to this value as long as we receive the announcements
+	constexpr float MaxBroadcastPeriodSec = 60.0f;
+
+	// Broadcasts queries to broadcastPort, starting with broadcastPeriodSec and doubling the period after every query
+	// while at least one server keeps sending announcements, the period goes back to broadcastPeriodSec
+	// when no announcements arrived for their TTL. Listens to the server announcements (see NsdServer::processAnnouncementsThread) on announcementPort.
+	// A server is reported as Removed when it says goodbye, when its announcement TTL expires,
+	// or (for the servers that only answer queries) when it doesn't answer two queries in a row.
 	ListenResult processServiceDiscoveryThread(
 		const char* serviceIdentifier,
 		uint16_t broadcastPort,
+		uint16_t announcementPort,
 		Network::AddressType addressType,
 		float broadcastPeriodSec,
 		const std::function<void(DiscoveryResult&&)>& resultFunction,
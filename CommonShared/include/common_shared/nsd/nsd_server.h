@@ -3,7 +3,9 @@
 
 #pragma once
 
+#include <atomic>
 #include <cstdint>
+#include <optional>
 #include <span>
 #include <string>
 #include <variant>
@@ -24,8 +26,16 @@ namespace NsdServer
 
 	using ListenResult = std::variant<SetupError, SocketError>;
 
+	// replies to the same source address are rate-limited, a client broadcasts a query once per broadcast period,
+	// this leaves some room for several clients behind one address
+	constexpr double RepliesPerSecondPerAddress = 2.0;
+	constexpr double MaxRepliesBurst = 4.0;
+
 	std::variant<Network::RawSocket, std::string> openNsdSocket(const Network::AddressType addressType);
 
+	// a client removes a server if it didn't hear from it for this long
+	constexpr uint16_t AnnouncementTtlSeconds = 120;
+
 	ListenResult listen(
 		Network::RawSocket socket,
 		const char* interfaceAddressStr,
@@ -35,4 +45,16 @@ namespace NsdServer
 		uint16_t advertizedPort,
 		std::span<const std::byte> extraData
 	);
+
+	// Broadcasts an unsolicited announcement to the clients listening on announcementPort as soon as it starts,
+	// repeats it every half of AnnouncementTtlSeconds, and announces a zero TTL (goodbye) when the stop signal is received.
+	// This lets the clients see the server appearing and disappearing without sending queries.
+	std::optional<std::string> processAnnouncementsThread(
+		Network::AddressType addressType,
+		uint16_t announcementPort,
+		const char* serviceIdentifier,
+		uint16_t advertizedPort,
+		std::span<const std::byte> extraData,
+		const std::atomic_bool& stopSignalReceiver
+	);
 } // namespace NsdServer
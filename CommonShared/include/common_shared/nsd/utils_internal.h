@@ -3,11 +3,38 @@
 
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
+#include <optional>
 #include <span>
+#include <string_view>
+#include <vector>
 
 namespace NsdInternalUtils
 {
+	// the first byte of an answer to a query
+	constexpr std::byte QueryAnswerVersion{ 0x01 };
+	// the first byte of an unsolicited announcement, the clients that don't support announcements just ignore them
+	constexpr std::byte AnnouncementVersion{ 0x02 };
+	// the size of the buffer the client receives the answers and announcements into, bigger packets are not built
+	constexpr size_t MaxPacketSize = 1024;
+
+	struct Announcement
+	{
+		// zero means that the server is going offline
+		uint16_t ttlSeconds = 0;
+		uint16_t port = 0;
+		std::vector<std::byte> extraData;
+	};
+
 	[[nodiscard]]
 	uint16_t checksum16v1(const std::span<const std::byte> data);
+
+	// version (1 byte), TTL in seconds (uint16), service identifier (short string), size of extra data (uint16), port (uint16), extra data, checksum (uint16),
+	// returns std::nullopt if the packet would be bigger than MaxPacketSize
+	[[nodiscard]]
+	std::optional<std::vector<std::byte>> buildAnnouncement(std::string_view serviceIdentifier, uint16_t ttlSeconds, uint16_t port, std::span<const std::byte> extraData);
+	// returns std::nullopt if the packet is malformed or is for a different service
+	[[nodiscard]]
+	std::optional<Announcement> parseAnnouncement(std::span<const std::byte> packet, std::string_view serviceIdentifier);
 } // namespace NsdInternalUtils
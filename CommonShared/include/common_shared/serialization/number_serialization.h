@@ -14,6 +14,8 @@ namespace Serialization
 	void appendUint16(std::vector<std::byte>& inOutStream, uint16_t value) noexcept;
 	void writeUint16(std::byte& outByte1, std::byte& outByte2, uint16_t value) noexcept;
 	[[nodiscard]] uint16_t readUint16(std::byte byte1, std::byte byte2) noexcept;
+	void writeUint32(std::span<std::byte> outSerializedData, uint32_t value) noexcept;
+	[[nodiscard]] uint32_t readUint32(std::span<const std::byte> serializedData) noexcept;
 	void writeUint64(std::span<std::byte> outSerializedData, uint64_t value) noexcept;
 	[[nodiscard]] uint64_t readUint64(std::span<const std::byte> serializedData) noexcept;
 } // namespace Serialization
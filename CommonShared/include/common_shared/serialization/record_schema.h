@@ -0,0 +1,237 @@
+// Copyright (C) Pavel Grebnev 2026
+// Distributed under the MIT License (license terms are at http://opensource.org/licenses/MIT).
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+#include "common_shared/debug/assert.h"
+#include "common_shared/serialization/number_serialization.h"
+#include "common_shared/serialization/serialization_helpers.h"
+
+namespace Serialization
+{
+	template<size_t N>
+	struct FieldName
+	{
+		consteval FieldName(const char (&text)[N]) noexcept
+		{
+			std::copy_n(text, N, value);
+		}
+
+		char value[N];
+	};
+
+	// a field of the record accessed through a chain of member pointers, e.g. Field<"publicKey", &Binding::staticKeys, &Keypair::publicKey>
+	template<FieldName Name, auto... MemberPath>
+	struct Field
+	{
+		static constexpr std::string_view name{ Name.value, sizeof(Name.value) - 1 };
+
+		template<typename Record>
+		[[nodiscard]] static constexpr auto& get(Record& record) noexcept
+		{
+			return (record .* ... .* MemberPath);
+		}
+	};
+
+	namespace SchemaInternal
+	{
+		template<typename T>
+		concept StringField = std::is_same_v<std::remove_cvref_t<T>, std::string>;
+
+		template<typename T>
+		concept NumberField = std::is_integral_v<std::remove_cvref_t<T>> || std::is_enum_v<std::remove_cvref_t<T>>;
+
+		template<typename T>
+		[[nodiscard]] consteval size_t getFixedFieldSize() noexcept
+		{
+			if constexpr (NumberField<T>)
+			{
+				return sizeof(T);
+			}
+			else if constexpr (requires { T::raw; })
+			{
+				// crypto byte sequences
+				return std::tuple_size_v<decltype(T::raw)>;
+			}
+			else
+			{
+				return std::tuple_size_v<T>;
+			}
+		}
+
+		template<typename T>
+		[[nodiscard]] size_t getFieldSize(const T& field) noexcept
+		{
+			if constexpr (StringField<T>)
+			{
+				// size byte and the characters
+				return 1 + field.size();
+			}
+			else
+			{
+				return getFixedFieldSize<T>();
+			}
+		}
+
+		template<typename T>
+		[[nodiscard]] std::array<std::byte, sizeof(T)> writeNumber(const T value) noexcept
+		{
+			using UnsignedType = std::conditional_t<sizeof(T) == 1, uint8_t, std::conditional_t<sizeof(T) == 2, uint16_t, std::conditional_t<sizeof(T) == 4, uint32_t, uint64_t>>>;
+			const UnsignedType number = static_cast<UnsignedType>(value);
+
+			std::array<std::byte, sizeof(T)> result;
+			if constexpr (sizeof(T) == 1)
+			{
+				result[0] = static_cast<std::byte>(number);
+			}
+			else if constexpr (sizeof(T) == 2)
+			{
+				writeUint16(result[0], result[1], number);
+			}
+			else if constexpr (sizeof(T) == 4)
+			{
+				writeUint32(result, number);
+			}
+			else
+			{
+				writeUint64(result, number);
+			}
+			return result;
+		}
+
+		template<typename T>
+		[[nodiscard]] T readNumber(const std::array<std::byte, sizeof(T)>& data) noexcept
+		{
+			if constexpr (sizeof(T) == 1)
+			{
+				return static_cast<T>(data[0]);
+			}
+			else if constexpr (sizeof(T) == 2)
+			{
+				return static_cast<T>(readUint16(data[0], data[1]));
+			}
+			else if constexpr (sizeof(T) == 4)
+			{
+				return static_cast<T>(readUint32(data));
+			}
+			else
+			{
+				return static_cast<T>(readUint64(data));
+			}
+		}
+
+		template<typename T>
+		[[nodiscard]] bool writeField(GenericSerializationWrapper& serializer, const T& field, std::string_view name) noexcept
+		{
+			if constexpr (StringField<T>)
+			{
+				return serializer.writeShortString(field, name);
+			}
+			else if constexpr (NumberField<T>)
+			{
+				return serializer.writeFixedData(writeNumber(field), name);
+			}
+			else
+			{
+				return serializer.writeFixedData(field, name);
+			}
+		}
+
+		template<typename T>
+		[[nodiscard]] bool readField(GenericDeserializationWrapper& deserializer, T& outField, std::string_view name) noexcept
+		{
+			if constexpr (StringField<T>)
+			{
+				return deserializer.readShortString(outField, name);
+			}
+			else if constexpr (NumberField<T>)
+			{
+				std::array<std::byte, sizeof(T)> data;
+				if (!deserializer.readFixedData(data, name))
+				{
+					return false;
+				}
+				outField = readNumber<T>(data);
+				return true;
+			}
+			else
+			{
+				return deserializer.readFixedData(outField, name);
+			}
+		}
+
+		template<typename Record, typename Field>
+		using FieldType = std::remove_cvref_t<decltype(Field::get(std::declval<Record&>()))>;
+	} // namespace SchemaInternal
+
+	/**
+	 * Compile-time description of a record layout, the fields are written one after another without tags or names:
+	 * strings as a size byte and the characters, numbers as big-endian, byte sequences as they are.
+	 * Encodes and decodes the records directly without building intermediate values.
+	 */
+	template<typename Record, typename... Fields>
+	class RecordSchema
+	{
+	public:
+		// set only if the record has no strings, so a buffer can be allocated on stack
+		static constexpr std::optional<size_t> FixedSize = []() -> std::optional<size_t> {
+			if constexpr ((SchemaInternal::StringField<SchemaInternal::FieldType<Record, Fields>> || ...))
+			{
+				return std::nullopt;
+			}
+			else
+			{
+				return (SchemaInternal::getFixedFieldSize<SchemaInternal::FieldType<Record, Fields>>() + ...);
+			}
+		}();
+
+		[[nodiscard]] static size_t getSerializedSize(const Record& record) noexcept
+		{
+			return (SchemaInternal::getFieldSize(Fields::get(record)) + ...);
+		}
+
+		// the buffer should have space for at least getSerializedSize(record) bytes
+		[[nodiscard]] static bool write(const Record& record, std::span<std::byte> outBuffer) noexcept
+		{
+			GenericSerializationWrapper serializer{ outBuffer };
+			return (SchemaInternal::writeField(serializer, Fields::get(record), Fields::name) && ...);
+		}
+
+		// reads the fields from the beginning of the data, returns the number of bytes read
+		[[nodiscard]] static std::optional<size_t> readPrefix(std::span<const std::byte> data, Record& outRecord) noexcept
+		{
+			GenericDeserializationWrapper deserializer{ data };
+			if (!(SchemaInternal::readField(deserializer, Fields::get(outRecord), Fields::name) && ...))
+			{
+				return std::nullopt;
+			}
+			return deserializer.getBytesRead();
+		}
+
+		// the data should contain exactly one record
+		[[nodiscard]] static bool read(std::span<const std::byte> data, Record& outRecord) noexcept
+		{
+			const std::optional<size_t> bytesRead = readPrefix(data, outRecord);
+			if (!bytesRead.has_value())
+			{
+				return false;
+			}
+
+			if (*bytesRead != data.size())
+			{
+				reportReleaseError("Deserialization of a record read incorrect number of bytes: got {}, read {}", data.size(), *bytesRead);
+				return false;
+			}
+			return true;
+		}
+	};
+} // namespace Serialization
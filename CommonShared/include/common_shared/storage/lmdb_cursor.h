@@ -17,29 +17,63 @@ namespace Lmdb
 		std::span<const std::byte> value;
 	};
 
-	class ReadOnlyTransaction;
-	class ReadOnlyDatabase;
-	class ReadOnlyCursor
+	class Cursor
 	{
 	public:
-		~ReadOnlyCursor() noexcept;
-
-		ReadOnlyCursor(const ReadOnlyCursor&) = delete;
-		ReadOnlyCursor& operator=(const ReadOnlyCursor&) = delete;
-		ReadOnlyCursor(ReadOnlyCursor&&) noexcept;
-		ReadOnlyCursor& operator=(ReadOnlyCursor&&) noexcept;
+		~Cursor() noexcept;
 
-		[[nodiscard]] static Result<ReadOnlyCursor> open(ReadOnlyTransaction& transaction, ReadOnlyDatabase& database) noexcept;
+		Cursor(const Cursor&) = delete;
+		Cursor& operator=(const Cursor&) = delete;
+		Cursor(Cursor&&) noexcept;
+		Cursor& operator=(Cursor&&) noexcept;
 
 		[[nodiscard]] ReturnCode first() noexcept;
+		[[nodiscard]] ReturnCode last() noexcept;
 		[[nodiscard]] ReturnCode next() noexcept;
+		[[nodiscard]] ReturnCode prev() noexcept;
+		// moves to the first key that is equal or greater than the provided key, NotFound if there is no such key
+		[[nodiscard]] ReturnCode seek(std::span<const std::byte> key) noexcept;
 
 		[[nodiscard]] Result<CursorDataView> get() noexcept;
 
+		// only for databases with fixed-size duplicates (DatabaseType::FixedSizeDuplicates)
+		// getMultiple returns the values of the current key packed one after another, up to one page at a time,
+		// nextMultiple returns the following portions of them, NotFound when all the values were returned
+		[[nodiscard]] Result<std::span<const std::byte>> getMultiple() noexcept;
+		[[nodiscard]] Result<std::span<const std::byte>> nextMultiple() noexcept;
+
+	protected:
+		Cursor(MDB_cursor* mdbCursor) noexcept;
+
+	protected:
+		MDB_cursor* mMdbCursor;
+	};
+
+	class ReadOnlyTransaction;
+	class ReadOnlyDatabase;
+	class ReadOnlyCursor : public Cursor
+	{
+	public:
+		[[nodiscard]] static Result<ReadOnlyCursor> open(ReadOnlyTransaction& transaction, ReadOnlyDatabase& database) noexcept;
+
 	private:
 		ReadOnlyCursor(MDB_cursor* mdbCursor) noexcept;
+	};
+
+	class ReadWriteTransaction;
+	class ReadWriteDatabase;
+	// should be destroyed before the transaction is committed or aborted
+	class ReadWriteCursor : public Cursor
+	{
+	public:
+		[[nodiscard]] static Result<ReadWriteCursor> open(ReadWriteTransaction& transaction, ReadWriteDatabase& database) noexcept;
+
+		// the cursor is moved to the new record
+		[[nodiscard]] ReturnCode put(std::span<const std::byte> key, std::span<const std::byte> value) noexcept;
+		// after deletion next() moves the cursor to the record that followed the deleted one
+		[[nodiscard]] ReturnCode deleteCurrent() noexcept;
 
 	private:
-		MDB_cursor* mMdbCursor;
+		ReadWriteCursor(MDB_cursor* mdbCursor) noexcept;
 	};
 } // namespace Lmdb
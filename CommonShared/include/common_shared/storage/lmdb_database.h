@@ -4,6 +4,7 @@
 #pragma once
 
 #include <cstddef>
+#include <cstdint>
 #include <span>
 #include <vector>
 
@@ -16,6 +17,20 @@ typedef unsigned int MDB_dbi;
 
 namespace Lmdb
 {
+	enum class DatabaseType : uint8_t
+	{
+		// one value per key
+		Default,
+		// any number of sorted values of the same size per key, they can be read in bulk with Cursor::getMultiple
+		FixedSizeDuplicates,
+	};
+
+	struct RecordView
+	{
+		std::span<const std::byte> key;
+		std::span<const std::byte> value;
+	};
+
 	class Database
 	{
 	public:
@@ -27,7 +42,7 @@ namespace Lmdb
 		Database& operator=(Database&&) noexcept;
 
 		[[nodiscard]] ReturnCode get(std::span<const std::byte> key, std::span<std::byte> outBuffer, size_t& readBytes) noexcept;
-		[[nodiscard]] ReturnCode getDynamic(std::span<const std::byte> key, std::vector<std::byte> outValue) noexcept;
+		[[nodiscard]] ReturnCode getDynamic(std::span<const std::byte> key, std::vector<std::byte>& outValue) noexcept;
 
 		// doesn't perform extra copy of the buffer, but need to be careful not to store pointers to the value data
 		[[nodiscard]] ReturnCode readValue(std::span<const std::byte> key, auto readFn) noexcept
@@ -61,14 +76,24 @@ namespace Lmdb
 	class ReadWriteDatabase : public Database
 	{
 	public:
-		[[nodiscard]] static Result<ReadWriteDatabase> open(ReadWriteTransaction& transaction, std::zstring_view name) noexcept;
+		// the type is used only when the database is created
+		[[nodiscard]] static Result<ReadWriteDatabase> open(ReadWriteTransaction& transaction, std::zstring_view name, DatabaseType type = DatabaseType::Default) noexcept;
 
+		// for FixedSizeDuplicates adds the value to the values of the key
 		[[nodiscard]] ReturnCode put(std::span<const std::byte> key, std::span<const std::byte> value) noexcept;
+		// only for Default databases, inserts the records in key order (the span gets sorted),
+		// records after the last key of the database are appended without searching the tree,
+		// for equal keys the last of them wins, same as with separate put calls
+		[[nodiscard]] ReturnCode putBatch(std::span<RecordView> inOutRecords) noexcept;
+		// only for Default databases, returns the memory for the value to be written in place,
+		// it is valid only until the next change in the transaction
+		[[nodiscard]] Result<std::span<std::byte>> reserve(std::span<const std::byte> key, size_t valueSize) noexcept;
+		// for FixedSizeDuplicates removes all the values of the key
 		[[nodiscard]] ReturnCode deleteKey(std::span<const std::byte> key) noexcept;
 
 		// removes all the data from the database and keeps it open
 		[[nodiscard]] ReturnCode emptyDatabase() noexcept;
-		// removes the database and closes it
+		// removes the database and closes it, shouldn't be used for the databases opened with Environment::openDatabaseHandles
 		[[nodiscard]] ReturnCode dropDatabase() noexcept;
 
 	private:
@@ -3,18 +3,92 @@
 
 #pragma once
 
+#include <chrono>
+#include <cstdint>
 #include <filesystem>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <zstring_view.hpp>
 
 #include "common_shared/storage/lmdb_return_codes.h"
 
 struct MDB_env;
+struct MDB_txn;
+typedef unsigned int MDB_dbi;
 
 namespace Lmdb
 {
+	enum class SyncMode : uint8_t
+	{
+		// every commit is flushed to disk before it returns
+		Full,
+		// the data is flushed on commit, but the meta page is not, a system crash can undo the last commit
+		NoMetaSync,
+		// nothing is flushed on commit, a system crash can undo the commits made after the last sync() call,
+		// or even corrupt the database if the filesystem doesn't keep the order of writes
+		NoSync,
+	};
+
+	struct EnvironmentOptions
+	{
+		SyncMode syncMode = SyncMode::Full;
+		// modified pages are written right into the memory map instead of separate writes to the file,
+		// faster for big transactions, but a stray write into the mapped memory can corrupt the database
+		bool useWriteMap = false;
+		// the map grows automatically when it gets full (see retryOnMapFull), each growth waits for all transactions to be closed
+		size_t initialMapSize = 1 * 1024 * 1024 * 1024;
+	};
+
+	// the parts of the environment that transactions refer to, they keep their address when the environment is moved
+	class EnvironmentCache
+	{
+	public:
+		EnvironmentCache() noexcept = default;
+		~EnvironmentCache() noexcept;
+
+		EnvironmentCache(const EnvironmentCache&) = delete;
+		EnvironmentCache& operator=(const EnvironmentCache&) = delete;
+		EnvironmentCache(EnvironmentCache&&) = delete;
+		EnvironmentCache& operator=(EnvironmentCache&&) = delete;
+
+		// a reset read-only transaction that can be renewed, nullptr if there are none
+		[[nodiscard]] MDB_txn* takeReadTransaction() noexcept;
+		// the transaction is reset and kept for reuse, or aborted if there are enough of them already
+		void releaseReadTransaction(MDB_txn* mdbTransaction) noexcept;
+
+		[[nodiscard]] std::optional<MDB_dbi> findDatabaseHandle(std::string_view name) const noexcept;
+
+		// held by every open transaction, the map can't be resized until all of them are closed
+		[[nodiscard]] std::shared_lock<std::shared_timed_mutex> lockMapForTransaction() noexcept;
+		// waits for the open transactions to close, the returned lock doesn't own the mutex if they didn't close in time
+		[[nodiscard]] std::unique_lock<std::shared_timed_mutex> tryLockMapForResize() noexcept;
+
+	private:
+		friend class Environment;
+
+		static constexpr size_t MaxPooledReadTransactions = 8;
+		static constexpr std::chrono::seconds MapResizeTimeout{ 1 };
+
+		std::shared_timed_mutex mMapResizeMutex;
+		std::mutex mPoolMutex;
+		std::vector<MDB_txn*> mPooledReadTransactions;
+		// filled by Environment::openDatabaseHandles before any other transactions start, so it is read without locking
+		std::map<std::string, MDB_dbi, std::less<>> mDatabaseHandles;
+	};
+
 	class Environment
 	{
 	public:
-		[[nodiscard]] static Result<Environment> open(const std::filesystem::path& path, size_t maxNamedDatabases) noexcept;
+		[[nodiscard]] static Result<Environment> open(const std::filesystem::path& path, size_t maxNamedDatabases, const EnvironmentOptions& options = {}) noexcept;
 		~Environment() noexcept;
 
 		Environment(const Environment&) = delete;
@@ -24,13 +98,30 @@ namespace Lmdb
 
 		[[nodiscard]] Result<int> checkForStaleReaders() noexcept;
 
+		// opens the named databases once (creating the missing ones) and keeps their handles until the environment is closed,
+		// so the databases are opened later without a lookup by name, should be called before any other transactions start
+		[[nodiscard]] ReturnCode openDatabaseHandles(std::span<const std::zstring_view> names) noexcept;
+
+		[[nodiscard]] ReturnCode setSyncMode(SyncMode syncMode) noexcept;
+		// flushes the commits made with NoSync or NoMetaSync to disk
+		[[nodiscard]] ReturnCode sync() noexcept;
+
+		[[nodiscard]] size_t getMapSize() noexcept;
+		// doubles the size of the memory map once all transactions of this environment are closed,
+		// returns EnvironmentIsBusy if they stay open (e.g. the calling thread keeps one open itself)
+		// fullMapSize is the map size seen before the transaction that got MapFull, if another thread has grown the map since then,
+		// it is not grown again
+		[[nodiscard]] ReturnCode growMap(size_t fullMapSize) noexcept;
+
 		[[nodiscard]] bool isValid() const noexcept { return mMdbEnvironment != nullptr; }
 		[[nodiscard]] MDB_env* getRaw() noexcept { return mMdbEnvironment; };
+		[[nodiscard]] EnvironmentCache* getCache() noexcept { return mCache.get(); }
 
 	private:
 		Environment(MDB_env* mdbEnvironment) noexcept;
 
 	private:
 		MDB_env* mMdbEnvironment;
+		std::unique_ptr<EnvironmentCache> mCache;
 	};
 } // namespace Lmdb
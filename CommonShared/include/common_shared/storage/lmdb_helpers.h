@@ -3,8 +3,13 @@
 
 #pragma once
 
+#include <algorithm>
+#include <span>
+
+#include "common_shared/debug/assert.h"
 #include "common_shared/storage/lmdb_cursor.h"
 #include "common_shared/storage/lmdb_database.h"
+#include "common_shared/storage/lmdb_environment.h"
 #include "common_shared/storage/lmdb_transaction.h"
 
 namespace Lmdb
@@ -56,6 +61,131 @@ namespace Lmdb
 		return ReturnCode::Success;
 	}
 
+	[[nodiscard]] inline bool hasKeyPrefix(std::span<const std::byte> key, std::span<const std::byte> prefix) noexcept
+	{
+		return key.size() >= prefix.size() && std::ranges::equal(key.first(prefix.size()), prefix);
+	}
+
+	// calls readFn for the records with keys starting with the prefix, in key order
+	ReturnCode readDbRecordsWithPrefix(ReadOnlyTransaction& transaction, ReadOnlyDatabase& database, std::span<const std::byte> prefix, auto readFn) noexcept
+	{
+		Result<ReadOnlyCursor> cursorRes = ReadOnlyCursor::open(transaction, database);
+		if (cursorRes.isError())
+		{
+			return cursorRes.getError();
+		}
+		ReadOnlyCursor cursor = cursorRes.consumeResult();
+
+		ReturnCode returnCode = cursor.seek(prefix);
+		while (returnCode == ReturnCode::Success)
+		{
+			const Result<CursorDataView> record = cursor.get();
+			if (record.isError())
+			{
+				returnCode = record.getError();
+				break;
+			}
+
+			if (!hasKeyPrefix(record->key, prefix))
+			{
+				// the keys are sorted, so no more keys with this prefix
+				return ReturnCode::Success;
+			}
+			readFn(record->key, record->value);
+
+			returnCode = cursor.next();
+		}
+
+		if (returnCode != ReturnCode::NotFound)
+		{
+			return returnCode;
+		}
+		return ReturnCode::Success;
+	}
+
+	// removes the records with keys starting with the prefix without scanning the rest of the database
+	[[nodiscard]] ReturnCode deleteDbRecordsWithPrefix(ReadWriteTransaction& transaction, ReadWriteDatabase& database, std::span<const std::byte> prefix) noexcept;
+
+	// calls readFn for each value of the key in a FixedSizeDuplicates database, reading the values in bulk
+	ReturnCode readAllDuplicates(ReadOnlyTransaction& transaction, ReadOnlyDatabase& database, std::span<const std::byte> key, auto readFn) noexcept
+	{
+		Result<ReadOnlyCursor> cursorRes = ReadOnlyCursor::open(transaction, database);
+		if (cursorRes.isError())
+		{
+			return cursorRes.getError();
+		}
+		ReadOnlyCursor cursor = cursorRes.consumeResult();
+
+		ReturnCode returnCode = cursor.seek(key);
+		if (returnCode != ReturnCode::Success)
+		{
+			return returnCode == ReturnCode::NotFound ? ReturnCode::Success : returnCode;
+		}
+
+		const Result<CursorDataView> firstRecord = cursor.get();
+		if (firstRecord.isError())
+		{
+			return firstRecord.getError();
+		}
+		if (!std::ranges::equal(firstRecord->key, key))
+		{
+			return ReturnCode::Success;
+		}
+
+		const size_t valueSize = firstRecord->value.size();
+		if (valueSize == 0)
+		{
+			reportReleaseError("Values of a database with duplicates can't be empty");
+			return ReturnCode::BadValueSize;
+		}
+
+		Result<std::span<const std::byte>> values = cursor.getMultiple();
+		while (values.isValid())
+		{
+			if (values->size() % valueSize != 0)
+			{
+				reportReleaseError("Unexpected size of multiple values {} for value size {}", values->size(), valueSize);
+				return ReturnCode::BadValueSize;
+			}
+
+			for (size_t offset = 0; offset < values->size(); offset += valueSize)
+			{
+				readFn(values->subspan(offset, valueSize));
+			}
+
+			values = cursor.nextMultiple();
+		}
+
+		if (values.getError() != ReturnCode::NotFound)
+		{
+			return values.getError();
+		}
+		return ReturnCode::Success;
+	}
+
+	// transactionFn should create, fill and commit its own transaction and return the result,
+	// if it fails because the map is full, the map is grown and transactionFn is called again
+	[[nodiscard]] ReturnCode retryOnMapFull(Environment& environment, auto transactionFn) noexcept
+	{
+		// each retry doubles the map size
+		static constexpr int MaxAttempts = 8;
+
+		for (int attempt = 1;; ++attempt)
+		{
+			const size_t mapSize = environment.getMapSize();
+			const ReturnCode returnCode = transactionFn();
+			if (returnCode != ReturnCode::MapFull || attempt == MaxAttempts)
+			{
+				return returnCode;
+			}
+
+			if (const ReturnCode growResult = environment.growMap(mapSize); growResult != ReturnCode::Success)
+			{
+				return growResult;
+			}
+		}
+	}
+
 	ReturnCode ReadOnlySingleDbWrapper::readAllDbRecords(auto readFn) noexcept
 	{
 		return ::Lmdb::readAllDbRecords(transaction, database, readFn);
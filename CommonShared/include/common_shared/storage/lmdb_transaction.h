@@ -3,6 +3,8 @@
 
 #pragma once
 
+#include <shared_mutex>
+
 #include "common_shared/storage/lmdb_return_codes.h"
 
 struct MDB_txn;
@@ -10,6 +12,7 @@ struct MDB_txn;
 namespace Lmdb
 {
 	class Environment;
+	class EnvironmentCache;
 	class Transaction
 	{
 	public:
@@ -24,12 +27,18 @@ namespace Lmdb
 
 		[[nodiscard]] bool isValid() const noexcept { return mMdbTransaction != nullptr; }
 		[[nodiscard]] MDB_txn* getRaw() noexcept { return mMdbTransaction; }
+		[[nodiscard]] EnvironmentCache* getEnvironmentCache() noexcept { return mEnvironmentCache; }
 
 	protected:
-		Transaction(MDB_txn* mdbTransaction) noexcept;
+		Transaction(MDB_txn* mdbTransaction, EnvironmentCache* environmentCache, std::shared_lock<std::shared_timed_mutex>&& mapLock) noexcept;
+
+		void releaseMapLock() noexcept;
 
 	protected:
 		MDB_txn* mMdbTransaction;
+		EnvironmentCache* mEnvironmentCache;
+		// keeps the map from being resized while the transaction is open
+		std::shared_lock<std::shared_timed_mutex> mMapLock;
 	};
 
 	class ReadWriteTransaction : public Transaction
@@ -40,15 +49,21 @@ namespace Lmdb
 		[[nodiscard]] ReturnCode commit() noexcept;
 
 	private:
-		ReadWriteTransaction(MDB_txn* mdbTransaction) noexcept;
+		ReadWriteTransaction(MDB_txn* mdbTransaction, EnvironmentCache* environmentCache, std::shared_lock<std::shared_timed_mutex>&& mapLock) noexcept;
 	};
 
+	// reuses the transactions from the pool of the environment, and returns them there when destroyed
 	class ReadOnlyTransaction : public Transaction
 	{
 	public:
+		~ReadOnlyTransaction() noexcept;
+
+		ReadOnlyTransaction(ReadOnlyTransaction&&) noexcept = default;
+		ReadOnlyTransaction& operator=(ReadOnlyTransaction&&) noexcept = default;
+
 		static Result<ReadOnlyTransaction> create(Environment& environment) noexcept;
 
 	private:
-		ReadOnlyTransaction(MDB_txn* mdbTransaction) noexcept;
+		ReadOnlyTransaction(MDB_txn* mdbTransaction, EnvironmentCache* environmentCache, std::shared_lock<std::shared_timed_mutex>&& mapLock) noexcept;
 	};
 } // namespace Lmdb
@@ -0,0 +1,298 @@
+// Copyright (C) Pavel Grebnev 2026
+// Distributed under the MIT License (license terms are at http://opensource.org/licenses/MIT).
+
+#pragma once
+
+#include <array>
+#include <concepts>
+#include <cstddef>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+#include "common_shared/debug/assert.h"
+#include "common_shared/serialization/number_serialization.h"
+#include "common_shared/storage/lmdb_database.h"
+#include "common_shared/storage/lmdb_helpers.h"
+
+namespace Lmdb
+{
+	/**
+	 * Codecs describe how the keys and values are stored in the database:
+	 * Type is what is written, encode(Type) returns the bytes or something that owns them (array or string),
+	 * View is what is read, decode returns it without copying the data, nullopt if the stored bytes don't fit.
+	 * IsBorrowedView is true if View points into the decoded bytes instead of owning its data.
+	 */
+	namespace Codecs
+	{
+		// raw bytes of a known size, e.g. IDs and keys
+		template<size_t N>
+		struct FixedBytes
+		{
+			using Type = std::array<std::byte, N>;
+			using View = std::span<const std::byte, N>;
+			static constexpr bool IsBorrowedView = true;
+
+			[[nodiscard]] static std::span<const std::byte> encode(const Type& value) noexcept
+			{
+				return value;
+			}
+
+			[[nodiscard]] static std::optional<View> decode(std::span<const std::byte> data) noexcept
+			{
+				if (data.size() != N)
+				{
+					return std::nullopt;
+				}
+				return data.first<N>();
+			}
+		};
+
+		// raw bytes of any size, e.g. records serialized with a RecordSchema
+		struct Bytes
+		{
+			using Type = std::span<const std::byte>;
+			using View = std::span<const std::byte>;
+			static constexpr bool IsBorrowedView = true;
+
+			[[nodiscard]] static std::span<const std::byte> encode(Type value) noexcept
+			{
+				return value;
+			}
+
+			[[nodiscard]] static std::optional<View> decode(std::span<const std::byte> data) noexcept
+			{
+				return data;
+			}
+		};
+
+		// big-endian, so the keys are sorted by LMDB in the numeric order
+		template<std::unsigned_integral T>
+			requires (sizeof(T) == 2 || sizeof(T) == 4 || sizeof(T) == 8)
+		struct BigEndian
+		{
+			using Type = T;
+			using View = T;
+			static constexpr bool IsBorrowedView = false;
+
+			[[nodiscard]] static std::array<std::byte, sizeof(T)> encode(T value) noexcept
+			{
+				std::array<std::byte, sizeof(T)> result;
+				if constexpr (sizeof(T) == 2)
+				{
+					Serialization::writeUint16(result[0], result[1], value);
+				}
+				else if constexpr (sizeof(T) == 4)
+				{
+					Serialization::writeUint32(result, value);
+				}
+				else
+				{
+					Serialization::writeUint64(result, value);
+				}
+				return result;
+			}
+
+			[[nodiscard]] static std::optional<View> decode(std::span<const std::byte> data) noexcept
+			{
+				if (data.size() != sizeof(T))
+				{
+					return std::nullopt;
+				}
+
+				if constexpr (sizeof(T) == 2)
+				{
+					return Serialization::readUint16(data[0], data[1]);
+				}
+				else if constexpr (sizeof(T) == 4)
+				{
+					return Serialization::readUint32(data);
+				}
+				else
+				{
+					return Serialization::readUint64(data);
+				}
+			}
+		};
+
+		struct String
+		{
+			using Type = std::string_view;
+			using View = std::string_view;
+			static constexpr bool IsBorrowedView = true;
+
+			[[nodiscard]] static std::span<const std::byte> encode(Type value) noexcept
+			{
+				return std::as_bytes(std::span(value));
+			}
+
+			[[nodiscard]] static std::optional<View> decode(std::span<const std::byte> data) noexcept
+			{
+				return std::string_view(reinterpret_cast<const char*>(data.data()), data.size());
+			}
+		};
+
+		// stored the same way as path.string(), the paths are read back as strings to not allocate
+		struct PathString
+		{
+			using Type = std::filesystem::path;
+			using View = std::string_view;
+			static constexpr bool IsBorrowedView = true;
+
+			[[nodiscard]] static auto encode(const Type& value) noexcept
+			{
+				if constexpr (std::is_same_v<std::filesystem::path::value_type, char>)
+				{
+					// the native representation is already what string() returns
+					return std::as_bytes(std::span(value.native()));
+				}
+				else
+				{
+					return value.string();
+				}
+			}
+
+			[[nodiscard]] static std::optional<View> decode(std::span<const std::byte> data) noexcept
+			{
+				return String::decode(data);
+			}
+		};
+	} // namespace Codecs
+
+	namespace TypedDatabaseInternal
+	{
+		[[nodiscard]] inline std::span<const std::byte> toBytes(std::span<const std::byte> encoded) noexcept
+		{
+			return encoded;
+		}
+
+		template<size_t N>
+		[[nodiscard]] std::span<const std::byte> toBytes(const std::array<std::byte, N>& encoded) noexcept
+		{
+			return encoded;
+		}
+
+		[[nodiscard]] inline std::span<const std::byte> toBytes(const std::string& encoded) noexcept
+		{
+			return std::as_bytes(std::span(encoded));
+		}
+	} // namespace TypedDatabaseInternal
+
+	/**
+	 * Typed access to an opened database, the keys and values are converted by the codecs at compile time.
+	 * The values that point into the memory of the transaction (see IsBorrowedView) are not returned,
+	 * they are only passed to the callbacks of read() and readAllRecords(), so they don't allocate or copy.
+	 * The views stay valid only during the call, copy the data to keep it for longer.
+	 * get() returns the values that own their data, e.g. numbers.
+	 */
+	template<typename KeyCodec, typename ValueCodec, typename DatabaseT = ReadOnlyDatabase>
+	class TypedDatabase
+	{
+	public:
+		using Key = typename KeyCodec::Type;
+		using Value = typename ValueCodec::Type;
+		using KeyView = typename KeyCodec::View;
+		using ValueView = typename ValueCodec::View;
+
+	public:
+		explicit TypedDatabase(DatabaseT& database) noexcept
+			: mDatabase(database)
+		{}
+
+		TypedDatabase(const TypedDatabase&) = delete;
+		TypedDatabase& operator=(const TypedDatabase&) = delete;
+		TypedDatabase(TypedDatabase&&) = delete;
+		TypedDatabase& operator=(TypedDatabase&&) = delete;
+
+		// calls readFn(ValueView) if the key is found, BadValueSize if the stored value can't be decoded
+		[[nodiscard]] ReturnCode read(const Key& key, auto readFn) noexcept
+		{
+			const auto encodedKey = KeyCodec::encode(key);
+			std::optional<size_t> undecodedValueSize;
+			const ReturnCode returnCode = mDatabase.readValue(TypedDatabaseInternal::toBytes(encodedKey), [&readFn, &undecodedValueSize](std::span<const std::byte> data) {
+				std::optional<ValueView> value = ValueCodec::decode(data);
+				if (!value.has_value())
+				{
+					undecodedValueSize = data.size();
+					return;
+				}
+				readFn(*value);
+			});
+			if (returnCode != ReturnCode::Success)
+			{
+				return returnCode;
+			}
+
+			if (undecodedValueSize.has_value())
+			{
+				reportReleaseError("Stored value can't be decoded, value size: {}", *undecodedValueSize);
+				return ReturnCode::BadValueSize;
+			}
+			return ReturnCode::Success;
+		}
+
+		// BadValueSize if the stored value can't be decoded
+		[[nodiscard]] Result<ValueView> get(const Key& key) noexcept
+			requires (!ValueCodec::IsBorrowedView)
+		{
+			std::optional<ValueView> result;
+			const ReturnCode returnCode = read(key, [&result](ValueView value) {
+				result = std::move(value);
+			});
+			if (returnCode != ReturnCode::Success)
+			{
+				return returnCode;
+			}
+			return std::move(*result);
+		}
+
+		[[nodiscard]] bool contains(const Key& key) noexcept
+		{
+			const auto encodedKey = KeyCodec::encode(key);
+			return mDatabase.readValue(TypedDatabaseInternal::toBytes(encodedKey), [](std::span<const std::byte>) {}) == ReturnCode::Success;
+		}
+
+		// calls readFn(KeyView, ValueView) for all the records in key order, the records that can't be decoded are skipped
+		[[nodiscard]] ReturnCode readAllRecords(ReadOnlyTransaction& transaction, auto readFn) noexcept
+			requires std::same_as<DatabaseT, ReadOnlyDatabase>
+		{
+			return readAllDbRecords(transaction, mDatabase, [&readFn](std::span<const std::byte> keyData, std::span<const std::byte> valueData) {
+				std::optional<KeyView> key = KeyCodec::decode(keyData);
+				std::optional<ValueView> value = ValueCodec::decode(valueData);
+				if (!key.has_value() || !value.has_value())
+				{
+					reportReleaseError("Stored record can't be decoded, key size: {}, value size: {}", keyData.size(), valueData.size());
+					return;
+				}
+				readFn(*key, *value);
+			});
+		}
+
+		[[nodiscard]] ReturnCode put(const Key& key, const Value& value) noexcept
+			requires std::same_as<DatabaseT, ReadWriteDatabase>
+		{
+			const auto encodedKey = KeyCodec::encode(key);
+			const auto encodedValue = ValueCodec::encode(value);
+			return mDatabase.put(TypedDatabaseInternal::toBytes(encodedKey), TypedDatabaseInternal::toBytes(encodedValue));
+		}
+
+		[[nodiscard]] ReturnCode deleteKey(const Key& key) noexcept
+			requires std::same_as<DatabaseT, ReadWriteDatabase>
+		{
+			const auto encodedKey = KeyCodec::encode(key);
+			return mDatabase.deleteKey(TypedDatabaseInternal::toBytes(encodedKey));
+		}
+
+		[[nodiscard]] DatabaseT& getUntyped() noexcept { return mDatabase; }
+
+	private:
+		DatabaseT& mDatabase;
+	};
+
+	template<typename KeyCodec, typename ValueCodec>
+	using TypedReadWriteDatabase = TypedDatabase<KeyCodec, ValueCodec, ReadWriteDatabase>;
+} // namespace Lmdb
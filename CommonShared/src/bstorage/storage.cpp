@@ -7,7 +7,10 @@
 #include <bit>
 #include <fstream>
 #include <iostream>
+#include <vector>
 
+#include "common_shared/cryptography/utils/crypto_wipe.h"
+#include "common_shared/files/file_utils.h"
 #include "common_shared/serialization/number_serialization.h"
 
 namespace BStorage
@@ -33,18 +36,57 @@ namespace BStorage
 		return std::make_tuple(std::move(*newValue), version);
 	}
 
+	std::optional<StorageView> loadStorageView(const std::filesystem::path& filePath) noexcept
+	{
+		std::optional<Files::MappedFile> file = Files::MappedFile::open(filePath);
+		if (!file.has_value())
+		{
+			return std::nullopt;
+		}
+
+		const std::span<const std::byte> data = file->getData();
+		if (data.size() < 2)
+		{
+			return std::nullopt;
+		}
+
+		const uint16_t version = Serialization::readUint16(data[0], data[1]);
+
+		const std::optional<ValueView> root = ValueView::parse(data.subspan(2));
+		if (!root.has_value())
+		{
+			return std::nullopt;
+		}
+
+		return StorageView(std::move(*file), *root, version);
+	}
+
+	StorageView::StorageView(Files::MappedFile&& file, const ValueView root, const uint16_t version) noexcept
+		: mFile(std::move(file))
+		, mRoot(root)
+		, mVersion(version)
+	{
+	}
+
 	bool saveStorage(const std::filesystem::path& filePath, const Value& storage, uint16_t version) noexcept
 	{
-		std::ofstream filestream(filePath, std::ios::binary);
-		if (!filestream)
+		const std::optional<size_t> storageSize = storage.getSerializedSize();
+		if (!storageSize.has_value())
 		{
 			return false;
 		}
 
-		std::array<std::byte, 2> versionBytes = {};
-		Serialization::writeUint16(versionBytes[0], versionBytes[1], version);
-		filestream.write(reinterpret_cast<char*>(versionBytes.data()), versionBytes.size());
+		// the whole file is prepared in memory, so it can be written with one call
+		std::vector<std::byte> data(2 + *storageSize);
+		Serialization::writeUint16(data[0], data[1], version);
+		if (!storage.writeToBuffer(std::span(data).subspan(2)))
+		{
+			return false;
+		}
 
-		return storage.writeToStream(filestream);
+		const bool isSaved = Files::writeFileAtomically(filePath, data);
+		// the storages can have secrets
+		Cryptography::cryptoWipeRawData(data);
+		return isSaved;
 	}
 } // namespace BStorage
@@ -6,38 +6,17 @@
 #include <algorithm>
 #include <array>
 #include <bit>
+#include <cstring>
+#include <tuple>
 
+#include "common_shared/bstorage/utils_internal.h"
 #include "common_shared/cryptography/utils/crypto_wipe.h"
+#include "common_shared/debug/assert.h"
 
 namespace BStorage
 {
 	namespace Internal
 	{
-		enum class TagBits : uint8_t
-		{
-			DynamicUnknown = 0x00,
-
-			// fixed size
-			U8 = 0x10,
-			U16 = 0x20,
-			U32 = 0x30,
-			U64 = 0x40,
-
-			// variable size
-			String = 0x01,
-			ByteArray = 0x11,
-
-			// compound, recursive
-			OptionNull = 0x02,
-			OptionSet = 0x12,
-
-			ArrayEmpty = 0x03,
-			ArrayVariableTypes = 0x13,
-			ArraySameType = 0x23, // does not repeat the type for each element
-
-			Object = 0x04,
-		};
-
 		static TagBits getAssociatedTagBits(Tag tag)
 		{
 			switch (tag)
@@ -66,25 +45,79 @@ namespace BStorage
 			return TagBits::DynamicUnknown;
 		}
 
-		template<typename T>
-		static void writeUint(std::ostream& outputStream, T v)
+		class StreamWriter
+		{
+		public:
+			explicit StreamWriter(std::ostream& outputStream) noexcept
+				: mOutputStream(outputStream)
+			{}
+
+			void writeBytes(const void* data, size_t size) noexcept
+			{
+				mOutputStream.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+			}
+
+		private:
+			std::ostream& mOutputStream;
+		};
+
+		// the pre-pass that only counts the size of the serialized data
+		class SizeCounter
+		{
+		public:
+			void writeBytes(const void*, size_t size) noexcept { mSize += size; }
+			[[nodiscard]] size_t getSize() const noexcept { return mSize; }
+
+		private:
+			size_t mSize = 0;
+		};
+
+		class BufferWriter
+		{
+		public:
+			explicit BufferWriter(std::span<std::byte> buffer) noexcept
+				: mBuffer(buffer)
+			{}
+
+			void writeBytes(const void* data, size_t size) noexcept
+			{
+				if (size > mBuffer.size() - mBytesWritten)
+				{
+					mIsOverflown = true;
+					return;
+				}
+				std::memcpy(mBuffer.data() + mBytesWritten, data, size);
+				mBytesWritten += size;
+			}
+
+			[[nodiscard]] size_t getBytesWritten() const noexcept { return mBytesWritten; }
+			[[nodiscard]] bool isOverflown() const noexcept { return mIsOverflown; }
+
+		private:
+			std::span<std::byte> mBuffer;
+			size_t mBytesWritten = 0;
+			bool mIsOverflown = false;
+		};
+
+		template<typename T, typename Writer>
+		static void writeUint(Writer& writer, T v)
 		{
 			if constexpr (sizeof(v) == 1)
 			{
 				// ReSharper disable once CppDFAUnreachableCode
-				outputStream.write(reinterpret_cast<const char*>(&v), sizeof(v));
+				writer.writeBytes(&v, sizeof(v));
 			}
 			else if constexpr (std::endian::native == std::endian::big)
 			{
 				// ReSharper disable once CppDFAUnreachableCode
-				outputStream.write(reinterpret_cast<const char*>(&v), sizeof(v));
+				writer.writeBytes(&v, sizeof(v));
 			}
 			else
 			{
 				// ReSharper disable once CppDFAUnreachableCode
 				std::array<unsigned char, sizeof(T)> temp = std::bit_cast<std::array<unsigned char, sizeof(T)>>(v);
 				std::ranges::reverse(temp);
-				outputStream.write(reinterpret_cast<const char*>(temp.data()), temp.size());
+				writer.writeBytes(temp.data(), temp.size());
 			}
 		}
 
@@ -114,14 +147,13 @@ namespace BStorage
 			return v;
 		}
 
-		constexpr size_t MaxContainerSize = 0x3FFFFFFF;
-
-		static void writeSize(std::ostream& outputStream, size_t size)
+		template<typename Writer>
+		static void writeSize(Writer& writer, size_t size)
 		{
 			// most arrays are within 127 elements
 			if (size <= 0x7F)
 			{
-				writeUint<uint8_t>(outputStream, static_cast<uint8_t>(size));
+				writeUint<uint8_t>(writer, static_cast<uint8_t>(size));
 				return;
 			}
 
@@ -130,13 +162,13 @@ namespace BStorage
 			{
 				// make space for the bit to signal about 2 bit value
 				const uint16_t bitRepresentation = 0x8000 | ((size & 0x3F80) << 1) | (size & 0x7F);
-				writeUint<uint16_t>(outputStream, bitRepresentation);
+				writeUint<uint16_t>(writer, bitRepresentation);
 				return;
 			}
 
 			// and if we get value above 1073741823, we treat it as incorrect with MaxContainerSize
 			const uint32_t bitRepresentation = 0x80800000 | ((size & 0x3F800000) << 1) | (size & 0x7FFFFF);
-			writeUint<uint32_t>(outputStream, bitRepresentation);
+			writeUint<uint32_t>(writer, bitRepresentation);
 		}
 
 		[[nodiscard]] static size_t readSize(std::istream& inputStream)
@@ -158,8 +190,94 @@ namespace BStorage
 			const size_t lastBytes = readUint<uint16_t>(inputStream);
 			return ((firstByte & 0x7F) << 23) | ((secondByte & 0x7F) << 16) | lastBytes;
 		}
+
+		[[nodiscard]] static Value::OptionType makeOptionPointer(Value&& v, std::pmr::memory_resource* resource)
+		{
+			std::pmr::polymorphic_allocator<Value> allocator(resource);
+			Value* optionValue = allocator.allocate(1);
+			std::construct_at(optionValue, std::move(v));
+			return Value::OptionType(optionValue, Value::OptionDeleter{ resource });
+		}
+
+		[[nodiscard]] static std::string_view getKey(const Value::ObjectMap::value_type& entry) noexcept
+		{
+			return entry.first;
+		}
 	} // namespace Internal
 
+	Arena::Arena(const size_t initialBufferSize) noexcept
+		: mResource(initialBufferSize)
+	{
+	}
+
+	void Value::OptionDeleter::operator()(Value* value) const noexcept
+	{
+		std::destroy_at(value);
+		std::pmr::polymorphic_allocator<Value>(resource).deallocate(value, 1);
+	}
+
+	Value::ObjectMap::ObjectMap(std::pmr::memory_resource* resource) noexcept
+		: mEntries(resource)
+	{
+	}
+
+	std::pair<Value::ObjectMap::iterator, bool> Value::ObjectMap::emplace(std::string_view key, Value&& value) noexcept
+	{
+		// the serialized objects and deep copies come already sorted, so this is the common case
+		if (mEntries.empty() || Internal::getKey(mEntries.back()) < key)
+		{
+			mEntries.emplace_back(std::piecewise_construct, std::forward_as_tuple(key), std::forward_as_tuple(std::move(value)));
+			return { std::prev(mEntries.end()), true };
+		}
+
+		const iterator it = std::ranges::lower_bound(mEntries, key, std::ranges::less{}, Internal::getKey);
+		if (it != mEntries.end() && it->first == key)
+		{
+			return { it, false };
+		}
+
+		return { mEntries.emplace(it, std::piecewise_construct, std::forward_as_tuple(key), std::forward_as_tuple(std::move(value))), true };
+	}
+
+	Value::ObjectMap::iterator Value::ObjectMap::find(std::string_view key) noexcept
+	{
+		const iterator it = std::ranges::lower_bound(mEntries, key, std::ranges::less{}, Internal::getKey);
+		if (it != mEntries.end() && it->first == key)
+		{
+			return it;
+		}
+		return mEntries.end();
+	}
+
+	Value::ObjectMap::const_iterator Value::ObjectMap::find(std::string_view key) const noexcept
+	{
+		const const_iterator it = std::ranges::lower_bound(mEntries, key, std::ranges::less{}, Internal::getKey);
+		if (it != mEntries.end() && it->first == key)
+		{
+			return it;
+		}
+		return mEntries.end();
+	}
+
+	bool Value::ObjectMap::contains(std::string_view key) const noexcept
+	{
+		return find(key) != mEntries.end();
+	}
+
+	Value& Value::ObjectMap::at(std::string_view key) noexcept
+	{
+		const iterator it = find(key);
+		assertFatalRelease(it != mEntries.end(), "Key '{}' is not found in the object", key);
+		return it->second;
+	}
+
+	const Value& Value::ObjectMap::at(std::string_view key) const noexcept
+	{
+		const const_iterator it = find(key);
+		assertFatalRelease(it != mEntries.end(), "Key '{}' is not found in the object", key);
+		return it->second;
+	}
+
 	Value Value::makeU8(uint8_t v) noexcept
 	{
 		Value newValue(Tag::U8);
@@ -188,44 +306,52 @@ namespace BStorage
 		return newValue;
 	}
 
-	Value Value::makeString(std::string_view v) noexcept
+	Value Value::makeString(std::string_view v, std::pmr::memory_resource* resource) noexcept
 	{
 		Value newValue(Tag::String);
-		new (&newValue.mStorage.String) std::string(v);
+		new (&newValue.mStorage.String) StringType(v, resource);
 		return newValue;
 	}
 
-	Value Value::makeString(std::string&& v) noexcept
+	Value Value::makeString(StringType&& v) noexcept
 	{
 		Value newValue(Tag::String);
-		new (&newValue.mStorage.String) std::string(std::move(v));
+		new (&newValue.mStorage.String) StringType(std::move(v));
 		return newValue;
 	}
-	Value Value::makeByteArray(std::span<const std::byte> v) noexcept
+
+	Value Value::makeByteArray(std::span<const std::byte> v, std::pmr::memory_resource* resource) noexcept
 	{
 		Value newValue(Tag::ByteArray);
-		new (&newValue.mStorage.ByteArray) std::vector<std::byte>(v.begin(), v.end());
+		new (&newValue.mStorage.ByteArray) ByteArrayType(v.begin(), v.end(), resource);
 		return newValue;
 	}
 
-	Value Value::makeByteArray(std::vector<std::byte>&& v) noexcept
+	Value Value::makeByteArray(ByteArrayType&& v) noexcept
 	{
 		Value newValue(Tag::ByteArray);
-		new (&newValue.mStorage.ByteArray) std::vector<std::byte>(std::move(v));
+		new (&newValue.mStorage.ByteArray) ByteArrayType(std::move(v));
 		return newValue;
 	}
 
-	Value Value::makeOption(std::unique_ptr<Value>&& v) noexcept
+	Value Value::makeOption(Value&& v, std::pmr::memory_resource* resource) noexcept
 	{
 		Value newValue(Tag::Option);
-		new (&newValue.mStorage.Option) std::unique_ptr<Value>(std::move(v));
+		new (&newValue.mStorage.Option) OptionType(Internal::makeOptionPointer(std::move(v), resource));
 		return newValue;
 	}
 
-	Value Value::makeArray(std::vector<Value>&& v) noexcept
+	Value Value::makeEmptyOption() noexcept
+	{
+		Value newValue(Tag::Option);
+		new (&newValue.mStorage.Option) OptionType();
+		return newValue;
+	}
+
+	Value Value::makeArray(ArrayType&& v) noexcept
 	{
 		Value newValue(Tag::Array);
-		new (&newValue.mStorage.Array) std::vector<Value>(std::move(v));
+		new (&newValue.mStorage.Array) ArrayType(std::move(v));
 		return newValue;
 	}
 
@@ -308,7 +434,7 @@ namespace BStorage
 		return nullptr;
 	}
 
-	std::string* Value::asString() noexcept
+	Value::StringType* Value::asString() noexcept
 	{
 		if (mTag == Tag::String)
 		{
@@ -317,7 +443,7 @@ namespace BStorage
 		return nullptr;
 	}
 
-	const std::string* Value::asString() const noexcept
+	const Value::StringType* Value::asString() const noexcept
 	{
 		if (mTag == Tag::String)
 		{
@@ -325,7 +451,8 @@ namespace BStorage
 		}
 		return nullptr;
 	}
-	std::vector<std::byte>* Value::asByteArray() noexcept
+
+	Value::ByteArrayType* Value::asByteArray() noexcept
 	{
 		if (mTag == Tag::ByteArray)
 		{
@@ -334,7 +461,7 @@ namespace BStorage
 		return nullptr;
 	}
 
-	const std::vector<std::byte>* Value::asByteArray() const noexcept
+	const Value::ByteArrayType* Value::asByteArray() const noexcept
 	{
 		if (mTag == Tag::ByteArray)
 		{
@@ -343,7 +470,7 @@ namespace BStorage
 		return nullptr;
 	}
 
-	std::unique_ptr<Value>* Value::asOption() noexcept
+	Value::OptionType* Value::asOption() noexcept
 	{
 		if (mTag == Tag::Option)
 		{
@@ -352,7 +479,7 @@ namespace BStorage
 		return nullptr;
 	}
 
-	const std::unique_ptr<Value>* Value::asOption() const noexcept
+	const Value::OptionType* Value::asOption() const noexcept
 	{
 		if (mTag == Tag::Option)
 		{
@@ -361,7 +488,7 @@ namespace BStorage
 		return nullptr;
 	}
 
-	std::vector<Value>* Value::asArray() noexcept
+	Value::ArrayType* Value::asArray() noexcept
 	{
 		if (mTag == Tag::Array)
 		{
@@ -370,7 +497,7 @@ namespace BStorage
 		return nullptr;
 	}
 
-	const std::vector<Value>* Value::asArray() const noexcept
+	const Value::ArrayType* Value::asArray() const noexcept
 	{
 		if (mTag == Tag::Array)
 		{
@@ -397,7 +524,8 @@ namespace BStorage
 		return nullptr;
 	}
 
-	bool Value::writeToStream(std::ostream& outputStream, bool skipTag) const noexcept
+	template<typename Writer>
+	bool Value::writeTo(Writer& writer, bool skipTag) const noexcept
 	{
 		const Internal::TagBits tagBits = Internal::getAssociatedTagBits(mTag);
 		if (skipTag && tagBits == Internal::TagBits::DynamicUnknown)
@@ -408,30 +536,30 @@ namespace BStorage
 
 		if (!skipTag && tagBits != Internal::TagBits::DynamicUnknown)
 		{
-			Internal::writeUint<uint8_t>(outputStream, static_cast<uint8_t>(tagBits));
+			Internal::writeUint<uint8_t>(writer, static_cast<uint8_t>(tagBits));
 		}
 
 		switch (mTag)
 		{
 		case Tag::U8:
-			Internal::writeUint<uint8_t>(outputStream, mStorage.U8);
+			Internal::writeUint<uint8_t>(writer, mStorage.U8);
 			return true;
 		case Tag::U16:
-			Internal::writeUint<uint16_t>(outputStream, mStorage.U16);
+			Internal::writeUint<uint16_t>(writer, mStorage.U16);
 			return true;
 		case Tag::U32:
-			Internal::writeUint<uint32_t>(outputStream, mStorage.U32);
+			Internal::writeUint<uint32_t>(writer, mStorage.U32);
 			return true;
 		case Tag::U64:
-			Internal::writeUint<uint64_t>(outputStream, mStorage.U64);
+			Internal::writeUint<uint64_t>(writer, mStorage.U64);
 			return true;
 		case Tag::String: {
 			if (mStorage.String.size() > Internal::MaxContainerSize)
 			{
 				return false;
 			}
-			Internal::writeSize(outputStream, mStorage.String.size());
-			outputStream.write(mStorage.String.data(), mStorage.String.size());
+			Internal::writeSize(writer, mStorage.String.size());
+			writer.writeBytes(mStorage.String.data(), mStorage.String.size());
 			return true;
 		}
 		case Tag::ByteArray: {
@@ -439,19 +567,19 @@ namespace BStorage
 			{
 				return false;
 			}
-			Internal::writeSize(outputStream, mStorage.ByteArray.size());
-			outputStream.write(reinterpret_cast<const char*>(mStorage.ByteArray.data()), mStorage.ByteArray.size());
+			Internal::writeSize(writer, mStorage.ByteArray.size());
+			writer.writeBytes(mStorage.ByteArray.data(), mStorage.ByteArray.size());
 			return true;
 		}
 		case Tag::Option: {
 			if (mStorage.Option)
 			{
-				Internal::writeUint<uint8_t>(outputStream, static_cast<uint8_t>(Internal::TagBits::OptionSet));
-				return mStorage.Option->writeToStream(outputStream);
+				Internal::writeUint<uint8_t>(writer, static_cast<uint8_t>(Internal::TagBits::OptionSet));
+				return mStorage.Option->writeTo(writer, false);
 			}
 			else
 			{
-				Internal::writeUint<uint8_t>(outputStream, static_cast<uint8_t>(Internal::TagBits::OptionNull));
+				Internal::writeUint<uint8_t>(writer, static_cast<uint8_t>(Internal::TagBits::OptionNull));
 				return true;
 			}
 		}
@@ -463,7 +591,7 @@ namespace BStorage
 
 			if (mStorage.Array.empty())
 			{
-				Internal::writeUint<uint8_t>(outputStream, static_cast<uint8_t>(Internal::TagBits::ArrayEmpty));
+				Internal::writeUint<uint8_t>(writer, static_cast<uint8_t>(Internal::TagBits::ArrayEmpty));
 				return true;
 			}
 
@@ -490,12 +618,12 @@ namespace BStorage
 
 			if (allAreSameType)
 			{
-				Internal::writeUint<uint8_t>(outputStream, static_cast<uint8_t>(Internal::TagBits::ArraySameType));
-				Internal::writeSize(outputStream, mStorage.Array.size());
-				Internal::writeUint<uint8_t>(outputStream, static_cast<uint8_t>(firstTagBits));
+				Internal::writeUint<uint8_t>(writer, static_cast<uint8_t>(Internal::TagBits::ArraySameType));
+				Internal::writeSize(writer, mStorage.Array.size());
+				Internal::writeUint<uint8_t>(writer, static_cast<uint8_t>(firstTagBits));
 				for (const Value& v : mStorage.Array)
 				{
-					if (v.writeToStream(outputStream, true) == false)
+					if (v.writeTo(writer, true) == false)
 					{
 						return false;
 					}
@@ -503,11 +631,11 @@ namespace BStorage
 			}
 			else
 			{
-				Internal::writeUint<uint8_t>(outputStream, static_cast<uint8_t>(Internal::TagBits::ArrayVariableTypes));
-				Internal::writeSize(outputStream, mStorage.Array.size());
+				Internal::writeUint<uint8_t>(writer, static_cast<uint8_t>(Internal::TagBits::ArrayVariableTypes));
+				Internal::writeSize(writer, mStorage.Array.size());
 				for (const Value& v : mStorage.Array)
 				{
-					if (v.writeToStream(outputStream) == false)
+					if (v.writeTo(writer, false) == false)
 					{
 						return false;
 					}
@@ -520,17 +648,17 @@ namespace BStorage
 			{
 				return false;
 			}
-			Internal::writeSize(outputStream, mStorage.Object.size());
-			for (const std::pair<const std::string, Value>& pair : mStorage.Object)
+			Internal::writeSize(writer, mStorage.Object.size());
+			for (const ObjectMap::value_type& pair : mStorage.Object)
 			{
 				if (pair.first.size() > Internal::MaxContainerSize)
 				{
 					return false;
 				}
-				Internal::writeSize(outputStream, pair.first.size());
-				outputStream.write(pair.first.data(), pair.first.size());
+				Internal::writeSize(writer, pair.first.size());
+				writer.writeBytes(pair.first.data(), pair.first.size());
 
-				if (pair.second.writeToStream(outputStream) == false)
+				if (pair.second.writeTo(writer, false) == false)
 				{
 					return false;
 				}
@@ -543,7 +671,33 @@ namespace BStorage
 		return false;
 	}
 
-	std::optional<Value> Value::readFromStream(std::istream& inputStream, std::optional<uint8_t> forcedTag) noexcept
+	bool Value::writeToStream(std::ostream& outputStream, bool skipTag) const noexcept
+	{
+		Internal::StreamWriter writer(outputStream);
+		return writeTo(writer, skipTag);
+	}
+
+	std::optional<size_t> Value::getSerializedSize() const noexcept
+	{
+		Internal::SizeCounter counter;
+		if (!writeTo(counter, false))
+		{
+			return std::nullopt;
+		}
+		return counter.getSize();
+	}
+
+	bool Value::writeToBuffer(std::span<std::byte> buffer) const noexcept
+	{
+		Internal::BufferWriter writer(buffer);
+		if (!writeTo(writer, false) || writer.isOverflown())
+		{
+			return false;
+		}
+		return writer.getBytesWritten() == buffer.size();
+	}
+
+	std::optional<Value> Value::readFromStream(std::istream& inputStream, std::optional<uint8_t> forcedTag, std::pmr::memory_resource* resource) noexcept
 	{
 		uint8_t tagBits;
 		if (forcedTag.has_value())
@@ -567,25 +721,25 @@ namespace BStorage
 			return makeU64(Internal::readUint<uint64_t>(inputStream));
 		case static_cast<uint8_t>(Internal::TagBits::String): {
 			const size_t size = Internal::readSize(inputStream);
-			std::string result;
+			StringType result(resource);
 			result.resize(size);
 			inputStream.read(result.data(), result.size());
 			return makeString(std::move(result));
 		}
 		case static_cast<uint8_t>(Internal::TagBits::ByteArray): {
 			const size_t size = Internal::readSize(inputStream);
-			std::vector<std::byte> result;
+			ByteArrayType result(resource);
 			result.resize(size);
 			inputStream.read(reinterpret_cast<char*>(result.data()), result.size());
 			return makeByteArray(std::move(result));
 		}
 		case static_cast<uint8_t>(Internal::TagBits::OptionNull):
-			return makeOption(std::unique_ptr<Value>{});
+			return makeEmptyOption();
 		case static_cast<uint8_t>(Internal::TagBits::OptionSet): {
-			std::optional<Value> internalValue = readFromStream(inputStream);
+			std::optional<Value> internalValue = readFromStream(inputStream, std::nullopt, resource);
 			if (internalValue.has_value())
 			{
-				return makeOption(std::make_unique<Value>(std::move(*internalValue)));
+				return makeOption(std::move(*internalValue), resource);
 			}
 			else
 			{
@@ -593,15 +747,15 @@ namespace BStorage
 			}
 		}
 		case static_cast<uint8_t>(Internal::TagBits::ArrayEmpty):
-			return makeArray(std::vector<Value>{});
+			return makeArray(ArrayType(resource));
 		case static_cast<uint8_t>(Internal::TagBits::ArraySameType): {
 			const size_t size = Internal::readSize(inputStream);
 			const uint8_t valueTag = Internal::readUint<uint8_t>(inputStream);
-			std::vector<Value> result;
+			ArrayType result(resource);
 			result.reserve(size);
 			for (size_t i = 0; i < size; ++i)
 			{
-				std::optional<Value> internalValue = readFromStream(inputStream, valueTag);
+				std::optional<Value> internalValue = readFromStream(inputStream, valueTag, resource);
 				if (internalValue.has_value())
 				{
 					result.push_back(std::move(*internalValue));
@@ -616,11 +770,11 @@ namespace BStorage
 		}
 		case static_cast<uint8_t>(Internal::TagBits::ArrayVariableTypes): {
 			const size_t size = Internal::readSize(inputStream);
-			std::vector<Value> result;
+			ArrayType result(resource);
 			result.reserve(size);
 			for (size_t i = 0; i < size; ++i)
 			{
-				std::optional<Value> internalValue = readFromStream(inputStream);
+				std::optional<Value> internalValue = readFromStream(inputStream, std::nullopt, resource);
 				if (internalValue.has_value())
 				{
 					result.push_back(std::move(*internalValue));
@@ -635,19 +789,20 @@ namespace BStorage
 		}
 		case static_cast<uint8_t>(Internal::TagBits::Object): {
 			const size_t size = Internal::readSize(inputStream);
-			ObjectMap result;
+			ObjectMap result(resource);
 			result.reserve(size);
+			// keys are short, so this buffer doesn't allocate and the map makes its own copy
+			std::string key;
 			for (size_t i = 0; i < size; ++i)
 			{
 				const size_t keySize = Internal::readSize(inputStream);
-				std::string key;
 				key.resize(keySize);
 				inputStream.read(key.data(), key.size());
 
-				std::optional<Value> internalValue = readFromStream(inputStream);
+				std::optional<Value> internalValue = readFromStream(inputStream, std::nullopt, resource);
 				if (internalValue.has_value())
 				{
-					result.emplace(std::move(key), std::move(*internalValue));
+					result.emplace(key, std::move(*internalValue));
 				}
 				else
 				{
@@ -722,15 +877,15 @@ namespace BStorage
 				return false;
 			}
 
-			for (const std::pair<const std::string, Value>& pair : mStorage.Object)
+			// both maps are sorted by key
+			for (auto it = mStorage.Object.begin(), otherIt = other.mStorage.Object.begin(); it != mStorage.Object.end(); ++it, ++otherIt)
 			{
-				const auto& otherValueIt = other.mStorage.Object.find(pair.first);
-				if (otherValueIt == other.mStorage.Object.end())
+				if (it->first != otherIt->first)
 				{
 					return false;
 				}
 
-				if (!pair.second.isSameDeepCompare(otherValueIt->second))
+				if (!it->second.isSameDeepCompare(otherIt->second))
 				{
 					return false;
 				}
@@ -744,7 +899,7 @@ namespace BStorage
 		return false;
 	}
 
-	Value Value::deepCopy() const noexcept
+	Value Value::deepCopy(std::pmr::memory_resource* resource) const noexcept
 	{
 		Value result(mTag);
 
@@ -763,40 +918,39 @@ namespace BStorage
 			result.mStorage.U64 = mStorage.U64;
 			break;
 		case Tag::String: {
-			new (&result.mStorage.String) std::string(mStorage.String);
+			new (&result.mStorage.String) StringType(mStorage.String, resource);
 			break;
 		}
 		case Tag::ByteArray: {
-			new (&result.mStorage.ByteArray) std::vector<std::byte>(mStorage.ByteArray);
+			new (&result.mStorage.ByteArray) ByteArrayType(mStorage.ByteArray, resource);
 			break;
 		}
 		case Tag::Option: {
 			if (mStorage.Option)
 			{
-				new (&result.mStorage.Option) std::unique_ptr<Value>();
-				result.mStorage.Option = std::make_unique<Value>(mStorage.Option->deepCopy());
+				new (&result.mStorage.Option) OptionType(Internal::makeOptionPointer(mStorage.Option->deepCopy(resource), resource));
 			}
 			else
 			{
-				new (&result.mStorage.Option) std::unique_ptr<Value>();
+				new (&result.mStorage.Option) OptionType();
 			}
 			break;
 		}
 		case Tag::Array: {
-			new (&result.mStorage.Array) std::vector<Value>();
+			new (&result.mStorage.Array) ArrayType(resource);
 			result.mStorage.Array.reserve(mStorage.Array.size());
 			for (const Value& v : mStorage.Array)
 			{
-				result.mStorage.Array.emplace_back(v.deepCopy());
+				result.mStorage.Array.emplace_back(v.deepCopy(resource));
 			}
 			break;
 		}
 		case Tag::Object: {
-			new (&result.mStorage.Object) ObjectMap();
+			new (&result.mStorage.Object) ObjectMap(resource);
 			result.mStorage.Object.reserve(mStorage.Object.size());
-			for (const std::pair<const std::string, Value>& pair : mStorage.Object)
+			for (const ObjectMap::value_type& pair : mStorage.Object)
 			{
-				result.mStorage.Object.emplace(pair.first, pair.second.deepCopy());
+				result.mStorage.Object.emplace(pair.first, pair.second.deepCopy(resource));
 			}
 			break;
 		}
@@ -824,19 +978,19 @@ namespace BStorage
 			mStorage.U64 = v.mStorage.U64;
 			break;
 		case Tag::String: {
-			new (&mStorage.String) std::string(std::move(v.mStorage.String));
+			new (&mStorage.String) StringType(std::move(v.mStorage.String));
 			break;
 		}
 		case Tag::ByteArray: {
-			new (&mStorage.ByteArray) std::vector<std::byte>(std::move(v.mStorage.ByteArray));
+			new (&mStorage.ByteArray) ByteArrayType(std::move(v.mStorage.ByteArray));
 			break;
 		}
 		case Tag::Option: {
-			new (&mStorage.Option) std::unique_ptr<Value>(std::move(v.mStorage.Option));
+			new (&mStorage.Option) OptionType(std::move(v.mStorage.Option));
 			break;
 		}
 		case Tag::Array: {
-			new (&mStorage.Array) std::vector<Value>(std::move(v.mStorage.Array));
+			new (&mStorage.Array) ArrayType(std::move(v.mStorage.Array));
 			break;
 		}
 		case Tag::Object: {
@@ -846,6 +1000,18 @@ namespace BStorage
 		}
 	}
 
+	Value& Value::operator=(Value&& v) noexcept
+	{
+		if (this != &v)
+		{
+			// v can be owned by this value (e.g. an element of its array), so it is moved out before this value is destroyed
+			Value movedValue(std::move(v));
+			std::destroy_at(this);
+			std::construct_at(this, std::move(movedValue));
+		}
+		return *this;
+	}
+
 	Value::~Value() noexcept
 	{
 		switch (mTag)
@@ -858,25 +1024,25 @@ namespace BStorage
 			break;
 		case Tag::String: {
 			Cryptography::cryptoWipeRawMemory(mStorage.String.data(), mStorage.String.capacity());
-			mStorage.String.std::string::~string();
+			std::destroy_at(&mStorage.String);
 			break;
 		}
 		case Tag::ByteArray: {
 			Cryptography::cryptoWipeRawMemory(mStorage.ByteArray.data(), mStorage.ByteArray.capacity());
-			mStorage.ByteArray.std::vector<std::byte>::~vector<std::byte>();
+			std::destroy_at(&mStorage.ByteArray);
 			break;
 		}
 		case Tag::Option: {
-			mStorage.Option.std::unique_ptr<Value>::~unique_ptr<Value>();
+			std::destroy_at(&mStorage.Option);
 			break;
 		}
 		case Tag::Array: {
-			mStorage.Array.std::vector<Value>::~vector<Value>();
+			std::destroy_at(&mStorage.Array);
 			break;
 		}
 		case Tag::Object: {
 			// we assume that Object keys don't have any confidential information to be securely erased
-			mStorage.Object.ObjectMap::~ObjectMap();
+			std::destroy_at(&mStorage.Object);
 			break;
 		}
 		}
@@ -0,0 +1,531 @@
+// Copyright (C) Pavel Grebnev 2026
+// Distributed under the MIT License (license terms are at http://opensource.org/licenses/MIT).
+
+#include "common_shared/bstorage/value_view.h"
+
+#include "common_shared/bstorage/utils_internal.h"
+#include "common_shared/debug/assert.h"
+
+namespace BStorage
+{
+	namespace ValueViewInternal
+	{
+		using Internal::TagBits;
+
+		// protects from stack overflow on malicious files, real documents are only a few levels deep
+		constexpr size_t MaxDepth = 64;
+
+		template<typename T>
+		[[nodiscard]] static T readUint(const std::byte* data) noexcept
+		{
+			T result = 0;
+			for (size_t i = 0; i < sizeof(T); ++i)
+			{
+				result = static_cast<T>((result << 8) | static_cast<T>(data[i]));
+			}
+			return result;
+		}
+
+		[[nodiscard]] static constexpr size_t getFixedPayloadSize(const uint8_t tagBits) noexcept
+		{
+			switch (tagBits)
+			{
+			case static_cast<uint8_t>(TagBits::U8):
+				return sizeof(uint8_t);
+			case static_cast<uint8_t>(TagBits::U16):
+				return sizeof(uint16_t);
+			case static_cast<uint8_t>(TagBits::U32):
+				return sizeof(uint32_t);
+			case static_cast<uint8_t>(TagBits::U64):
+				return sizeof(uint64_t);
+			case static_cast<uint8_t>(TagBits::OptionNull):
+			case static_cast<uint8_t>(TagBits::ArrayEmpty):
+				return 0;
+			default:
+				return SIZE_MAX;
+			}
+		}
+
+		// see writeSize in value.cpp for the format
+		[[nodiscard]] static size_t readSize(const std::byte*& position) noexcept
+		{
+			const size_t firstByte = static_cast<size_t>(position[0]);
+			if ((firstByte & 0x80) == 0)
+			{
+				position += 1;
+				return firstByte;
+			}
+
+			const size_t secondByte = static_cast<size_t>(position[1]);
+			if ((secondByte & 0x80) == 0)
+			{
+				position += 2;
+				return ((firstByte & 0x7F) << 7) | secondByte;
+			}
+
+			const size_t lastBytes = readUint<uint16_t>(position + 2);
+			position += 4;
+			return ((firstByte & 0x7F) << 23) | ((secondByte & 0x7F) << 16) | lastBytes;
+		}
+
+		[[nodiscard]] static bool readSizeChecked(const std::byte*& position, const std::byte* end, size_t& outSize) noexcept
+		{
+			if (end - position < 1)
+			{
+				return false;
+			}
+			if ((static_cast<uint8_t>(position[0]) & 0x80) != 0)
+			{
+				if (end - position < 2)
+				{
+					return false;
+				}
+				if ((static_cast<uint8_t>(position[1]) & 0x80) != 0 && end - position < 4)
+				{
+					return false;
+				}
+			}
+
+			outSize = readSize(position);
+			return true;
+		}
+
+		[[nodiscard]] static bool skipBytesChecked(const std::byte*& position, const std::byte* end, const size_t size) noexcept
+		{
+			if (static_cast<size_t>(end - position) < size)
+			{
+				return false;
+			}
+			position += size;
+			return true;
+		}
+
+		[[nodiscard]] static bool validate(const std::byte*& position, const std::byte* end, const uint8_t tagBits, const size_t depth) noexcept
+		{
+			if (depth > MaxDepth)
+			{
+				return false;
+			}
+
+			if (const size_t fixedSize = getFixedPayloadSize(tagBits); fixedSize != SIZE_MAX)
+			{
+				return skipBytesChecked(position, end, fixedSize);
+			}
+
+			switch (tagBits)
+			{
+			case static_cast<uint8_t>(TagBits::String):
+			case static_cast<uint8_t>(TagBits::ByteArray): {
+				size_t size;
+				return readSizeChecked(position, end, size) && skipBytesChecked(position, end, size);
+			}
+			case static_cast<uint8_t>(TagBits::OptionSet): {
+				if (end - position < 1)
+				{
+					return false;
+				}
+				const uint8_t valueTagBits = static_cast<uint8_t>(*position++);
+				return validate(position, end, valueTagBits, depth + 1);
+			}
+			case static_cast<uint8_t>(TagBits::ArraySameType): {
+				size_t size;
+				if (!readSizeChecked(position, end, size) || end - position < 1)
+				{
+					return false;
+				}
+				const uint8_t valueTagBits = static_cast<uint8_t>(*position++);
+
+				if (const size_t fixedSize = getFixedPayloadSize(valueTagBits); fixedSize != SIZE_MAX)
+				{
+					// size is limited by 30 bits, so it can't overflow
+					return skipBytesChecked(position, end, size * fixedSize);
+				}
+
+				for (size_t i = 0; i < size; ++i)
+				{
+					if (!validate(position, end, valueTagBits, depth + 1))
+					{
+						return false;
+					}
+				}
+				return true;
+			}
+			case static_cast<uint8_t>(TagBits::ArrayVariableTypes): {
+				size_t size;
+				if (!readSizeChecked(position, end, size))
+				{
+					return false;
+				}
+				for (size_t i = 0; i < size; ++i)
+				{
+					if (end - position < 1)
+					{
+						return false;
+					}
+					const uint8_t valueTagBits = static_cast<uint8_t>(*position++);
+					if (!validate(position, end, valueTagBits, depth + 1))
+					{
+						return false;
+					}
+				}
+				return true;
+			}
+			case static_cast<uint8_t>(TagBits::Object): {
+				size_t size;
+				if (!readSizeChecked(position, end, size))
+				{
+					return false;
+				}
+				for (size_t i = 0; i < size; ++i)
+				{
+					size_t keySize;
+					if (!readSizeChecked(position, end, keySize) || !skipBytesChecked(position, end, keySize) || end - position < 1)
+					{
+						return false;
+					}
+					const uint8_t valueTagBits = static_cast<uint8_t>(*position++);
+					if (!validate(position, end, valueTagBits, depth + 1))
+					{
+						return false;
+					}
+				}
+				return true;
+			}
+			default:
+				return false;
+			}
+		}
+
+		// the data was validated already, so no checks here
+		[[nodiscard]] static const std::byte* skip(const std::byte* payload, const uint8_t tagBits) noexcept
+		{
+			if (const size_t fixedSize = getFixedPayloadSize(tagBits); fixedSize != SIZE_MAX)
+			{
+				return payload + fixedSize;
+			}
+
+			const std::byte* position = payload;
+			switch (tagBits)
+			{
+			case static_cast<uint8_t>(TagBits::String):
+			case static_cast<uint8_t>(TagBits::ByteArray): {
+				const size_t size = readSize(position);
+				return position + size;
+			}
+			case static_cast<uint8_t>(TagBits::OptionSet): {
+				const uint8_t valueTagBits = static_cast<uint8_t>(*position);
+				return skip(position + 1, valueTagBits);
+			}
+			case static_cast<uint8_t>(TagBits::ArraySameType): {
+				const size_t size = readSize(position);
+				const uint8_t valueTagBits = static_cast<uint8_t>(*position++);
+				if (const size_t fixedSize = getFixedPayloadSize(valueTagBits); fixedSize != SIZE_MAX)
+				{
+					return position + size * fixedSize;
+				}
+				for (size_t i = 0; i < size; ++i)
+				{
+					position = skip(position, valueTagBits);
+				}
+				return position;
+			}
+			case static_cast<uint8_t>(TagBits::ArrayVariableTypes): {
+				const size_t size = readSize(position);
+				for (size_t i = 0; i < size; ++i)
+				{
+					const uint8_t valueTagBits = static_cast<uint8_t>(*position);
+					position = skip(position + 1, valueTagBits);
+				}
+				return position;
+			}
+			case static_cast<uint8_t>(TagBits::Object): {
+				const size_t size = readSize(position);
+				for (size_t i = 0; i < size; ++i)
+				{
+					const size_t keySize = readSize(position);
+					position += keySize;
+					const uint8_t valueTagBits = static_cast<uint8_t>(*position);
+					position = skip(position + 1, valueTagBits);
+				}
+				return position;
+			}
+			default:
+				assertFatalRelease(false, "Skipping a value with unknown tag {} that should have been rejected by validation", tagBits);
+				return payload;
+			}
+		}
+	} // namespace ValueViewInternal
+
+	ValueView::ArrayIterator::ArrayIterator(const std::byte* position, const size_t remainingCount, const uint8_t sameTypeTagBits) noexcept
+		: mPosition(position)
+		, mRemainingCount(remainingCount)
+		, mSameTypeTagBits(sameTypeTagBits)
+	{
+	}
+
+	ValueView ValueView::ArrayIterator::operator*() const noexcept
+	{
+		if (mSameTypeTagBits != 0)
+		{
+			return ValueView(mPosition, mSameTypeTagBits);
+		}
+		return ValueView(mPosition + 1, static_cast<uint8_t>(*mPosition));
+	}
+
+	ValueView::ArrayIterator& ValueView::ArrayIterator::operator++() noexcept
+	{
+		if (mSameTypeTagBits != 0)
+		{
+			mPosition = ValueViewInternal::skip(mPosition, mSameTypeTagBits);
+		}
+		else
+		{
+			mPosition = ValueViewInternal::skip(mPosition + 1, static_cast<uint8_t>(*mPosition));
+		}
+		--mRemainingCount;
+		return *this;
+	}
+
+	ValueView::ObjectIterator::ObjectIterator(const std::byte* position, const size_t remainingCount) noexcept
+		: mPosition(position)
+		, mRemainingCount(remainingCount)
+	{
+	}
+
+	std::pair<std::string_view, ValueView> ValueView::ObjectIterator::operator*() const noexcept
+	{
+		const std::byte* position = mPosition;
+		const size_t keySize = ValueViewInternal::readSize(position);
+		const std::string_view key(reinterpret_cast<const char*>(position), keySize);
+		position += keySize;
+		return { key, ValueView(position + 1, static_cast<uint8_t>(*position)) };
+	}
+
+	ValueView::ObjectIterator& ValueView::ObjectIterator::operator++() noexcept
+	{
+		const std::byte* position = mPosition;
+		const size_t keySize = ValueViewInternal::readSize(position);
+		position += keySize;
+		mPosition = ValueViewInternal::skip(position + 1, static_cast<uint8_t>(*position));
+		--mRemainingCount;
+		return *this;
+	}
+
+	std::optional<ValueView> ValueView::ObjectRange::find(const std::string_view key) const noexcept
+	{
+		for (const auto& [fieldKey, fieldValue] : *this)
+		{
+			if (fieldKey == key)
+			{
+				return fieldValue;
+			}
+		}
+		return std::nullopt;
+	}
+
+	std::optional<ValueView> ValueView::parse(const std::span<const std::byte> data) noexcept
+	{
+		if (data.empty())
+		{
+			return std::nullopt;
+		}
+
+		const std::byte* position = data.data();
+		const std::byte* end = data.data() + data.size();
+		const uint8_t tagBits = static_cast<uint8_t>(*position++);
+		const std::byte* payload = position;
+
+		if (!ValueViewInternal::validate(position, end, tagBits, 0) || position != end)
+		{
+			return std::nullopt;
+		}
+
+		return ValueView(payload, tagBits);
+	}
+
+	Tag ValueView::getTag() const noexcept
+	{
+		using Internal::TagBits;
+
+		switch (mTagBits)
+		{
+		case static_cast<uint8_t>(TagBits::U8):
+			return Tag::U8;
+		case static_cast<uint8_t>(TagBits::U16):
+			return Tag::U16;
+		case static_cast<uint8_t>(TagBits::U32):
+			return Tag::U32;
+		case static_cast<uint8_t>(TagBits::U64):
+			return Tag::U64;
+		case static_cast<uint8_t>(TagBits::String):
+			return Tag::String;
+		case static_cast<uint8_t>(TagBits::ByteArray):
+			return Tag::ByteArray;
+		case static_cast<uint8_t>(TagBits::OptionNull):
+		case static_cast<uint8_t>(TagBits::OptionSet):
+			return Tag::Option;
+		case static_cast<uint8_t>(TagBits::ArrayEmpty):
+		case static_cast<uint8_t>(TagBits::ArraySameType):
+		case static_cast<uint8_t>(TagBits::ArrayVariableTypes):
+			return Tag::Array;
+		default:
+			return Tag::Object;
+		}
+	}
+
+	std::optional<uint8_t> ValueView::asU8() const noexcept
+	{
+		if (mTagBits != static_cast<uint8_t>(Internal::TagBits::U8))
+		{
+			return std::nullopt;
+		}
+		return ValueViewInternal::readUint<uint8_t>(mPayload);
+	}
+
+	std::optional<uint16_t> ValueView::asU16() const noexcept
+	{
+		if (mTagBits != static_cast<uint8_t>(Internal::TagBits::U16))
+		{
+			return std::nullopt;
+		}
+		return ValueViewInternal::readUint<uint16_t>(mPayload);
+	}
+
+	std::optional<uint32_t> ValueView::asU32() const noexcept
+	{
+		if (mTagBits != static_cast<uint8_t>(Internal::TagBits::U32))
+		{
+			return std::nullopt;
+		}
+		return ValueViewInternal::readUint<uint32_t>(mPayload);
+	}
+
+	std::optional<uint64_t> ValueView::asU64() const noexcept
+	{
+		if (mTagBits != static_cast<uint8_t>(Internal::TagBits::U64))
+		{
+			return std::nullopt;
+		}
+		return ValueViewInternal::readUint<uint64_t>(mPayload);
+	}
+
+	std::optional<std::string_view> ValueView::asString() const noexcept
+	{
+		if (mTagBits != static_cast<uint8_t>(Internal::TagBits::String))
+		{
+			return std::nullopt;
+		}
+		const std::byte* position = mPayload;
+		const size_t size = ValueViewInternal::readSize(position);
+		return std::string_view(reinterpret_cast<const char*>(position), size);
+	}
+
+	std::optional<std::span<const std::byte>> ValueView::asByteArray() const noexcept
+	{
+		if (mTagBits != static_cast<uint8_t>(Internal::TagBits::ByteArray))
+		{
+			return std::nullopt;
+		}
+		const std::byte* position = mPayload;
+		const size_t size = ValueViewInternal::readSize(position);
+		return std::span<const std::byte>(position, size);
+	}
+
+	std::optional<ValueView> ValueView::asOptionValue() const noexcept
+	{
+		if (mTagBits != static_cast<uint8_t>(Internal::TagBits::OptionSet))
+		{
+			return std::nullopt;
+		}
+		return ValueView(mPayload + 1, static_cast<uint8_t>(*mPayload));
+	}
+
+	std::optional<ValueView::ArrayRange> ValueView::asArray() const noexcept
+	{
+		using Internal::TagBits;
+
+		const std::byte* position = mPayload;
+		switch (mTagBits)
+		{
+		case static_cast<uint8_t>(TagBits::ArrayEmpty):
+			return ArrayRange(ArrayIterator(position, 0, 0), 0);
+		case static_cast<uint8_t>(TagBits::ArraySameType): {
+			const size_t size = ValueViewInternal::readSize(position);
+			const uint8_t valueTagBits = static_cast<uint8_t>(*position++);
+			return ArrayRange(ArrayIterator(position, size, valueTagBits), size);
+		}
+		case static_cast<uint8_t>(TagBits::ArrayVariableTypes): {
+			const size_t size = ValueViewInternal::readSize(position);
+			return ArrayRange(ArrayIterator(position, size, 0), size);
+		}
+		default:
+			return std::nullopt;
+		}
+	}
+
+	std::optional<ValueView::ObjectRange> ValueView::asObject() const noexcept
+	{
+		if (mTagBits != static_cast<uint8_t>(Internal::TagBits::Object))
+		{
+			return std::nullopt;
+		}
+		const std::byte* position = mPayload;
+		const size_t size = ValueViewInternal::readSize(position);
+		return ObjectRange(ObjectIterator(position, size), size);
+	}
+
+	Value ValueView::toValue(std::pmr::memory_resource* resource) const noexcept
+	{
+		switch (getTag())
+		{
+		case Tag::U8:
+			return Value::makeU8(*asU8());
+		case Tag::U16:
+			return Value::makeU16(*asU16());
+		case Tag::U32:
+			return Value::makeU32(*asU32());
+		case Tag::U64:
+			return Value::makeU64(*asU64());
+		case Tag::String:
+			return Value::makeString(*asString(), resource);
+		case Tag::ByteArray:
+			return Value::makeByteArray(*asByteArray(), resource);
+		case Tag::Option: {
+			if (const std::optional<ValueView> optionValue = asOptionValue())
+			{
+				return Value::makeOption(optionValue->toValue(resource), resource);
+			}
+			return Value::makeEmptyOption();
+		}
+		case Tag::Array: {
+			const ArrayRange array = *asArray();
+			Value::ArrayType result(resource);
+			result.reserve(array.size());
+			for (const ValueView element : array)
+			{
+				result.push_back(element.toValue(resource));
+			}
+			return Value::makeArray(std::move(result));
+		}
+		case Tag::Object: {
+			const ObjectRange object = *asObject();
+			Value::ObjectMap result(resource);
+			result.reserve(object.size());
+			for (const auto& [key, fieldValue] : object)
+			{
+				result.emplace(key, fieldValue.toValue(resource));
+			}
+			return Value::makeObject(std::move(result));
+		}
+		}
+
+		// unreachable, but GCC does not believe that
+		return Value::makeEmptyOption();
+	}
+
+	ValueView::ValueView(const std::byte* payload, const uint8_t tagBits) noexcept
+		: mPayload(payload)
+		, mTagBits(tagBits)
+	{
+	}
+} // namespace BStorage
@@ -3,6 +3,7 @@
 
 #include "common_shared/cryptography/noise/cipher_utils.h"
 
+#include <algorithm>
 #include <limits>
 
 #include "common_shared/cryptography/primitives/cipher_functions.h"
@@ -71,6 +72,85 @@ namespace Noise::Utils
 		return decryptWithAd(cipherState, {}, inOutData, std::span<std::byte>(inOutData.data(), inOutData.size() - Cryptography::CipherAuthDataSize));
 	}
 
+	Cryptography::EncryptResult encryptTransportMessagesInplace(CipherStateSending& cipherState, const std::span<const std::span<std::byte>> inOutMessages, RekeySchedule& rekeySchedule)
+	{
+		if (inOutMessages.size() > MaxNonce - cipherState.nonce)
+		{
+			return Cryptography::EncryptResult::NonceExhausted;
+		}
+
+		// split the batch into runs that use the same key
+		size_t runStart = 0;
+		for (size_t i = 0; i < inOutMessages.size(); ++i)
+		{
+			const bool isLastMessage = i + 1 == inOutMessages.size();
+			const bool shouldRekey = registerTransportMessage(rekeySchedule, inOutMessages[i].size());
+			if (!shouldRekey && !isLastMessage)
+			{
+				continue;
+			}
+
+			const std::span<const std::span<std::byte>> run = inOutMessages.subspan(runStart, i + 1 - runStart);
+			const Cryptography::EncryptResult result = Cryptography::encryptInplaceBatch_chacha20poly1305(cipherState.cipherKey, cipherState.nonce, run);
+			if (result != Cryptography::EncryptResult::Success) [[unlikely]]
+			{
+				return result;
+			}
+			cipherState.nonce += run.size();
+			runStart = i + 1;
+
+			if (shouldRekey)
+			{
+				if (const Cryptography::EncryptResult rekeyResult = rekey(cipherState); rekeyResult != Cryptography::EncryptResult::Success) [[unlikely]]
+				{
+					return rekeyResult;
+				}
+			}
+		}
+
+		return Cryptography::EncryptResult::Success;
+	}
+
+	Cryptography::DecryptResult decryptTransportMessagesInplace(CipherStateReceiving& cipherState, const std::span<const std::span<std::byte>> inOutMessages, RekeySchedule& rekeySchedule)
+	{
+		if (inOutMessages.size() > MaxNonce - cipherState.nonce)
+		{
+			return Cryptography::DecryptResult::NonceExhausted;
+		}
+
+		// split the batch into runs that use the same key
+		size_t runStart = 0;
+		for (size_t i = 0; i < inOutMessages.size(); ++i)
+		{
+			const bool isLastMessage = i + 1 == inOutMessages.size();
+			const bool shouldRekey = registerTransportMessage(rekeySchedule, inOutMessages[i].size());
+			if (!shouldRekey && !isLastMessage)
+			{
+				continue;
+			}
+
+			const std::span<const std::span<std::byte>> run = inOutMessages.subspan(runStart, i + 1 - runStart);
+			size_t decryptedMessagesCount = 0;
+			const Cryptography::DecryptResult result = Cryptography::decryptInplaceBatch_chacha20poly1305(cipherState.cipherKey, cipherState.nonce, run, decryptedMessagesCount);
+			cipherState.nonce += decryptedMessagesCount;
+			if (result != Cryptography::DecryptResult::Success) [[unlikely]]
+			{
+				return result;
+			}
+			runStart = i + 1;
+
+			if (shouldRekey)
+			{
+				if (rekey(cipherState) != Cryptography::EncryptResult::Success) [[unlikely]]
+				{
+					return Cryptography::DecryptResult::IncorrectEncryptionKey;
+				}
+			}
+		}
+
+		return Cryptography::DecryptResult::Success;
+	}
+
 	Cryptography::EncryptResult encryptWithAd(CipherStateHandshake& cipherState, const std::span<const std::byte> associatedData, const std::span<const std::byte> plaintext, const std::span<std::byte> outCiphertext)
 	{
 		return encryptWithAdGeneric(cipherState, associatedData, plaintext, outCiphertext);
@@ -84,15 +164,8 @@ namespace Noise::Utils
 	template<CipherStateInstanceTag Tag>
 	[[nodiscard]] EncryptResult rekeyGeneric(CipherState<Tag>& cipherState)
 	{
-		const std::array<std::byte, Cryptography::CipherKeySize> allZeros = {};
-		std::array<std::byte, Cryptography::CipherKeySize + Cryptography::CipherAuthDataSize> cyphertext;
 		static_assert(MaxNonce == std::numeric_limits<Nonce>::max(), "Nonce expected to be 64 bit unsigned");
-		const EncryptResult result = Cryptography::encrypt_chacha20poly1305(cipherState.cipherKey, MaxNonce, std::span<std::byte>{}, allZeros, cyphertext);
-		if (result == EncryptResult::Success)
-		{
-			std::copy(cyphertext.begin(), cyphertext.begin() + Cryptography::CipherKeySize, cipherState.cipherKey.raw.begin());
-		}
-		return result;
+		return Cryptography::rekey_chacha20(cipherState.cipherKey);
 	}
 
 	EncryptResult rekey(CipherStateSending& cipherState)
@@ -104,4 +177,48 @@ namespace Noise::Utils
 	{
 		return rekeyGeneric(cipherState);
 	}
+
+	bool registerTransportMessage(RekeySchedule& rekeySchedule, const size_t ciphertextSize) noexcept
+	{
+		++rekeySchedule.messagesSinceRekey;
+		rekeySchedule.bytesSinceRekey += ciphertextSize;
+
+		const RekeyPolicy& policy = rekeySchedule.policy;
+		const bool isMessagesLimitReached = policy.messagesInterval != 0 && rekeySchedule.messagesSinceRekey >= policy.messagesInterval;
+		const bool isBytesLimitReached = policy.bytesInterval != 0 && rekeySchedule.bytesSinceRekey >= policy.bytesInterval;
+		if (isMessagesLimitReached || isBytesLimitReached)
+		{
+			resetRekeySchedule(rekeySchedule);
+			return true;
+		}
+		return false;
+	}
+
+	void resetRekeySchedule(RekeySchedule& rekeySchedule) noexcept
+	{
+		rekeySchedule.messagesSinceRekey = 0;
+		rekeySchedule.bytesSinceRekey = 0;
+	}
+
+	static uint64_t pickMoreFrequentInterval(const uint64_t a, const uint64_t b) noexcept
+	{
+		if (a == 0)
+		{
+			return b;
+		}
+		if (b == 0)
+		{
+			return a;
+		}
+		return std::min(a, b);
+	}
+
+	RekeyPolicy negotiateRekeyPolicy(const RekeyPolicy& ourPolicy, const RekeyPolicy& theirPolicy) noexcept
+	{
+		return RekeyPolicy{
+			.messagesInterval = pickMoreFrequentInterval(ourPolicy.messagesInterval, theirPolicy.messagesInterval),
+			.bytesInterval = pickMoreFrequentInterval(ourPolicy.bytesInterval, theirPolicy.bytesInterval),
+			.timeIntervalMs = pickMoreFrequentInterval(ourPolicy.timeIntervalMs, theirPolicy.timeIntervalMs),
+		};
+	}
 } // namespace Noise::Utils
@@ -106,6 +106,15 @@ namespace Noise::Utils
 		}
 	}
 
+	HashResult deriveResumptionSecret(const SymmetricState& symmetricState) noexcept
+	{
+		HashResult tempKey1;
+		HashResult tempKey2;
+		HashResult resumptionSecret;
+		Cryptography::HKDF_blake2b(symmetricState.chainingKey, std::span<std::byte>{}, 3, tempKey1, &tempKey2, &resumptionSecret);
+		return resumptionSecret;
+	}
+
 	int writeDataToBuffer(const std::span<const std::byte> data, const std::span<std::byte> inOutBuffer, size_t& inOutWritePos) noexcept
 	{
 		if (inOutBuffer.size() < (inOutWritePos + data.size()))
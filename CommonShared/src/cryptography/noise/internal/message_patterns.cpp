@@ -5,6 +5,7 @@
 
 #include "common_shared/cryptography/noise/internal/handshake_utils.h"
 #include "common_shared/cryptography/primitives/dh_functions.h"
+#include "common_shared/cryptography/utils/ephemeral_keypair_pool.h"
 
 namespace Noise::MessagePatterns
 {
@@ -16,7 +17,7 @@ namespace Noise::MessagePatterns
 			return MessageWriteError::EphemeralKeysAlreadySet;
 		}
 
-		handshakeState.ephemeralKeys = generateKeypair_x25519();
+		handshakeState.ephemeralKeys = EphemeralKeypairPool::takeKeypair();
 
 		if (!Cryptography::isPublicKeyValid(handshakeState.ephemeralKeys->publicKey))
 		{
@@ -369,7 +370,14 @@ namespace Noise::MessagePatterns
 			return MessageWriteError::NoRemoteStaticKey;
 		}
 
-		Utils::mixKey(Cryptography::diffieHellman_x25519(handshakeState.staticKeys->secretKey, *handshakeState.remoteStaticKey), handshakeState.symmetricState);
+		if (handshakeState.staticStaticDh.has_value())
+		{
+			Utils::mixKey(*handshakeState.staticStaticDh, handshakeState.symmetricState);
+		}
+		else
+		{
+			Utils::mixKey(Cryptography::diffieHellman_x25519(handshakeState.staticKeys->secretKey, *handshakeState.remoteStaticKey), handshakeState.symmetricState);
+		}
 
 		return std::nullopt;
 	}
@@ -386,7 +394,14 @@ namespace Noise::MessagePatterns
 			return MessageReadError::NoRemoteStaticKey;
 		}
 
-		Utils::mixKey(Cryptography::diffieHellman_x25519(handshakeState.staticKeys->secretKey, *handshakeState.remoteStaticKey), handshakeState.symmetricState);
+		if (handshakeState.staticStaticDh.has_value())
+		{
+			Utils::mixKey(*handshakeState.staticStaticDh, handshakeState.symmetricState);
+		}
+		else
+		{
+			Utils::mixKey(Cryptography::diffieHellman_x25519(handshakeState.staticKeys->secretKey, *handshakeState.remoteStaticKey), handshakeState.symmetricState);
+		}
 
 		return std::nullopt;
 	}
@@ -5,6 +5,7 @@
 
 #include "common_shared/cryptography/noise/internal/handshake_utils.h"
 #include "common_shared/cryptography/noise/internal/message_patterns.h"
+#include "common_shared/cryptography/primitives/dh_functions.h"
 
 namespace Noise::NoiseKK
 {
@@ -38,6 +39,25 @@ namespace Noise::NoiseKK
 		return handshakeState;
 	}
 
+	DhResult computeStaticStaticDh(const Keypair& staticKeys, const PublicKey& remoteStaticKey) noexcept
+	{
+		return Cryptography::diffieHellman_x25519(staticKeys.secretKey, remoteStaticKey);
+	}
+
+	InitiatorHandshakeState initializeInitiator(const Keypair& staticKeys, const PublicKey& remoteStaticKey, const DhResult& staticStaticDh) noexcept
+	{
+		InitiatorHandshakeState handshakeState = initializeInitiator(staticKeys, remoteStaticKey);
+		handshakeState.staticStaticDh = staticStaticDh.clone();
+		return handshakeState;
+	}
+
+	ResponderHandshakeState initializeResponder(const Keypair& staticKeys, const PublicKey& remoteStaticKey, const DhResult& staticStaticDh) noexcept
+	{
+		ResponderHandshakeState handshakeState = initializeResponder(staticKeys, remoteStaticKey);
+		handshakeState.staticStaticDh = staticStaticDh.clone();
+		return handshakeState;
+	}
+
 	AppendHandshakeMessage1Result appendHandshakeMessage1(InitiatorHandshakeState& handshakeState, const std::span<std::byte> outMessageBuffer, size_t& inOutCursor) noexcept
 	{
 		if (outMessageBuffer.size() < inOutCursor + Message1ExpectedSize)
@@ -112,6 +132,7 @@ namespace Noise::NoiseKK
 
 		HandshakeResult result;
 		Utils::split(handshakeState.symmetricState, result.sendingCipherState, result.receivingCipherState, Utils::HandshakeRole::Responder);
+		result.resumptionSecret = Utils::deriveResumptionSecret(handshakeState.symmetricState);
 		return result;
 	}
 
@@ -139,6 +160,7 @@ namespace Noise::NoiseKK
 
 		HandshakeResult result;
 		Utils::split(handshakeState.symmetricState, result.sendingCipherState, result.receivingCipherState, Utils::HandshakeRole::Initiator);
+		result.resumptionSecret = Utils::deriveResumptionSecret(handshakeState.symmetricState);
 		return result;
 	}
 } // namespace Noise::NoiseKK
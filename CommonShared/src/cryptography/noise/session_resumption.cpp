@@ -0,0 +1,93 @@
+// Copyright (C) Pavel Grebnev 2026
+// Distributed under the MIT License (license terms are at http://opensource.org/licenses/MIT).
+
+#include "common_shared/cryptography/noise/session_resumption.h"
+
+#include <algorithm>
+
+#include "common_shared/cryptography/primitives/cipher_functions.h"
+#include "common_shared/cryptography/primitives/hash_functions.h"
+#include "common_shared/serialization/number_serialization.h"
+
+namespace Noise::Resumption
+{
+	template<CipherStateInstanceTag Tag>
+	static void initializeKey(const HashResult& tempKey, CipherState<Tag>& inOutState)
+	{
+		static_assert(Cryptography::CipherKeySize <= HASHLEN, "Unexpected CipherKeySize");
+		std::copy(tempKey.raw.begin(), tempKey.raw.begin() + Cryptography::CipherKeySize, inOutState.cipherKey.raw.begin());
+		inOutState.nonce = static_cast<uint64_t>(0);
+	}
+
+	EncryptResult sealTicket(const CipherKey& ticketKey, const Cryptography::Nonce ticketNonce, const TicketContent& content, Ticket& outTicket) noexcept
+	{
+		Cryptography::ByteSequence<Cryptography::ByteSequenceTag::TempInternalBuffer, TicketPlaintextSize> plaintext;
+		std::copy(content.connectionId.raw.begin(), content.connectionId.raw.end(), plaintext.raw.begin());
+		std::copy(content.resumptionSecret.raw.begin(), content.resumptionSecret.raw.end(), plaintext.raw.begin() + HASHLEN);
+		Serialization::writeUint64(std::span(plaintext.raw.data() + 2 * HASHLEN, sizeof(uint64_t)), content.expirationTime);
+
+		// the nonce is not secret, it goes in front of the ciphertext and is authenticated as associated data
+		const std::span<std::byte> nonceData(outTicket.data(), sizeof(Cryptography::Nonce));
+		Serialization::writeUint64(nonceData, ticketNonce);
+
+		return Cryptography::encrypt_chacha20poly1305(ticketKey, ticketNonce, nonceData, plaintext, std::span(outTicket.data() + sizeof(Cryptography::Nonce), TicketPlaintextSize + CipherAuthDataSize));
+	}
+
+	std::optional<TicketContent> openTicket(const CipherKey& ticketKey, const std::span<const std::byte> ticket, const uint64_t currentTime) noexcept
+	{
+		if (ticket.size() != TicketSize)
+		{
+			return std::nullopt;
+		}
+
+		const std::span<const std::byte> nonceData = ticket.subspan(0, sizeof(Cryptography::Nonce));
+		const Cryptography::Nonce ticketNonce = Serialization::readUint64(nonceData);
+
+		Cryptography::ByteSequence<Cryptography::ByteSequenceTag::TempInternalBuffer, TicketPlaintextSize> plaintext;
+		if (Cryptography::decrypt_chacha20poly1305(ticketKey, ticketNonce, nonceData, ticket.subspan(sizeof(Cryptography::Nonce)), plaintext) != Cryptography::DecryptResult::Success)
+		{
+			return std::nullopt;
+		}
+
+		TicketContent content;
+		std::copy(plaintext.raw.begin(), plaintext.raw.begin() + HASHLEN, content.connectionId.raw.begin());
+		std::copy(plaintext.raw.begin() + HASHLEN, plaintext.raw.begin() + 2 * HASHLEN, content.resumptionSecret.raw.begin());
+		content.expirationTime = Serialization::readUint64(std::span(plaintext.raw.data() + 2 * HASHLEN, sizeof(uint64_t)));
+
+		if (content.expirationTime <= currentTime)
+		{
+			return std::nullopt;
+		}
+
+		return content;
+	}
+
+	Cryptography::Nonce getTicketNonce(const std::span<const std::byte> ticket) noexcept
+	{
+		return Serialization::readUint64(ticket.subspan(0, sizeof(Cryptography::Nonce)));
+	}
+
+	ResumedSession deriveResumedSession(const HashResult& resumptionSecret, const std::span<const std::byte> clientMessage, const RandomNonce& serverNonce, const SessionRole role) noexcept
+	{
+		HashResult transcriptHash;
+		Cryptography::hashWithContext_blake2b(clientMessage, serverNonce, transcriptHash);
+
+		HashResult clientToServerKey;
+		HashResult serverToClientKey;
+		ResumedSession result;
+		Cryptography::HKDF_blake2b(resumptionSecret, transcriptHash, 3, clientToServerKey, &serverToClientKey, &result.nextResumptionSecret);
+
+		if (role == SessionRole::Client)
+		{
+			initializeKey(clientToServerKey, result.sendingCipherState);
+			initializeKey(serverToClientKey, result.receivingCipherState);
+		}
+		else
+		{
+			initializeKey(serverToClientKey, result.sendingCipherState);
+			initializeKey(clientToServerKey, result.receivingCipherState);
+		}
+
+		return result;
+	}
+} // namespace Noise::Resumption
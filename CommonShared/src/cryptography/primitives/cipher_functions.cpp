@@ -31,6 +31,14 @@ namespace Cryptography
 		outChaCha20Nonce.raw[11] = static_cast<std::byte>((inNonce & 0xFF00000000000000) >> 0x38);
 	}
 
+	[[nodiscard]] static bool isEmptyKey(const CipherKey& key) noexcept
+	{
+		static_assert(sizeof(*key.raw.data()) == sizeof(uint8_t), "Expected key to be a byte array");
+		static_assert(sizeof(*EmptyKey.data()) == sizeof(uint8_t), "Expected empty key to be a byte array");
+		static_assert(CipherKeySize == 32, "crypto_verify32 only expected to be used to compare 32 byte values");
+		return crypto_verify32(reinterpret_cast<const uint8_t*>(key.raw.data()), reinterpret_cast<const uint8_t*>(EmptyKey.data())) == 0;
+	}
+
 	EncryptResult encrypt_chacha20poly1305(
 		const CipherKey& key,
 		const Nonce nonce,
@@ -57,10 +65,7 @@ namespace Cryptography
 			return EncryptResult::CiphertextBufferTooBig;
 		}
 
-		static_assert(sizeof(*key.raw.data()) == sizeof(uint8_t), "Expected key to be a byte array");
-		static_assert(sizeof(*EmptyKey.data()) == sizeof(uint8_t), "Expected empty key to be a byte array");
-		static_assert(CipherKeySize == 32, "crypto_verify32 only expected to be used to compare 32 byte values");
-		if (crypto_verify32(reinterpret_cast<const uint8_t*>(key.raw.data()), reinterpret_cast<const uint8_t*>(EmptyKey.data())) == 0)
+		if (isEmptyKey(key))
 		{
 			return EncryptResult::IncorrectEncryptionKey;
 		}
@@ -136,10 +141,7 @@ namespace Cryptography
 			return DecryptResult::PlaintextBufferTooBig;
 		}
 
-		static_assert(sizeof(*key.raw.data()) == sizeof(uint8_t), "Expected key to be a byte array");
-		static_assert(sizeof(*EmptyKey.data()) == sizeof(uint8_t), "Expected empty key to be a byte array");
-		static_assert(CipherKeySize == 32, "crypto_verify32 only expected to be used to compare 32 byte values");
-		if (crypto_verify32(reinterpret_cast<const uint8_t*>(key.raw.data()), reinterpret_cast<const uint8_t*>(EmptyKey.data())) == 0)
+		if (isEmptyKey(key))
 		{
 			return DecryptResult::IncorrectEncryptionKey;
 		}
@@ -187,4 +189,174 @@ namespace Cryptography
 
 		return DecryptResult::Success;
 	}
+
+	EncryptResult encryptInplaceBatch_chacha20poly1305(
+		const CipherKey& key,
+		const Nonce firstNonce,
+		const std::span<const std::span<std::byte>> inOutMessages
+	) noexcept
+	{
+		for (const std::span<std::byte> message : inOutMessages)
+		{
+			if (message.size() < CipherAuthDataSize) [[unlikely]]
+			{
+				reportDebugError("Message buffer can't fit the MAC {} < {}", message.size(), CipherAuthDataSize);
+				return EncryptResult::CiphertextBufferTooSmall;
+			}
+
+			if (message.size() > MaxMessageSize + CipherAuthDataSize) [[unlikely]]
+			{
+				reportDebugError("Plaintext for encryption is bigger than max allowed size {} > {}", message.size() - CipherAuthDataSize, MaxMessageSize);
+				return EncryptResult::PlaintextBiggerThanMaxMessageSize;
+			}
+		}
+
+		if (inOutMessages.size() > MaxNonce - firstNonce) [[unlikely]]
+		{
+			return EncryptResult::NonceExhausted;
+		}
+
+		if (isEmptyKey(key))
+		{
+			return EncryptResult::IncorrectEncryptionKey;
+		}
+
+		ChaCha20Nonce chaCha20Nonce;
+		crypto_aead_ctx context;
+		Nonce nonce = firstNonce;
+
+		for (const std::span<std::byte> message : inOutMessages)
+		{
+			const size_t macOffsetInCiphertext = message.size() - CipherAuthDataSize;
+
+			prepareChaCha20Nonce(nonce, chaCha20Nonce);
+
+			static_assert(sizeof(*key.raw.data()) == sizeof(uint8_t), "Expected key to be a byte array");
+			static_assert(sizeof(*chaCha20Nonce.raw.data()) == sizeof(uint8_t), "Expected chaCha20Nonce to be a byte array");
+			static_assert(sizeof(*message.data()) == sizeof(uint8_t), "Expected message buffer to be a byte array");
+			crypto_aead_init_ietf(&context, reinterpret_cast<const uint8_t*>(key.raw.data()), reinterpret_cast<const uint8_t*>(chaCha20Nonce.raw.data()));
+			crypto_aead_write(
+				&context,
+				reinterpret_cast<uint8_t*>(message.data()),
+				reinterpret_cast<uint8_t*>(message.data()) + macOffsetInCiphertext, // mac goes after text
+				nullptr,
+				0,
+				reinterpret_cast<const uint8_t*>(message.data()),
+				macOffsetInCiphertext
+			);
+
+			++nonce;
+		}
+
+		crypto_wipe(&context, sizeof(context));
+
+		return EncryptResult::Success;
+	}
+
+	DecryptResult decryptInplaceBatch_chacha20poly1305(
+		const CipherKey& key,
+		const Nonce firstNonce,
+		const std::span<const std::span<std::byte>> inOutMessages,
+		size_t& outDecryptedMessagesCount
+	) noexcept
+	{
+		outDecryptedMessagesCount = 0;
+
+		for (const std::span<std::byte> message : inOutMessages)
+		{
+			if (message.size() < CipherAuthDataSize) [[unlikely]]
+			{
+				reportDebugError("Ciphertext should be at least CipherAuthDataSize of size, but was shorter {}", message.size());
+				return DecryptResult::CiphertextSmallerThanMac;
+			}
+
+			if (message.size() > MaxMessageSize + CipherAuthDataSize) [[unlikely]]
+			{
+				reportDebugError("Ciphertext is bigger than max allowed size {}", message.size());
+				return DecryptResult::CiphertextBiggerThanMessageLimit;
+			}
+		}
+
+		if (inOutMessages.size() > MaxNonce - firstNonce) [[unlikely]]
+		{
+			return DecryptResult::NonceExhausted;
+		}
+
+		if (isEmptyKey(key))
+		{
+			return DecryptResult::IncorrectEncryptionKey;
+		}
+
+		ChaCha20Nonce chaCha20Nonce;
+		crypto_aead_ctx context;
+		Nonce nonce = firstNonce;
+
+		for (const std::span<std::byte> message : inOutMessages)
+		{
+			const size_t macOffsetInCiphertext = message.size() - CipherAuthDataSize;
+
+			prepareChaCha20Nonce(nonce, chaCha20Nonce);
+
+			static_assert(sizeof(*key.raw.data()) == sizeof(uint8_t), "Expected key to be a byte array");
+			static_assert(sizeof(*chaCha20Nonce.raw.data()) == sizeof(uint8_t), "Expected chaCha20Nonce to be a byte array");
+			static_assert(sizeof(*message.data()) == sizeof(uint8_t), "Expected message buffer to be a byte array");
+			crypto_aead_init_ietf(&context, reinterpret_cast<const uint8_t*>(key.raw.data()), reinterpret_cast<const uint8_t*>(chaCha20Nonce.raw.data()));
+			const int mismatch = crypto_aead_read(
+				&context,
+				reinterpret_cast<uint8_t*>(message.data()),
+				reinterpret_cast<const uint8_t*>(message.data()) + macOffsetInCiphertext, // mac is at the end of ciphertext
+				nullptr,
+				0,
+				reinterpret_cast<const uint8_t*>(message.data()),
+				macOffsetInCiphertext
+			);
+
+			if (mismatch != 0) [[unlikely]]
+			{
+				crypto_wipe(&context, sizeof(context));
+				Debug::Log::printDebug("Decryption of message {} in a batch failed, mac mismatch is {}", outDecryptedMessagesCount, mismatch);
+				return DecryptResult::AuthDataMismatch;
+			}
+
+			++nonce;
+			++outDecryptedMessagesCount;
+		}
+
+		crypto_wipe(&context, sizeof(context));
+
+		return DecryptResult::Success;
+	}
+
+	EncryptResult rekey_chacha20(CipherKey& inOutKey) noexcept
+	{
+		if (isEmptyKey(inOutKey))
+		{
+			return EncryptResult::IncorrectEncryptionKey;
+		}
+
+		ChaCha20Nonce chaCha20Nonce;
+		prepareChaCha20Nonce(MaxNonce, chaCha20Nonce);
+
+		// ChaCha20-Poly1305 uses the block 0 to derive the Poly1305 key and encrypts the text starting from block 1,
+		// so encrypting zeros gives us the raw keystream from block 1, and we don't need to calculate the MAC that is dropped anyway
+		constexpr uint32_t FirstTextBlockCounter = 1;
+		std::array<std::byte, CipherKeySize> newKey;
+
+		static_assert(sizeof(inOutKey.raw) == 32);
+		static_assert(chaCha20Nonce.raw.size() == 12);
+		// passing null as plaintext makes monocypher to write the keystream as is
+		crypto_chacha20_ietf(
+			reinterpret_cast<uint8_t*>(newKey.data()),
+			nullptr,
+			newKey.size(),
+			reinterpret_cast<const uint8_t*>(inOutKey.raw.data()),
+			reinterpret_cast<const uint8_t*>(chaCha20Nonce.raw.data()),
+			FirstTextBlockCounter
+		);
+
+		std::copy(newKey.begin(), newKey.end(), inOutKey.raw.begin());
+		crypto_wipe(newKey.data(), newKey.size());
+
+		return EncryptResult::Success;
+	}
 } // namespace Cryptography
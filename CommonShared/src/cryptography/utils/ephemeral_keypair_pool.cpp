@@ -0,0 +1,154 @@
+// Copyright (C) Pavel Grebnev 2026
+// Distributed under the MIT License (license terms are at http://opensource.org/licenses/MIT).
+
+#include "common_shared/cryptography/utils/ephemeral_keypair_pool.h"
+
+#if defined(_WIN32) || defined(_WIN64)
+#include <windows.h>
+#elif defined(__linux__) || defined(__ANDROID__)
+#include <sys/resource.h>
+#endif
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "common_shared/cryptography/primitives/dh_functions.h"
+
+namespace Cryptography::EphemeralKeypairPool
+{
+	struct PoolState
+	{
+		std::mutex mutex;
+		std::condition_variable refillCondition;
+		// destroying an element wipes the keys, so popping a keypair after moving it out leaves no copy behind
+		std::vector<Keypair> keypairs;
+		size_t capacity = 0;
+		bool isRunning = false;
+		bool shouldStop = false;
+		std::thread refillThread;
+
+		~PoolState()
+		{
+			// in case stop() wasn't called before exiting
+			if (refillThread.joinable())
+			{
+				{
+					std::lock_guard lock(mutex);
+					shouldStop = true;
+				}
+				refillCondition.notify_all();
+				refillThread.join();
+			}
+		}
+	};
+
+	static PoolState& getPoolState()
+	{
+		static PoolState state;
+		return state;
+	}
+
+	static void lowerCurrentThreadPriority()
+	{
+#if defined(_WIN32) || defined(_WIN64)
+		SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_LOWEST);
+#elif defined(__linux__) || defined(__ANDROID__)
+		// on Linux the nice value is per-thread, so this doesn't affect the other threads
+		setpriority(PRIO_PROCESS, 0, 19);
+#endif
+	}
+
+	static void refillThreadFunction(PoolState& state)
+	{
+		lowerCurrentThreadPriority();
+
+		std::unique_lock lock(state.mutex);
+		while (true)
+		{
+			state.refillCondition.wait(lock, [&state] {
+				return state.shouldStop || state.keypairs.size() < state.capacity;
+			});
+
+			if (state.shouldStop)
+			{
+				return;
+			}
+
+			// generate without holding the lock, so takers are not blocked
+			lock.unlock();
+			Keypair newKeypair = generateKeypair_x25519();
+			lock.lock();
+
+			if (state.keypairs.size() < state.capacity)
+			{
+				state.keypairs.push_back(std::move(newKeypair));
+			}
+		}
+	}
+
+	void start(size_t capacity) noexcept
+	{
+		PoolState& state = getPoolState();
+		std::lock_guard lock(state.mutex);
+		if (state.isRunning || capacity == 0)
+		{
+			return;
+		}
+
+		state.capacity = capacity;
+		state.keypairs.reserve(capacity);
+		state.shouldStop = false;
+		state.isRunning = true;
+		state.refillThread = std::thread(refillThreadFunction, std::ref(state));
+	}
+
+	void stop() noexcept
+	{
+		PoolState& state = getPoolState();
+		std::thread refillThread;
+		{
+			std::lock_guard lock(state.mutex);
+			if (!state.isRunning)
+			{
+				return;
+			}
+
+			state.shouldStop = true;
+			state.isRunning = false;
+			refillThread = std::move(state.refillThread);
+		}
+
+		state.refillCondition.notify_all();
+		refillThread.join();
+
+		std::lock_guard lock(state.mutex);
+		state.keypairs.clear();
+		state.capacity = 0;
+	}
+
+	Keypair takeKeypair() noexcept
+	{
+		PoolState& state = getPoolState();
+		{
+			std::lock_guard lock(state.mutex);
+			if (!state.keypairs.empty()) [[likely]]
+			{
+				Keypair result = std::move(state.keypairs.back());
+				state.keypairs.pop_back();
+				state.refillCondition.notify_one();
+				return result;
+			}
+		}
+
+		return generateKeypair_x25519();
+	}
+
+	size_t getAvailableCount() noexcept
+	{
+		PoolState& state = getPoolState();
+		std::lock_guard lock(state.mutex);
+		return state.keypairs.size();
+	}
+} // namespace Cryptography::EphemeralKeypairPool
@@ -0,0 +1,205 @@
+// Copyright (C) Pavel Grebnev 2026
+// Distributed under the MIT License (license terms are at http://opensource.org/licenses/MIT).
+
+#include "common_shared/files/append_only_file.h"
+
+#include <algorithm>
+
+#if defined(_WIN32) || defined(_WIN64)
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "common_shared/debug/assert.h"
+#include "common_shared/debug/log.h"
+
+namespace AppendOnlyFileInternal
+{
+#if defined(_WIN32) || defined(_WIN64)
+	static const HANDLE InvalidHandle = INVALID_HANDLE_VALUE;
+#else
+	static constexpr int InvalidHandle = -1;
+#endif
+} // namespace AppendOnlyFileInternal
+
+namespace Files
+{
+	std::optional<AppendOnlyFile> AppendOnlyFile::open(const std::filesystem::path& path) noexcept
+	{
+#if defined(_WIN32) || defined(_WIN64)
+		const HANDLE file = CreateFileW(path.c_str(), GENERIC_WRITE, FILE_SHARE_READ, nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (file == INVALID_HANDLE_VALUE)
+		{
+			Debug::Log::printDebug("Could not open file '{}', error: {}", path.string(), GetLastError());
+			return std::nullopt;
+		}
+
+		LARGE_INTEGER fileSize;
+		const LARGE_INTEGER zeroOffset{};
+		if (!GetFileSizeEx(file, &fileSize) || !SetFilePointerEx(file, zeroOffset, nullptr, FILE_END))
+		{
+			Debug::Log::printDebug("Could not get the size of file '{}', error: {}", path.string(), GetLastError());
+			CloseHandle(file);
+			return std::nullopt;
+		}
+
+		return AppendOnlyFile(file, static_cast<uint64_t>(fileSize.QuadPart));
+#else
+		const int file = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0600);
+		if (file < 0)
+		{
+			Debug::Log::printDebug("Could not open file '{}', errno: {}", path.string(), errno);
+			return std::nullopt;
+		}
+
+		struct stat fileStat;
+		if (fstat(file, &fileStat) != 0)
+		{
+			Debug::Log::printDebug("Could not get the size of file '{}', errno: {}", path.string(), errno);
+			::close(file);
+			return std::nullopt;
+		}
+
+		// make sure the file itself survives a crash, not only its data
+		std::filesystem::path directoryPath = path.parent_path();
+		if (directoryPath.empty())
+		{
+			directoryPath = ".";
+		}
+		const int directory = ::open(directoryPath.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+		if (directory >= 0)
+		{
+			::fsync(directory);
+			::close(directory);
+		}
+
+		return AppendOnlyFile(file, static_cast<uint64_t>(fileStat.st_size));
+#endif
+	}
+
+	AppendOnlyFile::AppendOnlyFile(const NativeHandle handle, const uint64_t size) noexcept
+		: mHandle(handle)
+		, mSize(size)
+	{
+	}
+
+	AppendOnlyFile::AppendOnlyFile(AppendOnlyFile&& other) noexcept
+		: mHandle(other.mHandle)
+		, mSize(other.mSize)
+	{
+		other.mHandle = AppendOnlyFileInternal::InvalidHandle;
+		other.mSize = 0;
+	}
+
+	AppendOnlyFile& AppendOnlyFile::operator=(AppendOnlyFile&& other) noexcept
+	{
+		if (this != &other)
+		{
+			close();
+			mHandle = other.mHandle;
+			mSize = other.mSize;
+			other.mHandle = AppendOnlyFileInternal::InvalidHandle;
+			other.mSize = 0;
+		}
+		return *this;
+	}
+
+	AppendOnlyFile::~AppendOnlyFile() noexcept
+	{
+		close();
+	}
+
+	bool AppendOnlyFile::append(std::span<const std::byte> data) noexcept
+	{
+		// normally this is a single write call, the loop only handles interrupted and partial writes
+		size_t bytesWritten = 0;
+		while (bytesWritten < data.size())
+		{
+#if defined(_WIN32) || defined(_WIN64)
+			const DWORD chunkSize = static_cast<DWORD>(std::min<size_t>(data.size() - bytesWritten, 0x40000000));
+			DWORD chunkWritten = 0;
+			if (WriteFile(mHandle, data.data() + bytesWritten, chunkSize, &chunkWritten, nullptr) == FALSE)
+			{
+				Debug::Log::printDebug("Could not append to a file, error: {}", GetLastError());
+				mSize += bytesWritten;
+				return false;
+			}
+#else
+			const ssize_t chunkWritten = ::write(mHandle, data.data() + bytesWritten, data.size() - bytesWritten);
+			if (chunkWritten < 0)
+			{
+				if (errno == EINTR)
+				{
+					continue;
+				}
+				Debug::Log::printDebug("Could not append to a file, errno: {}", errno);
+				mSize += bytesWritten;
+				return false;
+			}
+#endif
+			bytesWritten += static_cast<size_t>(chunkWritten);
+		}
+
+		mSize += bytesWritten;
+		return true;
+	}
+
+	bool AppendOnlyFile::sync() noexcept
+	{
+#if defined(_WIN32) || defined(_WIN64)
+		return FlushFileBuffers(mHandle) != FALSE;
+#elif defined(__linux__)
+		// the size is still flushed, but not the other metadata like the modification time
+		return ::fdatasync(mHandle) == 0;
+#else
+		return ::fsync(mHandle) == 0;
+#endif
+	}
+
+	bool AppendOnlyFile::truncate(const uint64_t size) noexcept
+	{
+		if (size > mSize)
+		{
+			reportDebugError("Tried to truncate a file of size {} to bigger size {}", mSize, size);
+			return false;
+		}
+
+#if defined(_WIN32) || defined(_WIN64)
+		LARGE_INTEGER offset;
+		offset.QuadPart = static_cast<LONGLONG>(size);
+		if (!SetFilePointerEx(mHandle, offset, nullptr, FILE_BEGIN) || !SetEndOfFile(mHandle))
+		{
+			Debug::Log::printDebug("Could not truncate a file, error: {}", GetLastError());
+			return false;
+		}
+#else
+		// the writes with O_APPEND continue from the new end
+		if (::ftruncate(mHandle, static_cast<off_t>(size)) != 0)
+		{
+			Debug::Log::printDebug("Could not truncate a file, errno: {}", errno);
+			return false;
+		}
+#endif
+		mSize = size;
+		return true;
+	}
+
+	void AppendOnlyFile::close() noexcept
+	{
+		if (mHandle == AppendOnlyFileInternal::InvalidHandle)
+		{
+			return;
+		}
+
+#if defined(_WIN32) || defined(_WIN64)
+		CloseHandle(mHandle);
+#else
+		::close(mHandle);
+#endif
+		mHandle = AppendOnlyFileInternal::InvalidHandle;
+	}
+} // namespace Files
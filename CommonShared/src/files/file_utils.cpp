@@ -3,6 +3,19 @@
 
 #include "common_shared/files/file_utils.h"
 
+#include <algorithm>
+
+#if defined(_WIN32) || defined(_WIN64)
+#include <windows.h>
+#else
+#include <cerrno>
+#include <cstdio>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include "common_shared/debug/log.h"
+
 namespace Files
 {
 	bool isFilePathAcceptable(const std::filesystem::path& path) noexcept
@@ -39,4 +52,87 @@ namespace Files
 		}
 		return parent != "..";
 	}
+
+	bool writeFileAtomically(const std::filesystem::path& path, std::span<const std::byte> data) noexcept
+	{
+		std::filesystem::path temporaryPath = path;
+		temporaryPath += ".tmp";
+
+#if defined(_WIN32) || defined(_WIN64)
+		const HANDLE file = CreateFileW(temporaryPath.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (file == INVALID_HANDLE_VALUE)
+		{
+			Debug::Log::printDebug("Could not create file '{}', error: {}", temporaryPath.string(), GetLastError());
+			return false;
+		}
+
+		bool isWritten = true;
+		size_t bytesWritten = 0;
+		while (isWritten && bytesWritten < data.size())
+		{
+			const DWORD chunkSize = static_cast<DWORD>(std::min<size_t>(data.size() - bytesWritten, 0x40000000));
+			DWORD chunkWritten = 0;
+			isWritten = WriteFile(file, data.data() + bytesWritten, chunkSize, &chunkWritten, nullptr) != FALSE;
+			bytesWritten += chunkWritten;
+		}
+		isWritten = isWritten && FlushFileBuffers(file) != FALSE;
+		CloseHandle(file);
+
+		if (!isWritten || MoveFileExW(temporaryPath.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) == FALSE)
+		{
+			Debug::Log::printDebug("Could not write file '{}', error: {}", path.string(), GetLastError());
+			DeleteFileW(temporaryPath.c_str());
+			return false;
+		}
+		return true;
+#else
+		const int file = ::open(temporaryPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+		if (file < 0)
+		{
+			Debug::Log::printDebug("Could not create file '{}', errno: {}", temporaryPath.string(), errno);
+			return false;
+		}
+
+		// normally this is a single write call, the loop only handles interrupted and partial writes
+		bool isWritten = true;
+		size_t bytesWritten = 0;
+		while (bytesWritten < data.size())
+		{
+			const ssize_t chunkWritten = ::write(file, data.data() + bytesWritten, data.size() - bytesWritten);
+			if (chunkWritten < 0)
+			{
+				if (errno == EINTR)
+				{
+					continue;
+				}
+				isWritten = false;
+				break;
+			}
+			bytesWritten += static_cast<size_t>(chunkWritten);
+		}
+		isWritten = isWritten && ::fsync(file) == 0;
+		isWritten = ::close(file) == 0 && isWritten;
+
+		if (!isWritten || std::rename(temporaryPath.c_str(), path.c_str()) != 0)
+		{
+			Debug::Log::printDebug("Could not write file '{}', errno: {}", path.string(), errno);
+			::unlink(temporaryPath.c_str());
+			return false;
+		}
+
+		// the rename itself is durable only after the directory is flushed
+		std::filesystem::path directoryPath = path.parent_path();
+		if (directoryPath.empty())
+		{
+			directoryPath = ".";
+		}
+		const int directory = ::open(directoryPath.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+		if (directory >= 0)
+		{
+			::fsync(directory);
+			::close(directory);
+		}
+		return true;
+#endif
+	}
 } // namespace Files
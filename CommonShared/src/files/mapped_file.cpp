@@ -0,0 +1,128 @@
+// Copyright (C) Pavel Grebnev 2026
+// Distributed under the MIT License (license terms are at http://opensource.org/licenses/MIT).
+
+#include "common_shared/files/mapped_file.h"
+
+#if defined(_WIN32) || defined(_WIN64)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "common_shared/debug/assert.h"
+
+namespace Files
+{
+	std::optional<MappedFile> MappedFile::open(const std::filesystem::path& path) noexcept
+	{
+#if defined(_WIN32) || defined(_WIN64)
+		const HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (file == INVALID_HANDLE_VALUE)
+		{
+			return std::nullopt;
+		}
+
+		LARGE_INTEGER fileSize;
+		if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+		{
+			CloseHandle(file);
+			return std::nullopt;
+		}
+
+		const HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		CloseHandle(file);
+		if (mapping == nullptr)
+		{
+			return std::nullopt;
+		}
+
+		// the view keeps the mapping object alive
+		void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+		CloseHandle(mapping);
+		if (data == nullptr)
+		{
+			return std::nullopt;
+		}
+
+		return MappedFile(static_cast<const std::byte*>(data), static_cast<size_t>(fileSize.QuadPart));
+#else
+		const int file = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+		if (file < 0)
+		{
+			return std::nullopt;
+		}
+
+		struct stat fileStat;
+		if (fstat(file, &fileStat) != 0 || fileStat.st_size <= 0)
+		{
+			close(file);
+			return std::nullopt;
+		}
+
+		// the mapping stays valid after the descriptor is closed
+		void* data = mmap(nullptr, static_cast<size_t>(fileStat.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+		close(file);
+		if (data == MAP_FAILED)
+		{
+			return std::nullopt;
+		}
+
+		return MappedFile(static_cast<const std::byte*>(data), static_cast<size_t>(fileStat.st_size));
+#endif
+	}
+
+	MappedFile::MappedFile(const std::byte* data, const size_t size) noexcept
+		: mData(data)
+		, mSize(size)
+	{
+	}
+
+	MappedFile::MappedFile(MappedFile&& other) noexcept
+		: mData(other.mData)
+		, mSize(other.mSize)
+	{
+		other.mData = nullptr;
+		other.mSize = 0;
+	}
+
+	MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+	{
+		if (this != &other)
+		{
+			unmap();
+			mData = other.mData;
+			mSize = other.mSize;
+			other.mData = nullptr;
+			other.mSize = 0;
+		}
+		return *this;
+	}
+
+	MappedFile::~MappedFile() noexcept
+	{
+		unmap();
+	}
+
+	void MappedFile::unmap() noexcept
+	{
+		if (mData == nullptr)
+		{
+			return;
+		}
+
+#if defined(_WIN32) || defined(_WIN64)
+		const bool isUnmapped = UnmapViewOfFile(mData) != 0;
+#else
+		const bool isUnmapped = munmap(const_cast<std::byte*>(mData), mSize) == 0;
+#endif
+		if (!isUnmapped)
+		{
+			reportDebugError("Could not unmap a file of size {}", mSize);
+		}
+		mData = nullptr;
+		mSize = 0;
+	}
+} // namespace Files
@@ -3,6 +3,8 @@
 
 #include "common_shared/hash_utils.h"
 
+#include <array>
+
 namespace Hash
 {
 	size_t hashSpan(std::span<const std::byte> span) noexcept
@@ -20,4 +22,28 @@ namespace Hash
 		}
 		return seed;
 	}
+
+	uint32_t crc32(std::span<const std::byte> data) noexcept
+	{
+		static constexpr std::array<uint32_t, 256> table = []() {
+			std::array<uint32_t, 256> result{};
+			for (uint32_t i = 0; i < result.size(); ++i)
+			{
+				uint32_t value = i;
+				for (int bit = 0; bit < 8; ++bit)
+				{
+					value = (value & 1) ? (0xEDB88320 ^ (value >> 1)) : (value >> 1);
+				}
+				result[i] = value;
+			}
+			return result;
+		}();
+
+		uint32_t crc = 0xFFFFFFFF;
+		for (const std::byte b : data)
+		{
+			crc = table[(crc ^ static_cast<uint32_t>(b)) & 0xFF] ^ (crc >> 8);
+		}
+		return crc ^ 0xFFFFFFFF;
+	}
 } // namespace Hash
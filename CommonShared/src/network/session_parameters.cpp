@@ -0,0 +1,99 @@
+// Copyright (C) Pavel Grebnev 2026
+// Distributed under the MIT License (license terms are at http://opensource.org/licenses/MIT).
+
+#include "common_shared/network/session_parameters.h"
+
+#include <bit>
+
+#include "common_shared/cryptography/noise/cipher_utils.h"
+#include "common_shared/network/protocol.h"
+#include "common_shared/serialization/number_serialization.h"
+
+namespace Protocol::SessionParameters
+{
+	constexpr size_t FeaturesOffset = 0;
+	constexpr size_t FrameModesOffset = FeaturesOffset + sizeof(uint32_t);
+	constexpr size_t HashModesOffset = FrameModesOffset + sizeof(uint8_t);
+	constexpr size_t CompressionModesOffset = HashModesOffset + sizeof(uint8_t);
+	constexpr size_t ReservedOffset = CompressionModesOffset + sizeof(uint8_t);
+	constexpr size_t RekeyPolicyOffset = ReservedOffset + sizeof(uint8_t);
+	static_assert(RekeyPolicyOffset + 3 * sizeof(uint64_t) == MessageSize);
+	static_assert(MaxMessageSize >= MessageSize);
+
+	void write(std::span<std::byte, MessageSize> outData, const Parameters& parameters) noexcept
+	{
+		Serialization::writeUint32(outData.subspan(FeaturesOffset, sizeof(uint32_t)), parameters.features);
+		outData[FrameModesOffset] = static_cast<std::byte>(parameters.frameModes);
+		outData[HashModesOffset] = static_cast<std::byte>(parameters.hashModes);
+		outData[CompressionModesOffset] = static_cast<std::byte>(parameters.compressionModes);
+		outData[ReservedOffset] = std::byte(0);
+		Serialization::writeUint64(outData.subspan(RekeyPolicyOffset, sizeof(uint64_t)), parameters.rekeyPolicy.messagesInterval);
+		Serialization::writeUint64(outData.subspan(RekeyPolicyOffset + sizeof(uint64_t), sizeof(uint64_t)), parameters.rekeyPolicy.bytesInterval);
+		Serialization::writeUint64(outData.subspan(RekeyPolicyOffset + 2 * sizeof(uint64_t), sizeof(uint64_t)), parameters.rekeyPolicy.timeIntervalMs);
+	}
+
+	Parameters read(std::span<const std::byte, MessageSize> data) noexcept
+	{
+		return Parameters{
+			.features = Serialization::readUint32(data.subspan(FeaturesOffset, sizeof(uint32_t))),
+			.frameModes = static_cast<uint8_t>(data[FrameModesOffset]),
+			.hashModes = static_cast<uint8_t>(data[HashModesOffset]),
+			.compressionModes = static_cast<uint8_t>(data[CompressionModesOffset]),
+			.rekeyPolicy = Noise::RekeyPolicy{
+				.messagesInterval = Serialization::readUint64(data.subspan(RekeyPolicyOffset, sizeof(uint64_t))),
+				.bytesInterval = Serialization::readUint64(data.subspan(RekeyPolicyOffset + sizeof(uint64_t), sizeof(uint64_t))),
+				.timeIntervalMs = Serialization::readUint64(data.subspan(RekeyPolicyOffset + 2 * sizeof(uint64_t), sizeof(uint64_t))),
+			},
+		};
+	}
+
+	Parameters getSupported() noexcept
+	{
+		return Parameters{
+			.features = Features::ResumptionTickets,
+			.frameModes = FrameModes::Chunk1024Window32,
+			.hashModes = HashModes::Blake2b,
+			.compressionModes = CompressionModes::None,
+			.rekeyPolicy = FileExchange::DefaultRekeyPolicy,
+		};
+	}
+
+	// the modes added later get higher bits and are considered better
+	static uint8_t pickBestCommonMode(const uint8_t ourModes, const uint8_t theirModes) noexcept
+	{
+		return std::bit_floor(static_cast<uint8_t>(ourModes & theirModes));
+	}
+
+	static bool isSingleOfferedMode(const uint8_t offeredModes, const uint8_t chosenMode) noexcept
+	{
+		return std::has_single_bit(chosenMode) && (offeredModes & chosenMode) != 0;
+	}
+
+	std::optional<Parameters> negotiate(const Parameters& ours, const Parameters& theirs) noexcept
+	{
+		const Parameters result{
+			.features = ours.features & theirs.features,
+			.frameModes = pickBestCommonMode(ours.frameModes, theirs.frameModes),
+			.hashModes = pickBestCommonMode(ours.hashModes, theirs.hashModes),
+			.compressionModes = pickBestCommonMode(ours.compressionModes, theirs.compressionModes),
+			.rekeyPolicy = Noise::Utils::negotiateRekeyPolicy(ours.rekeyPolicy, theirs.rekeyPolicy),
+		};
+
+		if (result.frameModes == 0 || result.hashModes == 0 || result.compressionModes == 0)
+		{
+			return std::nullopt;
+		}
+
+		return result;
+	}
+
+	bool isValidChoice(const Parameters& offered, const Parameters& chosen) noexcept
+	{
+		return (chosen.features & ~offered.features) == 0
+			&& isSingleOfferedMode(offered.frameModes, chosen.frameModes)
+			&& isSingleOfferedMode(offered.hashModes, chosen.hashModes)
+			&& isSingleOfferedMode(offered.compressionModes, chosen.compressionModes)
+			// the server is allowed to ask for more frequent rekeys, but not for less frequent ones
+			&& Noise::Utils::negotiateRekeyPolicy(offered.rekeyPolicy, chosen.rekeyPolicy) == chosen.rekeyPolicy;
+	}
+} // namespace Protocol::SessionParameters
@@ -0,0 +1,215 @@
+// Copyright (C) Pavel Grebnev 2026
+// Distributed under the MIT License (license terms are at http://opensource.org/licenses/MIT).
+
+#include "common_shared/network/socket_reaper.h"
+
+#if !(defined(_WIN32) || defined(_WIN64))
+#include <fcntl.h>
+#include <poll.h>
+#endif
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "common_shared/network/raw_sockets.h"
+
+namespace Network::SocketReaper
+{
+	// a new socket is picked up by the reaper thread no later than this
+	constexpr int PollIntervalMilliseconds = 10;
+	// limit the amount of data we read from a single socket per iteration, so a peer flooding us can't starve the others
+	constexpr size_t MaxDrainedBytesPerIteration = 16 * 1024;
+
+	struct PendingSocket
+	{
+		RawSocket socket;
+		std::chrono::steady_clock::time_point deadline;
+	};
+
+	struct ReaperState
+	{
+		std::mutex mutex;
+		std::condition_variable wakeUpCondition;
+		std::vector<PendingSocket> pendingSockets;
+		bool shouldStop = false;
+		std::thread reaperThread;
+
+		~ReaperState()
+		{
+			if (reaperThread.joinable())
+			{
+				{
+					std::lock_guard lock(mutex);
+					shouldStop = true;
+				}
+				wakeUpCondition.notify_all();
+				reaperThread.join();
+			}
+
+			for (const PendingSocket& pendingSocket : pendingSockets)
+			{
+				closeSocket(pendingSocket.socket, CloseMode::Immediate);
+			}
+		}
+	};
+
+	static ReaperState& getReaperState()
+	{
+		static ReaperState state;
+		return state;
+	}
+
+	static bool setNonBlocking(const RawSocket socket)
+	{
+#if defined(_WIN32) || defined(_WIN64)
+		u_long mode = 1;
+		return ioctlsocket(socket, FIONBIO, &mode) == 0;
+#else
+		const int flags = fcntl(socket, F_GETFL, 0);
+		return flags != -1 && fcntl(socket, F_SETFL, flags | O_NONBLOCK) != -1;
+#endif
+	}
+
+	static bool isWouldBlockError()
+	{
+#if defined(_WIN32) || defined(_WIN64)
+		return WSAGetLastError() == WSAEWOULDBLOCK;
+#else
+		return errno == EAGAIN || errno == EWOULDBLOCK;
+#endif
+	}
+
+	// returns true if the peer closed the connection or the connection is broken
+	static bool drainSocket(const RawSocket socket)
+	{
+		std::array<char, 1024> buffer;
+		size_t drainedBytes = 0;
+		while (drainedBytes < MaxDrainedBytesPerIteration)
+		{
+			const auto receivedBytes = ::recv(socket, buffer.data(), static_cast<int>(buffer.size()), 0);
+			if (receivedBytes == 0)
+			{
+				return true;
+			}
+
+			if (receivedBytes < 0)
+			{
+				return !isWouldBlockError();
+			}
+
+			drainedBytes += static_cast<size_t>(receivedBytes);
+		}
+		return false;
+	}
+
+	static void reaperThreadFunction(ReaperState& state)
+	{
+#if defined(_WIN32) || defined(_WIN64)
+		using PollFd = WSAPOLLFD;
+#else
+		using PollFd = pollfd;
+#endif
+		std::vector<PollFd> pollFds;
+		std::vector<RawSocket> socketsToClose;
+
+		std::unique_lock lock(state.mutex);
+		while (true)
+		{
+			state.wakeUpCondition.wait(lock, [&state] {
+				return state.shouldStop || !state.pendingSockets.empty();
+			});
+
+			if (state.shouldStop)
+			{
+				return;
+			}
+
+			pollFds.clear();
+			for (const PendingSocket& pendingSocket : state.pendingSockets)
+			{
+				PollFd pollFd{};
+				pollFd.fd = pendingSocket.socket;
+				pollFd.events = POLLIN;
+				pollFds.push_back(pollFd);
+			}
+
+			// new sockets can be added while we are waiting, they will be picked up on the next iteration
+			lock.unlock();
+#if defined(_WIN32) || defined(_WIN64)
+			WSAPoll(pollFds.data(), static_cast<ULONG>(pollFds.size()), PollIntervalMilliseconds);
+#else
+			poll(pollFds.data(), static_cast<nfds_t>(pollFds.size()), PollIntervalMilliseconds);
+#endif
+
+			for (PollFd& pollFd : pollFds)
+			{
+				if (pollFd.revents != 0 && drainSocket(pollFd.fd))
+				{
+					socketsToClose.push_back(pollFd.fd);
+				}
+			}
+			lock.lock();
+
+			// only we remove the sockets from the list, so the sockets from pollFds are still there
+			const auto now = std::chrono::steady_clock::now();
+			std::erase_if(state.pendingSockets, [&socketsToClose, now](const PendingSocket& pendingSocket) {
+				const bool isDrained = std::find(socketsToClose.begin(), socketsToClose.end(), pendingSocket.socket) != socketsToClose.end();
+				if (!isDrained && pendingSocket.deadline <= now)
+				{
+					socketsToClose.push_back(pendingSocket.socket);
+					return true;
+				}
+				return isDrained;
+			});
+
+			lock.unlock();
+			for (const RawSocket socket : socketsToClose)
+			{
+				closeSocket(socket, CloseMode::Immediate);
+			}
+			socketsToClose.clear();
+			lock.lock();
+		}
+	}
+
+	bool tryAdd(const RawSocket socket) noexcept
+	{
+		if (!setNonBlocking(socket))
+		{
+			return false;
+		}
+
+		ReaperState& state = getReaperState();
+		{
+			std::lock_guard lock(state.mutex);
+			if (state.shouldStop || state.pendingSockets.size() >= MaxPendingSockets)
+			{
+				return false;
+			}
+
+			state.pendingSockets.push_back(PendingSocket{
+				.socket = socket,
+				.deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(DrainTimeoutMilliseconds),
+			});
+
+			if (!state.reaperThread.joinable())
+			{
+				state.reaperThread = std::thread(reaperThreadFunction, std::ref(state));
+			}
+		}
+		state.wakeUpCondition.notify_one();
+		return true;
+	}
+
+	size_t getPendingCount() noexcept
+	{
+		ReaperState& state = getReaperState();
+		std::lock_guard lock(state.mutex);
+		return state.pendingSockets.size();
+	}
+} // namespace Network::SocketReaper
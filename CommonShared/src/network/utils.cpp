@@ -4,6 +4,7 @@
 #include "common_shared/network/utils.h"
 
 #include <algorithm>
+#include <array>
 #include <climits>
 #include <cstring>
 #include <format>
@@ -12,7 +13,10 @@
 #include "common_shared/cryptography/utils/crypto_wipe.h"
 #include "common_shared/debug/assert.h"
 #include "common_shared/debug/debug_print_helpers.h"
+#include "common_shared/network/protocol.h"
 #include "common_shared/network/raw_sockets.h"
+#include "common_shared/network/socket_reaper.h"
+#include "common_shared/serialization/number_serialization.h"
 
 namespace Network
 {
@@ -542,6 +546,60 @@ namespace Network
 		return std::nullopt;
 	}
 
+	static std::string encryptResultToString(const Cryptography::EncryptResult encryptResult)
+	{
+		switch (encryptResult)
+		{
+		case Cryptography::EncryptResult::Success:
+			return "Success";
+		case Cryptography::EncryptResult::PlaintextBiggerThanMaxMessageSize:
+			return "Plaintext is too big to be encrypted";
+		case Cryptography::EncryptResult::CiphertextBufferTooSmall:
+			return "Ciphertext buffer is too small to fit the result";
+		case Cryptography::EncryptResult::CiphertextBufferTooBig:
+			return "Ciphertext buffer is bigger than expected";
+		case Cryptography::EncryptResult::IncorrectEncryptionKey:
+			return "Encryption key is not valid (empty)";
+		case Cryptography::EncryptResult::PartiallyOverlappingBuffers:
+			return "Plaintext and ciphertext buffers are not allowed to partially overlap";
+		case Cryptography::EncryptResult::NoEncryptionKey:
+			return "No encryption key was provided";
+		case Cryptography::EncryptResult::NonceExhausted:
+			return "Nonce has been exhausted, can't send any more data in this stream";
+		}
+
+		return "Unreachable code reached";
+	}
+
+	static std::string decryptResultToString(const Cryptography::DecryptResult decryptResult)
+	{
+		switch (decryptResult)
+		{
+		case Cryptography::DecryptResult::Success:
+			return "Success";
+		case Cryptography::DecryptResult::AuthDataMismatch:
+			return "Auth data mismatch, the byte stream is corrupted or tempered with";
+		case Cryptography::DecryptResult::CiphertextSmallerThanMac:
+			return "Ciphertext is smaller than authentification data";
+		case Cryptography::DecryptResult::CiphertextBiggerThanMessageLimit:
+			return "Ciphertext is too big to be decrypted";
+		case Cryptography::DecryptResult::PlaintextBufferTooSmall:
+			return "Plaintext buffer is too small to fit the result";
+		case Cryptography::DecryptResult::PlaintextBufferTooBig:
+			return "Plaintext buffer is bigger than expected";
+		case Cryptography::DecryptResult::IncorrectEncryptionKey:
+			return "Encryption key is not valid (empty)";
+		case Cryptography::DecryptResult::PartiallyOverlappingBuffers:
+			return "Plaintext and ciphertext buffers are not allowed to partially oveerlap";
+		case Cryptography::DecryptResult::NoEncryptionKey:
+			return "No encryption key was provided";
+		case Cryptography::DecryptResult::NonceExhausted:
+			return "Nonce has been exhausted, can't send any more data in this stream";
+		}
+
+		return "Unreachable code reached";
+	}
+
 	std::optional<std::string> sendEncrypted(RawSocket socket, std::span<std::byte> buffer, size_t bytesToSend, Noise::CipherStateSending& cipherState)
 	{
 		if (buffer.size() < bytesToSend + Cryptography::CipherAuthDataSize)
@@ -564,28 +622,12 @@ namespace Network
 #endif // DEBUG_CHECKS
 
 		const Cryptography::EncryptResult encryptResult = Noise::Utils::encryptTransportMessageInplace(cipherState, std::span<std::byte>(buffer.data(), bytesToSend + Cryptography::CipherAuthDataSize));
-
-		switch (encryptResult)
+		if (encryptResult != Cryptography::EncryptResult::Success) [[unlikely]]
 		{
-		case Cryptography::EncryptResult::Success:
-			return send(socket, std::span<std::byte>(buffer.data(), bytesToSend + Cryptography::CipherAuthDataSize));
-		case Cryptography::EncryptResult::PlaintextBiggerThanMaxMessageSize:
-			return "Plaintext is too big to be encrypted";
-		case Cryptography::EncryptResult::CiphertextBufferTooSmall:
-			return "Ciphertext buffer is too small to fit the result";
-		case Cryptography::EncryptResult::CiphertextBufferTooBig:
-			return "Ciphertext buffer is bigger than expected";
-		case Cryptography::EncryptResult::IncorrectEncryptionKey:
-			return "Encryption key is not valid (empty)";
-		case Cryptography::EncryptResult::PartiallyOverlappingBuffers:
-			return "Plaintext and ciphertext buffers are not allowed to partially overlap";
-		case Cryptography::EncryptResult::NoEncryptionKey:
-			return "No encryption key was provided";
-		case Cryptography::EncryptResult::NonceExhausted:
-			return "Nonce has been exhausted, can't send any more data in this stream";
+			return encryptResultToString(encryptResult);
 		}
 
-		return "Unreachable code reached";
+		return send(socket, std::span<std::byte>(buffer.data(), bytesToSend + Cryptography::CipherAuthDataSize));
 	}
 
 	std::optional<std::string> recvEncrypted(RawSocket socket, std::span<std::byte> buffer, size_t& receivedBytes, Noise::CipherStateReceiving& cipherState)
@@ -602,59 +644,184 @@ namespace Network
 		}
 
 		const Cryptography::DecryptResult decryptResult = Noise::Utils::decryptTransportMessageInplace(cipherState, buffer);
+		if (decryptResult != Cryptography::DecryptResult::Success) [[unlikely]]
+		{
+			return decryptResultToString(decryptResult);
+		}
 
-		switch (decryptResult)
+		receivedBytes -= Cryptography::CipherAuthDataSize;
+		Cryptography::cryptoWipeRawData(std::span(buffer.data() + receivedBytes, Cryptography::CipherAuthDataSize));
+
+#ifdef DEBUG_CHECKS
+		if constexpr (debugPrintBuffers)
 		{
-		case Cryptography::DecryptResult::Success:
-			receivedBytes -= Cryptography::CipherAuthDataSize;
-			Cryptography::cryptoWipeRawData(std::span(buffer.data() + receivedBytes, Cryptography::CipherAuthDataSize));
+			Debug::Print::printSpan("recv (after decryption)", std::span<std::byte>(buffer.data(), receivedBytes));
+		}
+#endif // DEBUG_CHECKS
+
+		return std::nullopt;
+	}
+
+	std::optional<std::string> sendEncryptedBatch(RawSocket socket, std::span<const std::span<std::byte>> frames, Noise::CipherStateSending& cipherState, Noise::RekeySchedule& rekeySchedule)
+	{
+		for (const std::span<std::byte> frame : frames)
+		{
+			if (frame.size() <= Cryptography::CipherAuthDataSize)
+			{
+				reportDebugError("Tried to send a frame without any data, this signals about a logical error");
+				return std::format("Tried to send a frame without any data, this signals about a logical error");
+			}
+
+#ifdef DEBUG_CHECKS
+			if constexpr (debugPrintBuffers)
+			{
+				Debug::Print::printSpan("send (before encryption)", std::span(frame.data(), frame.size() - Cryptography::CipherAuthDataSize));
+			}
+#endif // DEBUG_CHECKS
+		}
+
+		const Cryptography::EncryptResult encryptResult = Noise::Utils::encryptTransportMessagesInplace(cipherState, frames, rekeySchedule);
+		if (encryptResult != Cryptography::EncryptResult::Success) [[unlikely]]
+		{
+			return encryptResultToString(encryptResult);
+		}
+
+		for (const std::span<std::byte> frame : frames)
+		{
+			if (auto sendResult = send(socket, frame); sendResult.has_value()) [[unlikely]]
+			{
+				return sendResult;
+			}
+		}
+
+		return std::nullopt;
+	}
+
+	std::optional<std::string> recvEncryptedBatch(RawSocket socket, std::span<const std::span<std::byte>> frames, Noise::CipherStateReceiving& cipherState, Noise::RekeySchedule& rekeySchedule)
+	{
+		for (const std::span<std::byte> frame : frames)
+		{
+			if (frame.size() <= Cryptography::CipherAuthDataSize)
+			{
+				return "Frame buffer is too small to fit any non-zero message";
+			}
+
+			size_t receivedBytes = 0;
+			if (auto recvResult = recv(socket, frame, static_cast<int>(frame.size()), receivedBytes); recvResult.has_value())
+			{
+				return recvResult;
+			}
+		}
+
+		const Cryptography::DecryptResult decryptResult = Noise::Utils::decryptTransportMessagesInplace(cipherState, frames, rekeySchedule);
+		if (decryptResult != Cryptography::DecryptResult::Success) [[unlikely]]
+		{
+			return decryptResultToString(decryptResult);
+		}
+
+		for (const std::span<std::byte> frame : frames)
+		{
+			const size_t plaintextSize = frame.size() - Cryptography::CipherAuthDataSize;
+			Cryptography::cryptoWipeRawData(std::span(frame.data() + plaintextSize, Cryptography::CipherAuthDataSize));
 
 #ifdef DEBUG_CHECKS
 			if constexpr (debugPrintBuffers)
 			{
-				Debug::Print::printSpan("recv (after decryption)", std::span<std::byte>(buffer.data(), receivedBytes));
+				Debug::Print::printSpan("recv (after decryption)", std::span<std::byte>(frame.data(), plaintextSize));
 			}
 #endif // DEBUG_CHECKS
+		}
 
-			return std::nullopt;
-		case Cryptography::DecryptResult::AuthDataMismatch:
-			return "Auth data mismatch, the byte stream is corrupted or tempered with";
-		case Cryptography::DecryptResult::CiphertextSmallerThanMac:
-			return "Ciphertext is smaller than authentification data";
-		case Cryptography::DecryptResult::CiphertextBiggerThanMessageLimit:
-			return "Ciphertext is too big to be decrypted";
-		case Cryptography::DecryptResult::PlaintextBufferTooSmall:
-			return "Plaintext buffer is too small to fit the result";
-		case Cryptography::DecryptResult::PlaintextBufferTooBig:
-			return "Plaintext buffer is bigger than expected";
-		case Cryptography::DecryptResult::IncorrectEncryptionKey:
-			return "Encryption key is not valid (empty)";
-		case Cryptography::DecryptResult::PartiallyOverlappingBuffers:
-			return "Plaintext and ciphertext buffers are not allowed to partially oveerlap";
-		case Cryptography::DecryptResult::NoEncryptionKey:
-			return "No encryption key was provided";
-		case Cryptography::DecryptResult::NonceExhausted:
-			return "Nonce has been exhausted, can't send any more data in this stream";
+		return std::nullopt;
+	}
+
+	std::optional<std::string> sendFrame(const RawSocket socket, const uint16_t requestTag, std::span<const std::byte> payload)
+	{
+		using namespace Protocol::ControlChannel;
+
+		if (payload.empty() || payload.size() > MaxFramePayloadSize)
+		{
+			reportDebugError("Incorrect size of a frame payload {}", payload.size());
+			return std::format("Incorrect size of a frame payload {}", payload.size());
 		}
 
-		return "Unreachable code reached";
+		// send the header and the payload together to not produce a separate TCP segment for the header
+		std::array<std::byte, FrameHeaderSize + MaxFramePayloadSize> buffer;
+		Serialization::writeUint16(buffer[0], buffer[1], static_cast<uint16_t>(payload.size()));
+		Serialization::writeUint16(buffer[2], buffer[3], requestTag);
+		std::copy(payload.begin(), payload.end(), buffer.begin() + FrameHeaderSize);
+
+		return send(socket, std::span<const std::byte>(buffer.data(), FrameHeaderSize + payload.size()));
 	}
 
-	void closeSocket(const RawSocket socket, int timeoutMicroseconds)
+	std::optional<std::string> recvFrame(const RawSocket socket, std::span<std::byte> outPayload, uint16_t& outRequestTag, size_t& outPayloadSize)
 	{
-		Network::setSocketTimeout(socket, SO_RCVTIMEO, 0, timeoutMicroseconds);
-		char buf[1024];
+		using namespace Protocol::ControlChannel;
+
+		std::array<std::byte, FrameHeaderSize> header;
+		size_t receivedBytes = 0;
+		if (auto result = recv(socket, header, static_cast<int>(header.size()), receivedBytes); result.has_value())
+		{
+			return result;
+		}
+
+		const uint16_t payloadSize = Serialization::readUint16(header[0], header[1]);
+		if (payloadSize == 0 || payloadSize > MaxFramePayloadSize || payloadSize > outPayload.size()) [[unlikely]]
+		{
+			return std::format("Received a frame with unexpected payload size {}", payloadSize);
+		}
 
+		if (auto result = recv(socket, outPayload, static_cast<int>(payloadSize), receivedBytes); result.has_value())
+		{
+			return result;
+		}
+
+		outRequestTag = Serialization::readUint16(header[2], header[3]);
+		outPayloadSize = payloadSize;
+		return std::nullopt;
+	}
+
+	static void platformCloseSocket(const RawSocket socket)
+	{
 #if _WIN32
-		shutdown(socket, SD_BOTH);
-		// wait for shutdown to complete
-		::recv(socket, buf, 1024, 0);
 		closesocket(socket);
 #else
-		shutdown(socket, SHUT_RDWR);
-		// wait for shutdown to complete
-		::recv(socket, buf, 1024, 0);
 		close(socket);
 #endif
 	}
+
+	void closeSocket(const RawSocket socket, const CloseMode closeMode)
+	{
+		switch (closeMode)
+		{
+		case CloseMode::Graceful:
+#if _WIN32
+			if (shutdown(socket, SD_SEND) == 0 && SocketReaper::tryAdd(socket))
+#else
+			if (shutdown(socket, SHUT_WR) == 0 && SocketReaper::tryAdd(socket))
+#endif
+			{
+				return;
+			}
+			// not connected (e.g. UDP) or the reaper is full, let the OS deal with the rest
+			platformCloseSocket(socket);
+			return;
+		case CloseMode::Immediate:
+#if _WIN32
+			shutdown(socket, SD_BOTH);
+#else
+			shutdown(socket, SHUT_RDWR);
+#endif
+			platformCloseSocket(socket);
+			return;
+		case CloseMode::Abortive: {
+			linger lingerOption{};
+			lingerOption.l_onoff = 1;
+			lingerOption.l_linger = 0;
+			setsockopt(socket, SOL_SOCKET, SO_LINGER, reinterpret_cast<const char*>(&lingerOption), sizeof(lingerOption));
+			platformCloseSocket(socket);
+			return;
+		}
+		}
+	}
 } // namespace Network
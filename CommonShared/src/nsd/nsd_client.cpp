@@ -11,6 +11,7 @@
 #include <vector>
 
 #include "common_shared/debug/assert.h"
+#include "common_shared/debug/log.h"
 #include "common_shared/network/raw_sockets.h"
 #include "common_shared/nsd/utils_internal.h"
 #include "common_shared/serialization/number_serialization.h"
@@ -52,18 +53,20 @@ namespace NsdClient
 		return std::nullopt;
 	}
 
-	struct NetworkAddressKey
+	struct CachedServer
 	{
-		sockaddr addr;
-		socklen_t addrLen = sizeof(sockaddr);
+		Network::NetworkAddress address;
+		std::chrono::steady_clock::time_point expirationTime;
+	};
 
-		bool operator==(const NetworkAddressKey& other) const noexcept
-		{
-			return addrLen == other.addrLen && std::memcmp(&addr, &other.addr, addrLen) == 0;
-		}
+	struct ReceivedPacket
+	{
+		size_t size = 0;
+		sockaddr_storage sourceAddress{};
+		socklen_t sourceAddressLen = sizeof(sockaddr_storage);
 	};
 
-	static bool processUdpRequestAnswer(const Network::RawSocket socket, std::byte* const inOutBuffer, const size_t bufferSize, NetworkAddressKey& outNetAddress, uint16_t& outPort, std::vector<std::byte>& outExtraData)
+	static bool receivePacket(const Network::RawSocket socket, std::span<std::byte> outBuffer, ReceivedPacket& outPacket)
 	{
 		// for the simplicity sake, we use UDP to communicate back as well
 		// this can miss packets sometimes, but it's fine for our use case
@@ -72,57 +75,198 @@ namespace NsdClient
 #else
 		using RecvFromResult = ssize_t;
 #endif
-		const RecvFromResult messageLength = recvfrom(socket, reinterpret_cast<char*>(inOutBuffer), static_cast<int>(bufferSize), 0, &outNetAddress.addr, &outNetAddress.addrLen);
+		outPacket.sourceAddressLen = sizeof(sockaddr_storage);
+		const RecvFromResult messageLength = recvfrom(socket, reinterpret_cast<char*>(outBuffer.data()), static_cast<int>(outBuffer.size()), 0, reinterpret_cast<sockaddr*>(&outPacket.sourceAddress), &outPacket.sourceAddressLen);
 		if (messageLength == -1) [[unlikely]]
 		{
 			// either failure or timeout, we don't destinguish them right now
 			return false;
 		}
 
-		if (messageLength < 1 + 2 + 2 + 0 + 2) [[unlikely]]
+		outPacket.size = static_cast<size_t>(messageLength);
+		return true;
+	}
+
+	static bool parseQueryAnswer(std::span<const std::byte> packet, uint16_t& outPort, std::vector<std::byte>& outExtraData)
+	{
+		if (packet.size() < 1 + 2 + 2 + 0 + 2) [[unlikely]]
 		{
 			return false;
 		}
 
-		// the only supported protocol version for now is 1
-		if (inOutBuffer[0] != std::byte(0x01)) [[unlikely]]
+		if (packet[0] != NsdInternalUtils::QueryAnswerVersion) [[unlikely]]
 		{
 			return false;
 		}
 
-		const uint16_t extraDataLen = Serialization::readUint16(inOutBuffer[1], inOutBuffer[2]);
+		const uint16_t extraDataLen = Serialization::readUint16(packet[1], packet[2]);
 
-		if (messageLength != 1 + 2 + 2 + static_cast<RecvFromResult>(extraDataLen) + 2) [[unlikely]]
+		if (packet.size() != size_t(1 + 2 + 2) + extraDataLen + 2) [[unlikely]]
 		{
 			return false;
 		}
 
-		outPort = Serialization::readUint16(inOutBuffer[3], inOutBuffer[4]);
-		const uint16_t receivedChecksum = Serialization::readUint16(inOutBuffer[5 + extraDataLen], inOutBuffer[6 + extraDataLen]);
+		outPort = Serialization::readUint16(packet[3], packet[4]);
+		const uint16_t receivedChecksum = Serialization::readUint16(packet[5 + extraDataLen], packet[6 + extraDataLen]);
 
-		const uint16_t actualChecksum = NsdInternalUtils::checksum16v1(std::span(
-			inOutBuffer + 3,
-			inOutBuffer + (3 + 2 + extraDataLen)
-		));
+		const uint16_t actualChecksum = NsdInternalUtils::checksum16v1(packet.subspan(3, 2 + extraDataLen));
 
 		if (receivedChecksum != actualChecksum) [[unlikely]]
 		{
 			return false;
 		}
 
-		outExtraData.clear();
-		std::copy(
-			inOutBuffer + 5,
-			inOutBuffer + 5 + extraDataLen,
-			std::back_inserter(outExtraData)
-		);
+		outExtraData.assign(packet.begin() + 5, packet.begin() + 5 + extraDataLen);
 
 		return true;
 	}
 
+	static std::optional<Network::NetworkAddress> makeServerAddress(const ReceivedPacket& packet, const uint16_t advertizedPort)
+	{
+		auto result = Network::parseAddress(&packet.sourceAddress, packet.sourceAddressLen);
+		if (!std::holds_alternative<Network::NetworkAddress>(result))
+		{
+			return std::nullopt;
+		}
+
+		Network::NetworkAddress address = std::get<Network::NetworkAddress>(std::move(result));
+		address.port = advertizedPort;
+		return address;
+	}
+
+	static bool isSameServer(const Network::NetworkAddress& a, const Network::NetworkAddress& b)
+	{
+		return a.ip == b.ip && a.port == b.port && a.addressType == b.addressType;
+	}
+
+	static void addOrRefreshServer(std::vector<CachedServer>& inOutCache, Network::NetworkAddress&& address, std::vector<std::byte>&& extraData, const std::chrono::steady_clock::time_point expirationTime, const std::function<void(DiscoveryResult&&)>& resultFunction)
+	{
+		auto it = std::ranges::find_if(inOutCache, [&address](const CachedServer& server) {
+			return isSameServer(server.address, address);
+		});
+
+		if (it != inOutCache.end())
+		{
+			it->expirationTime = std::max(it->expirationTime, expirationTime);
+			return;
+		}
+
+		inOutCache.push_back(CachedServer{ address, expirationTime });
+		debugAssert(inOutCache.size() < 8, "Too many servers during debugging ({}), is this a bug or are we stress-testing?", inOutCache.size());
+
+		resultFunction(DiscoveryResult{
+			.address = std::move(address),
+			.extraData = std::move(extraData),
+			.state = DiscoveryState::Added,
+		});
+	}
+
+	static void removeServers(std::vector<CachedServer>& inOutCache, const std::function<bool(const CachedServer&)>& shouldRemove, const std::function<void(DiscoveryResult&&)>& resultFunction)
+	{
+		for (size_t i = inOutCache.size(); i > 0; --i)
+		{
+			if (shouldRemove(inOutCache[i - 1]))
+			{
+				Network::NetworkAddress address = std::move(inOutCache[i - 1].address);
+				inOutCache.erase(inOutCache.begin() + static_cast<std::ptrdiff_t>(i - 1));
+
+				resultFunction(DiscoveryResult{
+					.address = std::move(address),
+					.extraData = std::vector<std::byte>{},
+					.state = DiscoveryState::Removed,
+				});
+			}
+		}
+	}
+
+	// inOutAnnouncementsExpirationTime is extended when a server announces itself, so we know when to expect the next announcement
+	static void processPacket(std::span<const std::byte> packetData, const ReceivedPacket& packet, const std::string_view serviceIdentifier, const std::chrono::steady_clock::duration answerTtl, std::vector<CachedServer>& inOutCache, std::chrono::steady_clock::time_point& inOutAnnouncementsExpirationTime, const std::function<void(DiscoveryResult&&)>& resultFunction)
+	{
+		if (packetData.empty())
+		{
+			return;
+		}
+
+		const auto now = std::chrono::steady_clock::now();
+
+		if (packetData[0] == NsdInternalUtils::QueryAnswerVersion)
+		{
+			uint16_t port = 0;
+			std::vector<std::byte> extraData;
+			if (!parseQueryAnswer(packetData, port, extraData))
+			{
+				return;
+			}
+
+			if (std::optional<Network::NetworkAddress> address = makeServerAddress(packet, port); address.has_value())
+			{
+				addOrRefreshServer(inOutCache, std::move(*address), std::move(extraData), now + answerTtl, resultFunction);
+			}
+		}
+		else if (packetData[0] == NsdInternalUtils::AnnouncementVersion)
+		{
+			std::optional<NsdInternalUtils::Announcement> announcement = NsdInternalUtils::parseAnnouncement(packetData, serviceIdentifier);
+			if (!announcement.has_value())
+			{
+				return;
+			}
+
+			std::optional<Network::NetworkAddress> address = makeServerAddress(packet, announcement->port);
+			if (!address.has_value())
+			{
+				return;
+			}
+
+			if (announcement->ttlSeconds == 0)
+			{
+				removeServers(inOutCache, [&address](const CachedServer& server) { return isSameServer(server.address, *address); }, resultFunction);
+				return;
+			}
+
+			const std::chrono::steady_clock::time_point expirationTime = now + std::chrono::seconds(announcement->ttlSeconds);
+			inOutAnnouncementsExpirationTime = std::max(inOutAnnouncementsExpirationTime, expirationTime);
+			addOrRefreshServer(inOutCache, std::move(*address), std::move(announcement->extraData), expirationTime, resultFunction);
+		}
+	}
+
+	static std::variant<Network::RawSocket, std::string> openAnnouncementSocket(const Network::AddressType addressType, const uint16_t announcementPort)
+	{
+		std::variant<Network::RawSocket, std::string> createSocketResult = Network::createSocket(Network::SocketType::Udp, addressType);
+		if (std::holds_alternative<std::string>(createSocketResult))
+		{
+			return createSocketResult;
+		}
+
+		const Network::RawSocket socket = std::get<Network::RawSocket>(createSocketResult);
+
+		// several clients on the same device should all get the announcements
+		if (auto result = Network::setSocketOption(socket, SO_REUSEADDR); result.has_value())
+		{
+			Network::closeSocket(socket, Network::CloseMode::Immediate);
+			return std::move(*result);
+		}
+
+#if !_WIN32
+		if (auto result = Network::setSocketOption(socket, SO_REUSEPORT); result.has_value())
+		{
+			Network::closeSocket(socket, Network::CloseMode::Immediate);
+			return std::move(*result);
+		}
+#endif
+
+		if (auto result = Network::bindSocket(socket, nullptr, addressType, announcementPort); result.has_value())
+		{
+			Network::closeSocket(socket, Network::CloseMode::Immediate);
+			return std::move(*result);
+		}
+
+		return socket;
+	}
+
 	ListenResult processServiceDiscoveryThread(
 		const char* serviceIdentifier,
 		const uint16_t broadcastPort,
+		const uint16_t announcementPort,
 		const Network::AddressType addressType,
 		const float broadcastPeriodSec,
 		const std::function<void(DiscoveryResult&&)>& resultFunction,
@@ -142,7 +286,7 @@ namespace NsdClient
 			return std::get<std::string>(createSocketResult);
 		}
 
-		const Network::AutoclosingSocket socket = Network::AutoclosingSocket(std::get<Network::RawSocket>(std::move(createSocketResult)));
+		const Network::AutoclosingSocket socket = Network::AutoclosingSocket(std::get<Network::RawSocket>(std::move(createSocketResult)), Network::CloseMode::Immediate);
 
 		if (auto result = Network::setSocketOption(socket, SO_BROADCAST); result.has_value())
 		{
@@ -150,40 +294,39 @@ namespace NsdClient
 			return result;
 		}
 
-		// 200 milliseconds means that 5 times per second we will check if the stop signal has been received
-		if (const auto result = Network::setSocketTimeout(socket, SO_RCVTIMEO, 0, 200000); result.has_value())
+		if (const auto result = Network::bindSocket(socket, nullptr, addressType, 0); result.has_value())
 		{
-			reportDebugError("Could not set SO_RCVTIMEO to NSD client socket");
+			reportDebugError("Could not bind NSD client socket");
 			return result;
 		}
 
-		if (const auto result = Network::bindSocket(socket, nullptr, addressType, 0); result.has_value())
+		// without the announcements we can only rely on the periodic queries
+		std::optional<Network::AutoclosingSocket> announcementSocket;
+		if (std::variant<Network::RawSocket, std::string> result = openAnnouncementSocket(addressType, announcementPort); std::holds_alternative<Network::RawSocket>(result))
 		{
-			reportDebugError("Could not bind NSD client socket");
-			return result;
+			announcementSocket.emplace(std::get<Network::RawSocket>(result), Network::CloseMode::Immediate);
+		}
+		else
+		{
+			Debug::Log::printDebug("Could not listen to NSD announcements, falling back to periodic queries: {}", std::get<std::string>(result));
 		}
 
 		// the std::vector solution is optimized for up to 8 servers, but up to 100 should be fine
 		// the assumption is that we won't have more than 1-2 servers at a time anyway
-
-		// we count generations based on our send timer
-		// we don't care about when we sent the broadcast that got the server to us
-		constexpr int GENERATIONS_TO_MISS_TO_REMOVE = 2;
-		std::array<std::vector<NetworkAddressKey>, GENERATIONS_TO_MISS_TO_REMOVE> discoveryGenerations;
-
-		std::vector<NetworkAddressKey> onlineServers;
-		std::vector<NetworkAddressKey> serversToRemove;
+		std::vector<CachedServer> cachedServers;
 
 		const std::string query = buildNsdQuery(serviceIdentifier);
 
-		constexpr size_t BUFFER_SIZE = 1024;
-		std::byte buffer[BUFFER_SIZE];
-		NetworkAddressKey netAddress{};
-		std::vector<std::byte> extraData;
+		std::array<std::byte, NsdInternalUtils::MaxPacketSize> buffer;
+		ReceivedPacket packet;
 
-		// set the time in the past, enough to trigger the broadcast immediately
-		const std::chrono::duration broadcastPeriod = std::chrono::round<std::chrono::nanoseconds>(std::chrono::duration<float>(broadcastPeriodSec));
-		std::chrono::time_point lastBroadcastTime = std::chrono::steady_clock::now() - (broadcastPeriod * 2);
+		const std::chrono::steady_clock::duration initialBroadcastPeriod = std::chrono::round<std::chrono::nanoseconds>(std::chrono::duration<float>(broadcastPeriodSec));
+		const std::chrono::steady_clock::duration maxBroadcastPeriod = std::max(initialBroadcastPeriod, std::chrono::round<std::chrono::steady_clock::duration>(std::chrono::duration<float>(MaxBroadcastPeriodSec)));
+		std::chrono::steady_clock::duration broadcastPeriod = initialBroadcastPeriod;
+		// the first broadcast is sent immediately
+		std::chrono::steady_clock::time_point nextBroadcastTime = std::chrono::steady_clock::now();
+		// until this time at least one server is known to send the announcements
+		std::chrono::steady_clock::time_point announcementsExpirationTime{};
 
 		while (true)
 		{
@@ -192,87 +335,62 @@ namespace NsdClient
 				return std::nullopt;
 			}
 
-			if (std::chrono::steady_clock::now() > lastBroadcastTime + broadcastPeriod)
+			const auto now = std::chrono::steady_clock::now();
+
+			// no announcements for a TTL, the servers around may only answer the queries, so query them often again
+			if (now >= announcementsExpirationTime && broadcastPeriod != initialBroadcastPeriod)
+			{
+				broadcastPeriod = initialBroadcastPeriod;
+				nextBroadcastTime = std::min(nextBroadcastTime, now + initialBroadcastPeriod);
+			}
+
+			if (now >= nextBroadcastTime)
 			{
 				if (const auto result = broadcastNdsUdpRequest(socket, addressType, query, broadcastPort); result.has_value()) [[unlikely]]
 				{
 					return result;
 				}
-				lastBroadcastTime = std::chrono::steady_clock::now();
 
-				// remove servers that are no longer online
-				serversToRemove.clear();
-				for (const NetworkAddressKey& server : onlineServers)
+				nextBroadcastTime = now + broadcastPeriod;
+				// the servers that send announcements will tell us when they come and go, so the queries are only needed for the older servers
+				if (now < announcementsExpirationTime)
 				{
-					bool found = false;
-					for (size_t i = 0; i < GENERATIONS_TO_MISS_TO_REMOVE; ++i)
-					{
-						if (std::ranges::find(discoveryGenerations[i], server) != discoveryGenerations[i].end())
-						{
-							found = true;
-							break;
-						}
-					}
-					if (!found)
-					{
-						serversToRemove.push_back(server);
-					}
+					broadcastPeriod = std::min(broadcastPeriod * 2, maxBroadcastPeriod);
 				}
+			}
 
-				if (!serversToRemove.empty())
-				{
-					for (size_t i = onlineServers.size(); i > 0; --i)
-					{
-						if (std::ranges::find(serversToRemove, onlineServers[i - 1]) != serversToRemove.end())
-						{
-							onlineServers.erase(onlineServers.begin() + static_cast<int>(i - 1));
-						}
-					}
-				}
+			removeServers(cachedServers, [now](const CachedServer& server) { return server.expirationTime <= now; }, resultFunction);
 
-				for (const NetworkAddressKey& server : serversToRemove)
-				{
-					auto result = Network::parseAddress(&server.addr, server.addrLen);
-					if (std::holds_alternative<Network::NetworkAddress>(result))
-					{
-						resultFunction(DiscoveryResult{
-							.address = std::move(std::get<Network::NetworkAddress>(result)),
-							.extraData = std::vector<std::byte>{},
-							.state = DiscoveryState::Removed,
-						});
-					}
-				}
+			fd_set readSockets;
+			FD_ZERO(&readSockets);
+			FD_SET(socket, &readSockets);
+			Network::RawSocket maxSocket = socket;
+			if (announcementSocket.has_value())
+			{
+				FD_SET(*announcementSocket, &readSockets);
+				maxSocket = std::max(maxSocket, static_cast<Network::RawSocket>(*announcementSocket));
+			}
 
-				std::rotate(discoveryGenerations.data(), discoveryGenerations.data() + (GENERATIONS_TO_MISS_TO_REMOVE - 1), discoveryGenerations.data() + GENERATIONS_TO_MISS_TO_REMOVE);
-				debugAssert(discoveryGenerations.size() < 8, "Too many servers during debugging ({}), is this a bug or are we stress-testing?", discoveryGenerations.size());
-				discoveryGenerations[0].clear();
+			// 200 milliseconds means that 5 times per second we will check if the stop signal has been received
+			timeval timeout{ .tv_sec = 0, .tv_usec = 200000 };
+			const int readyCount = select(static_cast<int>(maxSocket + 1), &readSockets, nullptr, nullptr, &timeout);
+			if (readyCount <= 0)
+			{
+				// either failure or timeout, we don't destinguish them right now
+				continue;
 			}
 
-			uint16_t port;
-			if (processUdpRequestAnswer(socket, buffer, BUFFER_SIZE, netAddress, port, extraData))
+			// the servers that answer the queries but don't send announcements are kept until they miss two queries in a row
+			const std::chrono::steady_clock::duration answerTtl = broadcastPeriod * 2;
+
+			if (FD_ISSET(socket, &readSockets) && receivePacket(socket, buffer, packet))
 			{
-				if (std::ranges::find(discoveryGenerations[0], netAddress) == discoveryGenerations[0].end())
-				{
-					discoveryGenerations[0].push_back(netAddress);
-				}
+				processPacket(std::span(buffer.data(), packet.size), packet, serviceIdentifier, answerTtl, cachedServers, announcementsExpirationTime, resultFunction);
+			}
 
-				if (std::ranges::find(onlineServers, netAddress) == onlineServers.end())
-				{
-					onlineServers.push_back(netAddress);
-					auto result = Network::parseAddress(&netAddress.addr, netAddress.addrLen);
-					if (std::holds_alternative<Network::NetworkAddress>(result))
-					{
-						resultFunction(DiscoveryResult{
-							.address = Network::NetworkAddress{
-								.ip = std::get<Network::NetworkAddress>(result).ip,
-								.port = port,
-								.addressType = std::get<Network::NetworkAddress>(result).addressType,
-							},
-							.extraData = extraData,
-							.state = DiscoveryState::Added,
-						});
-					}
-				}
+			if (announcementSocket.has_value() && FD_ISSET(*announcementSocket, &readSockets) && receivePacket(*announcementSocket, buffer, packet))
+			{
+				processPacket(std::span(buffer.data(), packet.size), packet, serviceIdentifier, answerTtl, cachedServers, announcementsExpirationTime, resultFunction);
 			}
 		}
 	}
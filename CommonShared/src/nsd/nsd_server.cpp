@@ -3,9 +3,18 @@
 
 #include "common_shared/nsd/nsd_server.h"
 
+#if defined(__linux__) || defined(__ANDROID__)
+#include <sys/socket.h>
+#endif
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <chrono>
 #include <cstring>
 #include <format>
 #include <string>
+#include <thread>
 
 #include "common_shared/debug/assert.h"
 #include "common_shared/network/raw_sockets.h"
@@ -13,6 +22,221 @@
 #include "common_shared/nsd/utils_internal.h"
 #include "common_shared/serialization/number_serialization.h"
 
+namespace NsdServerInternal
+{
+	// the sources are tracked in a fixed-size table, a collision just resets the limit for the new source
+	constexpr size_t RateLimiterTableSize = 1024;
+#if defined(__linux__) || defined(__ANDROID__)
+	// the number of datagrams received and answered with one system call
+	constexpr size_t BatchSize = 32;
+#endif
+
+	// limits how often we answer queries coming from the same address, so a broadcast storm doesn't turn into a reply storm
+	class ReplyRateLimiter
+	{
+	public:
+		[[nodiscard]] bool tryConsume(const sockaddr_storage& sourceAddress, const std::chrono::steady_clock::time_point now) noexcept
+		{
+			std::array<std::byte, 16> key{};
+			size_t keySize = 0;
+			if (sourceAddress.ss_family == AF_INET)
+			{
+				const in_addr& address = reinterpret_cast<const sockaddr_in*>(&sourceAddress)->sin_addr;
+				keySize = sizeof(address);
+				std::memcpy(key.data(), &address, keySize);
+			}
+			else if (sourceAddress.ss_family == AF_INET6)
+			{
+				const in6_addr& address = reinterpret_cast<const sockaddr_in6*>(&sourceAddress)->sin6_addr;
+				keySize = sizeof(address);
+				std::memcpy(key.data(), &address, keySize);
+			}
+			else
+			{
+				return false;
+			}
+
+			Entry& entry = mEntries[getIndex(std::span(key.data(), keySize))];
+			if (!entry.isUsed || entry.keySize != keySize || entry.key != key)
+			{
+				entry = Entry{
+					.key = key,
+					.keySize = keySize,
+					.tokens = NsdServer::MaxRepliesBurst,
+					.lastUpdateTime = now,
+					.isUsed = true,
+				};
+			}
+			else
+			{
+				const double elapsedSeconds = std::chrono::duration<double>(now - entry.lastUpdateTime).count();
+				entry.tokens = std::min(NsdServer::MaxRepliesBurst, entry.tokens + elapsedSeconds * NsdServer::RepliesPerSecondPerAddress);
+				entry.lastUpdateTime = now;
+			}
+
+			if (entry.tokens < 1.0)
+			{
+				return false;
+			}
+
+			entry.tokens -= 1.0;
+			return true;
+		}
+
+	private:
+		struct Entry
+		{
+			std::array<std::byte, 16> key{};
+			size_t keySize = 0;
+			double tokens = 0.0;
+			std::chrono::steady_clock::time_point lastUpdateTime;
+			bool isUsed = false;
+		};
+
+		static size_t getIndex(std::span<const std::byte> key) noexcept
+		{
+			// FNV-1a
+			uint32_t hash = 2166136261u;
+			for (const std::byte b : key)
+			{
+				hash ^= static_cast<uint32_t>(b);
+				hash *= 16777619u;
+			}
+			return hash % RateLimiterTableSize;
+		}
+
+	private:
+		std::array<Entry, RateLimiterTableSize> mEntries{};
+	};
+
+	static bool isExpectedQuery(const char* data, const size_t size, const std::string& expectedPacket) noexcept
+	{
+		// the size check filters out most of the unrelated packets before comparing the content
+		return size == expectedPacket.size() && std::memcmp(data, expectedPacket.data(), expectedPacket.size()) == 0;
+	}
+
+#if defined(__linux__) || defined(__ANDROID__)
+	static NsdServer::ListenResult processQueriesInBatches(const Network::RawSocket socket, const std::string& expectedPacket, std::span<const std::byte> response)
+	{
+		// one extra byte to tell a longer packet from the expected one
+		std::vector<char> buffers(BatchSize * (expectedPacket.size() + 1));
+		std::array<sockaddr_storage, BatchSize> sourceAddresses;
+		std::array<iovec, BatchSize> queryIovs;
+		std::array<mmsghdr, BatchSize> queries;
+		for (size_t i = 0; i < BatchSize; ++i)
+		{
+			queryIovs[i] = iovec{ .iov_base = buffers.data() + i * (expectedPacket.size() + 1), .iov_len = expectedPacket.size() + 1 };
+		}
+
+		// all the replies share the same data
+		iovec responseIov{ .iov_base = const_cast<std::byte*>(response.data()), .iov_len = response.size() };
+		std::array<mmsghdr, BatchSize> replies;
+
+		ReplyRateLimiter rateLimiter;
+
+		while (true)
+		{
+			for (size_t i = 0; i < BatchSize; ++i)
+			{
+				queries[i] = mmsghdr{};
+				queries[i].msg_hdr.msg_name = &sourceAddresses[i];
+				queries[i].msg_hdr.msg_namelen = sizeof(sockaddr_storage);
+				queries[i].msg_hdr.msg_iov = &queryIovs[i];
+				queries[i].msg_hdr.msg_iovlen = 1;
+			}
+
+			// blocks only until the first datagram, then takes whatever is already queued
+			const int receivedCount = recvmmsg(socket, queries.data(), BatchSize, MSG_WAITFORONE, nullptr);
+			if (receivedCount == -1)
+			{
+				if (errno == EINTR)
+				{
+					continue;
+				}
+				return NsdServer::SocketError{ std::format("Failed to receive from UDP socket, error code {}.", errno) };
+			}
+
+			const auto now = std::chrono::steady_clock::now();
+			size_t replyCount = 0;
+			for (size_t i = 0; i < static_cast<size_t>(receivedCount); ++i)
+			{
+				if (!isExpectedQuery(static_cast<const char*>(queryIovs[i].iov_base), queries[i].msg_len, expectedPacket))
+				{
+					continue;
+				}
+
+				if (!rateLimiter.tryConsume(sourceAddresses[i], now))
+				{
+					continue;
+				}
+
+				replies[replyCount] = mmsghdr{};
+				replies[replyCount].msg_hdr.msg_name = &sourceAddresses[i];
+				replies[replyCount].msg_hdr.msg_namelen = queries[i].msg_hdr.msg_namelen;
+				replies[replyCount].msg_hdr.msg_iov = &responseIov;
+				replies[replyCount].msg_hdr.msg_iovlen = 1;
+				++replyCount;
+			}
+
+			size_t sentCount = 0;
+			while (sentCount < replyCount)
+			{
+				const int result = sendmmsg(socket, replies.data() + sentCount, static_cast<unsigned int>(replyCount - sentCount), 0);
+				if (result == -1)
+				{
+					if (errno == EINTR)
+					{
+						continue;
+					}
+					return NsdServer::SocketError{ std::format("Failed to send response to UDP socket, error code {}.", errno) };
+				}
+				sentCount += static_cast<size_t>(result);
+			}
+		}
+	}
+#else
+#if _WIN32
+	using RecvFromResult = int;
+#else
+	using RecvFromResult = ssize_t;
+#endif
+
+	static NsdServer::ListenResult processQueriesOneByOne(const Network::RawSocket socket, const std::string& expectedPacket, std::span<const std::byte> response)
+	{
+		constexpr size_t BUFFER_SIZE = 1024;
+		char buf[BUFFER_SIZE];
+
+		ReplyRateLimiter rateLimiter;
+
+		RecvFromResult messageLength = 0;
+		sockaddr_storage clientAddr;
+		socklen_t clientAddrLen = sizeof(clientAddr);
+		while ((messageLength = recvfrom(socket, buf, BUFFER_SIZE, 0, reinterpret_cast<sockaddr*>(&clientAddr), &clientAddrLen)) != -1)
+		{
+			const socklen_t receivedAddrLen = clientAddrLen;
+			clientAddrLen = sizeof(clientAddr);
+
+			if (!isExpectedQuery(buf, static_cast<size_t>(messageLength), expectedPacket))
+			{
+				continue;
+			}
+
+			if (!rateLimiter.tryConsume(clientAddr, std::chrono::steady_clock::now()))
+			{
+				continue;
+			}
+
+			if (const auto sentSize = sendto(socket, reinterpret_cast<const char*>(response.data()), static_cast<int>(response.size()), 0, reinterpret_cast<sockaddr*>(&clientAddr), receivedAddrLen); sentSize == -1)
+			{
+				return NsdServer::SocketError{ std::format("Failed to send response to UDP socket, error code {}.", errno) };
+			}
+		}
+
+		return NsdServer::SocketError{ std::format("Failed to receive from UDP socket, error code {}.", errno) };
+	}
+#endif
+} // namespace NsdServerInternal
+
 namespace NsdServer
 {
 	std::variant<Network::RawSocket, std::string> openNsdSocket(const Network::AddressType addressType)
@@ -77,7 +301,7 @@ namespace NsdServer
 
 		std::vector<std::byte> response;
 		response.reserve(responseSize);
-		Serialization::appendByte(response, std::byte(0x01)); // protocol version
+		Serialization::appendByte(response, NsdInternalUtils::QueryAnswerVersion); // protocol version
 		Serialization::appendUint16(response, static_cast<uint16_t>(extraData.size())); // size of extra data
 		Serialization::appendUint16(response, advertizedPort); // port
 		std::ranges::copy(extraData, std::back_inserter(response)); // extra data
@@ -88,34 +312,89 @@ namespace NsdServer
 			return SetupError{ std::format("The actual size of response is {} bytes, expected {} bytes.", response.size(), responseSize) };
 		}
 
-		constexpr size_t BUFFER_SIZE = 1024;
-		char buf[BUFFER_SIZE];
-#if _WIN32
-		using RecvFromResult = int;
+#if defined(__linux__) || defined(__ANDROID__)
+		return NsdServerInternal::processQueriesInBatches(socket, expectedPacket, response);
 #else
-		using RecvFromResult = ssize_t;
+		return NsdServerInternal::processQueriesOneByOne(socket, expectedPacket, response);
 #endif
-		RecvFromResult messageLength = 0;
-		sockaddr clientAddr;
-		socklen_t clientAddrLen = sizeof(clientAddr);
-		while ((messageLength = recvfrom(socket, buf, BUFFER_SIZE, 0, &clientAddr, &clientAddrLen)) != -1)
+	}
+
+	static std::optional<std::string> broadcastAnnouncement(const Network::RawSocket socket, const uint16_t announcementPort, std::span<const std::byte> announcement)
+	{
+		sockaddr_in address{};
+		address.sin_addr.s_addr = INADDR_BROADCAST;
+		address.sin_family = AF_INET;
+		address.sin_port = htons(announcementPort);
+
+		if (sendto(socket, reinterpret_cast<const char*>(announcement.data()), static_cast<int>(announcement.size()), 0, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) == -1) [[unlikely]]
 		{
-			if (messageLength != static_cast<RecvFromResult>(expectedPacket.size()))
-			{
-				continue;
-			}
+			return std::format("Failed to send NSD announcement to UDP socket, error code {}.", errno);
+		}
+
+		return std::nullopt;
+	}
+
+	std::optional<std::string> processAnnouncementsThread(
+		const Network::AddressType addressType,
+		const uint16_t announcementPort,
+		const char* serviceIdentifier,
+		const uint16_t advertizedPort,
+		std::span<const std::byte> extraData,
+		const std::atomic_bool& stopSignalReceiver
+	)
+	{
+		if (serviceIdentifier == nullptr)
+		{
+			return "service identifier can't be nullptr";
+		}
+
+		if (addressType == Network::AddressType::IpV6)
+		{
+			reportDebugError("Not implemented");
+			return std::format("IPV6 broadcast (multicast) is somewhat complicated, it isn't implemented for now. Add when needed");
+		}
+
+		const std::optional<std::vector<std::byte>> announcement = NsdInternalUtils::buildAnnouncement(serviceIdentifier, AnnouncementTtlSeconds, advertizedPort, extraData);
+		const std::optional<std::vector<std::byte>> goodbye = NsdInternalUtils::buildAnnouncement(serviceIdentifier, 0, advertizedPort, extraData);
+		if (!announcement.has_value() || !goodbye.has_value())
+		{
+			reportDebugError("Service ID or extra data are too long for an NSD announcement");
+			return "Service ID or extra data are too long for an NSD announcement";
+		}
+
+		std::variant<Network::RawSocket, std::string> createSocketResult = Network::createSocket(Network::SocketType::Udp, addressType);
+		if (std::holds_alternative<std::string>(createSocketResult))
+		{
+			reportDebugError("Could not create NSD announcement socket");
+			return std::get<std::string>(createSocketResult);
+		}
+
+		const Network::AutoclosingSocket socket = Network::AutoclosingSocket(std::get<Network::RawSocket>(std::move(createSocketResult)), Network::CloseMode::Immediate);
+
+		if (auto result = Network::setSocketOption(socket, SO_BROADCAST); result.has_value())
+		{
+			reportDebugError("Could not set SO_BROADCAST flag to NSD announcement socket");
+			return result;
+		}
+
+		// same as for the NSD client, we check the stop signal 5 times per second
+		constexpr std::chrono::milliseconds StopCheckPeriod(200);
+		const std::chrono::seconds announcementPeriod(AnnouncementTtlSeconds / 2);
 
-			if (std::memcmp(buf, expectedPacket.data(), expectedPacket.size()) != 0)
+		while (!stopSignalReceiver.load(std::memory_order::relaxed))
+		{
+			if (auto result = broadcastAnnouncement(socket, announcementPort, *announcement); result.has_value())
 			{
-				continue;
+				return result;
 			}
 
-			if (const auto sentSize = sendto(socket, reinterpret_cast<const char*>(response.data()), static_cast<int>(responseSize), 0, &clientAddr, clientAddrLen); sentSize == -1)
+			const auto nextAnnouncementTime = std::chrono::steady_clock::now() + announcementPeriod;
+			while (std::chrono::steady_clock::now() < nextAnnouncementTime && !stopSignalReceiver.load(std::memory_order::relaxed))
 			{
-				return SocketError{ std::format("Failed to send response to UDP socket, error code {}.", errno) };
+				std::this_thread::sleep_for(StopCheckPeriod);
 			}
 		}
 
-		return SocketError{ std::format("Failed to receive from UDP socket, error code {}.", errno) };
+		return broadcastAnnouncement(socket, announcementPort, *goodbye);
 	}
 } // namespace NsdServer
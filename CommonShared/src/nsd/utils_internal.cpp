@@ -3,6 +3,12 @@
 
 #include "common_shared/nsd/utils_internal.h"
 
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+#include "common_shared/serialization/number_serialization.h"
+
 namespace NsdInternalUtils
 {
 	uint16_t checksum16v1(const std::span<const std::byte> data)
@@ -15,4 +21,58 @@ namespace NsdInternalUtils
 		}
 		return checksum;
 	}
+
+	std::optional<std::vector<std::byte>> buildAnnouncement(const std::string_view serviceIdentifier, const uint16_t ttlSeconds, const uint16_t port, const std::span<const std::byte> extraData)
+	{
+		const size_t packetSize = 1 + 2 + 1 + serviceIdentifier.size() + 2 + 2 + extraData.size() + 2;
+		if (serviceIdentifier.size() > std::numeric_limits<uint8_t>::max() || packetSize > MaxPacketSize)
+		{
+			return std::nullopt;
+		}
+
+		std::vector<std::byte> packet;
+		packet.reserve(packetSize);
+		Serialization::appendByte(packet, AnnouncementVersion);
+		Serialization::appendUint16(packet, ttlSeconds);
+		Serialization::appendUint8(packet, static_cast<uint8_t>(serviceIdentifier.size()));
+		std::ranges::copy(std::as_bytes(std::span(serviceIdentifier)), std::back_inserter(packet));
+		Serialization::appendUint16(packet, static_cast<uint16_t>(extraData.size()));
+		Serialization::appendUint16(packet, port);
+		std::ranges::copy(extraData, std::back_inserter(packet));
+		Serialization::appendUint16(packet, checksum16v1(std::span(packet.begin() + 1, packet.end())));
+		return packet;
+	}
+
+	std::optional<Announcement> parseAnnouncement(const std::span<const std::byte> packet, const std::string_view serviceIdentifier)
+	{
+		const size_t expectedPrefixSize = 1 + 2 + 1 + serviceIdentifier.size();
+		if (packet.size() < expectedPrefixSize + 2 + 2 + 2 || packet[0] != AnnouncementVersion)
+		{
+			return std::nullopt;
+		}
+
+		if (static_cast<size_t>(packet[3]) != serviceIdentifier.size() || std::memcmp(packet.data() + 4, serviceIdentifier.data(), serviceIdentifier.size()) != 0)
+		{
+			return std::nullopt;
+		}
+
+		const uint16_t extraDataSize = Serialization::readUint16(packet[expectedPrefixSize], packet[expectedPrefixSize + 1]);
+		if (packet.size() != expectedPrefixSize + 2 + 2 + extraDataSize + 2)
+		{
+			return std::nullopt;
+		}
+
+		const uint16_t receivedChecksum = Serialization::readUint16(packet[packet.size() - 2], packet[packet.size() - 1]);
+		if (receivedChecksum != checksum16v1(packet.subspan(1, packet.size() - 3)))
+		{
+			return std::nullopt;
+		}
+
+		const size_t extraDataOffset = expectedPrefixSize + 2 + 2;
+		return Announcement{
+			.ttlSeconds = Serialization::readUint16(packet[1], packet[2]),
+			.port = Serialization::readUint16(packet[expectedPrefixSize + 2], packet[expectedPrefixSize + 3]),
+			.extraData = std::vector<std::byte>(packet.begin() + static_cast<std::ptrdiff_t>(extraDataOffset), packet.begin() + static_cast<std::ptrdiff_t>(extraDataOffset + extraDataSize)),
+		};
+	}
 } // namespace NsdInternalUtils
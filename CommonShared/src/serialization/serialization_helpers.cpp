@@ -58,7 +58,8 @@ namespace Serialization
 	bool GenericDeserializationWrapper::readShortString(std::string& outData, std::string_view logName, size_t lengthLimit) noexcept
 	{
 		std::optional<std::string> readResult = Serialization::readShortString(mBuffer.subspan(mBytesRead), outData, lengthLimit);
-		mBytesRead += outData.size();
+		// the size byte and the string itself
+		mBytesRead += 1 + outData.size();
 		return Internal::reportIfReadError(readResult, logName);
 	}
 } // namespace Serialization
@@ -11,11 +11,36 @@
 
 namespace Lmdb
 {
-	ReadOnlyCursor::ReadOnlyCursor(MDB_cursor* mdbCursor) noexcept
+	[[nodiscard]] static ReturnCode moveCursor(MDB_cursor* mdbCursor, MDB_cursor_op operation, std::string_view positionName) noexcept
+	{
+		MDB_val key{};
+		MDB_val value{};
+		int returnCode = mdb_cursor_get(mdbCursor, &key, &value, operation);
+		assertRelease(returnCode == 0 || returnCode == MDB_NOTFOUND, "Could not move LMDB cursor to the {}: '{}'", positionName, mdb_strerror(returnCode));
+		return parseReturnCode(returnCode);
+	}
+
+	[[nodiscard]] static Result<std::span<const std::byte>> getMultipleValues(MDB_cursor* mdbCursor, MDB_cursor_op operation) noexcept
+	{
+		MDB_val key{};
+		MDB_val value{};
+		int returnCode = mdb_cursor_get(mdbCursor, &key, &value, operation);
+		if (returnCode != 0)
+		{
+			if (returnCode != MDB_NOTFOUND)
+			{
+				reportDebugError("Could not get multiple values from LMDB cursor: '{}'", mdb_strerror(returnCode));
+			}
+			return parseReturnCode(returnCode);
+		}
+		return std::span<const std::byte>(static_cast<const std::byte*>(value.mv_data), value.mv_size);
+	}
+
+	Cursor::Cursor(MDB_cursor* mdbCursor) noexcept
 		: mMdbCursor(mdbCursor)
 	{}
 
-	ReadOnlyCursor::~ReadOnlyCursor() noexcept
+	Cursor::~Cursor() noexcept
 	{
 		if (mMdbCursor != nullptr)
 		{
@@ -23,51 +48,52 @@ namespace Lmdb
 		}
 	}
 
-	ReadOnlyCursor::ReadOnlyCursor(ReadOnlyCursor&& other) noexcept
-		: ReadOnlyCursor(other.mMdbCursor)
+	Cursor::Cursor(Cursor&& other) noexcept
+		: Cursor(other.mMdbCursor)
 	{
 		other.mMdbCursor = nullptr;
 	}
 
-	ReadOnlyCursor& ReadOnlyCursor::operator=(ReadOnlyCursor&& other) noexcept
+	Cursor& Cursor::operator=(Cursor&& other) noexcept
 	{
 		mMdbCursor = other.mMdbCursor;
 		other.mMdbCursor = nullptr;
 		return *this;
 	}
 
-	Result<ReadOnlyCursor> ReadOnlyCursor::open(ReadOnlyTransaction& transaction, ReadOnlyDatabase& database) noexcept
+	ReturnCode Cursor::first() noexcept
 	{
-		MDB_cursor* mdbCursor;
-		int returnCode = mdb_cursor_open(transaction.getRaw(), database.getRaw(), &mdbCursor);
-		if (returnCode != 0)
-		{
-			reportDebugError("Could not create LMDB cursor: '{}'", mdb_strerror(returnCode));
-			return parseReturnCode(returnCode);
-		}
+		return moveCursor(mMdbCursor, MDB_FIRST, "first element");
+	}
 
-		return ReadOnlyCursor(mdbCursor);
+	ReturnCode Cursor::last() noexcept
+	{
+		return moveCursor(mMdbCursor, MDB_LAST, "last element");
 	}
 
-	ReturnCode ReadOnlyCursor::first() noexcept
+	ReturnCode Cursor::next() noexcept
 	{
-		MDB_val key{};
-		MDB_val value{};
-		int returnCode = mdb_cursor_get(mMdbCursor, &key, &value, MDB_FIRST);
-		assertRelease(returnCode == 0 || returnCode == MDB_NOTFOUND, "Could not move LMDB cursor to first element: '{}'", mdb_strerror(returnCode));
-		return parseReturnCode(returnCode);
+		return moveCursor(mMdbCursor, MDB_NEXT, "next position");
 	}
 
-	ReturnCode ReadOnlyCursor::next() noexcept
+	ReturnCode Cursor::prev() noexcept
 	{
-		MDB_val key{};
+		return moveCursor(mMdbCursor, MDB_PREV, "previous position");
+	}
+
+	ReturnCode Cursor::seek(std::span<const std::byte> key) noexcept
+	{
+		MDB_val mdbKey{
+			.mv_size = key.size(),
+			.mv_data = const_cast<std::byte*>(key.data()),
+		};
 		MDB_val value{};
-		int returnCode = mdb_cursor_get(mMdbCursor, &key, &value, MDB_NEXT);
-		assertRelease(returnCode == 0 || returnCode == MDB_NOTFOUND, "Could not move LMDB cursor to the next position: '{}'", mdb_strerror(returnCode));
+		int returnCode = mdb_cursor_get(mMdbCursor, &mdbKey, &value, MDB_SET_RANGE);
+		assertRelease(returnCode == 0 || returnCode == MDB_NOTFOUND, "Could not move LMDB cursor to the key: '{}'", mdb_strerror(returnCode));
 		return parseReturnCode(returnCode);
 	}
 
-	Result<CursorDataView> ReadOnlyCursor::get() noexcept
+	Result<CursorDataView> Cursor::get() noexcept
 	{
 		MDB_val key{};
 		MDB_val value{};
@@ -82,4 +108,72 @@ namespace Lmdb
 			.value = std::span<const std::byte>(static_cast<const std::byte*>(value.mv_data), value.mv_size),
 		};
 	}
+
+	Result<std::span<const std::byte>> Cursor::getMultiple() noexcept
+	{
+		return getMultipleValues(mMdbCursor, MDB_GET_MULTIPLE);
+	}
+
+	Result<std::span<const std::byte>> Cursor::nextMultiple() noexcept
+	{
+		return getMultipleValues(mMdbCursor, MDB_NEXT_MULTIPLE);
+	}
+
+	ReadOnlyCursor::ReadOnlyCursor(MDB_cursor* mdbCursor) noexcept
+		: Cursor(mdbCursor)
+	{}
+
+	Result<ReadOnlyCursor> ReadOnlyCursor::open(ReadOnlyTransaction& transaction, ReadOnlyDatabase& database) noexcept
+	{
+		MDB_cursor* mdbCursor;
+		int returnCode = mdb_cursor_open(transaction.getRaw(), database.getRaw(), &mdbCursor);
+		if (returnCode != 0)
+		{
+			reportDebugError("Could not create LMDB cursor: '{}'", mdb_strerror(returnCode));
+			return parseReturnCode(returnCode);
+		}
+
+		return ReadOnlyCursor(mdbCursor);
+	}
+
+	ReadWriteCursor::ReadWriteCursor(MDB_cursor* mdbCursor) noexcept
+		: Cursor(mdbCursor)
+	{}
+
+	Result<ReadWriteCursor> ReadWriteCursor::open(ReadWriteTransaction& transaction, ReadWriteDatabase& database) noexcept
+	{
+		MDB_cursor* mdbCursor;
+		int returnCode = mdb_cursor_open(transaction.getRaw(), database.getRaw(), &mdbCursor);
+		if (returnCode != 0)
+		{
+			reportDebugError("Could not create LMDB cursor: '{}'", mdb_strerror(returnCode));
+			return parseReturnCode(returnCode);
+		}
+
+		return ReadWriteCursor(mdbCursor);
+	}
+
+	ReturnCode ReadWriteCursor::put(std::span<const std::byte> key, std::span<const std::byte> value) noexcept
+	{
+		MDB_val mdbKey{
+			.mv_size = key.size(),
+			.mv_data = const_cast<std::byte*>(key.data()),
+		};
+
+		MDB_val mdbValue{
+			.mv_size = value.size(),
+			.mv_data = const_cast<std::byte*>(value.data()),
+		};
+
+		const int returnCode = mdb_cursor_put(mMdbCursor, &mdbKey, &mdbValue, 0);
+		assertRelease(returnCode == 0 || returnCode == MDB_MAP_FULL, "Could not put value with LMDB cursor: '{}'", mdb_strerror(returnCode));
+		return parseReturnCode(returnCode);
+	}
+
+	ReturnCode ReadWriteCursor::deleteCurrent() noexcept
+	{
+		const int returnCode = mdb_cursor_del(mMdbCursor, 0);
+		assertRelease(returnCode == 0, "Could not delete value with LMDB cursor: '{}'", mdb_strerror(returnCode));
+		return parseReturnCode(returnCode);
+	}
 } // namespace Lmdb
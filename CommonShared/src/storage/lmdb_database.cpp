@@ -3,11 +3,14 @@
 
 #include "common_shared/storage/lmdb_database.h"
 
+#include <algorithm>
 #include <cstring>
+#include <optional>
 
 #include <liblmdb/lmdb.h>
 
 #include "common_shared/debug/assert.h"
+#include "common_shared/storage/lmdb_environment.h"
 #include "common_shared/storage/lmdb_transaction.h"
 
 namespace Lmdb
@@ -71,7 +74,7 @@ namespace Lmdb
 		return ReturnCode::Success;
 	}
 
-	ReturnCode Database::getDynamic(std::span<const std::byte> key, std::vector<std::byte> outValue) noexcept
+	ReturnCode Database::getDynamic(std::span<const std::byte> key, std::vector<std::byte>& outValue) noexcept
 	{
 		const void* valueData = nullptr;
 		size_t readBytes = 0;
@@ -95,15 +98,9 @@ namespace Lmdb
 		return lmdbGetValueUnsafe(mMdbTransaction, mDbHandler, key, outTempValueData, outValueSize);
 	}
 
-	Database::~Database() noexcept
-	{
-		if (mMdbTransaction != nullptr)
-		{
-			// this isn't necessary, but I think it is nicer to reuse the handles
-			// instead of leaving them hanging
-			mdb_dbi_close(mdb_txn_env(mMdbTransaction), mDbHandler);
-		}
-	}
+	// the handles are not closed, opening the same database again returns the same handle,
+	// and closing a handle that is cached by the environment or used by another transaction is not safe
+	Database::~Database() noexcept = default;
 
 	Database::Database(Database&& other) noexcept
 		: Database(other.mDbHandler, other.mMdbTransaction)
@@ -124,10 +121,21 @@ namespace Lmdb
 	{
 	}
 
-	Result<ReadWriteDatabase> ReadWriteDatabase::open(ReadWriteTransaction& transaction, std::zstring_view name) noexcept
+	Result<ReadWriteDatabase> ReadWriteDatabase::open(ReadWriteTransaction& transaction, std::zstring_view name, DatabaseType type) noexcept
 	{
+		if (const std::optional<MDB_dbi> cachedHandler = transaction.getEnvironmentCache()->findDatabaseHandle(name); cachedHandler.has_value())
+		{
+			return ReadWriteDatabase(*cachedHandler, transaction.getRaw());
+		}
+
+		unsigned int flags = MDB_CREATE;
+		if (type == DatabaseType::FixedSizeDuplicates)
+		{
+			flags |= MDB_DUPSORT | MDB_DUPFIXED;
+		}
+
 		MDB_dbi dbHandler;
-		int returnCode = mdb_dbi_open(transaction.getRaw(), name.c_str(), MDB_CREATE, &dbHandler);
+		int returnCode = mdb_dbi_open(transaction.getRaw(), name.c_str(), flags, &dbHandler);
 		if (returnCode != 0)
 		{
 			reportDebugError("Could not open LMDB database '{}': '{}'", name, mdb_strerror(returnCode));
@@ -150,10 +158,97 @@ namespace Lmdb
 		};
 
 		const int returnCode = mdb_put(mMdbTransaction, mDbHandler, &mdbKey, &mdbValue, 0);
-		assertRelease(returnCode == 0, "Could not put value to LMDB database: '{}'", mdb_strerror(returnCode));
+		// a full map is expected, the transaction can be repeated after growing it
+		assertRelease(returnCode == 0 || returnCode == MDB_MAP_FULL, "Could not put value to LMDB database: '{}'", mdb_strerror(returnCode));
 		return parseReturnCode(returnCode);
 	}
 
+	ReturnCode ReadWriteDatabase::putBatch(std::span<RecordView> inOutRecords) noexcept
+	{
+		auto isKeyLess = [](std::span<const std::byte> left, std::span<const std::byte> right) {
+			return std::ranges::lexicographical_compare(left, right);
+		};
+		std::ranges::stable_sort(inOutRecords, isKeyLess, &RecordView::key);
+
+		// find where the records start to go after the existing data, before any changes invalidate the last key
+		size_t appendStartIdx = 0;
+		{
+			MDB_cursor* mdbCursor;
+			int returnCode = mdb_cursor_open(mMdbTransaction, mDbHandler, &mdbCursor);
+			if (returnCode != 0)
+			{
+				reportDebugError("Could not create LMDB cursor: '{}'", mdb_strerror(returnCode));
+				return parseReturnCode(returnCode);
+			}
+
+			MDB_val lastKey{};
+			MDB_val lastValue{};
+			returnCode = mdb_cursor_get(mdbCursor, &lastKey, &lastValue, MDB_LAST);
+			if (returnCode == 0)
+			{
+				const std::span<const std::byte> lastKeyBytes(static_cast<const std::byte*>(lastKey.mv_data), lastKey.mv_size);
+				appendStartIdx = static_cast<size_t>(std::ranges::partition_point(inOutRecords, [&isKeyLess, lastKeyBytes](const RecordView& record) {
+					return !isKeyLess(lastKeyBytes, record.key);
+				}) - inOutRecords.begin());
+			}
+			mdb_cursor_close(mdbCursor);
+
+			if (returnCode != 0 && returnCode != MDB_NOTFOUND)
+			{
+				reportDebugError("Could not get the last key of LMDB database: '{}'", mdb_strerror(returnCode));
+				return parseReturnCode(returnCode);
+			}
+		}
+
+		for (size_t i = 0; i < inOutRecords.size(); ++i)
+		{
+			if (i + 1 < inOutRecords.size() && std::ranges::equal(inOutRecords[i].key, inOutRecords[i + 1].key))
+			{
+				continue;
+			}
+
+			MDB_val mdbKey{
+				.mv_size = inOutRecords[i].key.size(),
+				.mv_data = const_cast<std::byte*>(inOutRecords[i].key.data()),
+			};
+
+			MDB_val mdbValue{
+				.mv_size = inOutRecords[i].value.size(),
+				.mv_data = const_cast<std::byte*>(inOutRecords[i].value.data()),
+			};
+
+			const int returnCode = mdb_put(mMdbTransaction, mDbHandler, &mdbKey, &mdbValue, i >= appendStartIdx ? MDB_APPEND : 0);
+			if (returnCode != 0)
+			{
+				assertRelease(returnCode == MDB_MAP_FULL, "Could not put value to LMDB database: '{}'", mdb_strerror(returnCode));
+				return parseReturnCode(returnCode);
+			}
+		}
+
+		return ReturnCode::Success;
+	}
+
+	Result<std::span<std::byte>> ReadWriteDatabase::reserve(std::span<const std::byte> key, size_t valueSize) noexcept
+	{
+		MDB_val mdbKey{
+			.mv_size = key.size(),
+			.mv_data = const_cast<std::byte*>(key.data()),
+		};
+
+		MDB_val mdbValue{
+			.mv_size = valueSize,
+			.mv_data = nullptr,
+		};
+
+		const int returnCode = mdb_put(mMdbTransaction, mDbHandler, &mdbKey, &mdbValue, MDB_RESERVE);
+		if (returnCode != 0)
+		{
+			assertRelease(returnCode == MDB_MAP_FULL, "Could not reserve value in LMDB database: '{}'", mdb_strerror(returnCode));
+			return parseReturnCode(returnCode);
+		}
+		return std::span<std::byte>(static_cast<std::byte*>(mdbValue.mv_data), mdbValue.mv_size);
+	}
+
 	ReturnCode ReadWriteDatabase::deleteKey(std::span<const std::byte> key) noexcept
 	{
 		MDB_val mdbKey{
@@ -187,6 +282,11 @@ namespace Lmdb
 
 	Result<ReadOnlyDatabase> ReadOnlyDatabase::open(ReadOnlyTransaction& transaction, std::zstring_view name) noexcept
 	{
+		if (const std::optional<MDB_dbi> cachedHandler = transaction.getEnvironmentCache()->findDatabaseHandle(name); cachedHandler.has_value())
+		{
+			return ReadOnlyDatabase(*cachedHandler, transaction.getRaw());
+		}
+
 		MDB_dbi dbHandler;
 		int returnCode = mdb_dbi_open(transaction.getRaw(), name.c_str(), 0, &dbHandler);
 		if (returnCode == MDB_NOTFOUND)
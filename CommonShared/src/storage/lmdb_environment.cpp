@@ -3,19 +3,97 @@
 
 #include "common_shared/storage/lmdb_environment.h"
 
+#include <limits>
+
 #include <liblmdb/lmdb.h>
 
 #include "common_shared/debug/assert.h"
+#include "common_shared/debug/log.h"
 
 namespace Lmdb
 {
+	[[nodiscard]] static unsigned int getSyncModeFlags(SyncMode syncMode) noexcept
+	{
+		switch (syncMode)
+		{
+		case SyncMode::Full:
+			return 0;
+		case SyncMode::NoMetaSync:
+			return MDB_NOMETASYNC;
+		case SyncMode::NoSync:
+			return MDB_NOSYNC;
+		}
+
+		reportReleaseError("Unknown LMDB sync mode {}", static_cast<int>(syncMode));
+		return 0;
+	}
+
+	EnvironmentCache::~EnvironmentCache() noexcept
+	{
+		for (MDB_txn* mdbTransaction : mPooledReadTransactions)
+		{
+			mdb_txn_abort(mdbTransaction);
+		}
+	}
+
+	MDB_txn* EnvironmentCache::takeReadTransaction() noexcept
+	{
+		std::lock_guard lock(mPoolMutex);
+		if (mPooledReadTransactions.empty())
+		{
+			return nullptr;
+		}
+
+		MDB_txn* mdbTransaction = mPooledReadTransactions.back();
+		mPooledReadTransactions.pop_back();
+		return mdbTransaction;
+	}
+
+	void EnvironmentCache::releaseReadTransaction(MDB_txn* mdbTransaction) noexcept
+	{
+		mdb_txn_reset(mdbTransaction);
+
+		{
+			std::lock_guard lock(mPoolMutex);
+			if (mPooledReadTransactions.size() < MaxPooledReadTransactions)
+			{
+				mPooledReadTransactions.push_back(mdbTransaction);
+				return;
+			}
+		}
+
+		mdb_txn_abort(mdbTransaction);
+	}
+
+	std::optional<MDB_dbi> EnvironmentCache::findDatabaseHandle(std::string_view name) const noexcept
+	{
+		const auto it = mDatabaseHandles.find(name);
+		if (it == mDatabaseHandles.end())
+		{
+			return std::nullopt;
+		}
+		return it->second;
+	}
+
+	std::shared_lock<std::shared_timed_mutex> EnvironmentCache::lockMapForTransaction() noexcept
+	{
+		return std::shared_lock(mMapResizeMutex);
+	}
+
+	std::unique_lock<std::shared_timed_mutex> EnvironmentCache::tryLockMapForResize() noexcept
+	{
+		return std::unique_lock(mMapResizeMutex, MapResizeTimeout);
+	}
+
 	Environment::Environment(MDB_env* mdbEnvironment) noexcept
 		: mMdbEnvironment(mdbEnvironment)
+		, mCache(std::make_unique<EnvironmentCache>())
 	{
 	}
 
 	Environment::Environment(Environment&& other) noexcept
-		: Environment(other.mMdbEnvironment)
+		: mMdbEnvironment(other.mMdbEnvironment)
+		, mCache(std::move(other.mCache))
 	{
 		other.mMdbEnvironment = nullptr;
 	}
@@ -29,6 +107,8 @@ namespace Lmdb
 			{
 				reportDebugError("Could not flush LMDB environment before closing: '{}'", mdb_strerror(returnCode));
 			}
+			// the pooled transactions should be closed before the environment
+			mCache.reset();
 			mdb_env_close(mMdbEnvironment);
 		}
 	}
@@ -36,11 +116,12 @@ namespace Lmdb
 	Environment& Environment::operator=(Environment&& other) noexcept
 	{
 		mMdbEnvironment = other.mMdbEnvironment;
+		mCache = std::move(other.mCache);
 		other.mMdbEnvironment = nullptr;
 		return *this;
 	}
 
-	Result<Environment> Environment::open(const std::filesystem::path& path, size_t maxNamedDatabases) noexcept
+	Result<Environment> Environment::open(const std::filesystem::path& path, size_t maxNamedDatabases, const EnvironmentOptions& options) noexcept
 	{
 		MDB_env* mdbEnvironment;
 		int returnCode = mdb_env_create(&mdbEnvironment);
@@ -50,8 +131,8 @@ namespace Lmdb
 			return parseReturnCode(returnCode);
 		}
 
-		// 1Gb, if the database ever wants to grow bigger, we definitely have a problem
-		returnCode = mdb_env_set_mapsize(mdbEnvironment, 1 * 1024 * 1024 * 1024);
+		// an existing environment keeps its size if it is bigger
+		returnCode = mdb_env_set_mapsize(mdbEnvironment, options.initialMapSize);
 		if (returnCode != 0)
 		{
 			reportDebugError("Could not size LMDB environment: '{}'", mdb_strerror(returnCode));
@@ -79,11 +160,18 @@ namespace Lmdb
 			reportDebugError("Could not create LMDB environment directory '{}'", path.string());
 			return ReturnCode::CanNotCreateDirectory;
 		}
+
+		// read-only transactions are not bound to threads, so the pooled ones can be renewed from any thread
+		unsigned int flags = getSyncModeFlags(options.syncMode) | MDB_NOTLS;
+		if (options.useWriteMap)
+		{
+			flags |= MDB_WRITEMAP;
+		}
 #if defined(_WIN32) || defined(_WIN64)
 		const std::string pathStr = path.string();
-		returnCode = mdb_env_open(mdbEnvironment, pathStr.c_str(), 0, 0644);
+		returnCode = mdb_env_open(mdbEnvironment, pathStr.c_str(), flags, 0644);
 #else
-		returnCode = mdb_env_open(mdbEnvironment, path.c_str(), 0, 0644);
+		returnCode = mdb_env_open(mdbEnvironment, path.c_str(), flags, 0644);
 #endif
 		if (returnCode != 0)
 		{
@@ -111,4 +199,116 @@ namespace Lmdb
 		}
 		return result;
 	}
+
+	ReturnCode Environment::openDatabaseHandles(std::span<const std::zstring_view> names) noexcept
+	{
+		const std::shared_lock mapLock = mCache->lockMapForTransaction();
+		MDB_txn* mdbTransaction;
+		int returnCode = mdb_txn_begin(mMdbEnvironment, nullptr, 0, &mdbTransaction);
+		if (returnCode != 0)
+		{
+			reportDebugError("Could not begin LMDB transaction: '{}'", mdb_strerror(returnCode));
+			return parseReturnCode(returnCode);
+		}
+
+		std::vector<MDB_dbi> handles(names.size());
+		for (size_t i = 0; i < names.size(); ++i)
+		{
+			returnCode = mdb_dbi_open(mdbTransaction, names[i].c_str(), MDB_CREATE, &handles[i]);
+			if (returnCode != 0)
+			{
+				reportDebugError("Could not open LMDB database '{}': '{}'", names[i], mdb_strerror(returnCode));
+				mdb_txn_abort(mdbTransaction);
+				return parseReturnCode(returnCode);
+			}
+		}
+
+		// the handles are available to other transactions only after the commit
+		returnCode = mdb_txn_commit(mdbTransaction);
+		if (returnCode != 0)
+		{
+			reportDebugError("Could not commit LMDB transaction: '{}'", mdb_strerror(returnCode));
+			return parseReturnCode(returnCode);
+		}
+
+		for (size_t i = 0; i < names.size(); ++i)
+		{
+			mCache->mDatabaseHandles.insert_or_assign(std::string(names[i]), handles[i]);
+		}
+		return ReturnCode::Success;
+	}
+
+	ReturnCode Environment::setSyncMode(SyncMode syncMode) noexcept
+	{
+		int returnCode = mdb_env_set_flags(mMdbEnvironment, MDB_NOSYNC | MDB_NOMETASYNC, 0);
+		if (returnCode == 0)
+		{
+			if (const unsigned int flags = getSyncModeFlags(syncMode); flags != 0)
+			{
+				returnCode = mdb_env_set_flags(mMdbEnvironment, flags, 1);
+			}
+		}
+
+		if (returnCode != 0)
+		{
+			reportDebugError("Could not change sync mode of LMDB environment: '{}'", mdb_strerror(returnCode));
+		}
+		return parseReturnCode(returnCode);
+	}
+
+	ReturnCode Environment::sync() noexcept
+	{
+		const int returnCode = mdb_env_sync(mMdbEnvironment, 1);
+		if (returnCode != 0)
+		{
+			reportDebugError("Could not flush LMDB environment: '{}'", mdb_strerror(returnCode));
+		}
+		return parseReturnCode(returnCode);
+	}
+
+	size_t Environment::getMapSize() noexcept
+	{
+		MDB_envinfo info{};
+		const int returnCode = mdb_env_info(mMdbEnvironment, &info);
+		if (returnCode != 0)
+		{
+			reportDebugError("Could not get LMDB environment info: '{}'", mdb_strerror(returnCode));
+			return 0;
+		}
+		return static_cast<size_t>(info.me_mapsize);
+	}
+
+	ReturnCode Environment::growMap(const size_t fullMapSize) noexcept
+	{
+		// LMDB doesn't check it, resizing the map under an open transaction invalidates its pages
+		const std::unique_lock resizeLock = mCache->tryLockMapForResize();
+		if (!resizeLock.owns_lock())
+		{
+			Debug::Log::printDebug("Could not grow LMDB map, some transactions are still open");
+			return ReturnCode::EnvironmentIsBusy;
+		}
+
+		const size_t mapSize = getMapSize();
+		if (mapSize > fullMapSize)
+		{
+			// several transactions got full at the same time, the map needs to be grown only once
+			return ReturnCode::Success;
+		}
+
+		if (mapSize == 0 || mapSize > std::numeric_limits<size_t>::max() / 2)
+		{
+			reportReleaseError("Could not grow LMDB map of size {}", mapSize);
+			return ReturnCode::MapFull;
+		}
+
+		const int returnCode = mdb_env_set_mapsize(mMdbEnvironment, mapSize * 2);
+		if (returnCode != 0)
+		{
+			reportReleaseError("Could not grow LMDB map from {} bytes: '{}'", mapSize, mdb_strerror(returnCode));
+			return parseReturnCode(returnCode);
+		}
+
+		Debug::Log::printDebug("LMDB map grown to {} bytes", mapSize * 2);
+		return ReturnCode::Success;
+	}
 } // namespace Lmdb
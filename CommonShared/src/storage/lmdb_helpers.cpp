@@ -44,4 +44,43 @@ namespace Lmdb
 			dbResult.consumeResult(),
 		};
 	}
+
+	ReturnCode deleteDbRecordsWithPrefix(ReadWriteTransaction& transaction, ReadWriteDatabase& database, std::span<const std::byte> prefix) noexcept
+	{
+		Result<ReadWriteCursor> cursorRes = ReadWriteCursor::open(transaction, database);
+		if (cursorRes.isError())
+		{
+			return cursorRes.getError();
+		}
+		ReadWriteCursor cursor = cursorRes.consumeResult();
+
+		ReturnCode returnCode = cursor.seek(prefix);
+		while (returnCode == ReturnCode::Success)
+		{
+			const Result<CursorDataView> record = cursor.get();
+			if (record.isError())
+			{
+				return record.getError();
+			}
+
+			if (!hasKeyPrefix(record->key, prefix))
+			{
+				return ReturnCode::Success;
+			}
+
+			returnCode = cursor.deleteCurrent();
+			if (returnCode != ReturnCode::Success)
+			{
+				return returnCode;
+			}
+
+			returnCode = cursor.next();
+		}
+
+		if (returnCode != ReturnCode::NotFound)
+		{
+			return returnCode;
+		}
+		return ReturnCode::Success;
+	}
 } // namespace Lmdb
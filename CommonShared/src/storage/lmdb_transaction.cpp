@@ -3,6 +3,9 @@
 
 #include "common_shared/storage/lmdb_transaction.h"
 
+#include <mutex>
+#include <utility>
+
 #include <liblmdb/lmdb.h>
 
 #include "common_shared/debug/assert.h"
@@ -10,8 +13,36 @@
 
 namespace Lmdb
 {
-	Transaction::Transaction(MDB_txn* mdbTransaction) noexcept
+	[[nodiscard]] static int beginTransaction(Environment& environment, unsigned int flags, std::shared_lock<std::shared_timed_mutex>& inOutMapLock, MDB_txn*& outMdbTransaction) noexcept
+	{
+		int returnCode = mdb_txn_begin(environment.getRaw(), nullptr, flags, &outMdbTransaction);
+		if (returnCode == MDB_MAP_RESIZED)
+		{
+			// the map was grown by another process, adopt the new size and try again,
+			// the same as growing the map it can be done only when no transactions are open
+			inOutMapLock.unlock();
+			{
+				const std::unique_lock resizeLock = environment.getCache()->tryLockMapForResize();
+				if (!resizeLock.owns_lock())
+				{
+					return MDB_MAP_RESIZED;
+				}
+				returnCode = mdb_env_set_mapsize(environment.getRaw(), 0);
+			}
+			inOutMapLock.lock();
+
+			if (returnCode == 0)
+			{
+				returnCode = mdb_txn_begin(environment.getRaw(), nullptr, flags, &outMdbTransaction);
+			}
+		}
+		return returnCode;
+	}
+
+	Transaction::Transaction(MDB_txn* mdbTransaction, EnvironmentCache* environmentCache, std::shared_lock<std::shared_timed_mutex>&& mapLock) noexcept
 		: mMdbTransaction(mdbTransaction)
+		, mEnvironmentCache(environmentCache)
+		, mMapLock(std::move(mapLock))
 	{
 	}
 
@@ -24,7 +55,7 @@ namespace Lmdb
 	}
 
 	Transaction::Transaction(Transaction&& other) noexcept
-		: Transaction(other.mMdbTransaction)
+		: Transaction(other.mMdbTransaction, other.mEnvironmentCache, std::move(other.mMapLock))
 	{
 		other.mMdbTransaction = nullptr;
 	}
@@ -32,6 +63,8 @@ namespace Lmdb
 	Transaction& Transaction::operator=(Transaction&& other) noexcept
 	{
 		mMdbTransaction = other.mMdbTransaction;
+		mEnvironmentCache = other.mEnvironmentCache;
+		mMapLock = std::move(other.mMapLock);
 		other.mMdbTransaction = nullptr;
 		return *this;
 	}
@@ -42,6 +75,7 @@ namespace Lmdb
 		{
 			mdb_txn_abort(mMdbTransaction);
 			mMdbTransaction = nullptr;
+			releaseMapLock();
 		}
 		else
 		{
@@ -49,27 +83,31 @@ namespace Lmdb
 		}
 	}
 
-	ReadWriteTransaction::ReadWriteTransaction(MDB_txn* mdbTransaction) noexcept
-		: Transaction(mdbTransaction)
+	void Transaction::releaseMapLock() noexcept
+	{
+		if (mMapLock.owns_lock())
+		{
+			mMapLock.unlock();
+		}
+	}
+
+	ReadWriteTransaction::ReadWriteTransaction(MDB_txn* mdbTransaction, EnvironmentCache* environmentCache, std::shared_lock<std::shared_timed_mutex>&& mapLock) noexcept
+		: Transaction(mdbTransaction, environmentCache, std::move(mapLock))
 	{
 	}
 
 	Result<ReadWriteTransaction> ReadWriteTransaction::create(Environment& environment) noexcept
 	{
+		std::shared_lock mapLock = environment.getCache()->lockMapForTransaction();
 		MDB_txn* mdbTransaction;
-		const int returnCode = mdb_txn_begin(
-			environment.getRaw(),
-			nullptr,
-			0,
-			&mdbTransaction
-		);
+		const int returnCode = beginTransaction(environment, 0, mapLock, mdbTransaction);
 		if (returnCode != 0)
 		{
 			reportDebugError("Could not begin LMDB transaction: '{}'", mdb_strerror(returnCode));
 			return parseReturnCode(returnCode);
 		}
 
-		return ReadWriteTransaction(mdbTransaction);
+		return ReadWriteTransaction(mdbTransaction, environment.getCache(), std::move(mapLock));
 	}
 
 	ReturnCode ReadWriteTransaction::commit() noexcept
@@ -81,9 +119,11 @@ namespace Lmdb
 			{
 				reportDebugError("Could not commit LMDB transaction: '{}'", mdb_strerror(returnCode));
 				mMdbTransaction = nullptr;
+				releaseMapLock();
 				return parseReturnCode(returnCode);
 			}
 			mMdbTransaction = nullptr;
+			releaseMapLock();
 			return ReturnCode::Success;
 		}
 		else
@@ -93,25 +133,43 @@ namespace Lmdb
 		}
 	}
 
-	ReadOnlyTransaction::ReadOnlyTransaction(MDB_txn* mdbTransaction) noexcept
-		: Transaction(mdbTransaction)
+	ReadOnlyTransaction::ReadOnlyTransaction(MDB_txn* mdbTransaction, EnvironmentCache* environmentCache, std::shared_lock<std::shared_timed_mutex>&& mapLock) noexcept
+		: Transaction(mdbTransaction, environmentCache, std::move(mapLock))
 	{
 	}
 
+	ReadOnlyTransaction::~ReadOnlyTransaction() noexcept
+	{
+		if (mMdbTransaction != nullptr && mEnvironmentCache != nullptr)
+		{
+			mEnvironmentCache->releaseReadTransaction(mMdbTransaction);
+			mMdbTransaction = nullptr;
+		}
+	}
+
 	Result<ReadOnlyTransaction> ReadOnlyTransaction::create(Environment& environment) noexcept
 	{
+		// the pooled transactions are reset, so they don't need to hold the lock until they are renewed
+		std::shared_lock mapLock = environment.getCache()->lockMapForTransaction();
+		if (MDB_txn* pooledTransaction = environment.getCache()->takeReadTransaction(); pooledTransaction != nullptr)
+		{
+			const int returnCode = mdb_txn_renew(pooledTransaction);
+			if (returnCode == 0)
+			{
+				return ReadOnlyTransaction(pooledTransaction, environment.getCache(), std::move(mapLock));
+			}
+
+			// e.g. the map was resized, start a new one instead
+			mdb_txn_abort(pooledTransaction);
+		}
+
 		MDB_txn* mdbTransaction;
-		const int returnCode = mdb_txn_begin(
-			environment.getRaw(),
-			nullptr,
-			0,
-			&mdbTransaction
-		);
+		const int returnCode = beginTransaction(environment, MDB_RDONLY, mapLock, mdbTransaction);
 		if (returnCode != 0)
 		{
 			reportDebugError("Could not begin LMDB transaction: '{}'", mdb_strerror(returnCode));
 			return parseReturnCode(returnCode);
 		}
-		return ReadOnlyTransaction(mdbTransaction);
+		return ReadOnlyTransaction(mdbTransaction, environment.getCache(), std::move(mapLock));
 	}
 } // namespace Lmdb
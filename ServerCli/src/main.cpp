@@ -7,8 +7,10 @@
 #include <format>
 #include <thread>
 
+#include "common_shared/cryptography/utils/ephemeral_keypair_pool.h"
 #include "common_shared/cryptography/utils/random.h"
 #include "common_shared/debug/log.h"
+#include "common_shared/network/protocol.h"
 #include "common_shared/network/utils.h"
 #include "common_shared/nsd/nsd_server.h"
 
@@ -19,20 +21,29 @@ int main()
 {
 	Network::initSocketLib();
 
-	ServerStorage storage = ServerStorage::load();
+	// keep ephemeral keys ready for handshakes of many clients connecting at once
+	Cryptography::EphemeralKeypairPool::start();
 
-	std::array<std::byte, 16> serverId{};
-	storage.mutate([&serverId](ServerStorageData& storageData) {
-		if (std::all_of(storageData.serverId.begin(), storageData.serverId.end(), [](std::byte b) {
-				return b == std::byte(0x00);
-			}))
+	std::optional<ServerStorage> storage = ServerStorage::openStorage(".");
+	if (!storage.has_value())
+	{
+		Debug::Log::printDebug("Could not open the server storage");
+		return 0;
+	}
+
+	ServerStorageData::ServerId serverId = storage->getSnapshot()->serverId;
+	if (std::all_of(serverId.begin(), serverId.end(), [](std::byte b) {
+			return b == std::byte(0x00);
+		}))
+	{
+		// we don't need cryptographically good random here, can use any simpler method
+		Cryptography::fillWithRandomBytes(serverId);
+		if (!storage->storeServerId(serverId))
 		{
-			// we don't need cryptographically good random here, can use any simpler method
-			Cryptography::fillWithRandomBytes(storageData.serverId);
+			Debug::Log::printDebug("Could not store the server ID");
+			return 0;
 		}
-
-		serverId = storageData.serverId;
-	});
+	}
 
 	auto openSocketResult = NsdServer::openNsdSocket(Network::AddressType::IpV4);
 
@@ -49,7 +60,7 @@ int main()
 		if (nsdCloseSocketFlag.load(std::memory_order::acquire) == false)
 		{
 			nsdCloseSocketFlag.store(true, std::memory_order::seq_cst);
-			Network::closeSocket(socket);
+			Network::closeSocket(socket, Network::CloseMode::Immediate);
 		}
 	};
 
@@ -57,7 +68,7 @@ int main()
 	std::future<uint16_t> portFuture = portPromise.get_future();
 
 	auto serverThread = std::thread([&storage, &portPromise] {
-		TcpServer::runServer(storage, "0.0.0.0", Network::AddressType::IpV4, portPromise);
+		TcpServer::runServer(*storage, "0.0.0.0", Network::AddressType::IpV4, portPromise);
 	});
 
 	if (auto status = portFuture.wait_for(std::chrono::seconds(3)); status != std::future_status::ready)
@@ -68,14 +79,22 @@ int main()
 
 	const uint16_t serverPort = portFuture.get();
 
-	std::thread nsdThread([socket, &nsdCloseSocketFlag, serverId, serverPort] {
-		std::array<std::byte, 18> extraData;
-		extraData[0] = static_cast<std::byte>(1); // protocol id
-		extraData[1] = static_cast<std::byte>(0); // the rest is the server ID
-		static_assert(extraData.size() >= 2 + serverId.size());
-		std::copy(serverId.begin(), serverId.end(), extraData.begin() + 2);
+	std::array<std::byte, 18> extraData;
+	extraData[0] = static_cast<std::byte>(1); // protocol id
+	extraData[1] = static_cast<std::byte>(0); // the rest is the server ID
+	static_assert(extraData.size() >= 2 + serverId.size());
+	std::copy(serverId.begin(), serverId.end(), extraData.begin() + 2);
 
-		NsdServer::ListenResult result = NsdServer::listen(socket, "0.0.0.0", Network::AddressType::IpV4, 5354, "_easy-photo-backup._tcp", serverPort, extraData);
+	std::atomic_bool nsdAnnouncementsStopFlag{};
+	std::thread nsdAnnouncementsThread([&nsdAnnouncementsStopFlag, &extraData, serverPort] {
+		if (auto result = NsdServer::processAnnouncementsThread(Network::AddressType::IpV4, Protocol::Discovery::AnnouncementPort, "_easy-photo-backup._tcp", serverPort, extraData, nsdAnnouncementsStopFlag); result.has_value())
+		{
+			Debug::Log::printDebug("NSD announcements error: '{}'", *result);
+		}
+	});
+
+	std::thread nsdThread([socket, &nsdCloseSocketFlag, &extraData, serverPort] {
+		NsdServer::ListenResult result = NsdServer::listen(socket, "0.0.0.0", Network::AddressType::IpV4, Protocol::Discovery::QueryPort, "_easy-photo-backup._tcp", serverPort, extraData);
 
 		if (std::holds_alternative<NsdServer::SetupError>(result))
 		{
@@ -88,7 +107,7 @@ int main()
 			{
 				Debug::Log::printDebug("NSD server error: '{}'", std::get<NsdServer::SocketError>(result).error);
 				nsdCloseSocketFlag.store(true, std::memory_order::release);
-				Network::closeSocket(socket);
+				Network::closeSocket(socket, Network::CloseMode::Immediate);
 			}
 			else
 			{
@@ -99,10 +118,16 @@ int main()
 
 	serverThread.join();
 
+	// the clients see that we're gone right away instead of waiting for the TTL to expire
+	nsdAnnouncementsStopFlag.store(true, std::memory_order::release);
+	nsdAnnouncementsThread.join();
+
 	stopNsdServer();
 	// wait for the thread to finish
 	nsdThread.join();
 
+	Cryptography::EphemeralKeypairPool::stop();
+
 	Network::shutdownSocketLib();
 
 	return 0;
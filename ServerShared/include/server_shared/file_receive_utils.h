@@ -31,5 +31,5 @@ namespace FileReceiveUtils
 	};
 #endif
 
-	void receiveFiles(const std::filesystem::path& targetDirectory, Network::RawSocket socket, Noise::CipherStateSending& sendingCipherstate, Noise::CipherStateReceiving& receivingCipherState, Mocks mocks = {});
+	void receiveFiles(const std::filesystem::path& targetDirectory, Network::RawSocket socket, Noise::CipherStateSending& sendingCipherstate, Noise::CipherStateReceiving& receivingCipherState, const Noise::RekeyPolicy& rekeyPolicy, Mocks mocks = {});
 } // namespace FileReceiveUtils
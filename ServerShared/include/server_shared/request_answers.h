@@ -1,7 +1,10 @@
 // Copyright (C) Pavel Grebnev 2026
 // Distributed under the MIT License (license terms are at http://opensource.org/licenses/MIT).
 
+#pragma once
+
 #include <optional>
+#include <span>
 #include <string>
 #include <variant>
 
@@ -15,7 +18,12 @@ namespace RequestAnswers
 	using RequestAnswer = std::variant<
 		UnsupportedProtocolVersion,
 		GetProtocolVersion,
-		GetServerName>;
+		GetServerName,
+		OpenControlChannel,
+		UnsupportedRequest,
+		Hello>;
 
+	// writes the answer ID and the answer data, see Protocol::ControlChannel
+	std::optional<std::string> writeRequestAnswer(RequestAnswer&& requestAnswer, std::span<std::byte> outData, size_t& outBytesWritten);
 	std::optional<std::string> sendRequestAnswer(Network::RawSocket socket, RequestAnswer&& requestAnswer);
 } // namespace RequestAnswers
@@ -1,6 +1,8 @@
 // Copyright (C) Pavel Grebnev 2026
 // Distributed under the MIT License (license terms are at http://opensource.org/licenses/MIT).
 
+#pragma once
+
 #include <span>
 #include <string>
 #include <variant>
@@ -21,7 +23,10 @@ namespace Requests
 		GetProtocolVersion,
 		GetServerName,
 		Pair,
-		SendFiles>;
+		SendFiles,
+		ResumeSendFiles,
+		OpenControlChannel,
+		Hello>;
 
 	RequestVariant parseRequest(std::byte requestId, std::span<std::byte const> requestData);
 } // namespace Requests
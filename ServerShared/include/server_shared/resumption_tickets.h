@@ -0,0 +1,18 @@
+// Copyright (C) Pavel Grebnev 2026
+// Distributed under the MIT License (license terms are at http://opensource.org/licenses/MIT).
+
+#pragma once
+
+#include <optional>
+#include <span>
+
+#include "common_shared/cryptography/noise/session_resumption.h"
+
+// The ticket key is generated on the first use and is kept only in memory,
+// so restarting the server invalidates all the issued tickets, and the clients fall back to the full handshake.
+namespace ResumptionTickets
+{
+	[[nodiscard]] std::optional<Noise::Resumption::Ticket> issueTicket(const Cryptography::HashResult& connectionId, const Cryptography::HashResult& resumptionSecret, uint64_t lifetimeSeconds) noexcept;
+	// a ticket can be redeemed only once, returns nullopt for invalid, expired and already redeemed tickets
+	[[nodiscard]] std::optional<Noise::Resumption::TicketContent> redeemTicket(std::span<const std::byte> ticket) noexcept;
+} // namespace ResumptionTickets
@@ -13,4 +13,6 @@ class ServerStorage;
 namespace Requests
 {
 	void processSendFilesInteractiveRequest(const Cryptography::HashResult& clientId, std::span<const std::byte> firstMessage, const Network::RawSocket socket, ServerStorage& storage);
+	// falls back to the full handshake if the ticket can't be used
+	void processResumeSendFilesInteractiveRequest(std::span<const std::byte> firstMessage, const Network::RawSocket socket, ServerStorage& storage);
 }
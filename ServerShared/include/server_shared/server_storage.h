@@ -4,13 +4,16 @@
 #pragma once
 
 #include <array>
-#include <functional>
+#include <atomic>
+#include <filesystem>
+#include <memory>
 #include <mutex>
+#include <optional>
 #include <unordered_map>
 
-#include "common_shared/bstorage/value.h"
 #include "common_shared/cryptography/types/dh_types.h"
 #include "common_shared/cryptography/types/hash_types.h"
+#include "common_shared/storage/lmdb_environment.h"
 
 struct ServerStorageData
 {
@@ -19,27 +22,66 @@ struct ServerStorageData
 		std::string name;
 		Cryptography::PublicKey remoteStaticKey;
 		Cryptography::Keypair staticKeys;
+		// DH(staticKeys, remoteStaticKey), computed once at pairing time, see NoiseKK::computeStaticStaticDh
+		Cryptography::DhResult staticStaticDh;
 	};
 
-	using ConfirmedClientBindingsType = std::unordered_map<Cryptography::HashResult, ClientBinding>;
+	// bindings are immutable and shared between versions of the data, so new versions don't copy key material
+	using ConfirmedClientBindingsType = std::unordered_map<Cryptography::HashResult, std::shared_ptr<const ClientBinding>>;
+	using ServerId = std::array<std::byte, 16>;
 
 	ConfirmedClientBindingsType confirmedClientBindings;
-	std::array<std::byte, 16> serverId;
+	ServerId serverId;
+
+	[[nodiscard]] ServerStorageData clone() const;
 };
 
+/**
+ * Readers get an immutable snapshot of the data without taking any locks,
+ * writers store the change in LMDB and then publish a new snapshot with the change applied.
+ * A snapshot stays valid for as long as the reader holds it, even if newer versions were published.
+ */
 class ServerStorage
 {
 public:
-	static ServerStorage load() noexcept;
-	[[nodiscard]] bool save() const noexcept;
+	using Snapshot = std::shared_ptr<const ServerStorageData>;
+
+public:
+	ServerStorage(ServerStorage&& other) noexcept;
+	ServerStorage& operator=(ServerStorage&&) = delete;
+
+	static std::optional<ServerStorage> openStorage(const std::filesystem::path& storageRootPath);
+
+	[[nodiscard]] Snapshot getSnapshot() const noexcept
+	{
+		return mSnapshot.load(std::memory_order_acquire);
+	}
+
+	template<typename Fn>
+	void read(Fn&& readFn) const
+	{
+		const Snapshot snapshot = getSnapshot();
+		readFn(*snapshot);
+	}
 
-	void read(const std::function<void(const ServerStorageData&)>& readFn) const noexcept;
-	void mutate(const std::function<void(ServerStorageData&)>& mutateFn) noexcept;
+	// only the new binding is written, it becomes visible to readers after it is durably stored
+	[[nodiscard]] bool addConfirmedClientBinding(Cryptography::HashResult&& connectionId, ServerStorageData::ClientBinding&& binding) noexcept;
+	[[nodiscard]] bool storeServerId(const ServerStorageData::ServerId& serverId) noexcept;
 
 private:
-	explicit ServerStorage(BStorage::Value&& value) noexcept;
+	ServerStorage(Lmdb::Environment&& environment, ServerStorageData&& data) noexcept;
+
+	// should be called with mWriteMutex locked
+	template<typename Fn>
+	void publish(Fn&& mutateFn)
+	{
+		std::shared_ptr<ServerStorageData> newData = std::make_shared<ServerStorageData>(mSnapshot.load(std::memory_order_relaxed)->clone());
+		mutateFn(*newData);
+		mSnapshot.store(std::move(newData), std::memory_order_release);
+	}
 
 private:
-	ServerStorageData mStorageData;
-	mutable std::mutex mMutex;
+	Lmdb::Environment mEnvironment;
+	std::atomic<Snapshot> mSnapshot;
+	std::mutex mWriteMutex;
 };
@@ -3,6 +3,7 @@
 
 #include "server_shared/file_receive_utils.h"
 
+#include <chrono>
 #include <fstream>
 #include <limits>
 
@@ -19,7 +20,7 @@ namespace FileReceiveUtils
 {
 	/// Files are sent in chunks of 1024 bytes + auth data,
 	/// each message is encrypted separately,
-	/// rekey is called after each message,
+	/// rekey is called according to the negotiated policy (see Protocol::FileExchange::DefaultRekeyPolicy),
 	/// no out-of-order messages allowed.
 	/// If the file size does not align to 1024, the next file will be written right after
 	/// in the same message if possible. All messages below 1024 bytes are padded with zeroes at the end.
@@ -127,6 +128,15 @@ namespace FileReceiveUtils
 		bool isPartial = false;
 		Cryptography::HashResult fileHash;
 		std::vector<Protocol::FileExchange::FileReceiveStatus> lastFileStatuses;
+		Noise::RekeySchedule sendingRekeySchedule;
+		Noise::RekeySchedule receivingRekeySchedule;
+		std::chrono::steady_clock::time_point lastRekeyTime = std::chrono::steady_clock::now();
+
+		FileReceivingState(const Noise::RekeyPolicy& rekeyPolicy)
+			: sendingRekeySchedule{ .policy = rekeyPolicy }
+			, receivingRekeySchedule{ .policy = rekeyPolicy }
+		{
+		}
 
 		[[nodiscard]] size_t getMetadataLen() const noexcept
 		{
@@ -527,22 +537,16 @@ namespace FileReceiveUtils
 				return false;
 			}
 
-			size_t bytesReceived = 0;
-			auto readResult = Network::recvEncrypted(socket, buffer, bytesReceived, receivingCipherstate);
+			// we can't know how many chunks the sender is going to send before the end of transmission,
+			// so we receive one chunk at a time, but decrypt and rekey it in one go
+			const std::array<std::span<std::byte>, 1> frames = { buffer.raw };
+			auto readResult = Network::recvEncryptedBatch(socket, frames, receivingCipherstate, receivingRekeySchedule);
 			if (readResult.has_value())
 			{
 				reportDebugError("Could not recv file part: {}", *readResult);
 				return false;
 			}
 
-			if (bytesReceived != ChunkSize)
-			{
-				reportDebugError("Received chunk of unexpected size: {}", bytesReceived);
-				return false;
-			}
-
-			Noise::Utils::rekey(receivingCipherstate);
-
 			++chunksReceived;
 			bytesReadInChunk = 0;
 
@@ -560,7 +564,13 @@ namespace FileReceiveUtils
 			return chunksReceived != 0 && chunksReceived % ChunksBetweenAnswers == 0;
 		}
 
-		[[nodiscard]] bool writeAnswer(Network::RawSocket socket, Noise::CipherStateSending& sendingCipherstate) noexcept
+		[[nodiscard]] bool isRekeyByTimeDue() const noexcept
+		{
+			const uint64_t timeIntervalMs = sendingRekeySchedule.policy.timeIntervalMs;
+			return timeIntervalMs != 0 && std::chrono::steady_clock::now() - lastRekeyTime >= std::chrono::milliseconds(timeIntervalMs);
+		}
+
+		[[nodiscard]] bool writeAnswer(Network::RawSocket socket, Noise::CipherStateSending& sendingCipherstate, Noise::CipherStateReceiving& receivingCipherstate) noexcept
 		{
 			// read the big comment in Protocol::FileExchange for the explanation
 
@@ -574,23 +584,25 @@ namespace FileReceiveUtils
 			// buffer is zeroed by default
 			Cryptography::ByteSequence<Cryptography::ByteSequenceTag::TempInternalBuffer, AnswerChunkSize + Cryptography::CipherAuthDataSize> sendingBuffer;
 
-			assertFatalRelease(statusesToSend < std::numeric_limits<uint16_t>::max(), "Too many files to confirm in one answer than ever expected {}", statusesToSend);
-			Serialization::writeUint16(sendingBuffer.raw[0], sendingBuffer.raw[1], static_cast<uint16_t>(statusesToSend));
+			// only we can see the time passing between the answers, so we decide when to rekey by time and let the other side know
+			const bool isRekeyRequested = isRekeyByTimeDue();
+
+			assertFatalRelease(statusesToSend < Protocol::FileExchange::AnswerRekeyFlag, "Too many files to confirm in one answer than ever expected {}", statusesToSend);
+			Serialization::writeUint16(sendingBuffer.raw[0], sendingBuffer.raw[1], static_cast<uint16_t>(statusesToSend | (isRekeyRequested ? Protocol::FileExchange::AnswerRekeyFlag : 0)));
 
 			const size_t bytesInBitset = (statusesToSend + 7) / 8;
 
 			const size_t bitsetChunks = (BitsetOffset + bytesInBitset + AnswerChunkSize - 1) / AnswerChunkSize;
 
 			size_t posInChunk = BitsetOffset;
-			auto sendChunk = [socket, &sendingBuffer, &sendingCipherstate, &posInChunk] {
-				if (auto result = Network::sendEncrypted(socket, sendingBuffer, AnswerChunkSize, sendingCipherstate))
+			auto sendChunk = [socket, &sendingBuffer, &sendingCipherstate, &rekeySchedule = sendingRekeySchedule, &posInChunk] {
+				const std::array<std::span<std::byte>, 1> frames = { sendingBuffer.raw };
+				if (auto result = Network::sendEncryptedBatch(socket, frames, sendingCipherstate, rekeySchedule))
 				{
 					reportDebugError("Could not send answer bitset chunk: {}", *result);
 					return false;
 				}
 
-				Noise::Utils::rekey(sendingCipherstate);
-
 				// clean the ciphertext from the buffer to make sure we have zeros to reuse the buffer
 				std::fill(sendingBuffer.raw.begin(), sendingBuffer.raw.end(), std::byte(0x00));
 				posInChunk = 0;
@@ -687,13 +699,26 @@ namespace FileReceiveUtils
 				lastFileStatuses.push_back(Protocol::FileExchange::FileReceiveStatus::Success);
 			}
 
+			if (isRekeyRequested)
+			{
+				if (Noise::Utils::rekey(sendingCipherstate) != Cryptography::EncryptResult::Success || Noise::Utils::rekey(receivingCipherstate) != Cryptography::EncryptResult::Success) [[unlikely]]
+				{
+					reportDebugError("Could not rekey the cipher states after the answer");
+					return false;
+				}
+
+				Noise::Utils::resetRekeySchedule(sendingRekeySchedule);
+				Noise::Utils::resetRekeySchedule(receivingRekeySchedule);
+				lastRekeyTime = std::chrono::steady_clock::now();
+			}
+
 			return true;
 		}
 	};
 
-	void receiveFiles(const std::filesystem::path& targetDirectory, Network::RawSocket socket, Noise::CipherStateSending& sendingCipherstate, Noise::CipherStateReceiving& receivingCipherstate, [[maybe_unused]] Mocks mocks)
+	void receiveFiles(const std::filesystem::path& targetDirectory, Network::RawSocket socket, Noise::CipherStateSending& sendingCipherstate, Noise::CipherStateReceiving& receivingCipherstate, const Noise::RekeyPolicy& rekeyPolicy, [[maybe_unused]] Mocks mocks)
 	{
-		FileReceivingState receivingState;
+		FileReceivingState receivingState{ rekeyPolicy };
 		receivingState.rootPath = targetDirectory;
 
 #ifdef WITH_TESTS
@@ -755,7 +780,7 @@ namespace FileReceiveUtils
 
 					if (receivingState.shouldWriteAnswer())
 					{
-						if (!receivingState.writeAnswer(socket, sendingCipherstate))
+						if (!receivingState.writeAnswer(socket, sendingCipherstate, receivingCipherstate))
 						{
 							return;
 						}
@@ -777,7 +802,7 @@ namespace FileReceiveUtils
 
 			if (receivingState.haveUnconfirmedFiles())
 			{
-				if (!receivingState.writeAnswer(socket, sendingCipherstate))
+				if (!receivingState.writeAnswer(socket, sendingCipherstate, receivingCipherstate))
 				{
 					return;
 				}
@@ -3,8 +3,10 @@
 
 #include "server_shared/request_answers.h"
 
+#include <algorithm>
 #include <array>
 #include <cstring>
+#include <format>
 #include <optional>
 
 #include "common_shared/network/raw_sockets.h"
@@ -15,41 +17,98 @@
 
 namespace RequestAnswers
 {
-	std::optional<std::string> sendRequestAnswer(Network::RawSocket socket, RequestAnswer&& requestAnswer)
+	std::optional<std::string> writeRequestAnswer(RequestAnswer&& requestAnswer, std::span<std::byte> outData, size_t& outBytesWritten)
 	{
 		return std::visit(
 			VisitLambda{
-				[socket](UnsupportedProtocolVersion&& response) -> std::optional<std::string> {
+				[outData, &outBytesWritten](UnsupportedProtocolVersion&& response) -> std::optional<std::string> {
 					// make sure this logic does not change, as this answer is supposed to be the same across all versions
 					// in order for it to work
-					std::array<std::byte, 3> buffer = {};
-					buffer[0] = static_cast<std::byte>(Protocol::RequestAnswerId::UnsupportedProtocolVersion);
-					Serialization::writeUint16(buffer[1], buffer[2], response.firstSupportedProtocolVersion);
-
-					return Network::send(socket, buffer);
+					if (outData.size() < 3) [[unlikely]]
+					{
+						return std::format("The buffer is too small to write the answer {}", outData.size());
+					}
+					outData[0] = static_cast<std::byte>(Protocol::RequestAnswerId::UnsupportedProtocolVersion);
+					Serialization::writeUint16(outData[1], outData[2], response.firstSupportedProtocolVersion);
+					outBytesWritten = 3;
+					return std::nullopt;
 				},
-				[socket](GetProtocolVersion&& response) -> std::optional<std::string> {
+				[outData, &outBytesWritten](GetProtocolVersion&& response) -> std::optional<std::string> {
 					// make sure this logic does not change, as this answer is supposed to be the same across all versions
 					// in order for it to work
-					std::array<std::byte, 3> buffer = {};
-					buffer[0] = static_cast<std::byte>(Protocol::RequestAnswerId::GetProtocolVersion);
-					Serialization::writeUint16(buffer[1], buffer[2], response.protocolVersion);
-
-					return Network::send(socket, buffer);
+					if (outData.size() < 3) [[unlikely]]
+					{
+						return std::format("The buffer is too small to write the answer {}", outData.size());
+					}
+					outData[0] = static_cast<std::byte>(Protocol::RequestAnswerId::GetProtocolVersion);
+					Serialization::writeUint16(outData[1], outData[2], response.protocolVersion);
+					outBytesWritten = 3;
+					return std::nullopt;
 				},
-				[socket](GetServerName&& response) -> std::optional<std::string> {
-					std::array<std::byte, Protocol::MaxServerNameSize + 2> buffer = {};
-					buffer[0] = static_cast<std::byte>(Protocol::RequestAnswerId::GetServerName);
+				[outData, &outBytesWritten](GetServerName&& response) -> std::optional<std::string> {
+					if (outData.size() < 1) [[unlikely]]
+					{
+						return std::format("The buffer is too small to write the answer {}", outData.size());
+					}
+					outData[0] = static_cast<std::byte>(Protocol::RequestAnswerId::GetServerName);
 					size_t bytesWritten = 0;
-					if (auto result = Serialization::writeShortString(std::span(buffer.data() + 1, buffer.size() - 1), response.serverName, bytesWritten); result.has_value()) [[unlikely]]
+					if (auto result = Serialization::writeShortString(outData.subspan(1), response.serverName, bytesWritten); result.has_value()) [[unlikely]]
 					{
 						return result;
 					}
-
-					return Network::send(socket, std::span(buffer.data(), bytesWritten + 1));
+					outBytesWritten = bytesWritten + 1;
+					return std::nullopt;
+				},
+				[outData, &outBytesWritten](OpenControlChannel&&) -> std::optional<std::string> {
+					if (outData.size() < 1) [[unlikely]]
+					{
+						return std::format("The buffer is too small to write the answer {}", outData.size());
+					}
+					outData[0] = static_cast<std::byte>(Protocol::RequestAnswerId::OpenControlChannel);
+					outBytesWritten = 1;
+					return std::nullopt;
+				},
+				[outData, &outBytesWritten](UnsupportedRequest&&) -> std::optional<std::string> {
+					if (outData.size() < 1) [[unlikely]]
+					{
+						return std::format("The buffer is too small to write the answer {}", outData.size());
+					}
+					outData[0] = static_cast<std::byte>(Protocol::RequestAnswerId::UnsupportedRequest);
+					outBytesWritten = 1;
+					return std::nullopt;
+				},
+				[outData, &outBytesWritten](Hello&& response) -> std::optional<std::string> {
+					constexpr size_t FixedSize = 1 + sizeof(Hello::protocolVersion) + sizeof(Hello::serverId) + sizeof(Hello::capabilities);
+					if (outData.size() < FixedSize) [[unlikely]]
+					{
+						return std::format("The buffer is too small to write the answer {}", outData.size());
+					}
+					outData[0] = static_cast<std::byte>(Protocol::RequestAnswerId::Hello);
+					Serialization::writeUint16(outData[1], outData[2], response.protocolVersion);
+					std::copy(response.serverId.begin(), response.serverId.end(), outData.begin() + 3);
+					Serialization::writeUint32(outData.subspan(3 + response.serverId.size(), sizeof(response.capabilities)), response.capabilities);
+					size_t bytesWritten = 0;
+					if (auto result = Serialization::writeShortString(outData.subspan(FixedSize), response.serverName, bytesWritten); result.has_value()) [[unlikely]]
+					{
+						return result;
+					}
+					outBytesWritten = FixedSize + bytesWritten;
+					return std::nullopt;
 				},
 			},
 			std::move(requestAnswer)
 		);
 	}
+
+	std::optional<std::string> sendRequestAnswer(Network::RawSocket socket, RequestAnswer&& requestAnswer)
+	{
+		std::array<std::byte, Protocol::MaxRequestAnswerSize> buffer = {};
+		size_t bytesWritten = 0;
+		if (auto result = writeRequestAnswer(std::move(requestAnswer), buffer, bytesWritten); result.has_value()) [[unlikely]]
+		{
+			return result;
+		}
+
+		return Network::send(socket, std::span(buffer.data(), bytesWritten));
+	}
 } // namespace RequestAnswers
@@ -34,6 +34,14 @@ namespace Requests
 				.firstMessage = std::vector<std::byte>(requestData.begin() + firstMessageStart, requestData.end()),
 			};
 		}
+		case static_cast<char>(Protocol::RequestId::ResumeSendFiles):
+			return ResumeSendFiles{
+				.firstMessage = std::vector<std::byte>(requestData.begin(), requestData.end()),
+			};
+		case static_cast<char>(Protocol::RequestId::OpenControlChannel):
+			return OpenControlChannel{};
+		case static_cast<char>(Protocol::RequestId::Hello):
+			return Hello{};
 		default:
 			reportDebugError("Unknown request ID {}", static_cast<int>(requestId));
 			return RequestReadError{ std::format("Unknown request ID {}", static_cast<int>(requestId)) };
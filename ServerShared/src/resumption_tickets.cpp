@@ -0,0 +1,92 @@
+// Copyright (C) Pavel Grebnev 2026
+// Distributed under the MIT License (license terms are at http://opensource.org/licenses/MIT).
+
+#include "server_shared/resumption_tickets.h"
+
+#include <chrono>
+#include <mutex>
+#include <unordered_map>
+
+#include "common_shared/cryptography/utils/random.h"
+#include "common_shared/debug/assert.h"
+
+namespace ResumptionTickets
+{
+	struct TicketIssuerState
+	{
+		TicketIssuerState()
+		{
+			Cryptography::fillWithRandomBytes(ticketKey.raw);
+		}
+
+		std::mutex mutex;
+		Cryptography::CipherKey ticketKey;
+		Cryptography::Nonce nextTicketNonce = 0;
+		// nonce -> expiration time, to reject replayed tickets until they expire anyway
+		std::unordered_map<Cryptography::Nonce, uint64_t> redeemedTickets;
+	};
+
+	static TicketIssuerState& getIssuerState()
+	{
+		static TicketIssuerState state;
+		return state;
+	}
+
+	static uint64_t getCurrentTime()
+	{
+		return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count());
+	}
+
+	std::optional<Noise::Resumption::Ticket> issueTicket(const Cryptography::HashResult& connectionId, const Cryptography::HashResult& resumptionSecret, const uint64_t lifetimeSeconds) noexcept
+	{
+		TicketIssuerState& state = getIssuerState();
+
+		Noise::Resumption::TicketContent content{
+			.connectionId = connectionId.clone(),
+			.resumptionSecret = resumptionSecret.clone(),
+			.expirationTime = getCurrentTime() + lifetimeSeconds,
+		};
+
+		Noise::Resumption::Ticket ticket;
+		std::lock_guard lock(state.mutex);
+		if (state.nextTicketNonce == Cryptography::MaxNonce) [[unlikely]]
+		{
+			reportDebugError("Ticket nonces are exhausted");
+			return std::nullopt;
+		}
+
+		if (const Cryptography::EncryptResult result = Noise::Resumption::sealTicket(state.ticketKey, state.nextTicketNonce, content, ticket); result != Cryptography::EncryptResult::Success)
+		{
+			reportDebugError("Could not seal a resumption ticket {}", static_cast<int>(result));
+			return std::nullopt;
+		}
+		++state.nextTicketNonce;
+
+		return ticket;
+	}
+
+	std::optional<Noise::Resumption::TicketContent> redeemTicket(const std::span<const std::byte> ticket) noexcept
+	{
+		TicketIssuerState& state = getIssuerState();
+		const uint64_t currentTime = getCurrentTime();
+
+		std::lock_guard lock(state.mutex);
+		std::optional<Noise::Resumption::TicketContent> content = Noise::Resumption::openTicket(state.ticketKey, ticket, currentTime);
+		if (!content.has_value())
+		{
+			return std::nullopt;
+		}
+
+		std::erase_if(state.redeemedTickets, [currentTime](const auto& pair) {
+			return pair.second <= currentTime;
+		});
+
+		if (!state.redeemedTickets.emplace(Noise::Resumption::getTicketNonce(ticket), content->expirationTime).second)
+		{
+			reportDebugError("A resumption ticket was presented more than once");
+			return std::nullopt;
+		}
+
+		return content;
+	}
+} // namespace ResumptionTickets
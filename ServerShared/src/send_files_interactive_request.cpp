@@ -3,12 +3,21 @@
 
 #include "server_shared/send_files_interactive_request.h"
 
+#include <array>
+
+#include "common_shared/cryptography/noise/cipher_utils.h"
 #include "common_shared/cryptography/noise/noise_kk_handshake.h"
+#include "common_shared/cryptography/noise/session_resumption.h"
+#include "common_shared/cryptography/utils/random.h"
 #include "common_shared/debug/assert.h"
 #include "common_shared/network/protocol.h"
 #include "common_shared/network/raw_sockets.h"
+#include "common_shared/network/session_parameters.h"
+#include "common_shared/serialization/number_serialization.h"
 
 #include "server_shared/file_receive_utils.h"
+#include "server_shared/requests.h"
+#include "server_shared/resumption_tickets.h"
 #include "server_shared/server_storage.h"
 
 namespace Requests
@@ -18,7 +27,7 @@ namespace Requests
 	constexpr const int FileTransferMessagesTimeoutSeconds = 20;
 	constexpr const int FileTransferMessagesTimeoutMicroseconds = 0;
 
-	bool processKkHandshake(const Cryptography::HashResult& connectionId, std::span<const std::byte> firstMessage, const Network::RawSocket socket, ServerStorage& storage, Noise::CipherStateSending& outSendingCipherState, Noise::CipherStateReceiving& outReceivingCipherState)
+	bool processKkHandshake(const Cryptography::HashResult& connectionId, std::span<const std::byte> firstMessage, const Network::RawSocket socket, ServerStorage& storage, Noise::CipherStateSending& outSendingCipherState, Noise::CipherStateReceiving& outReceivingCipherState, Cryptography::HashResult& outResumptionSecret)
 	{
 		using namespace Noise;
 
@@ -30,7 +39,7 @@ namespace Requests
 			if (auto it = storageData.confirmedClientBindings.find(connectionId); it != storageData.confirmedClientBindings.end())
 			{
 				// for now only apply first found
-				handshakeState = NoiseKK::initializeResponder(it->second.staticKeys, it->second.remoteStaticKey);
+				handshakeState = NoiseKK::initializeResponder(it->second->staticKeys, it->second->remoteStaticKey, it->second->staticStaticDh);
 				return;
 			}
 		});
@@ -111,6 +120,7 @@ namespace Requests
 			{
 				outSendingCipherState = std::move(std::get<NoiseKK::HandshakeResult>(result).sendingCipherState);
 				outReceivingCipherState = std::move(std::get<NoiseKK::HandshakeResult>(result).receivingCipherState);
+				outResumptionSecret = std::move(std::get<NoiseKK::HandshakeResult>(result).resumptionSecret);
 				return true;
 			}
 		}
@@ -118,32 +128,249 @@ namespace Requests
 		return false;
 	}
 
+	static bool sendChosenSessionParameters(const Network::RawSocket socket, const Protocol::SessionParameters::Parameters& chosenParameters, Noise::CipherStateSending& sendingCipherState)
+	{
+		constexpr size_t MessageSize = Protocol::SessionParameters::MessageSize;
+		Cryptography::ByteSequence<Cryptography::ByteSequenceTag::TempInternalBuffer, MessageSize + Cryptography::CipherAuthDataSize> buffer;
+
+		Protocol::SessionParameters::write(std::span<std::byte, MessageSize>(buffer.raw.data(), MessageSize), chosenParameters);
+
+		if (auto result = Network::sendEncrypted(socket, buffer, MessageSize, sendingCipherState); result.has_value())
+		{
+			reportDebugError("Could not send the chosen session parameters: {}", *result);
+			return false;
+		}
+
+		return true;
+	}
+
+	static std::optional<Protocol::SessionParameters::Parameters> chooseSessionParameters(const Protocol::SessionParameters::Parameters& clientParameters)
+	{
+		std::optional<Protocol::SessionParameters::Parameters> chosenParameters = Protocol::SessionParameters::negotiate(Protocol::SessionParameters::getSupported(), clientParameters);
+		if (!chosenParameters.has_value())
+		{
+			// this is not an error on our side, the client is too old or too new to talk to us
+			Debug::Log::printDebug("No common session parameters with the client, frame modes {}, hash modes {}, compression modes {}", clientParameters.frameModes, clientParameters.hashModes, clientParameters.compressionModes);
+		}
+		return chosenParameters;
+	}
+
+	// see Protocol::SessionParameters for the description of the negotiation
+	static std::optional<Protocol::SessionParameters::Parameters> negotiateSessionParameters(const Network::RawSocket socket, Noise::CipherStateSending& sendingCipherState, Noise::CipherStateReceiving& receivingCipherState)
+	{
+		constexpr size_t MessageSize = Protocol::SessionParameters::MessageSize;
+		Cryptography::ByteSequence<Cryptography::ByteSequenceTag::TempInternalBuffer, Protocol::SessionParameters::MaxMessageSize + Cryptography::CipherAuthDataSize> buffer;
+
+		size_t receivedBytes = 0;
+		if (auto result = Network::recvEncrypted(socket, buffer, receivedBytes, receivingCipherState); result.has_value())
+		{
+			reportDebugError("Could not receive the session parameters of the client: {}", *result);
+			return std::nullopt;
+		}
+
+		if (receivedBytes < MessageSize)
+		{
+			reportDebugError("Unexpected size of the session parameters message {}", receivedBytes);
+			return std::nullopt;
+		}
+
+		const std::optional<Protocol::SessionParameters::Parameters> chosenParameters = chooseSessionParameters(Protocol::SessionParameters::read(std::span<const std::byte, MessageSize>(buffer.raw.data(), MessageSize)));
+		if (!chosenParameters.has_value())
+		{
+			return std::nullopt;
+		}
+
+		if (!sendChosenSessionParameters(socket, *chosenParameters, sendingCipherState))
+		{
+			return std::nullopt;
+		}
+
+		return chosenParameters;
+	}
+
+	static bool setFileTransferTimeouts(const Network::RawSocket socket)
+	{
+		if (const auto result = Network::setSocketTimeout(socket, SO_RCVTIMEO, FileTransferMessagesTimeoutSeconds, FileTransferMessagesTimeoutMicroseconds); result.has_value())
+		{
+			reportDebugError("Could not set SO_RCVTIMEO to a connection socket: {}", *result);
+			return false;
+		}
+
+		if (const auto result = Network::setSocketTimeout(socket, SO_SNDTIMEO, FileTransferMessagesTimeoutSeconds, FileTransferMessagesTimeoutMicroseconds); result.has_value())
+		{
+			reportDebugError("Could not set SO_SNDTIMEO to a connection socket: {}", *result);
+			return false;
+		}
+
+		return true;
+	}
+
+	// see Protocol::Resumption for the description
+	static bool sendResumptionTicket(const Network::RawSocket socket, const Cryptography::HashResult& connectionId, const Cryptography::HashResult& resumptionSecret, Noise::CipherStateSending& sendingCipherState)
+	{
+		constexpr size_t MessageSize = Protocol::Resumption::TicketMessageSize;
+
+		std::optional<Noise::Resumption::Ticket> ticket = ResumptionTickets::issueTicket(connectionId, resumptionSecret, Protocol::Resumption::TicketLifetimeSeconds);
+		if (!ticket.has_value())
+		{
+			return false;
+		}
+
+		Cryptography::ByteSequence<Cryptography::ByteSequenceTag::TempInternalBuffer, MessageSize + Cryptography::CipherAuthDataSize> buffer;
+		std::copy(ticket->begin(), ticket->end(), buffer.raw.begin());
+		Serialization::writeUint64(std::span(buffer.raw.data() + ticket->size(), sizeof(uint64_t)), Protocol::Resumption::TicketLifetimeSeconds);
+
+		if (auto result = Network::sendEncrypted(socket, buffer, MessageSize, sendingCipherState); result.has_value())
+		{
+			reportDebugError("Could not send the resumption ticket: {}", *result);
+			return false;
+		}
+
+		return true;
+	}
+
+	static void receiveFilesInSession(const Network::RawSocket socket, const Cryptography::HashResult& connectionId, const Cryptography::HashResult& resumptionSecret, Noise::CipherStateSending& sendingCipherState, Noise::CipherStateReceiving& receivingCipherState, const Protocol::SessionParameters::Parameters& sessionParameters)
+	{
+		if ((sessionParameters.features & Protocol::SessionParameters::Features::ResumptionTickets) != 0)
+		{
+			if (!sendResumptionTicket(socket, connectionId, resumptionSecret, sendingCipherState))
+			{
+				return;
+			}
+		}
+
+		Debug::Log::printDebug("Start receiving files");
+		FileReceiveUtils::receiveFiles("./server_target_directory", socket, sendingCipherState, receivingCipherState, sessionParameters.rekeyPolicy);
+
+		Debug::Log::printDebug("Finished receiving files");
+	}
+
 	void processSendFilesInteractiveRequest(const Cryptography::HashResult& connectionId, std::span<const std::byte> firstMessage, const Network::RawSocket socket, ServerStorage& storage)
 	{
 		Noise::CipherStateSending sendingCipherState;
 		Noise::CipherStateReceiving receivingCipherState;
-		if (!processKkHandshake(connectionId, firstMessage, socket, storage, sendingCipherState, receivingCipherState))
+		Cryptography::HashResult resumptionSecret;
+		if (!processKkHandshake(connectionId, firstMessage, socket, storage, sendingCipherState, receivingCipherState, resumptionSecret))
 		{
 			reportDebugError("Could not process KK handshake");
 			return;
 		}
 
 		// increase the timeouts even further for the file transfer
-		if (const auto result = Network::setSocketTimeout(socket, SO_RCVTIMEO, FileTransferMessagesTimeoutSeconds, FileTransferMessagesTimeoutMicroseconds); result.has_value())
+		if (!setFileTransferTimeouts(socket))
+		{
+			return;
+		}
+
+		const std::optional<Protocol::SessionParameters::Parameters> sessionParameters = negotiateSessionParameters(socket, sendingCipherState, receivingCipherState);
+		if (!sessionParameters.has_value())
+		{
+			return;
+		}
+
+		receiveFilesInSession(socket, connectionId, resumptionSecret, sendingCipherState, receivingCipherState, *sessionParameters);
+	}
+
+	static void continueWithFullHandshake(const Network::RawSocket socket, ServerStorage& storage)
+	{
+		if (const auto result = Network::setSocketTimeout(socket, SO_RCVTIMEO, SubsequentMessagesTimeoutSeconds, SubsequentMessagesTimeoutMicroseconds); result.has_value())
 		{
 			reportDebugError("Could not set SO_RCVTIMEO to a connection socket: {}", *result);
 			return;
 		}
 
-		if (const auto result = Network::setSocketTimeout(socket, SO_SNDTIMEO, FileTransferMessagesTimeoutSeconds, FileTransferMessagesTimeoutMicroseconds); result.has_value())
+		constexpr size_t MessagePreludeSize = sizeof(Protocol::NetworkProtocolVersion) + sizeof(Protocol::RequestId);
+		std::array<std::byte, Protocol::MaxRequestSize> buffer = {};
+		size_t readBytes = 0;
+		// same as with the first message, we assume that the request is not fragmented
+		if (auto result = Network::recv(socket, buffer, -1, readBytes); result.has_value())
 		{
-			reportDebugError("Could not set SO_SNDTIMEO to a connection socket: {}", *result);
+			reportDebugError("Could not recv the SendFiles request after a rejected ticket: {}", *result);
 			return;
 		}
 
-		Debug::Log::printDebug("Start receiving files");
-		FileReceiveUtils::receiveFiles("./server_target_directory", socket, sendingCipherState, receivingCipherState);
+		if (readBytes < MessagePreludeSize || Serialization::readUint16(buffer[0], buffer[1]) != Protocol::NetworkProtocolVersion)
+		{
+			reportDebugError("Unexpected request after a rejected ticket");
+			return;
+		}
 
-		Debug::Log::printDebug("Finished receiving files");
+		RequestVariant request = parseRequest(buffer[2], std::span(buffer.data() + MessagePreludeSize, buffer.data() + readBytes));
+		if (SendFiles* sendFiles = std::get_if<SendFiles>(&request))
+		{
+			processSendFilesInteractiveRequest(sendFiles->connectionId, sendFiles->firstMessage, socket, storage);
+			return;
+		}
+
+		reportDebugError("Only SendFiles request is expected after a rejected ticket");
+	}
+
+	void processResumeSendFilesInteractiveRequest(std::span<const std::byte> firstMessage, const Network::RawSocket socket, ServerStorage& storage)
+	{
+		using namespace Noise::Resumption;
+
+		if (firstMessage.size() != Protocol::Resumption::FirstMessageSize)
+		{
+			reportDebugError("Unexpected size of the ResumeSendFiles request {}", firstMessage.size());
+			return;
+		}
+
+		std::optional<TicketContent> ticketContent = ResumptionTickets::redeemTicket(firstMessage.subspan(0, TicketSize));
+
+		// the client could have been unpaired after the ticket was issued
+		bool isBindingConfirmed = false;
+		if (ticketContent.has_value())
+		{
+			storage.read([&isBindingConfirmed, &connectionId = ticketContent->connectionId](const ServerStorageData& storageData) {
+				isBindingConfirmed = storageData.confirmedClientBindings.contains(connectionId);
+			});
+		}
+
+		std::array<std::byte, sizeof(Protocol::RequestAnswerId) + sizeof(Protocol::Resumption::ResumeStatus) + RandomNonceSize> answer;
+		answer[0] = static_cast<std::byte>(Protocol::RequestAnswerId::ResumeSendFiles);
+
+		if (!isBindingConfirmed)
+		{
+			answer[1] = static_cast<std::byte>(Protocol::Resumption::ResumeStatus::Rejected);
+			if (auto result = Network::send(socket, std::span(answer.data(), 2)); result.has_value())
+			{
+				reportDebugError("Could not send ticket rejection: {}", *result);
+				return;
+			}
+
+			continueWithFullHandshake(socket, storage);
+			return;
+		}
+
+		RandomNonce serverNonce;
+		Cryptography::fillWithRandomBytes(serverNonce);
+		ResumedSession session = deriveResumedSession(ticketContent->resumptionSecret, firstMessage, serverNonce, SessionRole::Server);
+
+		const std::optional<Protocol::SessionParameters::Parameters> sessionParameters = chooseSessionParameters(Protocol::SessionParameters::read(firstMessage.subspan<TicketSize + RandomNonceSize, Protocol::SessionParameters::MessageSize>()));
+		if (!sessionParameters.has_value())
+		{
+			return;
+		}
+
+		if (!setFileTransferTimeouts(socket))
+		{
+			return;
+		}
+
+		answer[1] = static_cast<std::byte>(Protocol::Resumption::ResumeStatus::Accepted);
+		std::copy(serverNonce.begin(), serverNonce.end(), answer.begin() + 2);
+		if (auto result = Network::send(socket, answer); result.has_value())
+		{
+			reportDebugError("Could not send ticket acceptance: {}", *result);
+			return;
+		}
+
+		// the client makes sure that we derived the same keys by decrypting this message
+		if (!sendChosenSessionParameters(socket, *sessionParameters, session.sendingCipherState))
+		{
+			return;
+		}
+
+		receiveFilesInSession(socket, ticketContent->connectionId, session.nextResumptionSecret, session.sendingCipherState, session.receivingCipherState, *sessionParameters);
 	}
 } // namespace Requests
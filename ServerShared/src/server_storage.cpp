@@ -3,177 +3,398 @@
 
 #include "server_shared/server_storage.h"
 
+#include <string_view>
+
 #include "common_shared/bstorage/storage.h"
+#include "common_shared/cryptography/noise/noise_kk_handshake.h"
+#include "common_shared/cryptography/utils/crypto_wipe.h"
+#include "common_shared/debug/assert.h"
+#include "common_shared/debug/log.h"
+#include "common_shared/serialization/record_schema.h"
+#include "common_shared/storage/lmdb_helpers.h"
 
 namespace ServerStorageInternal
 {
-	static constexpr uint16_t ServerStorageVersion = 0;
-	static constexpr std::string_view ServerStoragePath = "./server_storage.bin";
+	static constexpr std::string_view ServerStorageEnviromentName = "server_storage";
+	static constexpr std::zstring_view ConfirmedDatabaseName = "confirmed";
+	static constexpr std::zstring_view MetadataDatabaseName = "meta";
+	static constexpr std::string_view ServerIdKey = "server_id";
+
+	// the whole storage used to be rewritten into this file on every change, now it is only imported once
+	static constexpr std::string_view LegacyServerStorageFileName = "server_storage.bin";
+	static constexpr uint16_t LegacyServerStorageVersion = 0;
 	static constexpr std::string_view ConfirmedField = "confirmed";
 	static constexpr std::string_view ConnectionIdField = "conn_id";
 	static constexpr std::string_view NameField = "name";
 	static constexpr std::string_view RemoteStaticKeyField = "rs";
 	static constexpr std::string_view StaticPublicKeyField = "s_pub";
 	static constexpr std::string_view StaticSecretKeyField = "s_secret";
+	static constexpr std::string_view StaticStaticDhField = "ss";
 	static constexpr std::string_view ServerIdField = "server_id";
 
 	template<size_t N>
-	static void tryConsumeObjectFieldArray(BStorage::Value::ObjectMap& record, const std::string_view name, std::array<std::byte, N>& result)
+	static void tryReadObjectFieldArray(const BStorage::ValueView::ObjectRange& record, const std::string_view name, std::array<std::byte, N>& result)
 	{
-		if (auto it = record.find(name); it != record.end())
+		if (const std::optional<BStorage::ValueView> field = record.find(name))
 		{
-			if (std::vector<std::byte>* v = it->second.asByteArray())
+			if (const std::optional<std::span<const std::byte>> bytes = field->asByteArray(); bytes.has_value() && bytes->size() == N)
 			{
-				if (v->size() == N)
-				{
-					std::copy(v->begin(), v->end(), result.begin());
-				}
+				std::copy(bytes->begin(), bytes->end(), result.begin());
 			}
 		}
 	}
 
-	template<typename T>
-	static void tryConsumeObjectField(BStorage::Value::ObjectMap& record, const std::string_view name, T& result)
+	static void ReadLegacyConfirmedClientBindings(const BStorage::ValueView& value, ServerStorageData::ConfirmedClientBindingsType& confirmedClientBindings)
 	{
-		constexpr auto getT = [](BStorage::Value& v) -> T* {
-			if constexpr (std::is_same_v<T, std::string>)
-			{
-				return v.asString();
-			}
-			else if constexpr (std::is_same_v<T, std::vector<std::byte>>)
-			{
-				return v.asByteArray();
-			}
-			else if constexpr (std::is_same_v<T, uint64_t>)
-			{
-				return v.asU64();
-			}
-			else
+		if (const std::optional<BStorage::ValueView::ArrayRange> array = value.asArray())
+		{
+			confirmedClientBindings.reserve(array->size());
+			for (const BStorage::ValueView element : *array)
 			{
-				static_assert(false, "Unknown type");
+				if (const std::optional<BStorage::ValueView::ObjectRange> record = element.asObject())
+				{
+					ServerStorageData::ClientBinding newItem{};
+					Cryptography::HashResult id;
+					tryReadObjectFieldArray(*record, ConnectionIdField, id.raw);
+					if (const std::optional<BStorage::ValueView> name = record->find(NameField))
+					{
+						newItem.name = name->asString().value_or(std::string_view());
+					}
+					tryReadObjectFieldArray(*record, StaticPublicKeyField, newItem.staticKeys.publicKey.raw);
+					tryReadObjectFieldArray(*record, StaticSecretKeyField, newItem.staticKeys.secretKey.raw);
+					tryReadObjectFieldArray(*record, RemoteStaticKeyField, newItem.remoteStaticKey.raw);
+					if (record->find(StaticStaticDhField).has_value())
+					{
+						tryReadObjectFieldArray(*record, StaticStaticDhField, newItem.staticStaticDh.raw);
+					}
+					else
+					{
+						// bindings saved before the ss result was stored
+						newItem.staticStaticDh = Noise::NoiseKK::computeStaticStaticDh(newItem.staticKeys, newItem.remoteStaticKey);
+					}
+					confirmedClientBindings.emplace(std::move(id), std::make_shared<const ServerStorageData::ClientBinding>(std::move(newItem)));
+				}
 			}
-		};
+		}
+	}
 
-		if (auto it = record.find(name); it != record.end())
+	static ServerStorageData ReadLegacyServerStorageData(const BStorage::ValueView& value)
+	{
+		ServerStorageData result{};
+		if (const std::optional<BStorage::ValueView::ObjectRange> object = value.asObject())
 		{
-			if (T* v = getT(it->second))
+			if (const std::optional<BStorage::ValueView> confirmed = object->find(ConfirmedField))
 			{
-				result = std::move(*v);
+				ReadLegacyConfirmedClientBindings(*confirmed, result.confirmedClientBindings);
 			}
+
+			tryReadObjectFieldArray(*object, ServerIdField, result.serverId);
 		}
+		return result;
 	}
 
-	static BStorage::Value WriteConfirmedClientBindingsToValue(const ServerStorageData::ConfirmedClientBindingsType& confirmedClientBindings)
+	static std::span<const std::byte> getServerIdKey()
 	{
-		std::vector<BStorage::Value> vec;
-		vec.reserve(confirmedClientBindings.size());
-		for (auto& pair : confirmedClientBindings)
+		return std::as_bytes(std::span(ServerIdKey));
+	}
+
+	using ClientBindingSchema = Serialization::RecordSchema<
+		ServerStorageData::ClientBinding,
+		Serialization::Field<"name", &ServerStorageData::ClientBinding::name>,
+		Serialization::Field<"remoteStaticKey", &ServerStorageData::ClientBinding::remoteStaticKey>,
+		Serialization::Field<"publicKey", &ServerStorageData::ClientBinding::staticKeys, &Cryptography::Keypair::publicKey>,
+		Serialization::Field<"secretKey", &ServerStorageData::ClientBinding::staticKeys, &Cryptography::Keypair::secretKey>,
+		Serialization::Field<"staticStaticDh", &ServerStorageData::ClientBinding::staticStaticDh>>;
+
+	static Lmdb::ReturnCode putClientBinding(Lmdb::ReadWriteDatabase& database, const Cryptography::HashResult& connectionId, const ServerStorageData::ClientBinding& binding)
+	{
+		std::vector<std::byte> value;
+		value.resize(ClientBindingSchema::getSerializedSize(binding));
+		if (!ClientBindingSchema::write(binding, value))
 		{
-			BStorage::Value::ObjectMap record;
-			record.reserve(4);
-			record.emplace(ConnectionIdField, BStorage::Value::makeByteArray(std::vector<std::byte>(pair.first.raw.begin(), pair.first.raw.end())));
-			record.emplace(NameField, BStorage::Value::makeString(pair.second.name));
-			record.emplace(StaticPublicKeyField, BStorage::Value::makeByteArray(std::vector<std::byte>(pair.second.staticKeys.publicKey.raw.begin(), pair.second.staticKeys.publicKey.raw.end())));
-			record.emplace(StaticSecretKeyField, BStorage::Value::makeByteArray(std::vector<std::byte>(pair.second.staticKeys.secretKey.raw.begin(), pair.second.staticKeys.secretKey.raw.end())));
-			record.emplace(RemoteStaticKeyField, BStorage::Value::makeByteArray(std::vector<std::byte>(pair.second.remoteStaticKey.raw.begin(), pair.second.remoteStaticKey.raw.end())));
-			vec.push_back(BStorage::Value::makeObject(std::move(record)));
+			return Lmdb::ReturnCode::BadValueSize;
 		}
 
-		return BStorage::Value::makeArray(std::move(vec));
+		const Lmdb::ReturnCode returnCode = database.put(connectionId, value);
+		Cryptography::cryptoWipeRawData(value);
+		return returnCode;
+	}
+
+	static std::optional<ServerStorageData::ClientBinding> parseClientBinding(std::span<const std::byte> value)
+	{
+		ServerStorageData::ClientBinding result{};
+		if (!ClientBindingSchema::read(value, result))
+		{
+			return std::nullopt;
+		}
+		return result;
 	}
 
-	static void ReadConfirmedClientBindingsToValue(BStorage::Value&& value, ServerStorageData::ConfirmedClientBindingsType& confirmedClientBindings)
+	static Lmdb::Result<Lmdb::Environment> openEnvironment(const std::filesystem::path& dbPath)
 	{
-		if (std::vector<BStorage::Value>* vec = value.asArray())
+		static constexpr size_t maxNamedDatabases = 2;
+
+		Lmdb::Result<Lmdb::Environment> envResult = Lmdb::Environment::open(dbPath, maxNamedDatabases);
+
+		if (envResult.isError())
 		{
-			confirmedClientBindings.reserve(vec->size());
-			for (BStorage::Value& val : *vec)
+			switch (envResult.getError())
 			{
-				if (BStorage::Value::ObjectMap* record = val.asObject())
-				{
-					ServerStorageData::ClientBinding newItem{};
-					Cryptography::HashResult id;
-					tryConsumeObjectFieldArray(*record, ConnectionIdField, id.raw);
-					tryConsumeObjectField<std::string>(*record, NameField, newItem.name);
-					tryConsumeObjectFieldArray(*record, StaticPublicKeyField, newItem.staticKeys.publicKey.raw);
-					tryConsumeObjectFieldArray(*record, StaticSecretKeyField, newItem.staticKeys.secretKey.raw);
-					tryConsumeObjectFieldArray(*record, RemoteStaticKeyField, newItem.remoteStaticKey.raw);
-					confirmedClientBindings.emplace(std::move(id), std::move(newItem));
-				}
+			case Lmdb::ReturnCode::Corrupted:
+			case Lmdb::ReturnCode::InvalidFile:
+			case Lmdb::ReturnCode::Panic:
+			case Lmdb::ReturnCode::Problem:
+				// on fatal problems just recreate the DB, the clients will need to pair again
+				std::filesystem::remove_all(dbPath);
+				envResult = Lmdb::Environment::open(dbPath, maxNamedDatabases);
+				break;
+			default:
+				break;
 			}
 		}
+
+		return envResult;
 	}
 
-	static BStorage::Value WriteServerStorageDataToValue(const ServerStorageData& data)
+	// moves the data from the file of the old format into the environment, the file is removed after the data is committed,
+	// unreadable files are moved aside and the storage starts with what is already in the environment, as the old loading did
+	static bool importLegacyStorageFile(Lmdb::Environment& environment, const std::filesystem::path& legacyFilePath)
 	{
-		BStorage::Value::ObjectMap clientStorageDataObject;
-		clientStorageDataObject.reserve(2);
-		clientStorageDataObject.emplace(
-			ConfirmedField,
-			WriteConfirmedClientBindingsToValue(data.confirmedClientBindings)
-		);
-		clientStorageDataObject.emplace(ServerIdField, BStorage::Value::makeByteArray(data.serverId));
-		return BStorage::Value::makeObject(std::move(clientStorageDataObject));
+		std::error_code errorCode;
+		if (!std::filesystem::exists(legacyFilePath, errorCode))
+		{
+			return true;
+		}
+
+		// the file is unmapped right after reading, so it can be removed later
+		const std::optional<ServerStorageData> legacyData = [&legacyFilePath]() -> std::optional<ServerStorageData> {
+			const std::optional<BStorage::StorageView> loaded = BStorage::loadStorageView(legacyFilePath);
+			if (!loaded.has_value() || loaded->getVersion() != LegacyServerStorageVersion)
+			{
+				return std::nullopt;
+			}
+			return ReadLegacyServerStorageData(loaded->getRoot());
+		}();
+
+		if (!legacyData.has_value())
+		{
+			// e.g. truncated by the old non-atomic save, keep it for investigation but don't fail on every start
+			std::filesystem::path badFilePath = legacyFilePath;
+			badFilePath += ".bad";
+			reportReleaseError("Could not import server storage from '{}', moving it to '{}'", legacyFilePath.string(), badFilePath.string());
+			std::filesystem::rename(legacyFilePath, badFilePath, errorCode);
+			if (errorCode)
+			{
+				std::filesystem::remove(legacyFilePath, errorCode);
+			}
+			return true;
+		}
+
+		Lmdb::Result<Lmdb::ReadWriteTransaction> transaction = Lmdb::ReadWriteTransaction::create(environment);
+		if (transaction.isError())
+		{
+			return false;
+		}
+
+		Lmdb::Result<Lmdb::ReadWriteDatabase> confirmedDb = Lmdb::ReadWriteDatabase::open(*transaction, ConfirmedDatabaseName);
+		if (confirmedDb.isError())
+		{
+			return false;
+		}
+
+		for (const auto& [connectionId, binding] : legacyData->confirmedClientBindings)
+		{
+			if (putClientBinding(*confirmedDb, connectionId, *binding) != Lmdb::ReturnCode::Success)
+			{
+				return false;
+			}
+		}
+
+		Lmdb::Result<Lmdb::ReadWriteDatabase> metadataDb = Lmdb::ReadWriteDatabase::open(*transaction, MetadataDatabaseName);
+		if (metadataDb.isError())
+		{
+			return false;
+		}
+
+		if (metadataDb->put(getServerIdKey(), legacyData->serverId) != Lmdb::ReturnCode::Success)
+		{
+			return false;
+		}
+
+		if (transaction->commit() != Lmdb::ReturnCode::Success)
+		{
+			return false;
+		}
+
+		std::filesystem::remove(legacyFilePath, errorCode);
+		Debug::Log::printDebug("Imported {} client bindings from '{}'", legacyData->confirmedClientBindings.size(), legacyFilePath.string());
+		return true;
 	}
 
-	static ServerStorageData ReadServerStorageDataFromValue(BStorage::Value&& value)
+	static std::optional<ServerStorageData> readStorageData(Lmdb::Environment& environment)
 	{
 		ServerStorageData result{};
-		BStorage::Value::ObjectMap* object = value.asObject();
-		if (object != nullptr)
+
+		Lmdb::Result<Lmdb::ReadOnlyTransaction> transaction = Lmdb::ReadOnlyTransaction::create(environment);
+		if (transaction.isError())
 		{
-			if (auto it = object->find(ConfirmedField); it != object->end())
+			return std::nullopt;
+		}
+
+		if (Lmdb::Result<Lmdb::ReadOnlyDatabase> confirmedDb = Lmdb::ReadOnlyDatabase::open(*transaction, ConfirmedDatabaseName); !confirmedDb.isError())
+		{
+			const Lmdb::ReturnCode returnCode = Lmdb::readAllDbRecords(*transaction, *confirmedDb, [&result](std::span<const std::byte> key, std::span<const std::byte> value) {
+				Cryptography::HashResult connectionId;
+				if (key.size() != connectionId.size())
+				{
+					reportReleaseError("Unexpected size of connection ID in the confirmed bindings: {}", key.size());
+					return;
+				}
+				std::copy(key.begin(), key.end(), connectionId.raw.begin());
+
+				std::optional<ServerStorageData::ClientBinding> binding = parseClientBinding(value);
+				if (binding.has_value())
+				{
+					result.confirmedClientBindings.emplace(std::move(connectionId), std::make_shared<const ServerStorageData::ClientBinding>(std::move(*binding)));
+				}
+			});
+			if (returnCode != Lmdb::ReturnCode::Success)
 			{
-				ReadConfirmedClientBindingsToValue(std::move(it->second), result.confirmedClientBindings);
+				return std::nullopt;
 			}
+		}
+		else if (confirmedDb.getError() != Lmdb::ReturnCode::NotFound)
+		{
+			return std::nullopt;
+		}
 
-			tryConsumeObjectFieldArray(*object, ServerIdField, result.serverId);
+		if (Lmdb::Result<Lmdb::ReadOnlyDatabase> metadataDb = Lmdb::ReadOnlyDatabase::open(*transaction, MetadataDatabaseName); !metadataDb.isError())
+		{
+			const Lmdb::ReturnCode returnCode = metadataDb->readValue(getServerIdKey(), [&result](std::span<const std::byte> value) {
+				if (value.size() == result.serverId.size())
+				{
+					std::copy(value.begin(), value.end(), result.serverId.begin());
+				}
+			});
+			if (returnCode != Lmdb::ReturnCode::Success && returnCode != Lmdb::ReturnCode::NotFound)
+			{
+				return std::nullopt;
+			}
 		}
+		else if (metadataDb.getError() != Lmdb::ReturnCode::NotFound)
+		{
+			return std::nullopt;
+		}
+
 		return result;
 	}
 } // namespace ServerStorageInternal
 
-ServerStorage ServerStorage::load() noexcept
+ServerStorageData ServerStorageData::clone() const
+{
+	ServerStorageData result{};
+	result.confirmedClientBindings.reserve(confirmedClientBindings.size());
+	for (const auto& [connectionId, binding] : confirmedClientBindings)
+	{
+		result.confirmedClientBindings.emplace(connectionId.clone(), binding);
+	}
+	result.serverId = serverId;
+	return result;
+}
+
+std::optional<ServerStorage> ServerStorage::openStorage(const std::filesystem::path& storageRootPath)
 {
-	std::optional<std::tuple<BStorage::Value, uint16_t>> loaded = BStorage::loadStorage(ServerStorageInternal::ServerStoragePath);
+	using namespace ServerStorageInternal;
+
+	Lmdb::Result<Lmdb::Environment> envResult = openEnvironment(storageRootPath / ServerStorageEnviromentName);
+
+	// ToDo: on non-fatal problems wait and try again
 
-	if (loaded.has_value())
+	if (envResult.isError())
 	{
-		if (std::get<1>(*loaded) != ServerStorageInternal::ServerStorageVersion)
-		{
-			// here we need to have an update path
-			return ServerStorage(BStorage::Value::makeObject({}));
-		}
+		return std::nullopt;
+	}
+
+	Lmdb::Environment environment = envResult.consumeResult();
 
-		return ServerStorage(std::get<0>(std::move(*loaded)));
+	if (!importLegacyStorageFile(environment, storageRootPath / LegacyServerStorageFileName))
+	{
+		return std::nullopt;
 	}
-	else
+
+	std::optional<ServerStorageData> data = readStorageData(environment);
+	if (!data.has_value())
 	{
-		return ServerStorage(BStorage::Value::makeObject({}));
+		return std::nullopt;
 	}
+
+	return ServerStorage(std::move(environment), std::move(*data));
 }
 
-bool ServerStorage::save() const noexcept
+bool ServerStorage::addConfirmedClientBinding(Cryptography::HashResult&& connectionId, ServerStorageData::ClientBinding&& binding) noexcept
 {
-	using namespace ServerStorageInternal;
+	std::lock_guard g(mWriteMutex);
 
-	std::lock_guard g(mMutex);
-	return BStorage::saveStorage(ServerStoragePath, WriteServerStorageDataToValue(mStorageData), ServerStorageVersion);
+	Lmdb::Result<Lmdb::ReadWriteSingleDbWrapper> wrapper = Lmdb::openReadWriteSingleDbTransaction(mEnvironment, ServerStorageInternal::ConfirmedDatabaseName);
+	if (wrapper.isError())
+	{
+		return false;
+	}
+
+	Lmdb::ReturnCode returnCode = ServerStorageInternal::putClientBinding(wrapper->database, connectionId, binding);
+	if (returnCode != Lmdb::ReturnCode::Success)
+	{
+		return false;
+	}
+
+	returnCode = wrapper->transaction.commit();
+	if (returnCode != Lmdb::ReturnCode::Success)
+	{
+		return false;
+	}
+
+	publish([&connectionId, &binding](ServerStorageData& data) {
+		data.confirmedClientBindings.insert_or_assign(std::move(connectionId), std::make_shared<const ServerStorageData::ClientBinding>(std::move(binding)));
+	});
+	return true;
 }
 
-void ServerStorage::read(const std::function<void(const ServerStorageData&)>& readFn) const noexcept
+bool ServerStorage::storeServerId(const ServerStorageData::ServerId& serverId) noexcept
 {
-	std::lock_guard g(mMutex);
-	readFn(mStorageData);
+	std::lock_guard g(mWriteMutex);
+
+	Lmdb::Result<Lmdb::ReadWriteSingleDbWrapper> wrapper = Lmdb::openReadWriteSingleDbTransaction(mEnvironment, ServerStorageInternal::MetadataDatabaseName);
+	if (wrapper.isError())
+	{
+		return false;
+	}
+
+	Lmdb::ReturnCode returnCode = wrapper->database.put(ServerStorageInternal::getServerIdKey(), serverId);
+	if (returnCode != Lmdb::ReturnCode::Success)
+	{
+		return false;
+	}
+
+	returnCode = wrapper->transaction.commit();
+	if (returnCode != Lmdb::ReturnCode::Success)
+	{
+		return false;
+	}
+
+	publish([&serverId](ServerStorageData& data) {
+		data.serverId = serverId;
+	});
+	return true;
 }
 
-void ServerStorage::mutate(const std::function<void(ServerStorageData&)>& mutateFn) noexcept
+ServerStorage::ServerStorage(ServerStorage&& other) noexcept
+	: mEnvironment(std::move(other.mEnvironment))
+	, mSnapshot(other.mSnapshot.load())
 {
-	std::lock_guard g(mMutex);
-	mutateFn(mStorageData);
 }
 
-ServerStorage::ServerStorage(BStorage::Value&& value) noexcept
-	: mStorageData(ServerStorageInternal::ReadServerStorageDataFromValue(std::move(value)))
+ServerStorage::ServerStorage(Lmdb::Environment&& environment, ServerStorageData&& data) noexcept
+	: mEnvironment(std::move(environment))
+	, mSnapshot(std::make_shared<const ServerStorageData>(std::move(data)))
 {
 }
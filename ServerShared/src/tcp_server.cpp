@@ -4,10 +4,12 @@
 #include "server_shared/tcp_server.h"
 
 #include <array>
+#include <atomic>
 #include <cstring>
 #include <format>
 #include <thread>
 
+#include "common_shared/cryptography/noise/noise_kk_handshake.h"
 #include "common_shared/cryptography/utils/connection_id_utils.h"
 #include "common_shared/cryptography/utils/short_authentification_string_utils.h"
 #include "common_shared/debug/assert.h"
@@ -27,8 +29,118 @@ namespace TcpServer
 {
 	constexpr const int FirstMessageTimeoutSeconds = 0;
 	constexpr const int FirstMessageTimeoutMicroseconds = 100000;
+	// the channels are opened without authentication and each of them holds a thread, so their number is limited
+	constexpr const size_t MaxControlChannels = 16;
 
-	static void handleClient(const Network::RawSocket socket, sockaddr /*clientAddr*/, socklen_t /*clientAddrLen*/, ServerStorage& storage)
+	static RequestAnswers::GetServerName getServerNameAnswer()
+	{
+		return RequestAnswers::GetServerName{
+			.serverName = std::string("test server"),
+		};
+	}
+
+	static RequestAnswers::Hello getHelloAnswer(const ServerStorage& storage)
+	{
+		RequestAnswers::Hello answer{
+			.protocolVersion = Protocol::NetworkProtocolVersion,
+			.serverId = {},
+			.capabilities = Protocol::Capabilities::AllSupported,
+			.serverName = getServerNameAnswer().serverName,
+		};
+
+		storage.read([&answer](const ServerStorageData& storageData) {
+			answer.serverId = storageData.serverId;
+		});
+
+		return answer;
+	}
+
+	static RequestAnswers::RequestAnswer processControlChannelRequest(const std::byte requestIdByte, const std::span<const std::byte> requestData, const ServerStorage& storage)
+	{
+		if (requestIdByte == static_cast<std::byte>(Protocol::RequestId::GetProtocolVersion))
+		{
+			return RequestAnswers::GetProtocolVersion{
+				.protocolVersion = Protocol::NetworkProtocolVersion,
+			};
+		}
+
+		auto request = Requests::parseRequest(requestIdByte, requestData);
+		if (std::holds_alternative<Requests::GetServerName>(request))
+		{
+			return getServerNameAnswer();
+		}
+
+		if (std::holds_alternative<Requests::Hello>(request))
+		{
+			return getHelloAnswer(storage);
+		}
+
+		// interactive requests need a connection of their own
+		return RequestAnswers::UnsupportedRequest{};
+	}
+
+	// see Protocol::ControlChannel
+	static void processControlChannel(const Network::RawSocket socket, const ServerStorage& storage)
+	{
+		static std::atomic<size_t> openChannelsCount = 0;
+		if (openChannelsCount.fetch_add(1, std::memory_order::relaxed) >= MaxControlChannels)
+		{
+			openChannelsCount.fetch_sub(1, std::memory_order::relaxed);
+			Debug::Log::printDebug("Too many open control channels, refusing a new one");
+			// the client can still send the same requests through separate connections
+			RequestAnswers::sendRequestAnswer(socket, RequestAnswers::UnsupportedRequest{});
+			return;
+		}
+		// the slot is released however the channel is closed
+		struct ChannelSlotReleaser
+		{
+			~ChannelSlotReleaser() { openChannelsCount.fetch_sub(1, std::memory_order::relaxed); }
+		} channelSlotReleaser;
+
+		if (auto result = RequestAnswers::sendRequestAnswer(socket, RequestAnswers::OpenControlChannel{}); result.has_value())
+		{
+			reportDebugError("Could not confirm opening a control channel: {}", *result);
+			return;
+		}
+
+		if (const auto result = Network::setSocketTimeout(socket, SO_RCVTIMEO, Protocol::ControlChannel::IdleTimeoutSeconds, 0); result.has_value())
+		{
+			reportDebugError("Could not set SO_RCVTIMEO to a control channel socket");
+			return;
+		}
+
+		std::array<std::byte, Protocol::ControlChannel::MaxFramePayloadSize> requestBuffer;
+		std::array<std::byte, Protocol::ControlChannel::MaxFramePayloadSize> answerBuffer;
+		while (true)
+		{
+			uint16_t requestTag = 0;
+			size_t requestSize = 0;
+			if (auto result = Network::recvFrame(socket, requestBuffer, requestTag, requestSize); result.has_value())
+			{
+				// the client closed the channel or it was idle for too long
+				Debug::Log::printDebug("Control channel closed: {}", *result);
+				return;
+			}
+
+			RequestAnswers::RequestAnswer answer = processControlChannelRequest(requestBuffer[0], std::span(requestBuffer.data() + 1, requestSize - 1), storage);
+
+			size_t answerSize = 0;
+			if (auto result = RequestAnswers::writeRequestAnswer(std::move(answer), answerBuffer, answerSize); result.has_value())
+			{
+				reportDebugError("Could not write an answer to a control channel request: {}", *result);
+				return;
+			}
+
+			if (auto result = Network::sendFrame(socket, requestTag, std::span(answerBuffer.data(), answerSize)); result.has_value())
+			{
+				Debug::Log::printDebug("Could not send an answer through the control channel: {}", *result);
+				return;
+			}
+		}
+	}
+
+	// returns how the socket should be closed
+	static Network::CloseMode handleClient(const Network::RawSocket socket, sockaddr /*clientAddr*/, socklen_t /*clientAddrLen*/, ServerStorage& storage)
 	{
 		// we need to make sure to have a timeout to not get DOS as soon as a couple of connections hangs
 		// we should have a shorter timeout now and increase it when we authentificate the user for the file transfer
@@ -36,13 +148,13 @@ namespace TcpServer
 		if (const auto result = Network::setSocketTimeout(socket, SO_RCVTIMEO, FirstMessageTimeoutSeconds, FirstMessageTimeoutMicroseconds); result.has_value())
 		{
 			reportDebugError("Could not set SO_RCVTIMEO to a connection socket");
-			return;
+			return Network::CloseMode::Graceful;
 		}
 
 		if (const auto result = Network::setSocketTimeout(socket, SO_SNDTIMEO, FirstMessageTimeoutSeconds, FirstMessageTimeoutMicroseconds); result.has_value())
 		{
 			reportDebugError("Could not set SO_SNDTIMEO to a connection socket");
-			return;
+			return Network::CloseMode::Graceful;
 		}
 
 		constexpr size_t BUFFER_SIZE = Protocol::MaxRequestSize;
@@ -52,7 +164,8 @@ namespace TcpServer
 		if (auto result = Network::recv(socket, buffer, -1, readBytes); result.has_value())
 		{
 			Debug::Log::printDebug("Could not recv the first message from a client: {}", *result);
-			return;
+			// the client is either gone or stays silent, there is nothing to wait for
+			return Network::CloseMode::Abortive;
 		}
 
 		constexpr size_t MessagePreludeSize = sizeof(Protocol::NetworkProtocolVersion) + sizeof(Protocol::RequestId);
@@ -60,7 +173,7 @@ namespace TcpServer
 		// each request needs to be at least three bytes (protocol version (2) and request ID (1))
 		if (readBytes < MessagePreludeSize)
 		{
-			return;
+			return Network::CloseMode::Abortive;
 		}
 
 		// GetProtocolVersion is a special case that doesn't require version match
@@ -74,7 +187,7 @@ namespace TcpServer
 					.protocolVersion = Protocol::NetworkProtocolVersion,
 				}
 			);
-			return;
+			return Network::CloseMode::Graceful;
 		}
 
 		const uint16_t protocolVerstion = Serialization::readUint16(buffer[0], buffer[1]);
@@ -89,7 +202,7 @@ namespace TcpServer
 					.firstSupportedProtocolVersion = Protocol::NetworkProtocolVersion,
 				}
 			);
-			return;
+			return Network::CloseMode::Graceful;
 		}
 
 		const std::byte requestIdByte = buffer[2];
@@ -104,12 +217,7 @@ namespace TcpServer
 					reportFatalReleaseError("unreachable code");
 				},
 				[socket](const Requests::GetServerName&&) {
-					RequestAnswers::sendRequestAnswer(
-						socket,
-						RequestAnswers::GetServerName{
-							.serverName = std::string("test server"),
-						}
-					);
+					RequestAnswers::sendRequestAnswer(socket, getServerNameAnswer());
 				},
 				[socket, &storage](const Requests::Pair&& pair) {
 					auto pendingClientBinding = Requests::processPairingInteractiveRequest(pair.firstMessage, socket);
@@ -123,20 +231,22 @@ namespace TcpServer
 
 						Debug::Log::printDebug(Cryptography::generateSas(pendingClientBinding->handshakeHash, 6));
 
-						storage.mutate([&pendingClientBinding](ServerStorageData& storage) {
-							storage.confirmedClientBindings.emplace(
-								Cryptography::generateConnectionId(pendingClientBinding->remoteStaticKey, pendingClientBinding->staticKeys.publicKey),
-								ServerStorageData::ClientBinding{
-									.name = "test_client",
-									.remoteStaticKey = std::move(pendingClientBinding->remoteStaticKey),
-									.staticKeys = std::move(pendingClientBinding->staticKeys),
-								}
-							);
-						});
-
-						if (storage.save() == false)
+						Cryptography::DhResult staticStaticDh = Noise::NoiseKK::computeStaticStaticDh(pendingClientBinding->staticKeys, pendingClientBinding->remoteStaticKey);
+						Cryptography::HashResult connectionId = Cryptography::generateConnectionId(pendingClientBinding->remoteStaticKey, pendingClientBinding->staticKeys.publicKey);
+						const bool isStored = storage.addConfirmedClientBinding(
+							std::move(connectionId),
+							ServerStorageData::ClientBinding{
+								.name = "test_client",
+								.remoteStaticKey = std::move(pendingClientBinding->remoteStaticKey),
+								.staticKeys = std::move(pendingClientBinding->staticKeys),
+								.staticStaticDh = std::move(staticStaticDh),
+							}
+						);
+
+						if (!isStored)
 						{
 							reportDebugError("Could not save client data");
+							return;
 						}
 
 						Debug::Log::printDebug("The client got automatically approved for testing purposes");
@@ -145,9 +255,20 @@ namespace TcpServer
 				[socket, &storage](const Requests::SendFiles&& sendFiles) {
 					Requests::processSendFilesInteractiveRequest(sendFiles.connectionId, sendFiles.firstMessage, socket, storage);
 				},
+				[socket, &storage](const Requests::ResumeSendFiles&& resumeSendFiles) {
+					Requests::processResumeSendFilesInteractiveRequest(resumeSendFiles.firstMessage, socket, storage);
+				},
+				[socket, &storage](const Requests::OpenControlChannel&&) {
+					processControlChannel(socket, storage);
+				},
+				[socket, &storage](const Requests::Hello&&) {
+					RequestAnswers::sendRequestAnswer(socket, getHelloAnswer(storage));
+				},
 			},
 			std::move(request)
 		);
+
+		return Network::CloseMode::Graceful;
 	}
 
 	std::optional<std::string> runServer(ServerStorage& storage, const char* interfaceAddressStr, const Network::AddressType addressType, std::promise<uint16_t>& portPromise)
@@ -158,7 +279,7 @@ namespace TcpServer
 			return std::get<std::string>(createSocketResult);
 		}
 
-		const Network::AutoclosingSocket socket = Network::AutoclosingSocket(std::get<Network::RawSocket>(std::move(createSocketResult)));
+		const Network::AutoclosingSocket socket = Network::AutoclosingSocket(std::get<Network::RawSocket>(std::move(createSocketResult)), Network::CloseMode::Immediate);
 
 		if (auto result = Network::setSocketOption(socket, SO_REUSEADDR); result.has_value())
 		{
@@ -211,7 +332,7 @@ namespace TcpServer
 			// and avoid getting DOSed simply by spamming small requests
 			std::thread([connectionSocket, clientAddr, clientAddrLen, &storage] {
 				Network::AutoclosingSocket socketGuard(connectionSocket);
-				handleClient(connectionSocket, clientAddr, clientAddrLen, storage);
+				socketGuard.setCloseMode(handleClient(connectionSocket, clientAddr, clientAddrLen, storage));
 			}).detach();
 		}
 
@@ -0,0 +1,97 @@
+// Copyright (C) Pavel Grebnev 2026
+// Distributed under the MIT License (license terms are at http://opensource.org/licenses/MIT).
+
+#include <cstring>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <sstream>
+
+#include <gtest/gtest.h>
+
+#include "common_shared/bstorage/storage.h"
+
+namespace BStorageStorageTestsInternal
+{
+	static BStorage::Value makeDocument(const size_t recordsCount)
+	{
+		BStorage::Value::ArrayType records;
+		records.reserve(recordsCount);
+		for (size_t i = 0; i < recordsCount; ++i)
+		{
+			BStorage::Value::ObjectMap record;
+			record.emplace("name", BStorage::Value::makeString(std::format("record_{}", i)));
+			record.emplace("index", BStorage::Value::makeU64(i));
+			record.emplace("key", BStorage::Value::makeByteArray(std::vector<std::byte>(32, static_cast<std::byte>(i))));
+			record.emplace("flag", BStorage::Value::makeOption(BStorage::Value::makeU8(1)));
+			records.push_back(BStorage::Value::makeObject(std::move(record)));
+		}
+
+		BStorage::Value::ObjectMap document;
+		document.emplace("records", BStorage::Value::makeArray(std::move(records)));
+		document.emplace("empty", BStorage::Value::makeArray({}));
+		return BStorage::Value::makeObject(std::move(document));
+	}
+} // namespace BStorageStorageTestsInternal
+
+TEST(BStorageStorage, WriteToBuffer_SameAsWriteToStream)
+{
+	using namespace BStorageStorageTestsInternal;
+
+	const BStorage::Value document = makeDocument(300);
+
+	std::ostringstream stream;
+	ASSERT_TRUE(document.writeToStream(stream));
+	const std::string streamData = stream.str();
+
+	const std::optional<size_t> size = document.getSerializedSize();
+	ASSERT_TRUE(size.has_value());
+	ASSERT_EQ(*size, streamData.size());
+
+	std::vector<std::byte> buffer(*size);
+	ASSERT_TRUE(document.writeToBuffer(buffer));
+	EXPECT_EQ(std::memcmp(buffer.data(), streamData.data(), buffer.size()), 0);
+
+	// the buffer should be exactly of the serialized size
+	std::vector<std::byte> smallBuffer(*size - 1);
+	EXPECT_FALSE(document.writeToBuffer(smallBuffer));
+	std::vector<std::byte> bigBuffer(*size + 1);
+	EXPECT_FALSE(document.writeToBuffer(bigBuffer));
+}
+
+TEST(BStorageStorage, SaveStorage_ExistingFile_ReplacedWithoutTemporaryFile)
+{
+	using namespace BStorageStorageTestsInternal;
+
+	const std::filesystem::path filePath = "test_bstorage_storage.bin";
+	{
+		std::ofstream oldFile(filePath, std::ios::binary);
+		oldFile << "old content";
+	}
+
+	const BStorage::Value document = makeDocument(10);
+	ASSERT_TRUE(BStorage::saveStorage(filePath, document, 0x0102));
+	EXPECT_FALSE(std::filesystem::exists(std::filesystem::path("test_bstorage_storage.bin.tmp")));
+
+	const std::optional<std::tuple<BStorage::Value, uint16_t>> loaded = BStorage::loadStorage(filePath);
+	ASSERT_TRUE(loaded.has_value());
+	EXPECT_EQ(std::get<1>(*loaded), uint16_t(0x0102));
+	EXPECT_TRUE(std::get<0>(*loaded).isSameDeepCompare(document));
+
+	std::filesystem::remove(filePath);
+}
+
+TEST(BStorageStorage, SaveStorage_UnwritableTarget_OldContentKept)
+{
+	using namespace BStorageStorageTestsInternal;
+
+	// a directory can't be replaced by a file
+	const std::filesystem::path directoryPath = "test_bstorage_storage_directory";
+	std::filesystem::create_directories(directoryPath / "child");
+
+	EXPECT_FALSE(BStorage::saveStorage(directoryPath, makeDocument(1), 0));
+	EXPECT_TRUE(std::filesystem::is_directory(directoryPath / "child"));
+	EXPECT_FALSE(std::filesystem::exists(std::filesystem::path("test_bstorage_storage_directory.tmp")));
+
+	std::filesystem::remove_all(directoryPath);
+}
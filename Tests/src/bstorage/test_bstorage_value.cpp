@@ -1,8 +1,13 @@
 // Copyright (C) Pavel Grebnev 2026
 // Distributed under the MIT License (license terms are at http://opensource.org/licenses/MIT).
 
+#include <algorithm>
 #include <array>
+#include <sstream>
 #include <streambuf>
+#include <string>
+#include <string_view>
+#include <vector>
 
 #include <gtest/gtest.h>
 
@@ -415,7 +420,7 @@ TEST(BStorageValue, bytearray_test)
 	EXPECT_EQ(v.asU64(), nullptr);
 	EXPECT_EQ(v.asString(), nullptr);
 	ASSERT_NE(v.asByteArray(), nullptr);
-	EXPECT_EQ(*v.asByteArray(), bytes);
+	EXPECT_TRUE(std::ranges::equal(*v.asByteArray(), bytes));
 	EXPECT_EQ(v.asOption(), nullptr);
 	EXPECT_EQ(v.asArray(), nullptr);
 	EXPECT_EQ(v.asObject(), nullptr);
@@ -442,7 +447,7 @@ TEST(BStorageValue, bytearray_const_test)
 	EXPECT_EQ(v.asU64(), nullptr);
 	EXPECT_EQ(v.asString(), nullptr);
 	ASSERT_NE(v.asByteArray(), nullptr);
-	EXPECT_EQ(*v.asByteArray(), bytes);
+	EXPECT_TRUE(std::ranges::equal(*v.asByteArray(), bytes));
 	EXPECT_EQ(v.asOption(), nullptr);
 	EXPECT_EQ(v.asArray(), nullptr);
 	EXPECT_EQ(v.asObject(), nullptr);
@@ -456,7 +461,7 @@ TEST(BStorageValue, bytearray_construct_from_span_test)
 
 	ASSERT_TRUE(v.isA(BStorage::Tag::ByteArray));
 	ASSERT_NE(v.asByteArray(), nullptr);
-	EXPECT_EQ((*v.asByteArray()), (std::vector<std::byte>{ std::byte(0xAA), std::byte(0xBB), std::byte(0xCC) }));
+	EXPECT_TRUE(std::ranges::equal(*v.asByteArray(), (std::vector<std::byte>{ std::byte(0xAA), std::byte(0xBB), std::byte(0xCC) })));
 }
 
 TEST(BStorageValue, bytearray_move_construct_test)
@@ -467,7 +472,7 @@ TEST(BStorageValue, bytearray_move_construct_test)
 
 	ASSERT_TRUE(v.isA(BStorage::Tag::ByteArray));
 	ASSERT_NE(v.asByteArray(), nullptr);
-	EXPECT_EQ((*v.asByteArray()), (std::vector<std::byte>{ std::byte(0xAA), std::byte(0xBB), std::byte(0xCC) }));
+	EXPECT_TRUE(std::ranges::equal(*v.asByteArray(), (std::vector<std::byte>{ std::byte(0xAA), std::byte(0xBB), std::byte(0xCC) })));
 }
 
 TEST(BStorageValue, bytearray_copy_test)
@@ -479,10 +484,10 @@ TEST(BStorageValue, bytearray_copy_test)
 
 	ASSERT_TRUE(v1.isA(BStorage::Tag::ByteArray));
 	ASSERT_NE(v1.asByteArray(), nullptr);
-	EXPECT_EQ(*v1.asByteArray(), bytes);
+	EXPECT_TRUE(std::ranges::equal(*v1.asByteArray(), bytes));
 	ASSERT_TRUE(v2.isA(BStorage::Tag::ByteArray));
 	ASSERT_NE(v2.asByteArray(), nullptr);
-	EXPECT_EQ(*v2.asByteArray(), bytes);
+	EXPECT_TRUE(std::ranges::equal(*v2.asByteArray(), bytes));
 }
 
 TEST(BStorageValue, bytearray_move_test)
@@ -494,12 +499,12 @@ TEST(BStorageValue, bytearray_move_test)
 
 	ASSERT_TRUE(v2.isA(BStorage::Tag::ByteArray));
 	ASSERT_NE(v2.asByteArray(), nullptr);
-	EXPECT_EQ(*v2.asByteArray(), bytes);
+	EXPECT_TRUE(std::ranges::equal(*v2.asByteArray(), bytes));
 }
 
 TEST(BStorageValue, option_test)
 {
-	auto inner = std::make_unique<BStorage::Value>(BStorage::Value::makeU32(42));
+	BStorage::Value inner = BStorage::Value::makeU32(42);
 
 	BStorage::Value v = BStorage::Value::makeOption(std::move(inner));
 
@@ -529,7 +534,7 @@ TEST(BStorageValue, option_test)
 
 TEST(BStorageValue, option_const_test)
 {
-	auto inner = std::make_unique<BStorage::Value>(BStorage::Value::makeU32(42));
+	BStorage::Value inner = BStorage::Value::makeU32(42);
 
 	const BStorage::Value v = BStorage::Value::makeOption(std::move(inner));
 
@@ -559,7 +564,7 @@ TEST(BStorageValue, option_const_test)
 
 TEST(BStorageValue, option_null_test)
 {
-	BStorage::Value v = BStorage::Value::makeOption(nullptr);
+	BStorage::Value v = BStorage::Value::makeEmptyOption();
 
 	ASSERT_TRUE(v.isA(BStorage::Tag::Option));
 	ASSERT_NE(v.asOption(), nullptr);
@@ -568,7 +573,7 @@ TEST(BStorageValue, option_null_test)
 
 TEST(BStorageValue, option_copy_test)
 {
-	auto inner = std::make_unique<BStorage::Value>(BStorage::Value::makeU32(42));
+	BStorage::Value inner = BStorage::Value::makeU32(42);
 	BStorage::Value v1 = BStorage::Value::makeOption(std::move(inner));
 
 	BStorage::Value v2(v1.deepCopy());
@@ -587,7 +592,7 @@ TEST(BStorageValue, option_copy_test)
 
 TEST(BStorageValue, option_copy_test_null)
 {
-	BStorage::Value v1 = BStorage::Value::makeOption(nullptr);
+	BStorage::Value v1 = BStorage::Value::makeEmptyOption();
 
 	BStorage::Value v2(v1.deepCopy());
 
@@ -601,7 +606,7 @@ TEST(BStorageValue, option_copy_test_null)
 
 TEST(BStorageValue, option_move_test)
 {
-	auto inner = std::make_unique<BStorage::Value>(BStorage::Value::makeU32(42));
+	BStorage::Value inner = BStorage::Value::makeU32(42);
 	BStorage::Value v1 = BStorage::Value::makeOption(std::move(inner));
 
 	BStorage::Value v2(std::move(v1));
@@ -614,7 +619,7 @@ TEST(BStorageValue, option_move_test)
 
 TEST(BStorageValue, option_move_test_null)
 {
-	BStorage::Value v1 = BStorage::Value::makeOption(nullptr);
+	BStorage::Value v1 = BStorage::Value::makeEmptyOption();
 
 	BStorage::Value v2(std::move(v1));
 
@@ -625,7 +630,7 @@ TEST(BStorageValue, option_move_test_null)
 
 TEST(BStorageValue, array_test)
 {
-	std::vector<BStorage::Value> elems;
+	BStorage::Value::ArrayType elems;
 	elems.push_back(BStorage::Value::makeU8(1));
 	elems.push_back(BStorage::Value::makeU8(2));
 
@@ -658,7 +663,7 @@ TEST(BStorageValue, array_test)
 
 TEST(BStorageValue, array_const_test)
 {
-	std::vector<BStorage::Value> elems;
+	BStorage::Value::ArrayType elems;
 	elems.push_back(BStorage::Value::makeU8(1));
 	elems.push_back(BStorage::Value::makeU8(2));
 
@@ -689,7 +694,7 @@ TEST(BStorageValue, array_const_test)
 
 TEST(BStorageValue, array_different_types)
 {
-	std::vector<BStorage::Value> elems;
+	BStorage::Value::ArrayType elems;
 	elems.push_back(BStorage::Value::makeU8(1));
 	elems.push_back(BStorage::Value::makeU16(2000));
 
@@ -706,7 +711,7 @@ TEST(BStorageValue, array_different_types)
 
 TEST(BStorageValue, array_empty_test)
 {
-	BStorage::Value v = BStorage::Value::makeArray(std::vector<BStorage::Value>{});
+	BStorage::Value v = BStorage::Value::makeArray(BStorage::Value::ArrayType{});
 
 	ASSERT_TRUE(v.isA(BStorage::Tag::Array));
 	ASSERT_NE(v.asArray(), nullptr);
@@ -715,7 +720,7 @@ TEST(BStorageValue, array_empty_test)
 
 TEST(BStorageValue, array_copy_test)
 {
-	std::vector<BStorage::Value> elems;
+	BStorage::Value::ArrayType elems;
 	elems.push_back(BStorage::Value::makeU8(5));
 	BStorage::Value v1 = BStorage::Value::makeArray(std::move(elems));
 
@@ -732,7 +737,7 @@ TEST(BStorageValue, array_copy_test)
 
 TEST(BStorageValue, array_move_test)
 {
-	std::vector<BStorage::Value> elems;
+	BStorage::Value::ArrayType elems;
 	elems.push_back(BStorage::Value::makeU8(5));
 	BStorage::Value v1 = BStorage::Value::makeArray(std::move(elems));
 
@@ -744,6 +749,23 @@ TEST(BStorageValue, array_move_test)
 	EXPECT_EQ(*(*v2.asArray())[0].asU8(), static_cast<uint8_t>(5));
 }
 
+TEST(BStorageValue, array_move_assign_own_element_test)
+{
+	BStorage::Value::ArrayType innerElems;
+	innerElems.push_back(BStorage::Value::makeU8(5));
+	innerElems.push_back(BStorage::Value::makeU8(6));
+	BStorage::Value::ArrayType elems;
+	elems.push_back(BStorage::Value::makeArray(std::move(innerElems)));
+	BStorage::Value v = BStorage::Value::makeArray(std::move(elems));
+
+	v = std::move((*v.asArray())[0]);
+
+	ASSERT_TRUE(v.isA(BStorage::Tag::Array));
+	ASSERT_NE(v.asArray(), nullptr);
+	ASSERT_EQ(v.asArray()->size(), 2u);
+	EXPECT_EQ(*(*v.asArray())[1].asU8(), static_cast<uint8_t>(6));
+}
+
 TEST(BStorageValue, object_test)
 {
 	BStorage::Value::ObjectMap map;
@@ -844,6 +866,22 @@ TEST(BStorageValue, object_move_test)
 	EXPECT_EQ(*v2.asObject()->at("k").asU8(), static_cast<uint8_t>(9));
 }
 
+TEST(BStorageValue, object_move_assign_own_field_test)
+{
+	BStorage::Value::ObjectMap innerMap;
+	innerMap.emplace("inner", BStorage::Value::makeString(std::string_view("text")));
+	BStorage::Value::ObjectMap map;
+	map.emplace("k", BStorage::Value::makeObject(std::move(innerMap)));
+	BStorage::Value v = BStorage::Value::makeObject(std::move(map));
+
+	v = std::move(v.asObject()->at("k"));
+
+	ASSERT_TRUE(v.isA(BStorage::Tag::Object));
+	ASSERT_NE(v.asObject(), nullptr);
+	ASSERT_EQ(v.asObject()->size(), 1u);
+	EXPECT_EQ(*v.asObject()->at("inner").asString(), "text");
+}
+
 class VecStreamBuf : public std::streambuf
 {
 public:
@@ -862,22 +900,22 @@ public:
 
 TEST(BStorageValue, serialization_test)
 {
-	std::vector<BStorage::Value> array1;
+	BStorage::Value::ArrayType array1;
 	array1.reserve(4);
 	array1.push_back(BStorage::Value::makeByteArray(std::vector<std::byte>({ std::byte(0x10), std::byte(0x20), std::byte(0x30) })));
 	array1.push_back(BStorage::Value::makeU16(0x4567));
-	array1.push_back(BStorage::Value::makeOption(nullptr));
-	array1.push_back(BStorage::Value::makeOption(std::make_unique<BStorage::Value>(BStorage::Value::makeString(std::string_view("test")))));
+	array1.push_back(BStorage::Value::makeEmptyOption());
+	array1.push_back(BStorage::Value::makeOption(BStorage::Value::makeString(std::string_view("test"))));
 
-	std::vector<BStorage::Value> array2;
+	BStorage::Value::ArrayType array2;
 	array1.reserve(2);
 	array1.push_back(BStorage::Value::makeU16(0x6789));
 	array1.push_back(BStorage::Value::makeU16(0x1234));
 
-	std::vector<BStorage::Value> array3;
+	BStorage::Value::ArrayType array3;
 	array1.reserve(2);
-	array1.push_back(BStorage::Value::makeOption(nullptr));
-	array1.push_back(BStorage::Value::makeOption(std::make_unique<BStorage::Value>(BStorage::Value::makeU8(0xFF))));
+	array1.push_back(BStorage::Value::makeEmptyOption());
+	array1.push_back(BStorage::Value::makeOption(BStorage::Value::makeU8(0xFF)));
 
 	BStorage::Value::ObjectMap outherObject;
 	outherObject.emplace("k1", BStorage::Value::makeArray(std::move(array1)));
@@ -898,3 +936,51 @@ TEST(BStorageValue, serialization_test)
 	ASSERT_TRUE(result.has_value());
 	EXPECT_TRUE(initial.isSameDeepCompare(*result));
 }
+
+TEST(BStorageValue, object_unsorted_insertion_test)
+{
+	BStorage::Value::ObjectMap map;
+	EXPECT_TRUE(map.emplace("c", BStorage::Value::makeU8(3)).second);
+	EXPECT_TRUE(map.emplace("a", BStorage::Value::makeU8(1)).second);
+	EXPECT_TRUE(map.emplace("b", BStorage::Value::makeU8(2)).second);
+	// existing value is kept
+	EXPECT_FALSE(map.emplace("a", BStorage::Value::makeU8(10)).second);
+
+	ASSERT_EQ(map.size(), 3u);
+	EXPECT_TRUE(map.contains("b"));
+	EXPECT_FALSE(map.contains("d"));
+	EXPECT_EQ(*map.at("a").asU8(), static_cast<uint8_t>(1));
+
+	std::string keys;
+	for (const auto& [key, value] : map)
+	{
+		keys += key;
+	}
+	EXPECT_EQ(keys, "abc");
+}
+
+TEST(BStorageValue, arena_serialization_and_copy_test)
+{
+	BStorage::Arena arena;
+
+	BStorage::Value::ArrayType array(arena.getResource());
+	array.push_back(BStorage::Value::makeString(std::string_view("arena string"), arena.getResource()));
+	array.push_back(BStorage::Value::makeOption(BStorage::Value::makeU16(0x1234), arena.getResource()));
+	BStorage::Value::ObjectMap object(arena.getResource());
+	object.emplace("array", BStorage::Value::makeArray(std::move(array)));
+	object.emplace("bytes", BStorage::Value::makeByteArray(std::vector<std::byte>(100, std::byte(0x42)), arena.getResource()));
+	const BStorage::Value initial = BStorage::Value::makeObject(std::move(object));
+
+	std::stringstream stream;
+	ASSERT_TRUE(initial.writeToStream(stream));
+	const std::optional<BStorage::Value> result = BStorage::Value::readFromStream(stream, std::nullopt, arena.getResource());
+	ASSERT_TRUE(result.has_value());
+	EXPECT_TRUE(initial.isSameDeepCompare(*result));
+	EXPECT_EQ(result->asObject()->getResource(), arena.getResource());
+
+	// a copy that outlives the arena should use the default resource
+	const BStorage::Value copy = result->deepCopy();
+	EXPECT_TRUE(copy.isSameDeepCompare(initial));
+	EXPECT_EQ(copy.asObject()->getResource(), std::pmr::get_default_resource());
+	EXPECT_EQ(copy.asObject()->at("bytes").asByteArray()->get_allocator().resource(), std::pmr::get_default_resource());
+}
@@ -0,0 +1,158 @@
+// Copyright (C) Pavel Grebnev 2026
+// Distributed under the MIT License (license terms are at http://opensource.org/licenses/MIT).
+
+#include <filesystem>
+#include <format>
+#include <sstream>
+
+#include <gtest/gtest.h>
+
+#include "common_shared/bstorage/storage.h"
+#include "common_shared/bstorage/value_view.h"
+
+namespace BStorageValueViewTestsInternal
+{
+	static std::vector<std::byte> serialize(const BStorage::Value& value)
+	{
+		std::ostringstream stream;
+		EXPECT_TRUE(value.writeToStream(stream));
+		const std::string data = stream.str();
+		const std::span<const std::byte> bytes = std::as_bytes(std::span(data));
+		return std::vector<std::byte>(bytes.begin(), bytes.end());
+	}
+
+	static BStorage::Value makeRecord(const size_t index)
+	{
+		BStorage::Value::ObjectMap record;
+		record.emplace("name", BStorage::Value::makeString(std::format("record_{}", index)));
+		record.emplace("index", BStorage::Value::makeU64(index));
+		record.emplace("key", BStorage::Value::makeByteArray(std::vector<std::byte>(32, static_cast<std::byte>(index))));
+		return BStorage::Value::makeObject(std::move(record));
+	}
+
+	static BStorage::Value makeDocument()
+	{
+		BStorage::Value::ArrayType mixedArray;
+		mixedArray.push_back(BStorage::Value::makeByteArray(std::vector<std::byte>({ std::byte(0x10), std::byte(0x20), std::byte(0x30) })));
+		mixedArray.push_back(BStorage::Value::makeU16(0x4567));
+		mixedArray.push_back(BStorage::Value::makeEmptyOption());
+		mixedArray.push_back(BStorage::Value::makeOption(BStorage::Value::makeString(std::string_view("test"))));
+
+		BStorage::Value::ArrayType numbers;
+		numbers.push_back(BStorage::Value::makeU32(0x01234567));
+		numbers.push_back(BStorage::Value::makeU32(0x89ABCDEF));
+
+		BStorage::Value::ArrayType records;
+		for (size_t i = 0; i < 200; ++i)
+		{
+			records.push_back(makeRecord(i));
+		}
+
+		BStorage::Value::ObjectMap document;
+		document.emplace("mixed", BStorage::Value::makeArray(std::move(mixedArray)));
+		document.emplace("numbers", BStorage::Value::makeArray(std::move(numbers)));
+		document.emplace("records", BStorage::Value::makeArray(std::move(records)));
+		document.emplace("empty", BStorage::Value::makeArray({}));
+		document.emplace("u8", BStorage::Value::makeU8(0xFE));
+		// sizes that need two and four bytes
+		document.emplace("medium", BStorage::Value::makeString(std::string(300, 'm')));
+		document.emplace("large", BStorage::Value::makeByteArray(std::vector<std::byte>(20000, std::byte(0x5A))));
+		return BStorage::Value::makeObject(std::move(document));
+	}
+} // namespace BStorageValueViewTestsInternal
+
+TEST(BStorageValueView, Parse_SerializedDocument_SameAsValue)
+{
+	using namespace BStorageValueViewTestsInternal;
+
+	const BStorage::Value document = makeDocument();
+	const std::vector<std::byte> data = serialize(document);
+
+	const std::optional<BStorage::ValueView> view = BStorage::ValueView::parse(data);
+	ASSERT_TRUE(view.has_value());
+	EXPECT_TRUE(view->toValue().isSameDeepCompare(document));
+
+	const std::optional<BStorage::ValueView::ObjectRange> object = view->asObject();
+	ASSERT_TRUE(object.has_value());
+	EXPECT_EQ(object->size(), size_t(7));
+	EXPECT_FALSE(object->find("missing").has_value());
+	EXPECT_EQ(object->find("u8")->asU8(), uint8_t(0xFE));
+	EXPECT_EQ(object->find("u8")->asU16(), std::nullopt);
+	EXPECT_EQ(object->find("medium")->asString()->size(), size_t(300));
+	EXPECT_EQ(object->find("large")->asByteArray()->size(), size_t(20000));
+	EXPECT_TRUE(object->find("empty")->asArray()->empty());
+
+	const std::optional<BStorage::ValueView::ArrayRange> numbers = object->find("numbers")->asArray();
+	ASSERT_TRUE(numbers.has_value());
+	ASSERT_EQ(numbers->size(), size_t(2));
+	EXPECT_EQ((*numbers->begin()).asU32(), uint32_t(0x01234567));
+	EXPECT_EQ((*++numbers->begin()).asU32(), uint32_t(0x89ABCDEF));
+
+	const std::optional<BStorage::ValueView::ArrayRange> mixed = object->find("mixed")->asArray();
+	ASSERT_TRUE(mixed.has_value());
+	std::vector<BStorage::ValueView> mixedElements(mixed->begin(), mixed->end());
+	ASSERT_EQ(mixedElements.size(), size_t(4));
+	EXPECT_EQ(mixedElements[1].asU16(), uint16_t(0x4567));
+	EXPECT_TRUE(mixedElements[2].isA(BStorage::Tag::Option));
+	EXPECT_FALSE(mixedElements[2].asOptionValue().has_value());
+	EXPECT_EQ(mixedElements[3].asOptionValue()->asString(), "test");
+
+	const std::optional<BStorage::ValueView::ArrayRange> records = object->find("records")->asArray();
+	ASSERT_TRUE(records.has_value());
+	size_t recordIndex = 0;
+	for (const BStorage::ValueView record : *records)
+	{
+		const std::optional<BStorage::ValueView::ObjectRange> fields = record.asObject();
+		ASSERT_TRUE(fields.has_value());
+		EXPECT_EQ(fields->find("name")->asString(), std::format("record_{}", recordIndex));
+		EXPECT_EQ(fields->find("index")->asU64(), recordIndex);
+		EXPECT_EQ(fields->find("key")->asByteArray()->front(), static_cast<std::byte>(recordIndex));
+		++recordIndex;
+	}
+	EXPECT_EQ(recordIndex, size_t(200));
+}
+
+TEST(BStorageValueView, Parse_TruncatedOrExtraData_Rejected)
+{
+	using namespace BStorageValueViewTestsInternal;
+
+	std::vector<std::byte> data = serialize(makeDocument());
+
+	for (size_t size = 0; size < data.size(); ++size)
+	{
+		EXPECT_FALSE(BStorage::ValueView::parse(std::span(data.data(), size)).has_value()) << size;
+	}
+
+	data.push_back(std::byte(0));
+	EXPECT_FALSE(BStorage::ValueView::parse(data).has_value());
+}
+
+TEST(BStorageValueView, Parse_TooDeepNesting_Rejected)
+{
+	std::vector<std::byte> data;
+	// set options nested into each other
+	data.resize(1000, std::byte(0x12));
+	data.push_back(std::byte(0x10));
+	data.push_back(std::byte(0x01));
+
+	EXPECT_FALSE(BStorage::ValueView::parse(data).has_value());
+}
+
+TEST(BStorageValueView, LoadStorageView_SavedStorage_SameVersionAndData)
+{
+	using namespace BStorageValueViewTestsInternal;
+
+	const std::filesystem::path filePath = "test_bstorage_value_view.bin";
+	const BStorage::Value document = makeDocument();
+	ASSERT_TRUE(BStorage::saveStorage(filePath, document, 0x1234));
+
+	{
+		const std::optional<BStorage::StorageView> storage = BStorage::loadStorageView(filePath);
+		ASSERT_TRUE(storage.has_value());
+		EXPECT_EQ(storage->getVersion(), uint16_t(0x1234));
+		EXPECT_TRUE(storage->getRoot().toValue().isSameDeepCompare(document));
+	}
+
+	std::filesystem::remove(filePath);
+	EXPECT_FALSE(BStorage::loadStorageView(filePath).has_value());
+}
@@ -40,3 +40,41 @@ TEST(CryptographyNoiseKKHandshake, roundtripTest)
 	EXPECT_EQ(std::get<HandshakeResult>(result1).sendingCipherState.cipherKey.raw, std::get<HandshakeResult>(result2).receivingCipherState.cipherKey.raw);
 	EXPECT_EQ(std::get<HandshakeResult>(result1).sendingCipherState.nonce, std::get<HandshakeResult>(result2).receivingCipherState.nonce);
 }
+
+TEST(CryptographyNoiseKKHandshake, precomputedStaticStaticDh_sameResultAsComputingItDuringHandshake)
+{
+	using namespace Noise::NoiseKK;
+
+	Keypair initiatorStaticKeys = generateKeypair_x25519();
+	Keypair responderStaticKeys = generateKeypair_x25519();
+
+	const DhResult initiatorStaticStaticDh = computeStaticStaticDh(initiatorStaticKeys, responderStaticKeys.publicKey);
+	const DhResult responderStaticStaticDh = computeStaticStaticDh(responderStaticKeys, initiatorStaticKeys.publicKey);
+	EXPECT_EQ(initiatorStaticStaticDh.raw, responderStaticStaticDh.raw);
+
+	// the initiator uses the precomputed value and the responder computes it during the handshake
+	Noise::InitiatorHandshakeState initiatorHandshakeState = initializeInitiator(initiatorStaticKeys, responderStaticKeys.publicKey, initiatorStaticStaticDh);
+	Noise::ResponderHandshakeState responderHandshakeState = initializeResponder(responderStaticKeys, initiatorStaticKeys.publicKey);
+
+	std::array<std::byte, DHLEN> messageBuffer = {};
+	size_t initiatorCursor = 0;
+	EXPECT_EQ(appendHandshakeMessage1(initiatorHandshakeState, messageBuffer, initiatorCursor), std::nullopt);
+
+	size_t receiverCursor = 0;
+	EXPECT_EQ(processHandshakeMessage1(responderHandshakeState, messageBuffer, receiverCursor), std::nullopt);
+
+	EXPECT_EQ(initiatorHandshakeState.symmetricState.chainingKey.raw, responderHandshakeState.symmetricState.chainingKey.raw);
+	EXPECT_EQ(initiatorHandshakeState.symmetricState.handshakeHash.raw, responderHandshakeState.symmetricState.handshakeHash.raw);
+
+	receiverCursor = 0;
+	const auto result1 = appendHandshakeMessage2(std::move(responderHandshakeState), messageBuffer, receiverCursor);
+
+	initiatorCursor = 0;
+	const auto result2 = processHandshakeMessage2(std::move(initiatorHandshakeState), messageBuffer, initiatorCursor);
+
+	ASSERT_TRUE(std::holds_alternative<HandshakeResult>(result1));
+	ASSERT_TRUE(std::holds_alternative<HandshakeResult>(result2));
+
+	EXPECT_EQ(std::get<HandshakeResult>(result1).receivingCipherState.cipherKey.raw, std::get<HandshakeResult>(result2).sendingCipherState.cipherKey.raw);
+	EXPECT_EQ(std::get<HandshakeResult>(result1).sendingCipherState.cipherKey.raw, std::get<HandshakeResult>(result2).receivingCipherState.cipherKey.raw);
+}
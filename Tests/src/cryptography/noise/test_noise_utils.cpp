@@ -1,12 +1,15 @@
 // Copyright (C) Pavel Grebnev 2026
 // Distributed under the MIT License (license terms are at http://opensource.org/licenses/MIT).
 
+#include <format>
+
 #include "tests/assert_helper.h"
 #include "tests/helper_utils.h"
 #include <gtest/gtest.h>
 
 #include "common_shared/cryptography/noise/cipher_utils.h"
 #include "common_shared/cryptography/noise/internal/handshake_utils.h"
+#include "common_shared/cryptography/primitives/cipher_functions.h"
 #include "common_shared/cryptography/utils/random.h"
 
 static void testEncryptDecryptWithAd(Noise::CipherStateSending& sending, Noise::CipherStateReceiving& receiving, const std::vector<std::byte>& plaintext, const std::span<const std::byte> associatedData)
@@ -252,6 +255,205 @@ TEST(CryptographyNoiseUtils, rekey_test)
 	EXPECT_EQ(vectorToArray<Cryptography::CipherKeySize>(hexToBytes("ce8e87a7988c3f61a2df61e8dfa91bcbf18b67233a595dc30e26c69a4fdb717d")), cipherState.cipherKey.raw);
 }
 
+TEST(CryptographyNoiseUtils, rekey_sameAsEncryptingZerosWithMaxNonce)
+{
+	Noise::CipherStateSending cipherState;
+	Cryptography::fillWithRandomBytes(cipherState.cipherKey.raw);
+
+	const std::array<std::byte, Cryptography::CipherKeySize> allZeros = {};
+	std::array<std::byte, Cryptography::CipherKeySize + Cryptography::CipherAuthDataSize> ciphertext;
+	ASSERT_EQ(Cryptography::encrypt_chacha20poly1305(cipherState.cipherKey, Cryptography::MaxNonce, {}, allZeros, ciphertext), Cryptography::EncryptResult::Success);
+
+	ASSERT_EQ(Noise::Utils::rekey(cipherState), Cryptography::EncryptResult::Success);
+	EXPECT_TRUE(std::equal(cipherState.cipherKey.raw.begin(), cipherState.cipherKey.raw.end(), ciphertext.begin()));
+}
+
+TEST(CryptographyNoiseUtils, rekey_emptyKey_fails)
+{
+	Noise::CipherStateSending cipherState;
+
+	EXPECT_EQ(Noise::Utils::rekey(cipherState), Cryptography::EncryptResult::IncorrectEncryptionKey);
+}
+
+TEST(CryptographyNoiseUtils, registerTransportMessage_messagesInterval_rekeysEveryNthMessage)
+{
+	Noise::RekeySchedule rekeySchedule{ .policy = { .messagesInterval = 3, .bytesInterval = 0, .timeIntervalMs = 0 } };
+
+	for (size_t i = 0; i < 2; ++i)
+	{
+		EXPECT_FALSE(Noise::Utils::registerTransportMessage(rekeySchedule, 100));
+		EXPECT_FALSE(Noise::Utils::registerTransportMessage(rekeySchedule, 100));
+		EXPECT_TRUE(Noise::Utils::registerTransportMessage(rekeySchedule, 100));
+	}
+}
+
+TEST(CryptographyNoiseUtils, registerTransportMessage_bytesInterval_rekeysWhenBytesLimitReached)
+{
+	Noise::RekeySchedule rekeySchedule{ .policy = { .messagesInterval = 0, .bytesInterval = 250, .timeIntervalMs = 0 } };
+
+	EXPECT_FALSE(Noise::Utils::registerTransportMessage(rekeySchedule, 100));
+	EXPECT_FALSE(Noise::Utils::registerTransportMessage(rekeySchedule, 100));
+	EXPECT_TRUE(Noise::Utils::registerTransportMessage(rekeySchedule, 100));
+	EXPECT_FALSE(Noise::Utils::registerTransportMessage(rekeySchedule, 200));
+	EXPECT_TRUE(Noise::Utils::registerTransportMessage(rekeySchedule, 50));
+}
+
+TEST(CryptographyNoiseUtils, registerTransportMessage_noTriggers_neverRekeys)
+{
+	Noise::RekeySchedule rekeySchedule{ .policy = { .messagesInterval = 0, .bytesInterval = 0, .timeIntervalMs = 0 } };
+
+	for (size_t i = 0; i < 100; ++i)
+	{
+		EXPECT_FALSE(Noise::Utils::registerTransportMessage(rekeySchedule, 1000));
+	}
+}
+
+TEST(CryptographyNoiseUtils, negotiateRekeyPolicy_picksMoreFrequentTriggers)
+{
+	const Noise::RekeyPolicy policy1{ .messagesInterval = 10, .bytesInterval = 0, .timeIntervalMs = 5000 };
+	const Noise::RekeyPolicy policy2{ .messagesInterval = 32, .bytesInterval = 4096, .timeIntervalMs = 0 };
+	const Noise::RekeyPolicy expectedPolicy{ .messagesInterval = 10, .bytesInterval = 4096, .timeIntervalMs = 5000 };
+
+	EXPECT_EQ(Noise::Utils::negotiateRekeyPolicy(policy1, policy2), expectedPolicy);
+	EXPECT_EQ(Noise::Utils::negotiateRekeyPolicy(policy2, policy1), expectedPolicy);
+	EXPECT_EQ(Noise::Utils::negotiateRekeyPolicy(policy1, policy1), policy1);
+}
+
+TEST(CryptographyNoiseUtils, encryptTransportMessagesInplace_rekeySchedule_sameAsEncryptingOneByOne)
+{
+	constexpr size_t MessagesCount = 5;
+	std::array<std::byte, Cryptography::CipherKeySize> randomizedKey = {};
+	Cryptography::fillWithRandomBytes(randomizedKey);
+
+	Noise::CipherStateSending batchSendingState;
+	batchSendingState.cipherKey.raw = randomizedKey;
+	batchSendingState.nonce = static_cast<uint64_t>(0x102);
+	Noise::CipherStateSending sendingState;
+	sendingState.cipherKey.raw = randomizedKey;
+	sendingState.nonce = static_cast<uint64_t>(0x102);
+
+	std::array<std::vector<std::byte>, MessagesCount> batchBuffers;
+	std::array<std::vector<std::byte>, MessagesCount> buffers;
+	for (size_t i = 0; i < MessagesCount; ++i)
+	{
+		batchBuffers[i] = strToBytes(std::format("test text {}", i));
+		batchBuffers[i].resize(batchBuffers[i].size() + Cryptography::CipherAuthDataSize);
+		buffers[i] = batchBuffers[i];
+	}
+
+	// rekey after the second and the fourth message
+	Noise::RekeySchedule rekeySchedule{ .policy = { .messagesInterval = 2, .bytesInterval = 0, .timeIntervalMs = 0 } };
+	const std::array<std::span<std::byte>, MessagesCount> batch = { batchBuffers[0], batchBuffers[1], batchBuffers[2], batchBuffers[3], batchBuffers[4] };
+	ASSERT_EQ(Noise::Utils::encryptTransportMessagesInplace(batchSendingState, batch, rekeySchedule), Cryptography::EncryptResult::Success);
+
+	for (size_t i = 0; i < MessagesCount; ++i)
+	{
+		ASSERT_EQ(Noise::Utils::encryptTransportMessageInplace(sendingState, buffers[i]), Cryptography::EncryptResult::Success);
+		if (i % 2 == 1)
+		{
+			ASSERT_EQ(Noise::Utils::rekey(sendingState), Cryptography::EncryptResult::Success);
+		}
+	}
+
+	EXPECT_EQ(batchBuffers, buffers);
+	EXPECT_EQ(batchSendingState.cipherKey.raw, sendingState.cipherKey.raw);
+	EXPECT_EQ(batchSendingState.nonce, static_cast<uint64_t>(0x107));
+	EXPECT_EQ(sendingState.nonce, static_cast<uint64_t>(0x107));
+	EXPECT_EQ(rekeySchedule.messagesSinceRekey, static_cast<uint64_t>(1));
+}
+
+TEST(CryptographyNoiseUtils, encryptTransportMessagesInplace_decryptTransportMessagesInplace_roundtripTest)
+{
+	std::array<std::byte, Cryptography::CipherKeySize> randomizedKey = {};
+	Cryptography::fillWithRandomBytes(randomizedKey);
+
+	for (const uint64_t messagesInterval : { 0, 1, 2 })
+	{
+		Noise::RekeySchedule sendingRekeySchedule{ .policy = { .messagesInterval = messagesInterval, .bytesInterval = 0, .timeIntervalMs = 0 } };
+		Noise::RekeySchedule receivingRekeySchedule{ .policy = sendingRekeySchedule.policy };
+		Noise::CipherStateSending sendingState;
+		sendingState.cipherKey.raw = randomizedKey;
+		sendingState.nonce = static_cast<uint64_t>(0x102);
+		Noise::CipherStateReceiving receivingState;
+		receivingState.cipherKey.raw = randomizedKey;
+		receivingState.nonce = static_cast<uint64_t>(0x102);
+
+		const std::vector<std::byte> plaintext1 = strToBytes("test text 1");
+		const std::vector<std::byte> plaintext2 = strToBytes("and test text 2");
+
+		std::vector<std::byte> buffer1 = plaintext1;
+		buffer1.resize(plaintext1.size() + Cryptography::CipherAuthDataSize);
+		std::vector<std::byte> buffer2 = plaintext2;
+		buffer2.resize(plaintext2.size() + Cryptography::CipherAuthDataSize);
+		const std::array<std::span<std::byte>, 2> batch = { buffer1, buffer2 };
+
+		ASSERT_EQ(Noise::Utils::encryptTransportMessagesInplace(sendingState, batch, sendingRekeySchedule), Cryptography::EncryptResult::Success);
+		ASSERT_EQ(Noise::Utils::decryptTransportMessagesInplace(receivingState, batch, receivingRekeySchedule), Cryptography::DecryptResult::Success);
+
+		buffer1.resize(plaintext1.size());
+		buffer2.resize(plaintext2.size());
+		EXPECT_EQ(buffer1, plaintext1);
+		EXPECT_EQ(buffer2, plaintext2);
+		EXPECT_EQ(sendingState.nonce, static_cast<uint64_t>(0x104));
+		EXPECT_EQ(receivingState.nonce, static_cast<uint64_t>(0x104));
+		EXPECT_EQ(sendingState.cipherKey.raw, receivingState.cipherKey.raw);
+	}
+}
+
+TEST(CryptographyNoiseUtils, decryptTransportMessagesInplace_corruptedMessage_advancesOnlyForDecryptedMessages)
+{
+	std::array<std::byte, Cryptography::CipherKeySize> randomizedKey = {};
+	Cryptography::fillWithRandomBytes(randomizedKey);
+
+	Noise::CipherStateSending sendingState;
+	sendingState.cipherKey.raw = randomizedKey;
+	Noise::CipherStateReceiving receivingState;
+	receivingState.cipherKey.raw = randomizedKey;
+
+	std::array<std::vector<std::byte>, 3> buffers;
+	for (std::vector<std::byte>& buffer : buffers)
+	{
+		buffer = strToBytes("test text");
+		buffer.resize(buffer.size() + Cryptography::CipherAuthDataSize);
+	}
+	const std::array<std::span<std::byte>, 3> batch = { buffers[0], buffers[1], buffers[2] };
+
+	Noise::RekeySchedule sendingRekeySchedule{ .policy = { .messagesInterval = 0, .bytesInterval = 0, .timeIntervalMs = 0 } };
+	Noise::RekeySchedule receivingRekeySchedule{ .policy = sendingRekeySchedule.policy };
+	ASSERT_EQ(Noise::Utils::encryptTransportMessagesInplace(sendingState, batch, sendingRekeySchedule), Cryptography::EncryptResult::Success);
+	buffers[1][0] ^= std::byte(0x01);
+
+	EXPECT_EQ(Noise::Utils::decryptTransportMessagesInplace(receivingState, batch, receivingRekeySchedule), Cryptography::DecryptResult::AuthDataMismatch);
+	EXPECT_EQ(receivingState.nonce, static_cast<uint64_t>(1));
+}
+
+TEST(CryptographyNoiseUtils, encryptTransportMessagesInplace_exhaustNonceTest)
+{
+	std::array<std::byte, Cryptography::CipherKeySize> randomizedKey = {};
+	Cryptography::fillWithRandomBytes(randomizedKey);
+
+	Noise::CipherStateSending sendingState;
+	sendingState.cipherKey.raw = randomizedKey;
+	sendingState.nonce = static_cast<uint64_t>(0xFFFFFFFFFFFFFFFD);
+
+	std::array<std::vector<std::byte>, 3> buffers;
+	for (std::vector<std::byte>& buffer : buffers)
+	{
+		buffer = strToBytes("test text");
+		buffer.resize(buffer.size() + Cryptography::CipherAuthDataSize);
+	}
+	const std::array<std::span<std::byte>, 3> batch = { buffers[0], buffers[1], buffers[2] };
+	Noise::RekeySchedule rekeySchedule{ .policy = { .messagesInterval = 0, .bytesInterval = 0, .timeIntervalMs = 0 } };
+
+	ASSERT_EQ(Noise::Utils::encryptTransportMessagesInplace(sendingState, batch, rekeySchedule), Cryptography::EncryptResult::NonceExhausted);
+	EXPECT_EQ(sendingState.nonce, static_cast<uint64_t>(0xFFFFFFFFFFFFFFFD));
+	EXPECT_EQ(buffers[0], buffers[2]);
+
+	ASSERT_EQ(Noise::Utils::encryptTransportMessagesInplace(sendingState, std::span(batch.data(), 2), rekeySchedule), Cryptography::EncryptResult::Success);
+	EXPECT_EQ(sendingState.nonce, Cryptography::MaxNonce);
+}
+
+
 TEST(CryptographyNoiseUtils, initializeSymmetric_test)
 {
 	// the results are taken from the reference Rust implementation generated by noiseexplorer.com
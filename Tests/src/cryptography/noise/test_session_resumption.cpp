@@ -0,0 +1,171 @@
+// Copyright (C) Pavel Grebnev 2026
+// Distributed under the MIT License (license terms are at http://opensource.org/licenses/MIT).
+
+#include <gtest/gtest.h>
+
+#include "common_shared/cryptography/noise/noise_kk_handshake.h"
+#include "common_shared/cryptography/noise/session_resumption.h"
+#include "common_shared/cryptography/primitives/dh_functions.h"
+#include "common_shared/cryptography/utils/random.h"
+
+namespace SessionResumptionTestsInternal
+{
+	static Noise::CipherKey makeRandomTicketKey()
+	{
+		Noise::CipherKey key;
+		Cryptography::fillWithRandomBytes(key.raw);
+		return key;
+	}
+
+	static Noise::Resumption::TicketContent makeTicketContent(const uint64_t expirationTime)
+	{
+		Noise::Resumption::TicketContent content;
+		Cryptography::fillWithRandomBytes(content.connectionId.raw);
+		Cryptography::fillWithRandomBytes(content.resumptionSecret.raw);
+		content.expirationTime = expirationTime;
+		return content;
+	}
+} // namespace SessionResumptionTestsInternal
+
+TEST(CryptographyNoiseSessionResumption, sealTicketAndOpen_sameContent)
+{
+	using namespace Noise::Resumption;
+	using namespace SessionResumptionTestsInternal;
+
+	const Noise::CipherKey ticketKey = makeRandomTicketKey();
+	const TicketContent content = makeTicketContent(1000);
+
+	Ticket ticket;
+	ASSERT_EQ(sealTicket(ticketKey, 42, content, ticket), Cryptography::EncryptResult::Success);
+	EXPECT_EQ(getTicketNonce(ticket), Cryptography::Nonce(42));
+
+	const std::optional<TicketContent> openedContent = openTicket(ticketKey, ticket, 999);
+	ASSERT_TRUE(openedContent.has_value());
+	EXPECT_EQ(openedContent->connectionId.raw, content.connectionId.raw);
+	EXPECT_EQ(openedContent->resumptionSecret.raw, content.resumptionSecret.raw);
+	EXPECT_EQ(openedContent->expirationTime, content.expirationTime);
+}
+
+TEST(CryptographyNoiseSessionResumption, openTicket_tamperedTicket_rejected)
+{
+	using namespace Noise::Resumption;
+	using namespace SessionResumptionTestsInternal;
+
+	const Noise::CipherKey ticketKey = makeRandomTicketKey();
+
+	Ticket ticket;
+	ASSERT_EQ(sealTicket(ticketKey, 1, makeTicketContent(1000), ticket), Cryptography::EncryptResult::Success);
+
+	for (const size_t position : { size_t(0), sizeof(Cryptography::Nonce), TicketSize - 1 })
+	{
+		Ticket tamperedTicket = ticket;
+		tamperedTicket[position] ^= std::byte(0x01);
+		EXPECT_FALSE(openTicket(ticketKey, tamperedTicket, 0).has_value()) << position;
+	}
+
+	EXPECT_FALSE(openTicket(ticketKey, std::span(ticket.data(), TicketSize - 1), 0).has_value());
+}
+
+TEST(CryptographyNoiseSessionResumption, openTicket_differentKey_rejected)
+{
+	using namespace Noise::Resumption;
+	using namespace SessionResumptionTestsInternal;
+
+	Ticket ticket;
+	ASSERT_EQ(sealTicket(makeRandomTicketKey(), 1, makeTicketContent(1000), ticket), Cryptography::EncryptResult::Success);
+
+	EXPECT_FALSE(openTicket(makeRandomTicketKey(), ticket, 0).has_value());
+}
+
+TEST(CryptographyNoiseSessionResumption, openTicket_expiredTicket_rejected)
+{
+	using namespace Noise::Resumption;
+	using namespace SessionResumptionTestsInternal;
+
+	const Noise::CipherKey ticketKey = makeRandomTicketKey();
+
+	Ticket ticket;
+	ASSERT_EQ(sealTicket(ticketKey, 1, makeTicketContent(1000), ticket), Cryptography::EncryptResult::Success);
+
+	EXPECT_FALSE(openTicket(ticketKey, ticket, 1000).has_value());
+	EXPECT_FALSE(openTicket(ticketKey, ticket, 5000).has_value());
+}
+
+TEST(CryptographyNoiseSessionResumption, deriveResumedSession_bothRoles_matchingKeys)
+{
+	using namespace Noise::Resumption;
+
+	Noise::HashResult resumptionSecret;
+	Cryptography::fillWithRandomBytes(resumptionSecret.raw);
+	std::array<std::byte, 64> clientMessage;
+	Cryptography::fillWithRandomBytes(clientMessage);
+	RandomNonce serverNonce;
+	Cryptography::fillWithRandomBytes(serverNonce);
+
+	const ResumedSession clientSession = deriveResumedSession(resumptionSecret, clientMessage, serverNonce, SessionRole::Client);
+	const ResumedSession serverSession = deriveResumedSession(resumptionSecret, clientMessage, serverNonce, SessionRole::Server);
+
+	EXPECT_EQ(clientSession.sendingCipherState.cipherKey.raw, serverSession.receivingCipherState.cipherKey.raw);
+	EXPECT_EQ(clientSession.receivingCipherState.cipherKey.raw, serverSession.sendingCipherState.cipherKey.raw);
+	EXPECT_NE(clientSession.sendingCipherState.cipherKey.raw, clientSession.receivingCipherState.cipherKey.raw);
+	EXPECT_EQ(clientSession.nextResumptionSecret.raw, serverSession.nextResumptionSecret.raw);
+	EXPECT_NE(clientSession.nextResumptionSecret.raw, resumptionSecret.raw);
+}
+
+TEST(CryptographyNoiseSessionResumption, deriveResumedSession_differentInputs_differentKeys)
+{
+	using namespace Noise::Resumption;
+
+	Noise::HashResult resumptionSecret;
+	Cryptography::fillWithRandomBytes(resumptionSecret.raw);
+	std::array<std::byte, 64> clientMessage;
+	Cryptography::fillWithRandomBytes(clientMessage);
+	RandomNonce serverNonce;
+	Cryptography::fillWithRandomBytes(serverNonce);
+
+	const ResumedSession originalSession = deriveResumedSession(resumptionSecret, clientMessage, serverNonce, SessionRole::Client);
+
+	RandomNonce otherServerNonce = serverNonce;
+	otherServerNonce[0] ^= std::byte(0x01);
+	const ResumedSession otherNonceSession = deriveResumedSession(resumptionSecret, clientMessage, otherServerNonce, SessionRole::Server);
+	EXPECT_NE(originalSession.sendingCipherState.cipherKey.raw, otherNonceSession.receivingCipherState.cipherKey.raw);
+
+	std::array<std::byte, 64> modifiedClientMessage = clientMessage;
+	modifiedClientMessage[63] ^= std::byte(0x01);
+	const ResumedSession modifiedMessageSession = deriveResumedSession(resumptionSecret, modifiedClientMessage, serverNonce, SessionRole::Server);
+	EXPECT_NE(originalSession.sendingCipherState.cipherKey.raw, modifiedMessageSession.receivingCipherState.cipherKey.raw);
+}
+
+TEST(CryptographyNoiseSessionResumption, kkHandshake_bothSides_sameResumptionSecret)
+{
+	using namespace Noise::NoiseKK;
+
+	Keypair initiatorStaticKeys = generateKeypair_x25519();
+	Keypair responderStaticKeys = generateKeypair_x25519();
+
+	Noise::InitiatorHandshakeState initiatorHandshakeState = initializeInitiator(initiatorStaticKeys, responderStaticKeys.publicKey);
+	Noise::ResponderHandshakeState responderHandshakeState = initializeResponder(responderStaticKeys, initiatorStaticKeys.publicKey);
+
+	std::array<std::byte, DHLEN> messageBuffer = {};
+	size_t initiatorCursor = 0;
+	EXPECT_EQ(appendHandshakeMessage1(initiatorHandshakeState, messageBuffer, initiatorCursor), std::nullopt);
+
+	size_t receiverCursor = 0;
+	EXPECT_EQ(processHandshakeMessage1(responderHandshakeState, messageBuffer, receiverCursor), std::nullopt);
+
+	receiverCursor = 0;
+	const auto result1 = appendHandshakeMessage2(std::move(responderHandshakeState), messageBuffer, receiverCursor);
+
+	initiatorCursor = 0;
+	const auto result2 = processHandshakeMessage2(std::move(initiatorHandshakeState), messageBuffer, initiatorCursor);
+
+	ASSERT_TRUE(std::holds_alternative<HandshakeResult>(result1));
+	ASSERT_TRUE(std::holds_alternative<HandshakeResult>(result2));
+
+	const HandshakeResult& responderResult = std::get<HandshakeResult>(result1);
+	const HandshakeResult& initiatorResult = std::get<HandshakeResult>(result2);
+	EXPECT_EQ(responderResult.resumptionSecret.raw, initiatorResult.resumptionSecret.raw);
+	// the resumption secret should be independent from the transport keys
+	EXPECT_FALSE(std::equal(initiatorResult.resumptionSecret.raw.begin(), initiatorResult.resumptionSecret.raw.begin() + Cryptography::CipherKeySize, initiatorResult.sendingCipherState.cipherKey.raw.begin()));
+	EXPECT_FALSE(std::equal(initiatorResult.resumptionSecret.raw.begin(), initiatorResult.resumptionSecret.raw.begin() + Cryptography::CipherKeySize, initiatorResult.receivingCipherState.cipherKey.raw.begin()));
+}
@@ -0,0 +1,89 @@
+// Copyright (C) Pavel Grebnev 2026
+// Distributed under the MIT License (license terms are at http://opensource.org/licenses/MIT).
+
+#include <chrono>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "common_shared/cryptography/primitives/dh_functions.h"
+#include "common_shared/cryptography/utils/ephemeral_keypair_pool.h"
+
+static void waitForPoolToFill(size_t expectedCount)
+{
+	for (int i = 0; i < 1000 && Cryptography::EphemeralKeypairPool::getAvailableCount() < expectedCount; ++i)
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+}
+
+static bool isPublicKeyMatchingSecretKey(const Cryptography::Keypair& keypair)
+{
+	// both sides get the same DH result only if the public key corresponds to the secret key
+	const Cryptography::Keypair referenceKeypair = Cryptography::generateKeypair_x25519();
+	return Cryptography::diffieHellman_x25519(keypair.secretKey, referenceKeypair.publicKey).raw == Cryptography::diffieHellman_x25519(referenceKeypair.secretKey, keypair.publicKey).raw;
+}
+
+TEST(CryptographyEphemeralKeypairPool, takeKeypair_poolNotStarted_generatesValidKeypair)
+{
+	const Cryptography::Keypair keypair = Cryptography::EphemeralKeypairPool::takeKeypair();
+
+	EXPECT_TRUE(isPublicKeyMatchingSecretKey(keypair));
+	EXPECT_EQ(Cryptography::EphemeralKeypairPool::getAvailableCount(), size_t(0));
+}
+
+TEST(CryptographyEphemeralKeypairPool, start_poolFillsUpToCapacity)
+{
+	Cryptography::EphemeralKeypairPool::start(4);
+	waitForPoolToFill(4);
+
+	EXPECT_EQ(Cryptography::EphemeralKeypairPool::getAvailableCount(), size_t(4));
+
+	Cryptography::EphemeralKeypairPool::stop();
+
+	EXPECT_EQ(Cryptography::EphemeralKeypairPool::getAvailableCount(), size_t(0));
+}
+
+TEST(CryptographyEphemeralKeypairPool, takeKeypair_manyTakesFromSeveralThreads_allKeypairsAreValidAndUnique)
+{
+	constexpr size_t ThreadsCount = 4;
+	constexpr size_t TakesPerThread = 16;
+
+	Cryptography::EphemeralKeypairPool::start(8);
+	waitForPoolToFill(8);
+
+	std::vector<std::vector<Cryptography::Keypair>> takenKeypairs(ThreadsCount);
+	{
+		std::vector<std::thread> threads;
+		for (size_t i = 0; i < ThreadsCount; ++i)
+		{
+			threads.emplace_back([&keypairs = takenKeypairs[i]] {
+				for (size_t j = 0; j < TakesPerThread; ++j)
+				{
+					keypairs.push_back(Cryptography::EphemeralKeypairPool::takeKeypair());
+				}
+			});
+		}
+
+		for (std::thread& thread : threads)
+		{
+			thread.join();
+		}
+	}
+
+	Cryptography::EphemeralKeypairPool::stop();
+
+	std::set<std::array<std::byte, Cryptography::DHLEN>> uniqueSecretKeys;
+	for (const std::vector<Cryptography::Keypair>& keypairs : takenKeypairs)
+	{
+		for (const Cryptography::Keypair& keypair : keypairs)
+		{
+			EXPECT_TRUE(isPublicKeyMatchingSecretKey(keypair));
+			uniqueSecretKeys.insert(keypair.secretKey.raw);
+		}
+	}
+
+	EXPECT_EQ(uniqueSecretKeys.size(), ThreadsCount * TakesPerThread);
+}
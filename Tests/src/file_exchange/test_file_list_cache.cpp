@@ -0,0 +1,104 @@
+// Copyright (C) Pavel Grebnev 2026
+// Distributed under the MIT License (license terms are at http://opensource.org/licenses/MIT).
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "client_shared/file_list_cache.h"
+#include "common_shared/hash_utils.h"
+
+class FileListCacheTest : public testing::Test
+{
+protected:
+	void SetUp() override
+	{
+		std::filesystem::remove(CachePath);
+	}
+
+	void TearDown() override
+	{
+		std::filesystem::remove(CachePath);
+	}
+
+	static void appendRawBytes(std::string_view bytes)
+	{
+		std::ofstream file(CachePath, std::ios::binary | std::ios::app);
+		file.write(bytes.data(), bytes.size());
+	}
+
+	static inline const std::filesystem::path CachePath = "test_file_list_cache.wal";
+};
+
+TEST(FileListCacheHash, Crc32_StandardCheckValue_Matches)
+{
+	const std::string_view data = "123456789";
+	EXPECT_EQ(Hash::crc32(std::as_bytes(std::span(data))), 0xCBF43926u);
+	EXPECT_EQ(Hash::crc32({}), 0u);
+}
+
+TEST_F(FileListCacheTest, RecordAndCommit_SeveralAnswers_AllFilesRecovered)
+{
+	FileListCache cache(CachePath);
+	cache.recordFile("a.txt");
+	cache.recordFile(std::filesystem::path("dir") / "b.txt");
+	cache.commitRecordedFiles();
+	cache.recordFile("c.txt");
+	cache.commitRecordedFiles();
+
+	const std::vector<std::filesystem::path> expected{ "a.txt", std::filesystem::path("dir") / "b.txt", "c.txt" };
+	EXPECT_EQ(FileListCache::recoverPreviouslyRecorded(CachePath), expected);
+	EXPECT_EQ(cache.consumeAllFiles(), expected);
+	EXPECT_FALSE(std::filesystem::exists(CachePath));
+	EXPECT_TRUE(FileListCache::recoverPreviouslyRecorded(CachePath).empty());
+}
+
+TEST_F(FileListCacheTest, Record_NotCommitted_NotWrittenToDisk)
+{
+	FileListCache cache(CachePath);
+	cache.recordFile("a.txt");
+
+	EXPECT_TRUE(FileListCache::recoverPreviouslyRecorded(CachePath).empty());
+	EXPECT_EQ(cache.consumeAllFiles(), std::vector<std::filesystem::path>{ "a.txt" });
+}
+
+TEST_F(FileListCacheTest, Recover_TornOrDamagedTail_ValidRecordsKept)
+{
+	{
+		FileListCache cache(CachePath);
+		cache.recordFile("a.txt");
+		cache.recordFile("b.txt");
+		cache.commitRecordedFiles();
+	}
+	const std::vector<std::filesystem::path> expected{ "a.txt", "b.txt" };
+
+	// a header of a record that was not fully written
+	appendRawBytes(std::string_view("\x01\x02\x03\x04\x00\x10", 6));
+	EXPECT_EQ(FileListCache::recoverPreviouslyRecorded(CachePath), expected);
+
+	// a complete record with a wrong checksum
+	std::filesystem::resize_file(CachePath, std::filesystem::file_size(CachePath) - 6);
+	appendRawBytes(std::string_view("\x01\x02\x03\x04\x00\x01x", 7));
+	EXPECT_EQ(FileListCache::recoverPreviouslyRecorded(CachePath), expected);
+}
+
+TEST_F(FileListCacheTest, Commit_AfterTornTail_NewRecordsRecovered)
+{
+	{
+		FileListCache cache(CachePath);
+		cache.recordFile("a.txt");
+		cache.commitRecordedFiles();
+	}
+	appendRawBytes(std::string_view("\x01\x02", 2));
+
+	FileListCache cache(CachePath);
+	cache.recordFile("b.txt");
+	cache.commitRecordedFiles();
+
+	const std::vector<std::filesystem::path> expected{ "a.txt", "b.txt" };
+	EXPECT_EQ(FileListCache::recoverPreviouslyRecorded(CachePath), expected);
+}
@@ -185,6 +185,7 @@ struct FileExchangeTestInstructions
 	std::vector<FileExchangeTestFileRange> expectedOverriddenFiles = {};
 	std::optional<std::byte> corruptReceivedFilesPattern = {};
 	bool checkNoFilesWritten = false;
+	Noise::RekeyPolicy rekeyPolicy = Protocol::FileExchange::DefaultRekeyPolicy;
 };
 
 struct FileExchangeTestResult
@@ -275,7 +276,7 @@ static FileExchangeTestResult runFileExchangeTest(ClientStorage& clientStorage,
 		return -1;
 	};
 
-	auto sendingThread = std::thread([&filesToSend, &filesToSendIndex, &cipherKeyFromSenderToReceiver, &cipherKeyFromReceiverToSender, &clientStorage]() {
+	auto sendingThread = std::thread([&filesToSend, &filesToSendIndex, &cipherKeyFromSenderToReceiver, &cipherKeyFromReceiverToSender, &clientStorage, &instructions]() {
 		int fileToWriteIdx = -1;
 		size_t fileCursor = 0;
 		FileSendUtils::Mocks sendMocks{
@@ -327,7 +328,7 @@ static FileExchangeTestResult runFileExchangeTest(ClientStorage& clientStorage,
 		}
 		std::vector<uint64_t> previouslySentBytes;
 		clientStorage.filterOutSentFiles("", filePathsToSend, previouslySentBytes);
-		FileSendUtils::sendFiles(filePathsToSend, previouslySentBytes, "", senderSocket, clientStorage, "", cipherStateSending, cipherStateReceiving, sendMocks);
+		FileSendUtils::sendFiles(filePathsToSend, previouslySentBytes, "", senderSocket, clientStorage, "", cipherStateSending, cipherStateReceiving, instructions.rekeyPolicy, sendMocks);
 	});
 
 	std::vector<TestFileExchangeFile> receivedFiles = instructions.existingFiles;
@@ -441,7 +442,7 @@ static FileExchangeTestResult runFileExchangeTest(ClientStorage& clientStorage,
 	Noise::CipherStateReceiving cipherStateReceiving;
 	cipherStateReceiving.cipherKey = cipherKeyFromSenderToReceiver.clone();
 
-	FileReceiveUtils::receiveFiles("", receiverSocket, cipherStateSending, cipherStateReceiving, receiveMocks);
+	FileReceiveUtils::receiveFiles("", receiverSocket, cipherStateSending, cipherStateReceiving, instructions.rekeyPolicy, receiveMocks);
 	sendingThread.join();
 
 	EXPECT_EQ(size_t(0), fileMessages.size());
@@ -1070,6 +1071,44 @@ TEST_F(FileSendReceiveTest, Roundtrip_BigFilePartiallySentFourTimesAndThenSentFu
 	);
 }
 
+TEST_F(FileSendReceiveTest, Roundtrip_DifferentRekeyPolicies_AllFilesReceived)
+{
+	const std::minstd_rand::result_type seed = getRandomSeed();
+	std::vector<TestFileExchangeFile> filesToSend;
+	filesToSend.push_back(TestFileExchangeFile{
+		.path = "big.txt",
+		.data = generateTestFileData(200000, seed),
+	});
+	filesToSend.push_back(TestFileExchangeFile{
+		.path = "small.txt",
+		.data = generateTestFileData(500, seed + 1),
+	});
+
+	const std::array<Noise::RekeyPolicy, 4> rekeyPolicies = {
+		Noise::RekeyPolicy{ .messagesInterval = 1, .bytesInterval = 0, .timeIntervalMs = 0 },
+		Noise::RekeyPolicy{ .messagesInterval = 0, .bytesInterval = 3000, .timeIntervalMs = 0 },
+		Noise::RekeyPolicy{ .messagesInterval = 0, .bytesInterval = 0, .timeIntervalMs = 1 },
+		Noise::RekeyPolicy{ .messagesInterval = 0, .bytesInterval = 0, .timeIntervalMs = 0 },
+	};
+
+	for (const Noise::RekeyPolicy& rekeyPolicy : rekeyPolicies)
+	{
+		std::filesystem::remove_all("test_storage");
+		std::filesystem::create_directories("test_storage");
+		ClientStorage clientStorage = *ClientStorage::openStorage("test_storage");
+
+		runFileExchangeTest(
+			clientStorage,
+			filesToSend,
+			filesToSend,
+			filesToSend,
+			FileExchangeTestInstructions{
+				.rekeyPolicy = rekeyPolicy,
+			}
+		);
+	}
+}
+
 TEST_F(FileSendReceiveTest, Roundtrip_FileMarkedPartiallySentAtEOF_FileIsSkipped)
 {
 	ClientStorage clientStorage = *ClientStorage::openStorage("test_storage");
@@ -0,0 +1,122 @@
+// Copyright (C) Pavel Grebnev 2026
+// Distributed under the MIT License (license terms are at http://opensource.org/licenses/MIT).
+
+#include <algorithm>
+#include <cstring>
+#include <deque>
+#include <limits>
+
+#include "tests/assert_helper.h"
+#include "tests/helper_utils.h"
+#include <gtest/gtest.h>
+
+#include "common_shared/network/protocol.h"
+#include "common_shared/network/utils.h"
+#include "common_shared/serialization/number_serialization.h"
+
+class ControlChannelFramesTest : public testing::Test
+{
+protected:
+	void SetUp() override
+	{
+		Network::gSendTestMock = [this](Network::RawSocket /*socket*/, const char* buffer, int dataSize, int /*flags*/) -> int {
+			mStream.insert(mStream.end(), reinterpret_cast<const std::byte*>(buffer), reinterpret_cast<const std::byte*>(buffer) + dataSize);
+			return dataSize;
+		};
+
+		Network::gRecvTestMock = [this](Network::RawSocket /*socket*/, char* buffer, int dataSize, int /*flags*/) -> int {
+			if (mStream.empty())
+			{
+				return -1;
+			}
+
+			const size_t bytesToRead = std::min({ static_cast<size_t>(dataSize), mStream.size(), mMaxBytesPerRecv });
+			std::copy(mStream.begin(), mStream.begin() + static_cast<std::ptrdiff_t>(bytesToRead), reinterpret_cast<std::byte*>(buffer));
+			mStream.erase(mStream.begin(), mStream.begin() + static_cast<std::ptrdiff_t>(bytesToRead));
+			return static_cast<int>(bytesToRead);
+		};
+	}
+
+	void TearDown() override
+	{
+		Network::gSendTestMock = nullptr;
+		Network::gRecvTestMock = nullptr;
+	}
+
+	std::deque<std::byte> mStream;
+	size_t mMaxBytesPerRecv = std::numeric_limits<size_t>::max();
+};
+
+TEST_F(ControlChannelFramesTest, SendFrameAndRecvFrame_OneFrame_SameTagAndPayload)
+{
+	const std::vector<std::byte> payload = strToBytes("\x01test request");
+
+	EXPECT_EQ(Network::sendFrame(1, 0x1234, payload), std::nullopt);
+	EXPECT_EQ(mStream.size(), Protocol::ControlChannel::FrameHeaderSize + payload.size());
+
+	std::array<std::byte, Protocol::ControlChannel::MaxFramePayloadSize> buffer;
+	uint16_t requestTag = 0;
+	size_t payloadSize = 0;
+	ASSERT_EQ(Network::recvFrame(1, buffer, requestTag, payloadSize), std::nullopt);
+
+	EXPECT_EQ(requestTag, 0x1234);
+	ASSERT_EQ(payloadSize, payload.size());
+	EXPECT_TRUE(std::equal(payload.begin(), payload.end(), buffer.begin()));
+	EXPECT_TRUE(mStream.empty());
+}
+
+TEST_F(ControlChannelFramesTest, RecvFrame_SeveralFramesFragmentedStream_AllFramesReceivedInOrder)
+{
+	mMaxBytesPerRecv = 1;
+
+	std::vector<std::vector<std::byte>> payloads;
+	for (uint16_t i = 0; i < 5; ++i)
+	{
+		payloads.push_back(std::vector<std::byte>(1 + i * 100, static_cast<std::byte>(i)));
+		EXPECT_EQ(Network::sendFrame(1, i, payloads.back()), std::nullopt);
+	}
+
+	std::array<std::byte, Protocol::ControlChannel::MaxFramePayloadSize> buffer;
+	for (uint16_t i = 0; i < 5; ++i)
+	{
+		uint16_t requestTag = 0;
+		size_t payloadSize = 0;
+		ASSERT_EQ(Network::recvFrame(1, buffer, requestTag, payloadSize), std::nullopt);
+		EXPECT_EQ(requestTag, i);
+		ASSERT_EQ(payloadSize, payloads[i].size());
+		EXPECT_TRUE(std::equal(payloads[i].begin(), payloads[i].end(), buffer.begin()));
+	}
+
+	EXPECT_TRUE(mStream.empty());
+}
+
+TEST_F(ControlChannelFramesTest, SendFrame_EmptyOrTooBigPayload_ReturnsError)
+{
+	AssertHelper::ScopedAssertDisabler assertDisabler;
+
+	EXPECT_NE(Network::sendFrame(1, 0, std::span<const std::byte>()), std::nullopt);
+
+	const std::vector<std::byte> tooBigPayload(Protocol::ControlChannel::MaxFramePayloadSize + 1, std::byte(1));
+	EXPECT_NE(Network::sendFrame(1, 0, tooBigPayload), std::nullopt);
+
+	EXPECT_TRUE(mStream.empty());
+}
+
+TEST_F(ControlChannelFramesTest, RecvFrame_HeaderWithUnexpectedPayloadSize_ReturnsError)
+{
+	std::array<std::byte, 16> buffer;
+	uint16_t requestTag = 0;
+	size_t payloadSize = 0;
+
+	for (const uint16_t headerPayloadSize : { uint16_t(0), uint16_t(buffer.size() + 1), uint16_t(Protocol::ControlChannel::MaxFramePayloadSize + 1) })
+	{
+		mStream.clear();
+		std::array<std::byte, Protocol::ControlChannel::FrameHeaderSize> header;
+		Serialization::writeUint16(header[0], header[1], headerPayloadSize);
+		Serialization::writeUint16(header[2], header[3], 1);
+		mStream.insert(mStream.end(), header.begin(), header.end());
+		mStream.resize(mStream.size() + headerPayloadSize, std::byte(0));
+
+		EXPECT_NE(Network::recvFrame(1, buffer, requestTag, payloadSize), std::nullopt) << headerPayloadSize;
+	}
+}
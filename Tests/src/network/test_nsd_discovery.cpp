@@ -0,0 +1,187 @@
+// Copyright (C) Pavel Grebnev 2026
+// Distributed under the MIT License (license terms are at http://opensource.org/licenses/MIT).
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "common_shared/network/raw_sockets.h"
+#include "common_shared/network/utils.h"
+#include "common_shared/nsd/nsd_client.h"
+#include "common_shared/nsd/utils_internal.h"
+
+namespace NsdDiscoveryTestsInternal
+{
+	constexpr const char* ServiceIdentifier = "_test-discovery._tcp";
+	// nobody answers the queries in these tests, the servers are only announced
+	// the ports differ from the real ones, so a server running on the same machine doesn't interfere
+	constexpr uint16_t QueryPort = 45817;
+	constexpr uint16_t AnnouncementPort = 45819;
+
+	class DiscoveryClient
+	{
+	public:
+		void start()
+		{
+			mThread = std::thread([this] {
+				NsdClient::processServiceDiscoveryThread(
+					ServiceIdentifier,
+					QueryPort,
+					AnnouncementPort,
+					Network::AddressType::IpV4,
+					1.0f,
+					[this](NsdClient::DiscoveryResult&& result) {
+						std::lock_guard lock(mMutex);
+						mEvents.push_back(std::move(result));
+						mCondition.notify_all();
+					},
+					mStopFlag
+				);
+			});
+			// give the client time to bind the announcement socket
+			std::this_thread::sleep_for(std::chrono::milliseconds(100));
+		}
+
+		~DiscoveryClient()
+		{
+			mStopFlag.store(true);
+			if (mThread.joinable())
+			{
+				mThread.join();
+			}
+		}
+
+		std::optional<NsdClient::DiscoveryResult> waitForEvent(const std::chrono::milliseconds timeout)
+		{
+			std::unique_lock lock(mMutex);
+			if (!mCondition.wait_for(lock, timeout, [this] { return !mEvents.empty(); }))
+			{
+				return std::nullopt;
+			}
+
+			NsdClient::DiscoveryResult result = std::move(mEvents.front());
+			mEvents.erase(mEvents.begin());
+			return result;
+		}
+
+	private:
+		std::thread mThread;
+		std::atomic_bool mStopFlag{};
+		std::mutex mMutex;
+		std::condition_variable mCondition;
+		std::vector<NsdClient::DiscoveryResult> mEvents;
+	};
+
+	static void sendAnnouncement(const uint16_t ttlSeconds, const uint16_t advertizedPort)
+	{
+		const std::array<std::byte, 3> extraData{ std::byte(1), std::byte(2), std::byte(3) };
+		const std::optional<std::vector<std::byte>> announcement = NsdInternalUtils::buildAnnouncement(ServiceIdentifier, ttlSeconds, advertizedPort, extraData);
+		ASSERT_TRUE(announcement.has_value());
+
+		auto socketResult = Network::createSocket(Network::SocketType::Udp, Network::AddressType::IpV4);
+		ASSERT_TRUE(std::holds_alternative<Network::RawSocket>(socketResult));
+		const Network::AutoclosingSocket socket(std::get<Network::RawSocket>(socketResult), Network::CloseMode::Immediate);
+
+		sockaddr_in address{};
+		address.sin_family = AF_INET;
+		address.sin_port = htons(AnnouncementPort);
+		inet_pton(AF_INET, "127.0.0.1", &address.sin_addr);
+		ASSERT_EQ(sendto(socket, reinterpret_cast<const char*>(announcement->data()), static_cast<int>(announcement->size()), 0, reinterpret_cast<const sockaddr*>(&address), sizeof(address)), static_cast<int>(announcement->size()));
+	}
+} // namespace NsdDiscoveryTestsInternal
+
+TEST(NsdDiscovery, BuildAnnouncementAndParse_SameData)
+{
+	const std::array<std::byte, 3> extraData{ std::byte(1), std::byte(2), std::byte(3) };
+	const std::optional<std::vector<std::byte>> packet = NsdInternalUtils::buildAnnouncement("_service._tcp", 120, 5000, extraData);
+	ASSERT_TRUE(packet.has_value());
+
+	const std::optional<NsdInternalUtils::Announcement> announcement = NsdInternalUtils::parseAnnouncement(*packet, "_service._tcp");
+	ASSERT_TRUE(announcement.has_value());
+	EXPECT_EQ(announcement->ttlSeconds, 120);
+	EXPECT_EQ(announcement->port, 5000);
+	EXPECT_EQ(announcement->extraData, std::vector<std::byte>(extraData.begin(), extraData.end()));
+}
+
+TEST(NsdDiscovery, BuildAnnouncement_BiggerThanReceiveBuffer_NotBuilt)
+{
+	const std::string_view serviceIdentifier = "_service._tcp";
+	const size_t maxExtraDataSize = NsdInternalUtils::MaxPacketSize - (1 + 2 + 1 + serviceIdentifier.size() + 2 + 2 + 2);
+
+	const std::vector<std::byte> extraData(maxExtraDataSize, std::byte(0x55));
+	const std::optional<std::vector<std::byte>> packet = NsdInternalUtils::buildAnnouncement(serviceIdentifier, 120, 5000, extraData);
+	ASSERT_TRUE(packet.has_value());
+	EXPECT_EQ(packet->size(), NsdInternalUtils::MaxPacketSize);
+
+	const std::vector<std::byte> tooBigExtraData(maxExtraDataSize + 1, std::byte(0x55));
+	EXPECT_FALSE(NsdInternalUtils::buildAnnouncement(serviceIdentifier, 120, 5000, tooBigExtraData).has_value());
+}
+
+TEST(NsdDiscovery, ParseAnnouncement_OtherServiceOrCorrupted_Rejected)
+{
+	const std::optional<std::vector<std::byte>> packet = NsdInternalUtils::buildAnnouncement("_service._tcp", 120, 5000, {});
+	ASSERT_TRUE(packet.has_value());
+
+	EXPECT_FALSE(NsdInternalUtils::parseAnnouncement(*packet, "_other._tcp").has_value());
+	EXPECT_FALSE(NsdInternalUtils::parseAnnouncement(std::span(packet->data(), packet->size() - 1), "_service._tcp").has_value());
+
+	for (size_t i = 0; i < packet->size(); ++i)
+	{
+		std::vector<std::byte> corruptedPacket = *packet;
+		corruptedPacket[i] ^= std::byte(0x10);
+		EXPECT_FALSE(NsdInternalUtils::parseAnnouncement(corruptedPacket, "_service._tcp").has_value()) << i;
+	}
+}
+
+TEST(NsdDiscovery, ProcessServiceDiscoveryThread_Announcements_AddedAndRemovedWithoutQueries)
+{
+	using namespace NsdDiscoveryTestsInternal;
+
+	DiscoveryClient client;
+	client.start();
+
+	// the server is reported right after the announcement, not after the next query
+	ASSERT_NO_FATAL_FAILURE(sendAnnouncement(120, 1000));
+	std::optional<NsdClient::DiscoveryResult> event = client.waitForEvent(std::chrono::milliseconds(500));
+	ASSERT_TRUE(event.has_value());
+	EXPECT_EQ(event->state, NsdClient::DiscoveryState::Added);
+	EXPECT_EQ(event->address.ip, "127.0.0.1");
+	EXPECT_EQ(event->address.port, 1000);
+	EXPECT_EQ(event->extraData, (std::vector<std::byte>{ std::byte(1), std::byte(2), std::byte(3) }));
+
+	// repeated announcements only refresh the TTL
+	ASSERT_NO_FATAL_FAILURE(sendAnnouncement(120, 1000));
+	EXPECT_FALSE(client.waitForEvent(std::chrono::milliseconds(100)).has_value());
+
+	// goodbye removes the server immediately
+	ASSERT_NO_FATAL_FAILURE(sendAnnouncement(0, 1000));
+	event = client.waitForEvent(std::chrono::milliseconds(500));
+	ASSERT_TRUE(event.has_value());
+	EXPECT_EQ(event->state, NsdClient::DiscoveryState::Removed);
+	EXPECT_EQ(event->address.port, 1000);
+}
+
+TEST(NsdDiscovery, ProcessServiceDiscoveryThread_AnnouncementTtlExpired_Removed)
+{
+	using namespace NsdDiscoveryTestsInternal;
+
+	DiscoveryClient client;
+	client.start();
+
+	ASSERT_NO_FATAL_FAILURE(sendAnnouncement(1, 2000));
+	std::optional<NsdClient::DiscoveryResult> event = client.waitForEvent(std::chrono::milliseconds(500));
+	ASSERT_TRUE(event.has_value());
+	EXPECT_EQ(event->state, NsdClient::DiscoveryState::Added);
+
+	event = client.waitForEvent(std::chrono::milliseconds(2000));
+	ASSERT_TRUE(event.has_value());
+	EXPECT_EQ(event->state, NsdClient::DiscoveryState::Removed);
+	EXPECT_EQ(event->address.port, 2000);
+}
@@ -0,0 +1,187 @@
+// Copyright (C) Pavel Grebnev 2026
+// Distributed under the MIT License (license terms are at http://opensource.org/licenses/MIT).
+
+#include <array>
+#include <chrono>
+#include <string>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+#include "common_shared/network/raw_sockets.h"
+#include "common_shared/network/utils.h"
+#include "common_shared/nsd/nsd_server.h"
+
+namespace NsdServerLoadTestsInternal
+{
+	constexpr const char* ServiceIdentifier = "_test-service._tcp";
+	constexpr uint16_t AdvertizedPort = 4321;
+	// the responder stops when it doesn't get any packets for this long
+	constexpr int ResponderIdleTimeoutMilliseconds = 300;
+
+	class LoopbackResponder
+	{
+	public:
+		void start()
+		{
+			auto socketResult = NsdServer::openNsdSocket(Network::AddressType::IpV4);
+			ASSERT_TRUE(std::holds_alternative<Network::RawSocket>(socketResult));
+			mSocket = std::get<Network::RawSocket>(socketResult);
+			ASSERT_EQ(Network::setSocketTimeout(mSocket, SO_RCVTIMEO, 0, ResponderIdleTimeoutMilliseconds * 1000), std::nullopt);
+
+			mThread = std::thread([this] {
+				const std::array<std::byte, 2> extraData{ std::byte(0xAB), std::byte(0xCD) };
+				mResult = NsdServer::listen(mSocket, "127.0.0.1", Network::AddressType::IpV4, 0, ServiceIdentifier, AdvertizedPort, extraData);
+			});
+
+			const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+			while (mPort == 0 && std::chrono::steady_clock::now() < deadline)
+			{
+				auto portResult = Network::getSocketPort(mSocket);
+				ASSERT_TRUE(std::holds_alternative<uint16_t>(portResult));
+				mPort = std::get<uint16_t>(portResult);
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			}
+			ASSERT_NE(mPort, 0);
+		}
+
+		void stop()
+		{
+			if (mThread.joinable())
+			{
+				mThread.join();
+				Network::closeSocket(mSocket, Network::CloseMode::Immediate);
+			}
+		}
+
+		~LoopbackResponder()
+		{
+			stop();
+		}
+
+		uint16_t getPort() const
+		{
+			return mPort;
+		}
+
+	private:
+		Network::RawSocket mSocket{};
+		std::thread mThread;
+		uint16_t mPort = 0;
+		NsdServer::ListenResult mResult;
+	};
+
+	static Network::RawSocket openClientSocket(const char* address)
+	{
+		auto socketResult = Network::createSocket(Network::SocketType::Udp, Network::AddressType::IpV4);
+		EXPECT_TRUE(std::holds_alternative<Network::RawSocket>(socketResult));
+		const Network::RawSocket socket = std::get<Network::RawSocket>(socketResult);
+		EXPECT_EQ(Network::bindSocket(socket, address, Network::AddressType::IpV4, 0), std::nullopt);
+		EXPECT_EQ(Network::setSocketTimeout(socket, SO_RCVTIMEO, 0, 200 * 1000), std::nullopt);
+		return socket;
+	}
+
+	static bool sendQuery(const Network::RawSocket socket, const uint16_t port, const std::string& query)
+	{
+		sockaddr_in address{};
+		address.sin_family = AF_INET;
+		address.sin_port = htons(port);
+		inet_pton(AF_INET, "127.0.0.1", &address.sin_addr);
+		return sendto(socket, query.data(), static_cast<int>(query.size()), 0, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) == static_cast<int>(query.size());
+	}
+
+	// returns the number of received responses until the socket times out
+	static size_t receiveResponses(const Network::RawSocket socket)
+	{
+		size_t count = 0;
+		std::array<char, 64> buffer;
+		while (recv(socket, buffer.data(), static_cast<int>(buffer.size()), 0) > 0)
+		{
+			++count;
+		}
+		return count;
+	}
+} // namespace NsdServerLoadTestsInternal
+
+TEST(NsdServerLoad, Listen_ExpectedAndUnexpectedQueries_AnswersOnlyExpected)
+{
+	using namespace NsdServerLoadTestsInternal;
+
+	LoopbackResponder responder;
+	ASSERT_NO_FATAL_FAILURE(responder.start());
+
+	const Network::AutoclosingSocket clientSocket(openClientSocket("127.0.0.1"), Network::CloseMode::Immediate);
+
+	EXPECT_TRUE(sendQuery(clientSocket, responder.getPort(), "aloha:_other-service._tcp\n"));
+	EXPECT_TRUE(sendQuery(clientSocket, responder.getPort(), std::string("aloha:") + ServiceIdentifier));
+	EXPECT_TRUE(sendQuery(clientSocket, responder.getPort(), std::string("aloha:") + ServiceIdentifier + "\n"));
+
+	std::array<std::byte, 64> buffer;
+	const int receivedSize = recv(clientSocket, reinterpret_cast<char*>(buffer.data()), static_cast<int>(buffer.size()), 0);
+	// version, extra data size, port, extra data, checksum
+	ASSERT_EQ(receivedSize, 1 + 2 + 2 + 2 + 2);
+	EXPECT_EQ(buffer[0], std::byte(0x01));
+	EXPECT_EQ(buffer[5], std::byte(0xAB));
+	EXPECT_EQ(buffer[6], std::byte(0xCD));
+
+	EXPECT_EQ(receiveResponses(clientSocket), size_t(0));
+
+	responder.stop();
+}
+
+TEST(NsdServerLoad, Listen_QueryStormFromOneAddress_RateLimitedAndOtherClientsAnswered)
+{
+	using namespace NsdServerLoadTestsInternal;
+
+	constexpr size_t StormSocketsCount = 4;
+	constexpr size_t QueriesPerSocket = 5000;
+
+	LoopbackResponder responder;
+	ASSERT_NO_FATAL_FAILURE(responder.start());
+
+	const std::string query = std::string("aloha:") + ServiceIdentifier + "\n";
+
+	std::array<Network::RawSocket, StormSocketsCount> stormSockets;
+	for (Network::RawSocket& socket : stormSockets)
+	{
+		socket = openClientSocket("127.0.0.1");
+	}
+
+	const auto stormStart = std::chrono::steady_clock::now();
+	size_t sentQueries = 0;
+	for (size_t i = 0; i < QueriesPerSocket; ++i)
+	{
+		for (const Network::RawSocket socket : stormSockets)
+		{
+			sentQueries += sendQuery(socket, responder.getPort(), query) ? 1 : 0;
+		}
+	}
+	// otherwise the storm doesn't test the rate limit
+	EXPECT_GT(static_cast<double>(sentQueries), NsdServer::MaxRepliesBurst * 10);
+
+	// a client from a different address is not affected by the storm
+	const Network::AutoclosingSocket otherClientSocket(openClientSocket("127.0.0.2"), Network::CloseMode::Immediate);
+	// the query can wait behind the storm in the socket buffer or be dropped with it, so it is repeated until answered
+	constexpr int OtherClientAttempts = 10;
+	bool isOtherClientAnswered = false;
+	for (int attempt = 0; attempt < OtherClientAttempts && !isOtherClientAnswered; ++attempt)
+	{
+		ASSERT_TRUE(sendQuery(otherClientSocket, responder.getPort(), query));
+		std::array<char, 64> buffer;
+		isOtherClientAnswered = recv(otherClientSocket, buffer.data(), static_cast<int>(buffer.size()), 0) > 0;
+	}
+	EXPECT_TRUE(isOtherClientAnswered);
+
+	size_t stormReplies = 0;
+	for (const Network::RawSocket socket : stormSockets)
+	{
+		stormReplies += receiveResponses(socket);
+		Network::closeSocket(socket, Network::CloseMode::Immediate);
+	}
+
+	const double elapsedSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - stormStart).count();
+	EXPECT_GE(stormReplies, size_t(1));
+	EXPECT_LE(static_cast<double>(stormReplies), NsdServer::MaxRepliesBurst + NsdServer::RepliesPerSecondPerAddress * elapsedSeconds + 1.0);
+
+	responder.stop();
+}
@@ -0,0 +1,131 @@
+// Copyright (C) Pavel Grebnev 2026
+// Distributed under the MIT License (license terms are at http://opensource.org/licenses/MIT).
+
+#include <array>
+
+#include <gtest/gtest.h>
+
+#include "common_shared/network/session_parameters.h"
+
+TEST(SessionParameters, writeAndRead_sameParameters)
+{
+	using namespace Protocol::SessionParameters;
+
+	const Parameters parameters{
+		.features = 0x12345678,
+		.frameModes = 0x9A,
+		.hashModes = 0xBC,
+		.compressionModes = 0xDE,
+		.rekeyPolicy = Noise::RekeyPolicy{ .messagesInterval = 1, .bytesInterval = 0x0102030405060708, .timeIntervalMs = 60000 },
+	};
+
+	std::array<std::byte, MessageSize> buffer;
+	write(buffer, parameters);
+
+	EXPECT_EQ(read(buffer), parameters);
+}
+
+TEST(SessionParameters, negotiate_sameVersions_supportedParameters)
+{
+	using namespace Protocol::SessionParameters;
+
+	const std::optional<Parameters> result = negotiate(getSupported(), getSupported());
+	ASSERT_TRUE(result.has_value());
+	EXPECT_EQ(*result, getSupported());
+	EXPECT_TRUE(isValidChoice(getSupported(), *result));
+}
+
+TEST(SessionParameters, negotiate_differentModes_picksBestCommonModeAndCommonFeatures)
+{
+	using namespace Protocol::SessionParameters;
+
+	const Parameters ours{
+		.features = 0b0111,
+		.frameModes = 0b0111,
+		.hashModes = 0b0001,
+		.compressionModes = 0b0011,
+		.rekeyPolicy = Noise::RekeyPolicy{ .messagesInterval = 32, .bytesInterval = 0, .timeIntervalMs = 60000 },
+	};
+	const Parameters theirs{
+		.features = 0b1101,
+		.frameModes = 0b1011,
+		.hashModes = 0b1001,
+		.compressionModes = 0b0001,
+		.rekeyPolicy = Noise::RekeyPolicy{ .messagesInterval = 64, .bytesInterval = 1024, .timeIntervalMs = 0 },
+	};
+
+	const Parameters expectedResult{
+		.features = 0b0101,
+		.frameModes = 0b0010,
+		.hashModes = 0b0001,
+		.compressionModes = 0b0001,
+		.rekeyPolicy = Noise::RekeyPolicy{ .messagesInterval = 32, .bytesInterval = 1024, .timeIntervalMs = 60000 },
+	};
+
+	EXPECT_EQ(negotiate(ours, theirs), expectedResult);
+	EXPECT_EQ(negotiate(theirs, ours), expectedResult);
+	EXPECT_TRUE(isValidChoice(ours, expectedResult));
+	EXPECT_TRUE(isValidChoice(theirs, expectedResult));
+}
+
+TEST(SessionParameters, negotiate_noCommonMode_nullopt)
+{
+	using namespace Protocol::SessionParameters;
+
+	Parameters theirs = getSupported();
+	theirs.hashModes = 0b1000'0000;
+
+	EXPECT_EQ(negotiate(getSupported(), theirs), std::nullopt);
+
+	theirs = getSupported();
+	theirs.compressionModes = 0;
+
+	EXPECT_EQ(negotiate(getSupported(), theirs), std::nullopt);
+}
+
+TEST(SessionParameters, isValidChoice_choiceNotOffered_false)
+{
+	using namespace Protocol::SessionParameters;
+
+	const Parameters offered{
+		.features = 0b0011,
+		.frameModes = 0b0011,
+		.hashModes = 0b0001,
+		.compressionModes = 0b0001,
+		.rekeyPolicy = Noise::RekeyPolicy{ .messagesInterval = 32, .bytesInterval = 0, .timeIntervalMs = 60000 },
+	};
+
+	Parameters validChoice = offered;
+	validChoice.frameModes = 0b0010;
+	ASSERT_TRUE(isValidChoice(offered, validChoice));
+
+	// several modes chosen
+	Parameters choice = validChoice;
+	choice.frameModes = 0b0011;
+	EXPECT_FALSE(isValidChoice(offered, choice));
+
+	// mode that we don't support
+	choice = validChoice;
+	choice.frameModes = 0b0100;
+	EXPECT_FALSE(isValidChoice(offered, choice));
+
+	// no mode chosen
+	choice = validChoice;
+	choice.hashModes = 0;
+	EXPECT_FALSE(isValidChoice(offered, choice));
+
+	// feature that we don't support
+	choice = validChoice;
+	choice.features = 0b0100;
+	EXPECT_FALSE(isValidChoice(offered, choice));
+
+	// less frequent rekeys than we asked for
+	choice = validChoice;
+	choice.rekeyPolicy.messagesInterval = 64;
+	EXPECT_FALSE(isValidChoice(offered, choice));
+
+	// more frequent rekeys are fine
+	choice = validChoice;
+	choice.rekeyPolicy.messagesInterval = 16;
+	EXPECT_TRUE(isValidChoice(offered, choice));
+}
@@ -0,0 +1,110 @@
+// Copyright (C) Pavel Grebnev 2026
+// Distributed under the MIT License (license terms are at http://opensource.org/licenses/MIT).
+
+#include <array>
+#include <chrono>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+#include "common_shared/network/raw_sockets.h"
+#include "common_shared/network/socket_reaper.h"
+#include "common_shared/network/utils.h"
+
+namespace SocketCloseTestsInternal
+{
+	struct ConnectedPair
+	{
+		Network::RawSocket clientSocket;
+		Network::RawSocket serverSocket;
+	};
+
+	static void openConnectedPair(ConnectedPair& outPair)
+	{
+		auto listenSocketResult = Network::createSocket(Network::SocketType::Tcp, Network::AddressType::IpV4);
+		ASSERT_TRUE(std::holds_alternative<Network::RawSocket>(listenSocketResult));
+		const Network::AutoclosingSocket listenSocket(std::get<Network::RawSocket>(listenSocketResult), Network::CloseMode::Immediate);
+
+		ASSERT_EQ(Network::bindSocket(listenSocket, "127.0.0.1", Network::AddressType::IpV4, 0), std::nullopt);
+		ASSERT_EQ(listen(listenSocket, 1), 0);
+		auto portResult = Network::getSocketPort(listenSocket);
+		ASSERT_TRUE(std::holds_alternative<uint16_t>(portResult));
+
+		auto clientSocketResult = Network::createSocket(Network::SocketType::Tcp, Network::AddressType::IpV4);
+		ASSERT_TRUE(std::holds_alternative<Network::RawSocket>(clientSocketResult));
+		outPair.clientSocket = std::get<Network::RawSocket>(clientSocketResult);
+		ASSERT_EQ(Network::setSocketTimeout(outPair.clientSocket, SO_RCVTIMEO, 1, 0), std::nullopt);
+		ASSERT_EQ(Network::connectToServer(outPair.clientSocket, "127.0.0.1", Network::AddressType::IpV4, std::get<uint16_t>(portResult)), std::nullopt);
+
+		outPair.serverSocket = accept(listenSocket, nullptr, nullptr);
+		ASSERT_NE(outPair.serverSocket, Network::RawSocket(-1));
+	}
+
+	static void waitForReaperToFinish()
+	{
+		const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(Network::SocketReaper::DrainTimeoutMilliseconds * 10);
+		while (Network::SocketReaper::getPendingCount() != 0 && std::chrono::steady_clock::now() < deadline)
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(5));
+		}
+	}
+} // namespace SocketCloseTestsInternal
+
+TEST(SocketClose, GracefulClose_UnreadIncomingData_DoesNotBlockAndPeerGetsEndOfStream)
+{
+	using namespace SocketCloseTestsInternal;
+
+	ConnectedPair pair{};
+	ASSERT_NO_FATAL_FAILURE(openConnectedPair(pair));
+
+	const std::array<char, 16> data = {};
+	ASSERT_EQ(::send(pair.clientSocket, data.data(), static_cast<int>(data.size()), 0), static_cast<int>(data.size()));
+	std::array<char, 16> serverData = {};
+	ASSERT_EQ(::send(pair.serverSocket, serverData.data(), static_cast<int>(serverData.size()), 0), static_cast<int>(serverData.size()));
+
+	// the client keeps the connection open, so a blocking drain would wait for the whole timeout
+	const auto closeStart = std::chrono::steady_clock::now();
+	Network::closeSocket(pair.serverSocket, Network::CloseMode::Graceful);
+	EXPECT_LT(std::chrono::steady_clock::now() - closeStart, std::chrono::milliseconds(Network::SocketReaper::DrainTimeoutMilliseconds / 2));
+
+	// the data sent before closing is delivered and is followed by the end of stream, not by a reset
+	std::array<char, 64> buffer = {};
+	EXPECT_EQ(::recv(pair.clientSocket, buffer.data(), static_cast<int>(buffer.size()), 0), static_cast<int>(serverData.size()));
+	EXPECT_EQ(::recv(pair.clientSocket, buffer.data(), static_cast<int>(buffer.size()), 0), 0);
+
+	Network::closeSocket(pair.clientSocket, Network::CloseMode::Immediate);
+	waitForReaperToFinish();
+	EXPECT_EQ(Network::SocketReaper::getPendingCount(), size_t(0));
+}
+
+TEST(SocketClose, GracefulClose_PeerNeverCloses_SocketClosedAfterDrainTimeout)
+{
+	using namespace SocketCloseTestsInternal;
+
+	ConnectedPair pair{};
+	ASSERT_NO_FATAL_FAILURE(openConnectedPair(pair));
+
+	Network::closeSocket(pair.serverSocket, Network::CloseMode::Graceful);
+	EXPECT_EQ(Network::SocketReaper::getPendingCount(), size_t(1));
+
+	waitForReaperToFinish();
+	EXPECT_EQ(Network::SocketReaper::getPendingCount(), size_t(0));
+
+	Network::closeSocket(pair.clientSocket, Network::CloseMode::Immediate);
+}
+
+TEST(SocketClose, AbortiveClose_PeerGetsReset)
+{
+	using namespace SocketCloseTestsInternal;
+
+	ConnectedPair pair{};
+	ASSERT_NO_FATAL_FAILURE(openConnectedPair(pair));
+
+	Network::closeSocket(pair.serverSocket, Network::CloseMode::Abortive);
+	EXPECT_EQ(Network::SocketReaper::getPendingCount(), size_t(0));
+
+	std::array<char, 16> buffer = {};
+	EXPECT_LT(::recv(pair.clientSocket, buffer.data(), static_cast<int>(buffer.size()), 0), 0);
+
+	Network::closeSocket(pair.clientSocket, Network::CloseMode::Immediate);
+}
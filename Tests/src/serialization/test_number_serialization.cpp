@@ -28,6 +28,16 @@ TEST(NumberSerialization, SerializeUint16)
 	EXPECT_EQ(vectorToArray<2>(hexToBytes("4677")), buffer);
 }
 
+TEST(NumberSerialization, SerializeUint32)
+{
+	std::array<std::byte, 4> buffer;
+
+	Serialization::writeUint32(buffer, uint32_t(3054198966));
+
+	// no matter what endiannes the current system have, the result should be the same
+	EXPECT_EQ(vectorToArray<4>(hexToBytes("B60B60B6")), buffer);
+}
+
 TEST(NumberSerialization, SerializeUint64)
 {
 	std::array<std::byte, 8> buffer;
@@ -55,6 +65,23 @@ TEST(NumberSerialization, SerializeDeserializeU16Rountrip)
 	EXPECT_EQ(std::numeric_limits<uint16_t>::max(), Serialization::readUint16(buffer[0], buffer[1]));
 }
 
+TEST(NumberSerialization, SerializeDeserializeU32Rountrip)
+{
+	std::array<std::byte, 4> buffer;
+
+	Serialization::writeUint32(buffer, 0);
+	EXPECT_EQ(static_cast<uint32_t>(0), Serialization::readUint32(buffer));
+
+	Serialization::writeUint32(buffer, 257);
+	EXPECT_EQ(static_cast<uint32_t>(257), Serialization::readUint32(buffer));
+
+	Serialization::writeUint32(buffer, 2000000042);
+	EXPECT_EQ(static_cast<uint32_t>(2000000042), Serialization::readUint32(buffer));
+
+	Serialization::writeUint32(buffer, std::numeric_limits<uint32_t>::max());
+	EXPECT_EQ(std::numeric_limits<uint32_t>::max(), Serialization::readUint32(buffer));
+}
+
 TEST(NumberSerialization, SerializeDeserializeU64Rountrip)
 {
 	std::array<std::byte, 8> buffer;
@@ -0,0 +1,116 @@
+// Copyright (C) Pavel Grebnev 2026
+// Distributed under the MIT License (license terms are at http://opensource.org/licenses/MIT).
+
+#include "tests/assert_helper.h"
+#include "tests/helper_utils.h"
+#include <gtest/gtest.h>
+
+#include "common_shared/serialization/record_schema.h"
+
+namespace RecordSchemaTestsInternal
+{
+	enum class Kind : uint8_t
+	{
+		First = 1,
+		Second = 2,
+	};
+
+	struct Header
+	{
+		std::array<std::byte, 2> magic;
+		uint16_t version;
+	};
+
+	struct Record
+	{
+		std::string name;
+		Header header;
+		Kind kind;
+		uint64_t counter;
+	};
+
+	using RecordSchema = Serialization::RecordSchema<
+		Record,
+		Serialization::Field<"name", &Record::name>,
+		Serialization::Field<"magic", &Record::header, &Header::magic>,
+		Serialization::Field<"version", &Record::header, &Header::version>,
+		Serialization::Field<"kind", &Record::kind>,
+		Serialization::Field<"counter", &Record::counter>>;
+
+	using HeaderSchema = Serialization::RecordSchema<
+		Header,
+		Serialization::Field<"magic", &Header::magic>,
+		Serialization::Field<"version", &Header::version>>;
+
+	static Record makeRecord()
+	{
+		Record record;
+		record.name = "abc";
+		record.header.magic = { std::byte(0xCA), std::byte(0xFE) };
+		record.header.version = 0x0102;
+		record.kind = Kind::Second;
+		record.counter = 0x0102030405060708;
+		return record;
+	}
+} // namespace RecordSchemaTestsInternal
+
+TEST(RecordSchema, Write_Record_ExpectedLayout)
+{
+	using namespace RecordSchemaTestsInternal;
+
+	const Record record = makeRecord();
+
+	std::vector<std::byte> buffer(RecordSchema::getSerializedSize(record));
+	ASSERT_TRUE(RecordSchema::write(record, buffer));
+
+	// size-prefixed string, raw bytes, big-endian numbers
+	EXPECT_EQ(hexToBytes("03616263CAFE0102020102030405060708"), buffer);
+}
+
+TEST(RecordSchema, WriteAndRead_Record_SameData)
+{
+	using namespace RecordSchemaTestsInternal;
+
+	const Record record = makeRecord();
+	std::vector<std::byte> buffer(RecordSchema::getSerializedSize(record));
+	ASSERT_TRUE(RecordSchema::write(record, buffer));
+
+	Record result{};
+	ASSERT_TRUE(RecordSchema::read(buffer, result));
+	EXPECT_EQ(result.name, record.name);
+	EXPECT_EQ(result.header.magic, record.header.magic);
+	EXPECT_EQ(result.header.version, record.header.version);
+	EXPECT_EQ(result.kind, record.kind);
+	EXPECT_EQ(result.counter, record.counter);
+}
+
+TEST(RecordSchema, FixedSize_OnlyForRecordsWithoutStrings)
+{
+	using namespace RecordSchemaTestsInternal;
+
+	EXPECT_FALSE(RecordSchema::FixedSize.has_value());
+	static_assert(HeaderSchema::FixedSize == size_t(4));
+}
+
+TEST(RecordSchema, Read_TruncatedOrExtraData_Rejected)
+{
+	using namespace RecordSchemaTestsInternal;
+
+	const Record record = makeRecord();
+	std::vector<std::byte> buffer(RecordSchema::getSerializedSize(record));
+	ASSERT_TRUE(RecordSchema::write(record, buffer));
+
+	AssertHelper::ScopedAssertDisabler assertDisabler;
+
+	for (size_t size = 0; size < buffer.size(); ++size)
+	{
+		Record result{};
+		EXPECT_FALSE(RecordSchema::read(std::span(buffer.data(), size), result)) << size;
+	}
+
+	buffer.push_back(std::byte(0));
+	Record result{};
+	EXPECT_FALSE(RecordSchema::read(buffer, result));
+	// the prefix of the data is still a valid record
+	EXPECT_EQ(RecordSchema::readPrefix(buffer, result), buffer.size() - 1);
+}
@@ -0,0 +1,78 @@
+// Copyright (C) Pavel Grebnev 2026
+// Distributed under the MIT License (license terms are at http://opensource.org/licenses/MIT).
+
+#include <filesystem>
+
+#include <gtest/gtest.h>
+
+#include "common_shared/cryptography/primitives/dh_functions.h"
+
+#include "client_shared/client_storage.h"
+
+class ClientStorageEndpointsTest : public testing::Test
+{
+protected:
+	void SetUp() override
+	{
+		std::filesystem::create_directories(StoragePath);
+	}
+
+	void TearDown() override
+	{
+		std::filesystem::remove_all(StoragePath);
+	}
+
+	static ClientStorageData::ServerBinding makeServerBinding()
+	{
+		Cryptography::Keypair staticKeys = Cryptography::generateKeypair_x25519();
+		Cryptography::Keypair remoteKeys = Cryptography::generateKeypair_x25519();
+		return ClientStorageData::ServerBinding{
+			.serverName = "server",
+			.connectionId = {},
+			.remoteStaticKey = std::move(remoteKeys.publicKey),
+			.staticKeys = std::move(staticKeys),
+			.staticStaticDh = {},
+		};
+	}
+
+	static constexpr const char* StoragePath = "test_client_storage_endpoints";
+};
+
+TEST_F(ClientStorageEndpointsTest, StoreServerEndpoint_ThenGet_SameAddress)
+{
+	std::optional<ClientStorage> storage = ClientStorage::openStorage(StoragePath);
+	ASSERT_TRUE(storage.has_value());
+
+	const ClientStorageData::ServerId serverId{ std::byte(1), std::byte(2), std::byte(3) };
+	EXPECT_EQ(storage->getServerEndpoint(serverId), std::nullopt);
+
+	storage->storeServerEndpoint(serverId, Network::NetworkAddress{ .ip = "192.168.1.20", .port = 41234, .addressType = Network::AddressType::IpV4 });
+	storage->storeServerEndpoint(serverId, Network::NetworkAddress{ .ip = "192.168.1.21", .port = 41235, .addressType = Network::AddressType::IpV4 });
+
+	const std::optional<Network::NetworkAddress> endpoint = storage->getServerEndpoint(serverId);
+	ASSERT_TRUE(endpoint.has_value());
+	EXPECT_EQ(endpoint->ip, "192.168.1.21");
+	EXPECT_EQ(endpoint->port, 41235);
+	EXPECT_EQ(endpoint->addressType, Network::AddressType::IpV4);
+}
+
+TEST_F(ClientStorageEndpointsTest, RemoveConfirmedServerBinding_EndpointRemoved)
+{
+	std::optional<ClientStorage> storage = ClientStorage::openStorage(StoragePath);
+	ASSERT_TRUE(storage.has_value());
+
+	const ClientStorageData::ServerId serverId{ std::byte(1) };
+	const ClientStorageData::ServerId otherServerId{ std::byte(2) };
+	storage->addConfirmedServerBinding(serverId, makeServerBinding());
+	storage->addConfirmedServerBinding(otherServerId, makeServerBinding());
+	storage->storeServerEndpoint(serverId, Network::NetworkAddress{ .ip = "10.0.0.1", .port = 1000, .addressType = Network::AddressType::IpV4 });
+	storage->storeServerEndpoint(otherServerId, Network::NetworkAddress{ .ip = "10.0.0.2", .port = 1000, .addressType = Network::AddressType::IpV4 });
+
+	EXPECT_EQ(storage->getConfirmedServerIds(), (std::vector<ClientStorageData::ServerId>{ serverId, otherServerId }));
+
+	EXPECT_TRUE(storage->removeConfirmedServerBinding(serverId));
+
+	EXPECT_EQ(storage->getServerEndpoint(serverId), std::nullopt);
+	EXPECT_TRUE(storage->getServerEndpoint(otherServerId).has_value());
+	EXPECT_EQ(storage->getConfirmedServerIds(), std::vector<ClientStorageData::ServerId>{ otherServerId });
+}
@@ -0,0 +1,74 @@
+// Copyright (C) Pavel Grebnev 2026
+// Distributed under the MIT License (license terms are at http://opensource.org/licenses/MIT).
+
+#include <filesystem>
+
+#include <gtest/gtest.h>
+
+#include "client_shared/client_storage.h"
+
+class ClientStorageSentFilesTest : public testing::Test
+{
+protected:
+	void SetUp() override
+	{
+		std::filesystem::create_directories(StoragePath);
+	}
+
+	void TearDown() override
+	{
+		std::filesystem::remove_all(StoragePath);
+	}
+
+	static constexpr const char* StoragePath = "test_client_storage_sent_files";
+};
+
+TEST_F(ClientStorageSentFilesTest, FilterOutSentFiles_SomeFilesSent_OthersKeepOrder)
+{
+	std::optional<ClientStorage> storage = ClientStorage::openStorage(StoragePath);
+	ASSERT_TRUE(storage.has_value());
+
+	storage->addSentFiles({ "dir/b", "dir/d", "dir/zzz", "a" }, {}, 0, {});
+
+	std::vector<std::filesystem::path> paths = { "root/dir/e", "root/dir/d", "root/c", "root/dir/b", "root/dir/a", "root/a", "root/dir/bb" };
+	std::vector<uint64_t> previouslySentBytes;
+	storage->filterOutSentFiles("root", paths, previouslySentBytes);
+
+	const std::vector<std::filesystem::path> expectedPaths = { "root/dir/e", "root/c", "root/dir/a", "root/dir/bb" };
+	EXPECT_EQ(paths, expectedPaths);
+	EXPECT_TRUE(previouslySentBytes.empty());
+}
+
+TEST_F(ClientStorageSentFilesTest, FilterOutSentFiles_NothingSent_AllFilesKept)
+{
+	std::optional<ClientStorage> storage = ClientStorage::openStorage(StoragePath);
+	ASSERT_TRUE(storage.has_value());
+
+	storage->addSentFiles({ "x" }, {}, 0, {});
+
+	std::vector<std::filesystem::path> paths = { "c", "b", "a" };
+	std::vector<uint64_t> previouslySentBytes;
+	storage->filterOutSentFiles("", paths, previouslySentBytes);
+
+	const std::vector<std::filesystem::path> expectedPaths = { "c", "b", "a" };
+	EXPECT_EQ(paths, expectedPaths);
+}
+
+TEST_F(ClientStorageSentFilesTest, FilterOutSentFiles_PartiallySentFiles_MovedToFront)
+{
+	std::optional<ClientStorage> storage = ClientStorage::openStorage(StoragePath);
+	ASSERT_TRUE(storage.has_value());
+
+	storage->addSentFiles({ "sent" }, "partial_1", 10, {});
+	storage->addSentFiles({}, "partial_2", 20, {});
+
+	std::vector<std::filesystem::path> paths = { "a", "partial_2", "sent", "b" };
+	std::vector<uint64_t> previouslySentBytes;
+	storage->filterOutSentFiles("", paths, previouslySentBytes);
+
+	// the files missing from the list are added too
+	const std::vector<std::filesystem::path> expectedPaths = { "partial_2", "partial_1", "a", "b" };
+	EXPECT_EQ(paths, expectedPaths);
+	const std::vector<uint64_t> expectedSentBytes = { 20, 10 };
+	EXPECT_EQ(previouslySentBytes, expectedSentBytes);
+}
@@ -1,6 +1,7 @@
 // Copyright (C) Pavel Grebnev 2026
 // Distributed under the MIT License (license terms are at http://opensource.org/licenses/MIT).
 
+#include <algorithm>
 #include <array>
 #include <filesystem>
 
@@ -511,3 +512,250 @@ TEST_F(LmdbTest, Cursor_IteratesAllValuesInKeyOrder)
 		EXPECT_EQ(values[2], std::make_pair(std::string("c"), std::string("value_c")));
 	}
 }
+
+TEST_F(LmdbTest, Cursor_SeekLastAndPrev_MovesInKeyOrder)
+{
+	Lmdb::Result<Lmdb::Environment> env = Lmdb::Environment::open("test_lmdb_env_path", 10);
+	ASSERT_TRUE(env.isValid());
+
+	auto toBytes = [](std::string_view text) {
+		return std::as_bytes(std::span(text));
+	};
+	auto keyOf = [](const Lmdb::Result<Lmdb::CursorDataView>& record) {
+		return std::string(reinterpret_cast<const char*>(record->key.data()), record->key.size());
+	};
+
+	{
+		auto transaction = Lmdb::ReadWriteTransaction::create(*env);
+		ASSERT_TRUE(transaction.isValid());
+		auto db = Lmdb::ReadWriteDatabase::open(*transaction, "db");
+		ASSERT_TRUE(db.isValid());
+
+		for (std::string_view key : { "b", "d", "f" })
+		{
+			ASSERT_EQ(Lmdb::ReturnCode::Success, db->put(toBytes(key), toBytes("value")));
+		}
+		ASSERT_EQ(Lmdb::ReturnCode::Success, transaction->commit());
+	}
+
+	auto transaction = Lmdb::ReadOnlyTransaction::create(*env);
+	ASSERT_TRUE(transaction.isValid());
+	auto db = Lmdb::ReadOnlyDatabase::open(*transaction, "db");
+	ASSERT_TRUE(db.isValid());
+	auto cursor = Lmdb::ReadOnlyCursor::open(*transaction, *db);
+	ASSERT_TRUE(cursor.isValid());
+
+	ASSERT_EQ(Lmdb::ReturnCode::Success, cursor->seek(toBytes("d")));
+	EXPECT_EQ("d", keyOf(cursor->get()));
+
+	ASSERT_EQ(Lmdb::ReturnCode::Success, cursor->seek(toBytes("c")));
+	EXPECT_EQ("d", keyOf(cursor->get()));
+
+	ASSERT_EQ(Lmdb::ReturnCode::Success, cursor->prev());
+	EXPECT_EQ("b", keyOf(cursor->get()));
+
+	EXPECT_EQ(Lmdb::ReturnCode::NotFound, cursor->prev());
+
+	ASSERT_EQ(Lmdb::ReturnCode::Success, cursor->last());
+	EXPECT_EQ("f", keyOf(cursor->get()));
+
+	EXPECT_EQ(Lmdb::ReturnCode::NotFound, cursor->seek(toBytes("g")));
+}
+
+TEST_F(LmdbTest, ReadWriteCursor_PutAndDeleteCurrent_ChangesCommitted)
+{
+	Lmdb::Result<Lmdb::Environment> env = Lmdb::Environment::open("test_lmdb_env_path", 10);
+	ASSERT_TRUE(env.isValid());
+
+	auto toBytes = [](std::string_view text) {
+		return std::as_bytes(std::span(text));
+	};
+
+	{
+		auto transaction = Lmdb::ReadWriteTransaction::create(*env);
+		ASSERT_TRUE(transaction.isValid());
+		auto db = Lmdb::ReadWriteDatabase::open(*transaction, "db");
+		ASSERT_TRUE(db.isValid());
+		{
+			auto cursor = Lmdb::ReadWriteCursor::open(*transaction, *db);
+			ASSERT_TRUE(cursor.isValid());
+
+			ASSERT_EQ(Lmdb::ReturnCode::Success, cursor->put(toBytes("a"), toBytes("value_a")));
+			ASSERT_EQ(Lmdb::ReturnCode::Success, cursor->put(toBytes("b"), toBytes("value_b")));
+			ASSERT_EQ(Lmdb::ReturnCode::Success, cursor->put(toBytes("c"), toBytes("value_c")));
+
+			ASSERT_EQ(Lmdb::ReturnCode::Success, cursor->seek(toBytes("b")));
+			ASSERT_EQ(Lmdb::ReturnCode::Success, cursor->deleteCurrent());
+
+			// the cursor moves to the record after the deleted one
+			ASSERT_EQ(Lmdb::ReturnCode::Success, cursor->next());
+			auto record = cursor->get();
+			ASSERT_TRUE(record.isValid());
+			EXPECT_TRUE(std::ranges::equal(record->key, toBytes("c")));
+		}
+		ASSERT_EQ(Lmdb::ReturnCode::Success, transaction->commit());
+	}
+
+	auto transaction = Lmdb::ReadOnlyTransaction::create(*env);
+	ASSERT_TRUE(transaction.isValid());
+	auto db = Lmdb::ReadOnlyDatabase::open(*transaction, "db");
+	ASSERT_TRUE(db.isValid());
+
+	std::vector<std::byte> value;
+	EXPECT_EQ(Lmdb::ReturnCode::Success, db->getDynamic(toBytes("a"), value));
+	EXPECT_EQ(Lmdb::ReturnCode::NotFound, db->getDynamic(toBytes("b"), value));
+	EXPECT_EQ(Lmdb::ReturnCode::Success, db->getDynamic(toBytes("c"), value));
+}
+
+TEST_F(LmdbTest, ReadWriteDatabase_PutBatchUnsortedWithExistingKeys_AllRecordsStored)
+{
+	Lmdb::Result<Lmdb::Environment> env = Lmdb::Environment::open("test_lmdb_env_path", 10);
+	ASSERT_TRUE(env.isValid());
+
+	auto toBytes = [](std::string_view text) {
+		return std::as_bytes(std::span(text));
+	};
+
+	{
+		auto transaction = Lmdb::ReadWriteTransaction::create(*env);
+		ASSERT_TRUE(transaction.isValid());
+		auto db = Lmdb::ReadWriteDatabase::open(*transaction, "db");
+		ASSERT_TRUE(db.isValid());
+
+		ASSERT_EQ(Lmdb::ReturnCode::Success, db->put(toBytes("c"), toBytes("old_c")));
+		ASSERT_EQ(Lmdb::ReturnCode::Success, db->put(toBytes("e"), toBytes("old_e")));
+
+		// keys before, between and after the existing ones, and a repeated key
+		std::vector<Lmdb::RecordView> records = {
+			{ .key = toBytes("g"), .value = toBytes("value_g") },
+			{ .key = toBytes("a"), .value = toBytes("value_a") },
+			{ .key = toBytes("f"), .value = toBytes("first_f") },
+			{ .key = toBytes("e"), .value = toBytes("value_e") },
+			{ .key = toBytes("d"), .value = toBytes("value_d") },
+			{ .key = toBytes("f"), .value = toBytes("value_f") },
+		};
+		ASSERT_EQ(Lmdb::ReturnCode::Success, db->putBatch(records));
+		ASSERT_EQ(Lmdb::ReturnCode::Success, transaction->commit());
+	}
+
+	auto transaction = Lmdb::ReadOnlyTransaction::create(*env);
+	ASSERT_TRUE(transaction.isValid());
+	auto db = Lmdb::ReadOnlyDatabase::open(*transaction, "db");
+	ASSERT_TRUE(db.isValid());
+
+	std::vector<std::pair<std::string, std::string>> values;
+	auto cursor = Lmdb::ReadOnlyCursor::open(*transaction, *db);
+	ASSERT_TRUE(cursor.isValid());
+	for (Lmdb::ReturnCode returnCode = cursor->first(); returnCode == Lmdb::ReturnCode::Success; returnCode = cursor->next())
+	{
+		auto record = cursor->get();
+		ASSERT_TRUE(record.isValid());
+		values.emplace_back(
+			std::string(reinterpret_cast<const char*>(record->key.data()), record->key.size()),
+			std::string(reinterpret_cast<const char*>(record->value.data()), record->value.size())
+		);
+	}
+
+	const std::vector<std::pair<std::string, std::string>> expectedValues = {
+		{ "a", "value_a" },
+		{ "c", "old_c" },
+		{ "d", "value_d" },
+		{ "e", "value_e" },
+		{ "f", "value_f" },
+		{ "g", "value_g" },
+	};
+	EXPECT_EQ(values, expectedValues);
+}
+
+TEST_F(LmdbTest, ReadWriteDatabase_ReserveAndFill_ValueStored)
+{
+	Lmdb::Result<Lmdb::Environment> env = Lmdb::Environment::open("test_lmdb_env_path", 10);
+	ASSERT_TRUE(env.isValid());
+
+	const std::array<std::byte, 2> key{ std::byte(1), std::byte(2) };
+	{
+		auto transaction = Lmdb::ReadWriteTransaction::create(*env);
+		ASSERT_TRUE(transaction.isValid());
+		auto db = Lmdb::ReadWriteDatabase::open(*transaction, "db");
+		ASSERT_TRUE(db.isValid());
+
+		auto value = db->reserve(key, 4);
+		ASSERT_TRUE(value.isValid());
+		ASSERT_EQ(value->size(), size_t(4));
+		std::ranges::fill(*value, std::byte(0xAB));
+		ASSERT_EQ(Lmdb::ReturnCode::Success, transaction->commit());
+	}
+
+	auto transaction = Lmdb::ReadOnlyTransaction::create(*env);
+	ASSERT_TRUE(transaction.isValid());
+	auto db = Lmdb::ReadOnlyDatabase::open(*transaction, "db");
+	ASSERT_TRUE(db.isValid());
+
+	std::vector<std::byte> value;
+	ASSERT_EQ(Lmdb::ReturnCode::Success, db->getDynamic(key, value));
+	EXPECT_EQ(value, std::vector<std::byte>(4, std::byte(0xAB)));
+}
+
+TEST_F(LmdbTest, ReadOnlyTransaction_CreateAfterPreviousDestroyed_PooledTransactionReused)
+{
+	Lmdb::Result<Lmdb::Environment> env = Lmdb::Environment::open("test_lmdb_env_path", 10);
+	ASSERT_TRUE(env.isValid());
+
+	MDB_txn* firstTransaction = nullptr;
+	{
+		auto transaction = Lmdb::ReadOnlyTransaction::create(*env);
+		ASSERT_TRUE(transaction.isValid());
+		firstTransaction = transaction->getRaw();
+	}
+
+	{
+		auto transaction = Lmdb::ReadOnlyTransaction::create(*env);
+		ASSERT_TRUE(transaction.isValid());
+		EXPECT_EQ(transaction->getRaw(), firstTransaction);
+
+		// the renewed transaction sees the data
+		auto db = Lmdb::ReadOnlyDatabase::open(*transaction, "test_db");
+		EXPECT_TRUE(db.isValid());
+
+		// while the pooled one is in use, a new one is created
+		auto secondTransaction = Lmdb::ReadOnlyTransaction::create(*env);
+		ASSERT_TRUE(secondTransaction.isValid());
+		EXPECT_NE(secondTransaction->getRaw(), firstTransaction);
+	}
+}
+
+TEST_F(LmdbTest, Environment_OpenDatabaseHandles_DatabasesOpenedWithCachedHandles)
+{
+	Lmdb::Result<Lmdb::Environment> env = Lmdb::Environment::open("test_lmdb_env_path", 10);
+	ASSERT_TRUE(env.isValid());
+
+	static constexpr std::array<std::zstring_view, 2> names = { "test_db", "new_db" };
+	ASSERT_EQ(Lmdb::ReturnCode::Success, env->openDatabaseHandles(names));
+
+	const std::optional<MDB_dbi> newDbHandle = env->getCache()->findDatabaseHandle("new_db");
+	ASSERT_TRUE(newDbHandle.has_value());
+	EXPECT_FALSE(env->getCache()->findDatabaseHandle("unknown_db").has_value());
+
+	const std::array<std::byte, 1> key{ std::byte(1) };
+	{
+		auto transaction = Lmdb::ReadWriteTransaction::create(*env);
+		ASSERT_TRUE(transaction.isValid());
+		auto db = Lmdb::ReadWriteDatabase::open(*transaction, "new_db");
+		ASSERT_TRUE(db.isValid());
+		EXPECT_EQ(db->getRaw(), *newDbHandle);
+		ASSERT_EQ(Lmdb::ReturnCode::Success, db->put(key, key));
+		ASSERT_EQ(Lmdb::ReturnCode::Success, transaction->commit());
+	}
+
+	for (int i = 0; i < 2; ++i)
+	{
+		auto transaction = Lmdb::ReadOnlyTransaction::create(*env);
+		ASSERT_TRUE(transaction.isValid());
+		auto db = Lmdb::ReadOnlyDatabase::open(*transaction, "new_db");
+		ASSERT_TRUE(db.isValid());
+		EXPECT_EQ(db->getRaw(), *newDbHandle);
+
+		std::vector<std::byte> value;
+		EXPECT_EQ(Lmdb::ReturnCode::Success, db->getDynamic(key, value));
+	}
+}
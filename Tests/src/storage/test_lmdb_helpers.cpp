@@ -1,8 +1,12 @@
 // Copyright (C) Pavel Grebnev 2026
 // Distributed under the MIT License (license terms are at http://opensource.org/licenses/MIT).
 
+#include <algorithm>
 #include <array>
+#include <chrono>
 #include <filesystem>
+#include <latch>
+#include <thread>
 
 #include <gtest/gtest.h>
 
@@ -174,3 +178,220 @@ TEST_F(LmdbHelpersTest, Cursor_IteratesAllValuesInKeyOrder)
 		EXPECT_EQ(values[2], std::make_pair(std::string("c"), std::string("value_c")));
 	}
 }
+
+TEST_F(LmdbHelpersTest, ReadDbRecordsWithPrefix_OnlyRecordsWithPrefixInKeyOrder)
+{
+	auto env = Lmdb::Environment::open("test_lmdb_env_path", 10);
+	ASSERT_TRUE(env.isValid());
+
+	auto toBytes = [](std::string_view text) {
+		return std::as_bytes(std::span(text));
+	};
+
+	{
+		auto helper = Lmdb::openReadWriteSingleDbTransaction(*env, "test_db");
+		ASSERT_TRUE(helper.isValid());
+		for (std::string_view key : { "a/1", "b", "b/2", "b/1", "ba", "c" })
+		{
+			ASSERT_EQ(Lmdb::ReturnCode::Success, helper->database.put(toBytes(key), toBytes(key)));
+		}
+		ASSERT_EQ(Lmdb::ReturnCode::Success, helper->transaction.commit());
+	}
+
+	{
+		auto helper = Lmdb::openReadOnlySingleDbTransaction(*env, "test_db");
+		ASSERT_TRUE(helper.isValid());
+
+		std::vector<std::string> keys;
+		const Lmdb::ReturnCode returnCode = Lmdb::readDbRecordsWithPrefix(helper->transaction, helper->database, toBytes("b/"), [&keys](std::span<const std::byte> key, std::span<const std::byte>) {
+			keys.emplace_back(reinterpret_cast<const char*>(key.data()), key.size());
+		});
+		EXPECT_EQ(Lmdb::ReturnCode::Success, returnCode);
+		EXPECT_EQ(keys, std::vector<std::string>({ "b/1", "b/2" }));
+	}
+
+	{
+		auto helper = Lmdb::openReadWriteSingleDbTransaction(*env, "test_db");
+		ASSERT_TRUE(helper.isValid());
+		EXPECT_EQ(Lmdb::ReturnCode::Success, Lmdb::deleteDbRecordsWithPrefix(helper->transaction, helper->database, toBytes("b")));
+		// nothing to delete
+		EXPECT_EQ(Lmdb::ReturnCode::Success, Lmdb::deleteDbRecordsWithPrefix(helper->transaction, helper->database, toBytes("z")));
+		ASSERT_EQ(Lmdb::ReturnCode::Success, helper->transaction.commit());
+	}
+
+	{
+		auto helper = Lmdb::openReadOnlySingleDbTransaction(*env, "test_db");
+		ASSERT_TRUE(helper.isValid());
+
+		std::vector<std::string> keys;
+		const Lmdb::ReturnCode returnCode = helper->readAllDbRecords([&keys](std::span<const std::byte> key, std::span<const std::byte>) {
+			keys.emplace_back(reinterpret_cast<const char*>(key.data()), key.size());
+		});
+		EXPECT_EQ(Lmdb::ReturnCode::Success, returnCode);
+		EXPECT_EQ(keys, std::vector<std::string>({ "a/1", "c" }));
+	}
+}
+
+TEST_F(LmdbHelpersTest, ReadAllDuplicates_FixedSizeDuplicates_AllValuesOfKeyRead)
+{
+	auto env = Lmdb::Environment::open("test_lmdb_env_path", 10);
+	ASSERT_TRUE(env.isValid());
+
+	auto toBytes = [](std::string_view text) {
+		return std::as_bytes(std::span(text));
+	};
+
+	constexpr uint32_t ValuesCount = 3000;
+	{
+		auto transaction = Lmdb::ReadWriteTransaction::create(*env);
+		ASSERT_TRUE(transaction.isValid());
+		auto db = Lmdb::ReadWriteDatabase::open(*transaction, "duplicates", Lmdb::DatabaseType::FixedSizeDuplicates);
+		ASSERT_TRUE(db.isValid());
+
+		for (uint32_t i = 0; i < ValuesCount; ++i)
+		{
+			const std::array<std::byte, 4> value{ std::byte(i >> 24), std::byte(i >> 16), std::byte(i >> 8), std::byte(i) };
+			ASSERT_EQ(Lmdb::ReturnCode::Success, db->put(toBytes("key"), value));
+		}
+		const std::array<std::byte, 4> otherValue{ std::byte(0xFF), std::byte(0xFF), std::byte(0xFF), std::byte(0xFF) };
+		ASSERT_EQ(Lmdb::ReturnCode::Success, db->put(toBytes("other"), otherValue));
+		ASSERT_EQ(Lmdb::ReturnCode::Success, transaction->commit());
+	}
+
+	auto helper = Lmdb::openReadOnlySingleDbTransaction(*env, "duplicates");
+	ASSERT_TRUE(helper.isValid());
+
+	uint32_t expectedValue = 0;
+	Lmdb::ReturnCode returnCode = Lmdb::readAllDuplicates(helper->transaction, helper->database, toBytes("key"), [&expectedValue](std::span<const std::byte> value) {
+		ASSERT_EQ(value.size(), size_t(4));
+		const uint32_t number = (uint32_t(value[0]) << 24) | (uint32_t(value[1]) << 16) | (uint32_t(value[2]) << 8) | uint32_t(value[3]);
+		EXPECT_EQ(number, expectedValue);
+		++expectedValue;
+	});
+	EXPECT_EQ(Lmdb::ReturnCode::Success, returnCode);
+	EXPECT_EQ(expectedValue, ValuesCount);
+
+	size_t missingKeyValues = 0;
+	returnCode = Lmdb::readAllDuplicates(helper->transaction, helper->database, toBytes("missing"), [&missingKeyValues](std::span<const std::byte>) {
+		++missingKeyValues;
+	});
+	EXPECT_EQ(Lmdb::ReturnCode::Success, returnCode);
+	EXPECT_EQ(missingKeyValues, size_t(0));
+}
+
+TEST_F(LmdbHelpersTest, RetryOnMapFull_TransactionBiggerThanMap_MapGrownAndTransactionCommitted)
+{
+	auto env = Lmdb::Environment::open("test_lmdb_env_path", 10, Lmdb::EnvironmentOptions{ .initialMapSize = 64 * 1024 });
+	ASSERT_TRUE(env.isValid());
+	const size_t initialMapSize = env->getMapSize();
+
+	constexpr size_t RecordsCount = 200;
+	const std::vector<std::byte> value(1024, std::byte(0x55));
+
+	int attempts = 0;
+	const Lmdb::ReturnCode returnCode = Lmdb::retryOnMapFull(*env, [&env, &value, &attempts]() {
+		++attempts;
+		auto helper = Lmdb::openReadWriteSingleDbTransaction(*env, "test_db");
+		if (helper.isError())
+		{
+			return helper.getError();
+		}
+
+		for (size_t i = 0; i < RecordsCount; ++i)
+		{
+			const std::array<std::byte, 2> key{ std::byte(i >> 8), std::byte(i) };
+			if (const Lmdb::ReturnCode putResult = helper->database.put(key, value); putResult != Lmdb::ReturnCode::Success)
+			{
+				return putResult;
+			}
+		}
+		return helper->transaction.commit();
+	});
+
+	EXPECT_EQ(Lmdb::ReturnCode::Success, returnCode);
+	EXPECT_GT(attempts, 1);
+	EXPECT_GT(env->getMapSize(), initialMapSize);
+
+	auto helper = Lmdb::openReadOnlySingleDbTransaction(*env, "test_db");
+	ASSERT_TRUE(helper.isValid());
+	size_t recordsCount = 0;
+	EXPECT_EQ(Lmdb::ReturnCode::Success, helper->readAllDbRecords([&recordsCount](std::span<const std::byte>, std::span<const std::byte>) {
+		++recordsCount;
+	}));
+	EXPECT_EQ(recordsCount, RecordsCount);
+}
+
+TEST_F(LmdbHelpersTest, GrowMap_TransactionOpen_WaitsForItOrFails)
+{
+	auto env = Lmdb::Environment::open("test_lmdb_env_path", 10, Lmdb::EnvironmentOptions{ .initialMapSize = 64 * 1024 });
+	ASSERT_TRUE(env.isValid());
+	const size_t initialMapSize = env->getMapSize();
+
+	{
+		// the transaction stays open for longer than growMap waits
+		auto transaction = Lmdb::ReadOnlyTransaction::create(*env);
+		ASSERT_TRUE(transaction.isValid());
+		EXPECT_EQ(Lmdb::ReturnCode::EnvironmentIsBusy, env->growMap(initialMapSize));
+		EXPECT_EQ(env->getMapSize(), initialMapSize);
+	}
+
+	std::latch transactionOpened(1);
+	std::thread closingThread([&env, &transactionOpened]() {
+		auto transaction = Lmdb::ReadWriteTransaction::create(*env);
+		transactionOpened.count_down();
+		std::this_thread::sleep_for(std::chrono::milliseconds(50));
+	});
+	transactionOpened.wait();
+	EXPECT_EQ(Lmdb::ReturnCode::Success, env->growMap(initialMapSize));
+	closingThread.join();
+	EXPECT_EQ(env->getMapSize(), initialMapSize * 2);
+
+	// the pooled transactions are not open
+	EXPECT_EQ(Lmdb::ReturnCode::Success, env->growMap(initialMapSize * 2));
+	EXPECT_EQ(env->getMapSize(), initialMapSize * 4);
+	auto helper = Lmdb::openReadOnlySingleDbTransaction(*env, "test_db");
+	EXPECT_TRUE(helper.isValid());
+}
+
+TEST_F(LmdbHelpersTest, GrowMap_AlreadyGrownByAnotherThread_NotGrownAgain)
+{
+	auto env = Lmdb::Environment::open("test_lmdb_env_path", 10, Lmdb::EnvironmentOptions{ .initialMapSize = 64 * 1024 });
+	ASSERT_TRUE(env.isValid());
+	const size_t initialMapSize = env->getMapSize();
+
+	// both threads saw the same full map
+	EXPECT_EQ(Lmdb::ReturnCode::Success, env->growMap(initialMapSize));
+	EXPECT_EQ(Lmdb::ReturnCode::Success, env->growMap(initialMapSize));
+	EXPECT_EQ(env->getMapSize(), initialMapSize * 2);
+}
+
+TEST_F(LmdbHelpersTest, Environment_NoSyncCommitsThenSync_DataKept)
+{
+	auto toBytes = [](std::string_view text) {
+		return std::as_bytes(std::span(text));
+	};
+
+	{
+		auto env = Lmdb::Environment::open("test_lmdb_env_path", 10, Lmdb::EnvironmentOptions{ .syncMode = Lmdb::SyncMode::NoSync });
+		ASSERT_TRUE(env.isValid());
+
+		for (std::string_view key : { "a", "b", "c" })
+		{
+			auto helper = Lmdb::openReadWriteSingleDbTransaction(*env, "test_db");
+			ASSERT_TRUE(helper.isValid());
+			ASSERT_EQ(Lmdb::ReturnCode::Success, helper->database.put(toBytes(key), toBytes("value")));
+			ASSERT_EQ(Lmdb::ReturnCode::Success, helper->transaction.commit());
+		}
+
+		EXPECT_EQ(Lmdb::ReturnCode::Success, env->sync());
+		EXPECT_EQ(Lmdb::ReturnCode::Success, env->setSyncMode(Lmdb::SyncMode::NoMetaSync));
+		EXPECT_EQ(Lmdb::ReturnCode::Success, env->setSyncMode(Lmdb::SyncMode::Full));
+	}
+
+	auto env = Lmdb::Environment::open("test_lmdb_env_path", 10);
+	ASSERT_TRUE(env.isValid());
+	auto helper = Lmdb::openReadOnlySingleDbTransaction(*env, "test_db");
+	ASSERT_TRUE(helper.isValid());
+	std::vector<std::byte> value;
+	EXPECT_EQ(Lmdb::ReturnCode::Success, helper->database.getDynamic(toBytes("c"), value));
+}
@@ -0,0 +1,130 @@
+// Copyright (C) Pavel Grebnev 2026
+// Distributed under the MIT License (license terms are at http://opensource.org/licenses/MIT).
+
+#include <algorithm>
+#include <array>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "tests/assert_helper.h"
+#include <gtest/gtest.h>
+
+#include "common_shared/storage/lmdb_environment.h"
+#include "common_shared/storage/lmdb_helpers.h"
+#include "common_shared/storage/lmdb_typed_database.h"
+
+namespace LmdbTypedDatabaseTestsInternal
+{
+	using IdCodec = Lmdb::Codecs::FixedBytes<4>;
+	using PathsDatabase = Lmdb::TypedReadWriteDatabase<Lmdb::Codecs::PathString, Lmdb::Codecs::BigEndian<uint64_t>>;
+
+	// the views into the transaction memory can be only read in a callback, not returned
+	template<typename TypedDb>
+	concept CanGet = requires(TypedDb& database, TypedDb::Key key) { database.get(key); };
+	static_assert(!CanGet<Lmdb::TypedDatabase<IdCodec, Lmdb::Codecs::Bytes>>);
+	static_assert(!CanGet<Lmdb::TypedDatabase<IdCodec, Lmdb::Codecs::String>>);
+	static_assert(CanGet<Lmdb::TypedDatabase<IdCodec, Lmdb::Codecs::BigEndian<uint32_t>>>);
+} // namespace LmdbTypedDatabaseTestsInternal
+
+class LmdbTypedDatabaseTest : public testing::Test
+{
+protected:
+	void TearDown() override
+	{
+		std::filesystem::remove_all("test_lmdb_env_path");
+	}
+};
+
+TEST(LmdbTypedDatabase, BigEndianCodec_EncodedBytes_SortedAsNumbers)
+{
+	using Codec = Lmdb::Codecs::BigEndian<uint32_t>;
+
+	EXPECT_EQ(Codec::encode(0x01020304), (std::array{ std::byte(0x01), std::byte(0x02), std::byte(0x03), std::byte(0x04) }));
+	EXPECT_LT(Codec::encode(0xFF), Codec::encode(0x100));
+	EXPECT_EQ(Codec::decode(Codec::encode(0xDEADBEEF)), 0xDEADBEEF);
+	EXPECT_FALSE(Codec::decode(std::array<std::byte, 3>{}).has_value());
+}
+
+TEST(LmdbTypedDatabase, FixedBytesCodec_WrongSize_NotDecoded)
+{
+	using Codec = Lmdb::Codecs::FixedBytes<4>;
+
+	const std::array<std::byte, 5> data{ std::byte(1), std::byte(2), std::byte(3), std::byte(4), std::byte(5) };
+	EXPECT_FALSE(Codec::decode(data).has_value());
+
+	const std::optional<Codec::View> view = Codec::decode(std::span(data).first(4));
+	ASSERT_TRUE(view.has_value());
+	// doesn't copy the data
+	EXPECT_EQ(view->data(), data.data());
+}
+
+TEST_F(LmdbTypedDatabaseTest, PutAndGet_TypedRecords_ReadBackDecoded)
+{
+	using namespace LmdbTypedDatabaseTestsInternal;
+
+	auto env = Lmdb::Environment::open("test_lmdb_env_path", 10);
+	ASSERT_TRUE(env.isValid());
+
+	{
+		auto wrapper = Lmdb::openReadWriteSingleDbTransaction(*env, "test_db");
+		ASSERT_TRUE(wrapper.isValid());
+		PathsDatabase database{ wrapper->database };
+		EXPECT_EQ(database.put(std::filesystem::path("dir") / "b.txt", 20), Lmdb::ReturnCode::Success);
+		EXPECT_EQ(database.put("a.txt", 10), Lmdb::ReturnCode::Success);
+		EXPECT_EQ(database.put("c.txt", 30), Lmdb::ReturnCode::Success);
+		EXPECT_EQ(database.deleteKey("c.txt"), Lmdb::ReturnCode::Success);
+		ASSERT_EQ(wrapper->transaction.commit(), Lmdb::ReturnCode::Success);
+	}
+
+	auto wrapper = Lmdb::openReadOnlySingleDbTransaction(*env, "test_db");
+	ASSERT_TRUE(wrapper.isValid());
+	Lmdb::TypedDatabase<Lmdb::Codecs::PathString, Lmdb::Codecs::BigEndian<uint64_t>> database{ wrapper->database };
+
+	Lmdb::Result<uint64_t> value = database.get("a.txt");
+	ASSERT_TRUE(value.isValid());
+	EXPECT_EQ(*value, 10u);
+	EXPECT_TRUE(database.contains(std::filesystem::path("dir") / "b.txt"));
+	EXPECT_FALSE(database.contains("c.txt"));
+	EXPECT_EQ(database.get("c.txt").getError(), Lmdb::ReturnCode::NotFound);
+
+	std::vector<std::pair<std::string, uint64_t>> records;
+	const Lmdb::ReturnCode returnCode = database.readAllRecords(wrapper->transaction, [&records](std::string_view path, uint64_t sentBytes) {
+		records.emplace_back(path, sentBytes);
+	});
+	EXPECT_EQ(returnCode, Lmdb::ReturnCode::Success);
+	const std::vector<std::pair<std::string, uint64_t>> expectedRecords{ { "a.txt", 10 }, { (std::filesystem::path("dir") / "b.txt").string(), 20 } };
+	EXPECT_EQ(records, expectedRecords);
+}
+
+TEST_F(LmdbTypedDatabaseTest, Get_ValueOfUnexpectedSize_ReturnsError)
+{
+	using namespace LmdbTypedDatabaseTestsInternal;
+
+	auto env = Lmdb::Environment::open("test_lmdb_env_path", 10);
+	ASSERT_TRUE(env.isValid());
+
+	auto wrapper = Lmdb::openReadWriteSingleDbTransaction(*env, "test_db");
+	ASSERT_TRUE(wrapper.isValid());
+	const std::array<std::byte, 4> key{ std::byte(1), std::byte(2), std::byte(3), std::byte(4) };
+	const std::array<std::byte, 3> value{ std::byte(5), std::byte(6), std::byte(7) };
+	ASSERT_EQ(wrapper->database.put(key, value), Lmdb::ReturnCode::Success);
+
+	Lmdb::TypedReadWriteDatabase<IdCodec, Lmdb::Codecs::BigEndian<uint32_t>> database{ wrapper->database };
+	{
+		AssertHelper::ScopedAssertDisabler assertDisabler;
+		EXPECT_EQ(database.get(key).getError(), Lmdb::ReturnCode::BadValueSize);
+	}
+
+	Lmdb::TypedReadWriteDatabase<IdCodec, Lmdb::Codecs::Bytes> bytesDatabase{ wrapper->database };
+	bool isEqual = false;
+	const Lmdb::ReturnCode returnCode = bytesDatabase.read(key, [&value, &isEqual](std::span<const std::byte> bytes) {
+		isEqual = std::ranges::equal(bytes, value);
+	});
+	EXPECT_EQ(returnCode, Lmdb::ReturnCode::Success);
+	EXPECT_TRUE(isEqual);
+}
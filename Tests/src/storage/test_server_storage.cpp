@@ -0,0 +1,210 @@
+// Copyright (C) Pavel Grebnev 2026
+// Distributed under the MIT License (license terms are at http://opensource.org/licenses/MIT).
+
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "tests/assert_helper.h"
+#include <gtest/gtest.h>
+
+#include "common_shared/bstorage/storage.h"
+
+#include "server_shared/server_storage.h"
+
+class ServerStorageTest : public testing::Test
+{
+protected:
+	void SetUp() override
+	{
+		std::filesystem::create_directories(StoragePath);
+	}
+
+	void TearDown() override
+	{
+		std::filesystem::remove_all(StoragePath);
+	}
+
+	static Cryptography::HashResult makeConnectionId(const std::byte idByte)
+	{
+		Cryptography::HashResult connectionId{};
+		connectionId.raw[0] = idByte;
+		return connectionId;
+	}
+
+	static ServerStorageData::ClientBinding makeClientBinding(const std::byte keyByte)
+	{
+		ServerStorageData::ClientBinding binding{};
+		binding.name = "client";
+		binding.remoteStaticKey.raw.fill(keyByte);
+		binding.staticKeys.secretKey.raw.fill(keyByte);
+		return binding;
+	}
+
+	static constexpr const char* StoragePath = "test_server_storage";
+};
+
+TEST_F(ServerStorageTest, AddConfirmedClientBinding_OldSnapshotUnchanged)
+{
+	std::optional<ServerStorage> storage = ServerStorage::openStorage(StoragePath);
+	ASSERT_TRUE(storage.has_value());
+
+	const ServerStorage::Snapshot oldSnapshot = storage->getSnapshot();
+
+	ASSERT_TRUE(storage->addConfirmedClientBinding(makeConnectionId(std::byte(1)), makeClientBinding(std::byte(1))));
+
+	EXPECT_TRUE(oldSnapshot->confirmedClientBindings.empty());
+	EXPECT_EQ(storage->getSnapshot()->confirmedClientBindings.size(), size_t(1));
+
+	size_t readBindingsCount = 0;
+	storage->read([&readBindingsCount](const ServerStorageData& data) {
+		readBindingsCount = data.confirmedClientBindings.size();
+	});
+	EXPECT_EQ(readBindingsCount, size_t(1));
+}
+
+TEST_F(ServerStorageTest, AddConfirmedClientBindingAndServerId_Reopen_SameData)
+{
+	const ServerStorageData::ServerId serverId{ std::byte(1), std::byte(2), std::byte(3) };
+	{
+		std::optional<ServerStorage> storage = ServerStorage::openStorage(StoragePath);
+		ASSERT_TRUE(storage.has_value());
+		ASSERT_TRUE(storage->storeServerId(serverId));
+		ASSERT_TRUE(storage->addConfirmedClientBinding(makeConnectionId(std::byte(1)), makeClientBinding(std::byte(0x11))));
+		ASSERT_TRUE(storage->addConfirmedClientBinding(makeConnectionId(std::byte(2)), makeClientBinding(std::byte(0x22))));
+	}
+
+	std::optional<ServerStorage> storage = ServerStorage::openStorage(StoragePath);
+	ASSERT_TRUE(storage.has_value());
+	const ServerStorage::Snapshot snapshot = storage->getSnapshot();
+	EXPECT_EQ(snapshot->serverId, serverId);
+	ASSERT_EQ(snapshot->confirmedClientBindings.size(), size_t(2));
+
+	auto it = snapshot->confirmedClientBindings.find(makeConnectionId(std::byte(2)));
+	ASSERT_NE(it, snapshot->confirmedClientBindings.end());
+	EXPECT_EQ(it->second->name, "client");
+	EXPECT_EQ(it->second->remoteStaticKey.raw[0], std::byte(0x22));
+	EXPECT_EQ(it->second->staticKeys.secretKey.raw[31], std::byte(0x22));
+}
+
+TEST_F(ServerStorageTest, OpenStorage_LegacyFile_ImportedAndRemoved)
+{
+	const std::filesystem::path legacyFilePath = std::filesystem::path(StoragePath) / "server_storage.bin";
+
+	BStorage::Value::ArrayType bindings;
+	{
+		BStorage::Value::ObjectMap record;
+		record.emplace("conn_id", BStorage::Value::makeByteArray(std::vector<std::byte>(32, std::byte(0x05))));
+		record.emplace("name", BStorage::Value::makeString(std::string("legacy_client")));
+		record.emplace("rs", BStorage::Value::makeByteArray(std::vector<std::byte>(32, std::byte(0x06))));
+		record.emplace("s_pub", BStorage::Value::makeByteArray(std::vector<std::byte>(32, std::byte(0x07))));
+		record.emplace("s_secret", BStorage::Value::makeByteArray(std::vector<std::byte>(32, std::byte(0x08))));
+		record.emplace("ss", BStorage::Value::makeByteArray(std::vector<std::byte>(32, std::byte(0x09))));
+		bindings.push_back(BStorage::Value::makeObject(std::move(record)));
+	}
+	BStorage::Value::ObjectMap root;
+	root.emplace("confirmed", BStorage::Value::makeArray(std::move(bindings)));
+	root.emplace("server_id", BStorage::Value::makeByteArray(std::vector<std::byte>(16, std::byte(0x0A))));
+	ASSERT_TRUE(BStorage::saveStorage(legacyFilePath, BStorage::Value::makeObject(std::move(root)), 0));
+
+	{
+		std::optional<ServerStorage> storage = ServerStorage::openStorage(StoragePath);
+		ASSERT_TRUE(storage.has_value());
+	}
+	EXPECT_FALSE(std::filesystem::exists(legacyFilePath));
+
+	// the data is read from the new storage after the import
+	std::optional<ServerStorage> storage = ServerStorage::openStorage(StoragePath);
+	ASSERT_TRUE(storage.has_value());
+	const ServerStorage::Snapshot snapshot = storage->getSnapshot();
+	EXPECT_EQ(snapshot->serverId[15], std::byte(0x0A));
+	ASSERT_EQ(snapshot->confirmedClientBindings.size(), size_t(1));
+	const ServerStorageData::ClientBinding& binding = *snapshot->confirmedClientBindings.begin()->second;
+	EXPECT_EQ(binding.name, "legacy_client");
+	EXPECT_EQ(binding.staticKeys.secretKey.raw[0], std::byte(0x08));
+	EXPECT_EQ(binding.staticStaticDh.raw[0], std::byte(0x09));
+}
+
+TEST_F(ServerStorageTest, OpenStorage_EmptyOrTruncatedLegacyFile_MovedAsideAndStorageOpened)
+{
+	const std::filesystem::path legacyFilePath = std::filesystem::path(StoragePath) / "server_storage.bin";
+	const std::filesystem::path badFilePath = std::filesystem::path(StoragePath) / "server_storage.bin.bad";
+
+	{
+		std::optional<ServerStorage> storage = ServerStorage::openStorage(StoragePath);
+		ASSERT_TRUE(storage.has_value());
+		ASSERT_TRUE(storage->addConfirmedClientBinding(makeConnectionId(std::byte(0x01)), makeClientBinding(std::byte(0x02))));
+	}
+
+	// an empty file and a file cut in the middle of the data
+	for (const std::string_view content : { std::string_view(), std::string_view("\x00\x00\x08", 3) })
+	{
+		{
+			std::ofstream legacyFile(legacyFilePath, std::ios::binary | std::ios::trunc);
+			legacyFile.write(content.data(), content.size());
+		}
+
+		AssertHelper::ScopedAssertDisabler assertDisabler;
+		std::optional<ServerStorage> storage = ServerStorage::openStorage(StoragePath);
+		ASSERT_TRUE(storage.has_value());
+		EXPECT_FALSE(std::filesystem::exists(legacyFilePath));
+		EXPECT_TRUE(std::filesystem::exists(badFilePath));
+		// the data already in the new storage is kept
+		EXPECT_EQ(storage->getSnapshot()->confirmedClientBindings.size(), size_t(1));
+	}
+}
+
+TEST_F(ServerStorageTest, ReadWhileAdding_ReadersSeeOnlyCompleteVersions)
+{
+	constexpr size_t ReadersCount = 4;
+	constexpr size_t BindingsCount = 100;
+
+	std::optional<ServerStorage> storage = ServerStorage::openStorage(StoragePath);
+	ASSERT_TRUE(storage.has_value());
+
+	std::atomic_bool stopFlag{};
+	std::atomic_size_t inconsistentReads{};
+	std::vector<std::thread> readers;
+	for (size_t i = 0; i < ReadersCount; ++i)
+	{
+		readers.emplace_back([&storage, &stopFlag, &inconsistentReads] {
+			size_t lastSeenCount = 0;
+			while (!stopFlag.load())
+			{
+				storage->read([&inconsistentReads, &lastSeenCount](const ServerStorageData& data) {
+					if (data.confirmedClientBindings.size() < lastSeenCount)
+					{
+						++inconsistentReads;
+					}
+					lastSeenCount = data.confirmedClientBindings.size();
+
+					for (const auto& [connectionId, binding] : data.confirmedClientBindings)
+					{
+						if (binding->remoteStaticKey.raw[0] != connectionId.raw[0])
+						{
+							++inconsistentReads;
+						}
+					}
+				});
+			}
+		});
+	}
+
+	for (size_t i = 0; i < BindingsCount; ++i)
+	{
+		const std::byte idByte = static_cast<std::byte>(i + 1);
+		EXPECT_TRUE(storage->addConfirmedClientBinding(makeConnectionId(idByte), makeClientBinding(idByte)));
+	}
+
+	stopFlag.store(true);
+	for (std::thread& reader : readers)
+	{
+		reader.join();
+	}
+
+	EXPECT_EQ(inconsistentReads.load(), size_t(0));
+	EXPECT_EQ(storage->getSnapshot()->confirmedClientBindings.size(), BindingsCount);
+}
@@ -28,9 +28,9 @@ public:
 		mTestState.stopDiscovery();
 	}
 
-	[[nodiscard]] static std::optional<std::string> requestServerName(const Network::NetworkAddress& address)
+	[[nodiscard]] std::optional<std::string> requestServerName(const Network::NetworkAddress& address)
 	{
-		return TestFullFileBackup::requestServerName(address);
+		return mTestState.requestServerName(address);
 	}
 
 	[[nodiscard]] std::variant<std::string, PendingServerBinding> exchangePairInformationWithServer(const TestServerInfo& serverInfo)
@@ -173,9 +173,10 @@ Java_com_unnamed_easyphotobackup_TestFullFileBackup_requestServerNameNative(
 	jlong serverInfoHandle
 )
 {
+	TestFullFileBackupNative* obj = reinterpret_cast<TestFullFileBackupNative*>(handle);
 	TestServerInfoNative* info = reinterpret_cast<TestServerInfoNative*>(serverInfoHandle);
 
-	std::optional<std::string> serverName = TestFullFileBackupNative::requestServerName(info->serverInfo.address);
+	std::optional<std::string> serverName = obj->requestServerName(info->serverInfo.address);
 
 	if (!serverName.has_value())
 	{